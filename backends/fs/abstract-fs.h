@@ -41,6 +41,7 @@ typedef Common::Array<AbstractFSNode *>	AbstractFSList;
 class AbstractFSNode {
 protected:
 	friend class Common::FSNode;
+	friend class Common::FSDirectory;
 	typedef Common::FSNode::ListMode ListMode;
 
 	/**
@@ -62,6 +63,15 @@ protected:
 	 */
 	virtual AbstractFSNode *getChild(const Common::String &name) const = 0;
 
+	/**
+	 * Like getChild(), but for a child already known to exist, and to be a
+	 * directory or not, so that the file system need not be asked. Used to
+	 * rebuild directory listings that were saved.
+	 *
+	 * @return The new node, or nullptr if this is not supported.
+	 */
+	virtual AbstractFSNode *getKnownChild(const Common::String &name, bool isDirectory) const { return nullptr; }
+
 	/**
 	 * The parent node of this directory.
 	 * The parent of the root is the root itself.
@@ -172,6 +182,16 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Obtain a value that changes whenever the object referred by this path
+	 * is modified, such as its modification time. For a directory, that
+	 * includes adding, removing and renaming its entries.
+	 *
+	 * @return bool true if the value was obtained, false if this is not
+	 *         supported or the object cannot be examined.
+	 */
+	virtual bool getModificationStamp(int64 &stamp) const { return false; }
+
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
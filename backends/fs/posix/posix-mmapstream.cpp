@@ -0,0 +1,119 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "backends/fs/posix/posix-mmapstream.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#include <sys/mman.h>
+#define HAVE_POSIX_MMAP
+#endif
+
+// Smaller files take longer to map than to read.
+static const int64 kMinMappedSize = 64 * 1024;
+
+PosixMmapStream::Mapping::~Mapping() {
+#ifdef HAVE_POSIX_MMAP
+	munmap(_address, _length);
+#endif
+}
+
+PosixMmapStream *PosixMmapStream::makeFromPath(const Common::String &path) {
+#ifdef HAVE_POSIX_MMAP
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return nullptr;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < kMinMappedSize ||
+			(uint64)st.st_size > (uint64)(size_t)-1) {
+		close(fd);
+		return nullptr;
+	}
+
+	// The mapping stays valid once the file is closed.
+	void *address = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED)
+		return nullptr;
+
+	Common::SharedPtr<Mapping> mapping(new Mapping(address, (size_t)st.st_size));
+	return new PosixMmapStream(mapping, (const byte *)address, st.st_size);
+#else
+	return nullptr;
+#endif
+}
+
+PosixMmapStream::PosixMmapStream(const Common::SharedPtr<Mapping> &mapping, const byte *data, int64 size) :
+		_mapping(mapping), _data(data), _size(size), _pos(0), _eos(false) {
+}
+
+bool PosixMmapStream::seek(int64 offs, int whence) {
+	switch (whence) {
+	case SEEK_END:
+		offs += _size;
+		break;
+	case SEEK_CUR:
+		offs += _pos;
+		break;
+	case SEEK_SET:
+	default:
+		break;
+	}
+
+	// Like fseek(), allow seeking past the end, where reads then fail.
+	if (offs < 0)
+		return false;
+
+	_pos = offs;
+	_eos = false;
+	return true;
+}
+
+uint32 PosixMmapStream::read(void *dataPtr, uint32 dataSize) {
+	const int64 avail = _pos < _size ? _size - _pos : 0;
+	if (dataSize > avail) {
+		dataSize = (uint32)avail;
+		_eos = true;
+	}
+
+	if (dataSize) {
+		memcpy(dataPtr, _data + _pos, dataSize);
+		_pos += dataSize;
+	}
+	return dataSize;
+}
+
+const byte *PosixMmapStream::getDataRange(int64 begin, int64 end) {
+	if (begin < 0 || begin > end || end > _size)
+		return nullptr;
+	return _data + begin;
+}
+
+Common::SeekableReadStream *PosixMmapStream::createSubView(int64 begin, int64 end) {
+	if (begin < 0 || begin > end || end > _size)
+		return nullptr;
+	return new PosixMmapStream(_mapping, _data + begin, end - begin);
+}
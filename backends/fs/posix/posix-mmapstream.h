@@ -0,0 +1,76 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_POSIXMMAPSTREAM_H
+#define BACKENDS_FS_POSIX_POSIXMMAPSTREAM_H
+
+#include "common/noncopyable.h"
+#include "common/ptr.h"
+#include "common/str.h"
+#include "common/stream.h"
+
+/**
+ * A read stream of a memory-mapped file. Reading copies from the mapping,
+ * with no system call, and getDataRange() and createSubView() give its
+ * data without copying at all; the pages are only read in when touched.
+ *
+ * The file must not be truncated while it is mapped.
+ */
+class PosixMmapStream final : public Common::SeekableReadStream, public Common::NonCopyable {
+public:
+	/**
+	 * Map a regular file. Returns nullptr if it is not one, if it is small
+	 * enough to read through stdio as quickly, or if mmap() fails, so that
+	 * the caller can fall back to a StdioStream.
+	 */
+	static PosixMmapStream *makeFromPath(const Common::String &path);
+
+	bool eos() const override { return _eos; }
+	void clearErr() override { _eos = false; }
+
+	int64 pos() const override { return _pos; }
+	int64 size() const override { return _size; }
+	bool seek(int64 offs, int whence = SEEK_SET) override;
+	uint32 read(void *dataPtr, uint32 dataSize) override;
+
+	const byte *getDataRange(int64 begin, int64 end) override;
+	Common::SeekableReadStream *createSubView(int64 begin, int64 end) override;
+
+private:
+	/** A mapped file, unmapped once no stream uses it. */
+	struct Mapping : public Common::NonCopyable {
+		void *_address;
+		size_t _length;
+
+		Mapping(void *address, size_t length) : _address(address), _length(length) {}
+		~Mapping();
+	};
+
+	PosixMmapStream(const Common::SharedPtr<Mapping> &mapping, const byte *data, int64 size);
+
+	Common::SharedPtr<Mapping> _mapping;
+	const byte *_data; ///< The start of this stream in the mapping.
+	int64 _size;
+	int64 _pos;
+	bool _eos;
+};
+
+#endif
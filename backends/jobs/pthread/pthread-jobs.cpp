@@ -0,0 +1,150 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+
+#include "backends/jobs/pthread/pthread-jobs.h"
+#include "backends/mutex/pthread/pthread-mutex.h"
+
+#include "common/textconsole.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+/**
+ * pthreads worker threads
+ */
+class PthreadJobWorkersInternal final : public Common::JobWorkersInternal {
+public:
+	PthreadJobWorkersInternal();
+	~PthreadJobWorkersInternal() override;
+
+	bool start(Common::JobSystem *system, uint count) override;
+	void join() override;
+	int getCurrentWorker() override;
+	void wait() override;
+	void signal() override;
+	void yield() override;
+	Common::MutexInternal *createMutex() override;
+
+private:
+	struct Worker {
+		pthread_t thread;
+		Common::JobSystem *system;
+		uint index;
+	};
+
+	static void *threadMain(void *arg);
+
+	Common::Array<Worker> _workers;
+	uint _numStarted;
+
+	// A semaphore (unnamed POSIX ones are not everywhere).
+	pthread_mutex_t _mutex;
+	pthread_cond_t _cond;
+	uint _signals;
+};
+
+
+PthreadJobWorkersInternal::PthreadJobWorkersInternal() : _numStarted(0), _signals(0) {
+	if (pthread_mutex_init(&_mutex, nullptr) != 0)
+		warning("pthread_mutex_init() failed");
+	if (pthread_cond_init(&_cond, nullptr) != 0)
+		warning("pthread_cond_init() failed");
+}
+
+PthreadJobWorkersInternal::~PthreadJobWorkersInternal() {
+	assert(_numStarted == 0);
+	pthread_cond_destroy(&_cond);
+	pthread_mutex_destroy(&_mutex);
+}
+
+void *PthreadJobWorkersInternal::threadMain(void *arg) {
+	Worker *worker = (Worker *)arg;
+	worker->system->runWorker(worker->index);
+	return nullptr;
+}
+
+bool PthreadJobWorkersInternal::start(Common::JobSystem *system, uint count) {
+	// Sized first, since the threads keep pointers into it.
+	_workers.resize(count);
+	for (uint i = 0; i < count; i++) {
+		Worker &worker = _workers[i];
+		worker.system = system;
+		worker.index = i;
+		if (pthread_create(&worker.thread, nullptr, &threadMain, &worker) != 0) {
+			warning("pthread_create() failed");
+			return false;
+		}
+		_numStarted++;
+	}
+	return true;
+}
+
+void PthreadJobWorkersInternal::join() {
+	for (uint i = 0; i < _numStarted; i++) {
+		if (pthread_join(_workers[i].thread, nullptr) != 0)
+			warning("pthread_join() failed");
+	}
+	_numStarted = 0;
+}
+
+int PthreadJobWorkersInternal::getCurrentWorker() {
+	const pthread_t self = pthread_self();
+	for (uint i = 0; i < _numStarted; i++) {
+		if (pthread_equal(_workers[i].thread, self))
+			return i;
+	}
+	return -1;
+}
+
+void PthreadJobWorkersInternal::wait() {
+	pthread_mutex_lock(&_mutex);
+	while (_signals == 0)
+		pthread_cond_wait(&_cond, &_mutex);
+	_signals--;
+	pthread_mutex_unlock(&_mutex);
+}
+
+void PthreadJobWorkersInternal::signal() {
+	pthread_mutex_lock(&_mutex);
+	_signals++;
+	pthread_cond_signal(&_cond);
+	pthread_mutex_unlock(&_mutex);
+}
+
+void PthreadJobWorkersInternal::yield() {
+	sched_yield();
+}
+
+Common::MutexInternal *PthreadJobWorkersInternal::createMutex() {
+	return createPthreadMutexInternal();
+}
+
+Common::JobSystem *createPthreadJobSystem(uint numThreads) {
+	if (numThreads == 0) {
+		const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		numThreads = cpus > 1 ? (uint)cpus - 1 : 0;
+	}
+	return new Common::JobSystem(new PthreadJobWorkersInternal(), numThreads);
+}
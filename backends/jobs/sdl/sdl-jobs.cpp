@@ -0,0 +1,146 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#if defined(SDL_BACKEND)
+
+#include "backends/jobs/sdl/sdl-jobs.h"
+#include "backends/mutex/sdl/sdl-mutex.h"
+#include "backends/platform/sdl/sdl-sys.h"
+
+#include "common/textconsole.h"
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+typedef SDL_ThreadID SdlThreadID;
+typedef SDL_Semaphore SdlSemaphore;
+#elif SDL_VERSION_ATLEAST(2, 0, 0)
+typedef SDL_threadID SdlThreadID;
+typedef SDL_sem SdlSemaphore;
+#else
+typedef Uint32 SdlThreadID;
+typedef SDL_sem SdlSemaphore;
+#endif
+
+class SdlJobWorkersInternal final : public Common::JobWorkersInternal {
+public:
+	SdlJobWorkersInternal() : _numStarted(0) { _sem = SDL_CreateSemaphore(0); }
+	~SdlJobWorkersInternal() override {
+		assert(_numStarted == 0);
+		SDL_DestroySemaphore(_sem);
+	}
+
+	bool start(Common::JobSystem *system, uint count) override {
+		// Sized first, since the threads keep pointers into it.
+		_workers.resize(count);
+		for (uint i = 0; i < count; i++) {
+			Worker &worker = _workers[i];
+			worker.system = system;
+			worker.index = i;
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+			worker.thread = SDL_CreateThread(&threadMain, "ScummVM jobs", &worker);
+#else
+			worker.thread = SDL_CreateThread(&threadMain, &worker);
+#endif
+			if (!worker.thread) {
+				warning("SDL_CreateThread() failed: %s", SDL_GetError());
+				return false;
+			}
+			worker.id = SDL_GetThreadID(worker.thread);
+			_numStarted++;
+		}
+		return true;
+	}
+
+	void join() override {
+		for (uint i = 0; i < _numStarted; i++)
+			SDL_WaitThread(_workers[i].thread, nullptr);
+		_numStarted = 0;
+	}
+
+	int getCurrentWorker() override {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+		const SdlThreadID self = SDL_GetCurrentThreadID();
+#else
+		const SdlThreadID self = SDL_ThreadID();
+#endif
+		for (uint i = 0; i < _numStarted; i++) {
+			if (_workers[i].id == self)
+				return i;
+		}
+		return -1;
+	}
+
+	void wait() override {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+		SDL_WaitSemaphore(_sem);
+#else
+		SDL_SemWait(_sem);
+#endif
+	}
+
+	void signal() override {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+		SDL_SignalSemaphore(_sem);
+#else
+		SDL_SemPost(_sem);
+#endif
+	}
+
+	void yield() override { SDL_Delay(0); }
+
+	Common::MutexInternal *createMutex() override { return createSdlMutexInternal(); }
+
+private:
+	struct Worker {
+		SDL_Thread *thread;
+		SdlThreadID id;
+		Common::JobSystem *system;
+		uint index;
+	};
+
+	static int SDLCALL threadMain(void *arg) {
+		Worker *worker = (Worker *)arg;
+		worker->system->runWorker(worker->index);
+		return 0;
+	}
+
+	Common::Array<Worker> _workers;
+	uint _numStarted;
+	SdlSemaphore *_sem;
+};
+
+Common::JobSystem *createSdlJobSystem(uint numThreads) {
+	if (numThreads == 0) {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+		const int cpus = SDL_GetNumLogicalCPUCores();
+#elif SDL_VERSION_ATLEAST(2, 0, 0)
+		const int cpus = SDL_GetCPUCount();
+#else
+		// SDL 1.2 cannot tell, so stay serial.
+		const int cpus = 1;
+#endif
+		numThreads = cpus > 1 ? (uint)cpus - 1 : 0;
+	}
+	return new Common::JobSystem(new SdlJobWorkersInternal(), numThreads);
+}
+
+#endif
@@ -66,6 +66,7 @@
 
 #include "backends/audiocd/default/default-audiocd.h"
 #include "backends/events/default/default-events.h"
+#include "backends/jobs/pthread/pthread-jobs.h"
 #include "backends/mutex/pthread/pthread-mutex.h"
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
@@ -894,6 +895,10 @@ Common::MutexInternal *OSystem_Android::createMutex() {
 	return createPthreadMutexInternal();
 }
 
+Common::JobSystem *OSystem_Android::createJobSystem(uint numThreads) {
+	return createPthreadJobSystem(numThreads);
+}
+
 void OSystem_Android::quit() {
 	ENTER();
 
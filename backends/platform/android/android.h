@@ -249,6 +249,7 @@ public:
 	uint32 getMillis(bool skipRecord = false) override;
 	void delayMillis(uint msecs) override;
 	Common::MutexInternal *createMutex() override;
+	Common::JobSystem *createJobSystem(uint numThreads = 0) override;
 
 	void quit() override;
 
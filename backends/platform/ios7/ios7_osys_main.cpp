@@ -51,6 +51,7 @@
 #include "backends/graphics3d/ios/ios-graphics3d.h"
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
+#include "backends/jobs/pthread/pthread-jobs.h"
 #include "backends/mutex/pthread/pthread-mutex.h"
 #include "backends/fs/chroot/chroot-fs-factory.h"
 #include "backends/fs/posix/posix-fs.h"
@@ -393,6 +394,10 @@ Common::MutexInternal *OSystem_iOS7::createMutex() {
 	return createPthreadMutexInternal();
 }
 
+Common::JobSystem *OSystem_iOS7::createJobSystem(uint numThreads) {
+	return createPthreadJobSystem(numThreads);
+}
+
 void OSystem_iOS7::quit() {
 }
 
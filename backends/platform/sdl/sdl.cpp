@@ -45,6 +45,7 @@
 #include "backends/mixer/null/null-mixer.h"
 #include "backends/events/default/default-events.h"
 #include "backends/keymapper/hardware-input.h"
+#include "backends/jobs/sdl/sdl-jobs.h"
 #include "backends/mutex/sdl/sdl-mutex.h"
 #include "backends/timer/sdl/sdl-timer.h"
 #include "backends/graphics/surfacesdl/surfacesdl-graphics.h"
@@ -385,6 +386,7 @@ void OSystem_SDL::initBackend() {
 
 	ConfMan.registerDefault("iconspath", this->getDefaultIconsPath());
 	ConfMan.registerDefault("dlcspath", this->getDefaultDLCsPath());
+	ConfMan.registerDefault("dirindexpath", this->getDefaultDirIndexPath());
 
 	_inited = true;
 
@@ -843,6 +845,10 @@ Common::MutexInternal *OSystem_SDL::createMutex() {
 	return createSdlMutexInternal();
 }
 
+Common::JobSystem *OSystem_SDL::createJobSystem(uint numThreads) {
+	return createSdlJobSystem(numThreads);
+}
+
 uint32 OSystem_SDL::getMillis(bool skipRecord) {
 	uint32 millis = SDL_GetTicks();
 
@@ -929,6 +935,11 @@ Common::Path OSystem_SDL::getDefaultDLCsPath() {
 	return path;
 }
 
+// Not specified in base class
+Common::Path OSystem_SDL::getDefaultDirIndexPath() {
+	return ConfMan.getPath("dirindexpath");
+}
+
 //Not specified in base class
 Common::Path OSystem_SDL::getScreenshotsPath() {
 	return ConfMan.getPath("screenshotpath");
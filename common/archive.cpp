@@ -338,6 +338,7 @@ void SearchSet::insert(const Node &node) {
 			break;
 	}
 	_list.insert(it, node);
+	invalidateIndex();
 }
 
 void SearchSet::add(const String &name, Archive *archive, int priority, bool autoFree) {
@@ -428,6 +429,7 @@ void SearchSet::remove(const String &name) {
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
+		invalidateIndex();
 	}
 }
 
@@ -451,6 +453,7 @@ void SearchSet::clear() {
 	}
 
 	_list.clear();
+	invalidateIndex();
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -469,10 +472,45 @@ void SearchSet::setPriority(const String &name, int priority) {
 	insert(node);
 }
 
+void SearchSet::setIndexed(bool indexed) {
+	_indexed = indexed;
+	invalidateIndex();
+}
+
+Archive *SearchSet::lookupIndex(const Path &path) const {
+	if (!_indexValid) {
+		// Archives are listed from the highest priority, so the first one
+		// found to have a member is the one that is searched first.
+		for (const auto &archive : _list) {
+			ArchiveMemberList members;
+			archive._arc->listMembers(members);
+			for (const ArchiveMemberPtr &member : members) {
+				const Path memberPath = member->getPathInArchive();
+				if (!_index.contains(memberPath))
+					_index[memberPath] = archive._arc;
+			}
+		}
+		_indexValid = true;
+	}
+
+	ArchiveIndex::const_iterator it = _index.find(path);
+	return it != _index.end() ? it->_value : nullptr;
+}
+
 bool SearchSet::hasFile(const Path &path) const {
 	if (path.empty())
 		return false;
 
+	if (_indexed) {
+		// Not in the index means that no archive has it. An archive that
+		// no longer has it falls back to asking each one.
+		Archive *arc = lookupIndex(path);
+		if (!arc)
+			return false;
+		if (arc->hasFile(path))
+			return true;
+	}
+
 	for (const auto &archive : _list) {
 		if (archive._arc->hasFile(path))
 			return true;
@@ -553,6 +591,17 @@ const ArchiveMemberPtr SearchSet::getMember(const Path &path, Archive **containe
 	if (path.empty())
 		return ArchiveMemberPtr();
 
+	if (_indexed) {
+		Archive *arc = lookupIndex(path);
+		if (!arc)
+			return ArchiveMemberPtr();
+		if (arc->hasFile(path)) {
+			if (container)
+				*container = arc;
+			return arc->getMember(path);
+		}
+	}
+
 	for (const auto &archive : _list) {
 		if (archive._arc->hasFile(path)) {
 			if (container) {
@@ -573,6 +622,15 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const Path &path) const
 	if (path.empty())
 		return nullptr;
 
+	if (_indexed) {
+		Archive *arc = lookupIndex(path);
+		if (!arc)
+			return nullptr;
+		SeekableReadStream *stream = arc->createReadStreamForMember(path);
+		if (stream)
+			return stream;
+	}
+
 	for (const auto &archive : _list) {
 		SeekableReadStream *stream = archive._arc->createReadStreamForMember(path);
 		if (stream)
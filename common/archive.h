@@ -347,8 +347,20 @@ class SearchSet : public Archive {
 
 	bool _ignoreClashes;
 
+	// The first archive with each member, when indexed.
+	typedef HashMap<Path, Archive *, Path::IgnoreCaseAndMac_Hash, Path::IgnoreCaseAndMac_EqualTo> ArchiveIndex;
+	bool _indexed;
+	mutable bool _indexValid;
+	mutable ArchiveIndex _index;
+
+	/**
+	 * Find the archive to ask for a member, building the index first if needed.
+	 * Returns nullptr if no archive has it.
+	 */
+	Archive *lookupIndex(const Path &path) const;
+
 public:
-	SearchSet() : _ignoreClashes(false) { }
+	SearchSet() : _ignoreClashes(false), _indexed(false), _indexValid(false) { }
 	virtual ~SearchSet() { clear(); }
 
 	char getPathSeparator() const override { return '/'; }
@@ -476,6 +488,24 @@ public:
 	 */
 	void setIgnoreClashes(bool ignoreClashes) { _ignoreClashes = ignoreClashes; }
 
+	/**
+	 * Look members up in one index of all the archives' members, rather than
+	 * asking each archive in turn. This makes hasFile(), getMember() and
+	 * createReadStreamForMember() take the same time however many archives
+	 * there are, at the cost of listing all their members when the index is
+	 * first needed.
+	 *
+	 * The index is rebuilt after any archive is added or removed, or its
+	 * priority changed. Only use it when all the archives list all of their
+	 * members, and call invalidateIndex() if their contents change.
+	 */
+	void setIndexed(bool indexed);
+
+	/**
+	 * Rebuild the index, if there is one, when it is next needed.
+	 */
+	void invalidateIndex() { _indexValid = false; _index.clear(); }
+
 	bool getChildren(const Common::Path &path, Common::Array<Common::String> &list, ListMode mode = kListDirectoriesOnly, bool hidden = true) const override;
 };
 
@@ -988,20 +988,49 @@ Common::SharedArchiveContents unzOpenCurrentFile (unzFile file
 	}
 
 	uint32 crc32_wait = s->cur_file_info.crc;
+	const int64 dataOffset = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER + iSizeVar;
+	const int64 dataEnd = dataOffset + s->cur_file_info.compressed_size;
 
-	byte *compressedBuffer = new byte[s->cur_file_info.compressed_size];
-	s->_stream->seek(s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER + iSizeVar);
-	s->_stream->read(compressedBuffer, s->cur_file_info.compressed_size);
+	// The data of a mapped archive is used where it is, rather than read.
+	const byte *compressedData = s->_stream->getDataRange(dataOffset, dataEnd);
+
+	// A stored file of one can even be handed out as it is.
+	if (compressedData && s->cur_file_info.compression_method == 0) {
+#ifndef USE_ZLIB
+		uint32 crc32_data = crc.crcFast(compressedData, s->cur_file_info.compressed_size);
+#else
+		uint32 crc32_data = crc32(0, compressedData, s->cur_file_info.compressed_size);
+#endif
+		if (crc32_data != crc32_wait) {
+			warning("CRC32 mismatch: %08x, %08x", crc32_data, crc32_wait);
+			return Common::SharedArchiveContents();
+		}
+		Common::SeekableReadStream *view = s->_stream->createSubView(dataOffset, dataEnd);
+		if (view)
+			return Common::SharedArchiveContents::bypass(view);
+	}
+
+	byte *compressedBuffer = nullptr;
+	if (!compressedData) {
+		compressedBuffer = new byte[s->cur_file_info.compressed_size];
+		s->_stream->seek(dataOffset);
+		s->_stream->read(compressedBuffer, s->cur_file_info.compressed_size);
+		compressedData = compressedBuffer;
+	}
 	byte *uncompressedBuffer = nullptr;
 
 	switch (s->cur_file_info.compression_method) {
 	case 0: // Store
+		if (!compressedBuffer) {
+			compressedBuffer = new byte[s->cur_file_info.compressed_size];
+			memcpy(compressedBuffer, compressedData, s->cur_file_info.compressed_size);
+		}
 		uncompressedBuffer = compressedBuffer;
 		break;
 	case Z_DEFLATED:
 		uncompressedBuffer = new byte[s->cur_file_info.uncompressed_size];
 		assert(s->cur_file_info.uncompressed_size == 0 || uncompressedBuffer != nullptr);
-		Common::inflateZlibHeaderless(uncompressedBuffer, s->cur_file_info.uncompressed_size, compressedBuffer, s->cur_file_info.compressed_size);
+		Common::inflateZlibHeaderless(uncompressedBuffer, s->cur_file_info.uncompressed_size, compressedData, s->cur_file_info.compressed_size);
 		delete[] compressedBuffer;
 		compressedBuffer = nullptr;
 		break;
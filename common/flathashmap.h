@@ -0,0 +1,656 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// The hash map implementation in this file follows the design of the
+// "Swiss table" of the Abseil library: open addressing over groups of slots,
+// with one control byte per slot so that a whole group is probed at once.
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/endian.h"
+#include "common/hashmap.h"
+#include "common/intrinsics.h"
+#include "common/util.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLATHASHMAP_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * @defgroup common_flathashmap Flat hash table (FlatHashMap)
+ * @ingroup common
+ *
+ * @brief API for operations on a hash table storing its elements inline.
+ *
+ * @{
+ */
+
+/**
+ * The control bytes of a group of slots of a FlatHashMap, and the searches
+ * done on all of them at once. Each byte is either kCtrlEmpty, kCtrlDeleted,
+ * or the low 7 bits of the hash of the key in that slot.
+ *
+ * This is an implementation detail of FlatHashMap.
+ */
+class FlatHashMapGroup {
+public:
+	enum {
+		kWidth = 16,
+		kCtrlEmpty = 0x80,
+		kCtrlDeleted = 0xFE
+	};
+
+#ifdef FLATHASHMAP_USE_SSE2
+	explicit FlatHashMapGroup(const byte *ctrl) : _ctrl(_mm_loadu_si128((const __m128i *)ctrl)) {}
+
+	/** A mask with bit i set if slot i may hold a key with this hash. */
+	uint32 match(byte h2) const {
+		return (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8((char)h2), _ctrl));
+	}
+
+	/** A mask with bit i set if slot i is empty. */
+	uint32 matchEmpty() const {
+		return match(kCtrlEmpty);
+	}
+
+	/** A mask with bit i set if slot i is empty or deleted. */
+	uint32 matchFree() const {
+		return (uint32)_mm_movemask_epi8(_ctrl);
+	}
+
+private:
+	__m128i _ctrl;
+#else
+	explicit FlatHashMapGroup(const byte *ctrl) : _lo(READ_LE_UINT64(ctrl)), _hi(READ_LE_UINT64(ctrl + 8)) {}
+
+	// The same as above, eight bytes at a time. match() may also report
+	// a byte that follows a real match, which the key comparison rejects.
+	uint32 match(byte h2) const {
+		const uint64 pattern = kLsbs * h2;
+		return pack(matchZero(_lo ^ pattern)) | (pack(matchZero(_hi ^ pattern)) << 8);
+	}
+
+	uint32 matchEmpty() const {
+		return pack(_lo & (~_lo << 6) & kMsbs) | (pack(_hi & (~_hi << 6) & kMsbs) << 8);
+	}
+
+	uint32 matchFree() const {
+		return pack(_lo & kMsbs) | (pack(_hi & kMsbs) << 8);
+	}
+
+private:
+	static const uint64 kLsbs = 0x0101010101010101ULL;
+	static const uint64 kMsbs = 0x8080808080808080ULL;
+
+	static uint64 matchZero(uint64 x) {
+		return (x - kLsbs) & ~x & kMsbs;
+	}
+
+	/** Gather the top bit of each byte into the low 8 bits. */
+	static uint32 pack(uint64 msbs) {
+		return (uint32)(((msbs >> 7) * 0x0102040810204080ULL) >> 56);
+	}
+
+	uint64 _lo, _hi;
+#endif
+};
+
+/**
+ * FlatHashMap<Key,Val> maps objects of type Key to objects of type Val, with
+ * the same interface as HashMap. Elements are stored in one array instead
+ * of being allocated one by one, and a lookup compares a key against 16
+ * slots at once, using SSE2 where available. This makes it faster for maps
+ * that are looked up often, especially with small keys and values. Keys
+ * that are small consecutive integers are the exception: with their
+ * identity hash, a HashMap looks them up in order, which is hard to beat.
+ *
+ * Unlike with HashMap, inserting an element may move the others, so
+ * pointers and references to values are only valid until the next
+ * insertion. Iterators are kept valid by erasing elements, as with HashMap.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+	struct Node {
+		Val _value;
+		const Key _key;
+		explicit Node(const Key &key) : _value(), _key(key) {}
+	};
+
+private:
+
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> HM_t;
+	typedef FlatHashMapGroup Group;
+
+	enum {
+		FLATHASHMAP_MIN_CAPACITY = Group::kWidth,
+
+		// Up to 7/8 of the slots may be used, counting deleted ones, so
+		// that a probe always ends on an empty slot.
+		FLATHASHMAP_LOADFACTOR_NUMERATOR = 7,
+		FLATHASHMAP_LOADFACTOR_DENOMINATOR = 8
+	};
+
+	/** Default value, returned by the const getVal. */
+	Val _defaultVal;
+
+	byte *_ctrl;		///< One control byte per slot.
+	Node *_slots;		///< The slots; only those with a full control byte are constructed.
+	size_type _mask;	///< Capacity of the FlatHashMap minus one; the capacity is a power of two of at least 16
+	size_type _size;
+	size_type _deleted; ///< Number of slots marked deleted
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	static bool isFull(byte ctrl) { return ctrl < 0x80; }
+
+	/**
+	 * Spread the bits of a hash, as identity hashes of integers would all
+	 * fall in the same group. Only the high half of the product is kept,
+	 * as each of its bits depends on all the bits of the hash.
+	 */
+	static size_type mixHash(size_type hash) {
+		return (size_type)(((uint64)hash * 0x9E3779B97F4A7C15ULL) >> 32);
+	}
+
+	void allocStorage(size_type capacity) {
+		_mask = capacity - 1;
+		_ctrl = (byte *)malloc(capacity);
+		_slots = (Node *)malloc(capacity * sizeof(Node));
+		assert(_ctrl != nullptr && _slots != nullptr);
+		memset(_ctrl, Group::kCtrlEmpty, capacity);
+		_size = 0;
+		_deleted = 0;
+	}
+
+	void freeStorage() {
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (isFull(_ctrl[ctr]))
+				_slots[ctr].~Node();
+		}
+		free(_ctrl);
+		free(_slots);
+	}
+
+	void assign(const HM_t &map);
+	size_type lookup(const Key &key, size_type hash) const;
+	size_type lookup(const Key &key) const { return lookup(key, mixHash(_hash(key))); }
+	size_type findFreeSlot(size_type hash) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	void rehash(size_type newCapacity);
+	void eraseSlot(size_type ctr);
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != nullptr);
+			assert(_idx <= _hashmap->_mask);
+			assert(isFull(_hashmap->_ctrl[_idx]));
+			return &_hashmap->_slots[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(nullptr) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			_idx = _hashmap->nextFull(_idx + 1);
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+	/** The first used slot from @p ctr on, or (size_type)-1 if none. */
+	size_type nextFull(size_type ctr) const {
+		for (; ctr <= _mask; ++ctr) {
+			if (isFull(_ctrl[ctr]))
+				return ctr;
+		}
+		return (size_type)-1;
+	}
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const HM_t &map);
+	~FlatHashMap();
+
+	HM_t &operator=(const HM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		freeStorage();
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getOrCreateVal(const Key &key);
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getValOrDefault(const Key &key) const;
+	const Val &getValOrDefault(const Key &key, const Val &defaultVal) const;
+	bool tryGetVal(const Key &key, Val &out) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator	begin() {
+		return iterator(nextFull(0), this);
+	}
+	iterator	end() {
+		return iterator((size_type)-1, this);
+	}
+
+	const_iterator	begin() const {
+		return const_iterator(nextFull(0), this);
+	}
+	const_iterator	end() const {
+		return const_iterator((size_type)-1, this);
+	}
+
+	iterator	find(const Key &key) {
+		size_type ctr = lookup(key);
+		if (ctr <= _mask)
+			return iterator(ctr, this);
+		return end();
+	}
+
+	const_iterator	find(const Key &key) const {
+		size_type ctr = lookup(key);
+		if (ctr <= _mask)
+			return const_iterator(ctr, this);
+		return end();
+	}
+
+	/** Return true if hashmap is empty. */
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Base constructor, creates an empty hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocStorage(FLATHASHMAP_MIN_CAPACITY);
+}
+
+/**
+ * Copy constructor, creates a full copy of the given hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const HM_t &map) :
+	_defaultVal() {
+	assign(map);
+}
+
+/**
+ * Destructor, frees all used memory.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	freeStorage();
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note The previous storage here is *not* deallocated here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
+	// The same layout, so that nothing needs to be hashed again
+	allocStorage(map._mask + 1);
+	memcpy(_ctrl, map._ctrl, _mask + 1);
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (isFull(_ctrl[ctr]))
+			new ((void *)&_slots[ctr]) Node(map._slots[ctr]);
+	}
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+/**
+ * Clear all values in the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	if (shrinkArray && _mask >= FLATHASHMAP_MIN_CAPACITY) {
+		freeStorage();
+		allocStorage(FLATHASHMAP_MIN_CAPACITY);
+		return;
+	}
+
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (isFull(_ctrl[ctr]))
+			_slots[ctr].~Node();
+	}
+	memset(_ctrl, Group::kCtrlEmpty, _mask + 1);
+	_size = 0;
+	_deleted = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::rehash(size_type newCapacity) {
+	assert(newCapacity >= FLATHASHMAP_MIN_CAPACITY && newCapacity > _size);
+
+#ifndef RELEASE_BUILD
+	const size_type old_size = _size;
+#endif
+	const size_type old_mask = _mask;
+	byte *old_ctrl = _ctrl;
+	Node *old_slots = _slots;
+
+	allocStorage(newCapacity);
+
+	// Move all the old elements. Since we know that no key exists twice,
+	// each only needs a free slot, without comparing keys.
+	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
+		if (!isFull(old_ctrl[ctr]))
+			continue;
+
+		Node &node = old_slots[ctr];
+		const size_type hash = mixHash(_hash(node._key));
+		const size_type idx = findFreeSlot(hash);
+		_ctrl[idx] = hash & 0x7F;
+		new ((void *)&_slots[idx]) Node(node._key);
+		_slots[idx]._value = Common::move(node._value);
+		node.~Node();
+		_size++;
+	}
+
+#ifndef RELEASE_BUILD
+	// Perform a sanity check: Old number of elements should match the new one!
+	// This check will fail if some previous operation corrupted this hashmap.
+	assert(_size == old_size);
+#endif
+
+	free(old_ctrl);
+	free(old_slots);
+}
+
+/**
+ * The slot holding @p key, or _mask + 1 if there is none. The groups are
+ * visited by triangular steps, which reach each of them once as their
+ * number is a power of two.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key, size_type hash) const {
+	const size_type groupMask = _mask / Group::kWidth;
+	const byte h2 = hash & 0x7F;
+	size_type group = (hash >> 7) & groupMask;
+	for (size_type step = 1; ; ++step) {
+		const size_type base = group * Group::kWidth;
+		const Group g(_ctrl + base);
+		for (uint32 match = g.match(h2); match; match &= match - 1) {
+			const size_type ctr = base + countTrailingZeros(match);
+			if (_equal(_slots[ctr]._key, key))
+				return ctr;
+		}
+		if (g.matchEmpty())
+			return _mask + 1;
+		group = (group + step) & groupMask;
+	}
+}
+
+/**
+ * The first empty or deleted slot on the probe sequence for @p hash.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::findFreeSlot(size_type hash) const {
+	const size_type groupMask = _mask / Group::kWidth;
+	size_type group = (hash >> 7) & groupMask;
+	for (size_type step = 1; ; ++step) {
+		const size_type base = group * Group::kWidth;
+		const uint32 freeSlots = Group(_ctrl + base).matchFree();
+		if (freeSlots)
+			return base + countTrailingZeros(freeSlots);
+		group = (group + step) & groupMask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	const size_type hash = mixHash(_hash(key));
+	size_type ctr = lookup(key, hash);
+	if (ctr <= _mask)
+		return ctr;
+
+	// Keep the load factor below a certain threshold, deleted slots
+	// included. Growing is only needed when most of them are in use;
+	// otherwise, dropping the deleted ones is enough.
+	size_type capacity = _mask + 1;
+	if ((_size + _deleted + 1) * FLATHASHMAP_LOADFACTOR_DENOMINATOR > capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR) {
+		if ((_size + 1) * 2 * FLATHASHMAP_LOADFACTOR_DENOMINATOR > capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR)
+			capacity *= 2;
+		rehash(capacity);
+	}
+
+	ctr = findFreeSlot(hash);
+	if (_ctrl[ctr] == Group::kCtrlDeleted)
+		_deleted--;
+	_ctrl[ctr] = hash & 0x7F;
+	new ((void *)&_slots[ctr]) Node(key);
+	_size++;
+	return ctr;
+}
+
+/**
+ * Check whether the hashmap contains the given key.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) <= _mask;
+}
+
+/**
+ * Get a value from the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getOrCreateVal(key);
+}
+
+/**
+ * @overload
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+/**
+ * Get a value from the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getOrCreateVal(const Key &key) {
+	// The slot first, as finding it may move the slots
+	const size_type ctr = lookupAndCreateIfMissing(key);
+	return _slots[ctr]._value;
+}
+
+/**
+ * @overload
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return _slots[ctr]._value;
+	else
+		// See the comment in HashMap::getVal().
+#ifdef RELEASE_BUILD
+		return _defaultVal;
+#else
+		unknownKeyError(key);
+#endif
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return _slots[ctr]._value;
+	else
+		// See the comment in HashMap::getVal().
+#ifdef RELEASE_BUILD
+		return _defaultVal;
+#else
+		unknownKeyError(key);
+#endif
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getValOrDefault(const Key &key) const {
+	return getValOrDefault(key, _defaultVal);
+}
+
+/**
+ * Get a value from the hashmap. If the key is not present, then return @p defaultVal.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getValOrDefault(const Key &key, const Val &defaultVal) const {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return _slots[ctr]._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::tryGetVal(const Key &key, Val &out) const {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask) {
+		out = _slots[ctr]._value;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+/**
+ * Assign an element specified by @p key to a value @p val.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	const size_type ctr = lookupAndCreateIfMissing(key);
+	_slots[ctr]._value = val;
+}
+
+/**
+ * Internal method for freeing a used slot. If its group still has an empty
+ * slot, no probe ever went past that group, so the slot can be made empty
+ * again; otherwise it must be marked deleted for probes to go on.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseSlot(size_type ctr) {
+	assert(ctr <= _mask);
+	assert(isFull(_ctrl[ctr]));
+
+	_slots[ctr].~Node();
+	if (Group(_ctrl + (ctr & ~(size_type)(Group::kWidth - 1))).matchEmpty()) {
+		_ctrl[ctr] = Group::kCtrlEmpty;
+	} else {
+		_ctrl[ctr] = Group::kCtrlDeleted;
+		_deleted++;
+	}
+	_size--;
+}
+
+/**
+ * Erase an element referred to by an iterator.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	eraseSlot(entry._idx);
+}
+
+/**
+ * Erase an element specified by a key.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		eraseSlot(ctr);
+}
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -21,6 +21,8 @@
 
 #include "common/system.h"
 #include "common/debug.h"
+#include "common/endian.h"
+#include "common/memstream.h"
 #include "common/punycode.h"
 #include "common/textconsole.h"
 #include "backends/fs/abstract-fs.h"
@@ -423,12 +425,80 @@ FSDirectory *FSDirectory::getSubDirectory(const Path &prefix, const Path &name,
 	return new FSDirectory(prefix, *node, depth, flat, ignoreClashes);
 }
 
-void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const Path& prefix) const {
+/**
+ * The index file holds a header, then one record per directory listed, in the
+ * order they are listed while caching: the directory's modification stamp,
+ * its number of children and, for each child, a byte telling whether it is a
+ * directory followed by its zero-terminated name.
+ */
+enum {
+	kIndexVersion = 1
+};
+
+struct FSDirectory::IndexState {
+	SeekableReadStream *in;         // when loading the index
+	MemoryWriteStreamDynamic *out;  // when building it
+	bool valid;                     // false once the index being built can't be used
+};
+
+void FSDirectory::setIndexFile(const Path &indexFile) {
+	assert(!_cached);
+	_indexFile = indexFile;
+}
+
+bool FSDirectory::listDirectory(const FSNode &node, FSList &list, IndexState *index) const {
+	if (!index)
+		return node.getChildren(list, FSNode::kListAll);
+
+	int64 stamp;
+	const bool hasStamp = node._realNode->getModificationStamp(stamp);
+
+	if (index->in) {
+		// Stale as soon as one directory was modified since it was listed
+		if (!hasStamp || index->in->readSint64LE() != stamp)
+			return false;
+
+		const uint32 count = index->in->readUint32LE();
+		for (uint32 i = 0; i < count; i++) {
+			const bool isDirectory = index->in->readByte() != 0;
+			const String name = index->in->readString();
+			// A damaged index can hold anything, but a child's name is one
+			// path component
+			if (index->in->err() || index->in->eos() || name.empty() || name.contains('/'))
+				return false;
+
+			AbstractFSNode *child = node._realNode->getKnownChild(name, isDirectory);
+			if (!child)
+				return false;
+			list.push_back(FSNode(child));
+		}
+		return true;
+	}
+
+	// Take the stamp before listing, so that a change made meanwhile is seen
+	// the next time
+	if (!node.getChildren(list, FSNode::kListAll) || !hasStamp)
+		index->valid = false;
+
+	if (index->valid) {
+		index->out->writeSint64LE(stamp);
+		index->out->writeUint32LE(list.size());
+		for (const auto &child : list) {
+			index->out->writeByte(child.isDirectory() ? 1 : 0);
+			index->out->writeString(child.getRealName());
+			index->out->writeByte(0);
+		}
+	}
+	return true;
+}
+
+bool FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const Path& prefix, IndexState *index) const {
 	if (depth <= 0)
-		return;
+		return true;
 
 	FSList list;
-	node.getChildren(list, FSNode::kListAll);
+	if (!listDirectory(node, list, index))
+		return false;
 
 	for (auto &curNode : list) {
 		Path name = prefix.appendComponent(curNode.getRealName());
@@ -447,7 +517,8 @@ void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const Path& pr
 						        Common::toPrintable(name.toString(Common::Path::kNativeSeparator)).c_str());
 					}
 				}
-				cacheDirectoryRecursive(curNode, depth - 1, _flat ? prefix : name);
+				if (!cacheDirectoryRecursive(curNode, depth - 1, _flat ? prefix : name, index))
+					return false;
 				_subDirCache[name] = curNode;
 				_dirMapCache[prefix].push_back(curNode.getRealName());
 			}
@@ -464,13 +535,77 @@ void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const Path& pr
 		}
 	}
 
+	return true;
+}
+
+void FSDirectory::clearCache() const {
+	_fileCache.clear();
+	_subDirCache.clear();
+	_fileMapCache.clear();
+	_dirMapCache.clear();
+}
+
+bool FSDirectory::loadIndex() const {
+	FSNode indexNode(_indexFile);
+	if (!indexNode.exists())
+		return false;
+
+	SeekableReadStream *stream = indexNode.createReadStream();
+	if (!stream)
+		return false;
+
+	IndexState index = { stream, nullptr, true };
+	bool loaded = stream->readUint32BE() == MKTAG('D', 'I', 'D', 'X') &&
+	              stream->readUint32LE() == kIndexVersion &&
+	              stream->readString() == _node.getPath().toConfig() &&
+	              stream->readSint32LE() == _depth &&
+	              stream->readByte() == (_flat ? 1 : 0) &&
+	              !stream->err() && !stream->eos();
+	if (loaded)
+		loaded = cacheDirectoryRecursive(_node, _depth, _prefix, &index) && !stream->err() && stream->pos() == stream->size();
+	delete stream;
+
+	if (!loaded) {
+		debug(2, "FSDirectory: Index '%s' is out of date", _indexFile.toString(Common::Path::kNativeSeparator).c_str());
+		clearCache();
+	}
+	return loaded;
 }
 
 void FSDirectory::ensureCached() const  {
 	if (_cached)
 		return;
-	cacheDirectoryRecursive(_node, _depth, _prefix);
 	_cached = true;
+
+	if (_indexFile.empty()) {
+		cacheDirectoryRecursive(_node, _depth, _prefix);
+		return;
+	}
+
+	if (loadIndex())
+		return;
+
+	MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+	out.writeUint32BE(MKTAG('D', 'I', 'D', 'X'));
+	out.writeUint32LE(kIndexVersion);
+	out.writeString(_node.getPath().toConfig());
+	out.writeByte(0);
+	out.writeSint32LE(_depth);
+	out.writeByte(_flat ? 1 : 0);
+
+	IndexState index = { nullptr, &out, true };
+	cacheDirectoryRecursive(_node, _depth, _prefix, &index);
+	if (!index.valid)
+		return;
+
+	WriteStream *stream = FSNode(_indexFile).createWriteStream();
+	if (!stream)
+		return;
+	stream->write(out.getData(), out.size());
+	stream->finalize();
+	if (stream->err())
+		warning("FSDirectory: Could not write index '%s'", _indexFile.toString(Common::Path::kNativeSeparator).c_str());
+	delete stream;
 }
 
 bool FSDirectory::getChildren(const Common::Path &path, Common::Array<Common::String> &list, ListMode mode, bool hidden) const {
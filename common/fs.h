@@ -356,11 +356,17 @@ class FSDirectory : public Archive {
 	mutable NodeMapCache	_fileMapCache, _dirMapCache;
 	mutable bool _cached;
 
+	Path	_indexFile; // where the tree listing is kept between runs, if anywhere
+
 	// look for a match
 	FSNode *lookupCache(NodeCache &cache, const Path &name) const;
 
 	// cache management
-	void cacheDirectoryRecursive(FSNode node, int depth, const Path& prefix) const;
+	struct IndexState;
+	bool cacheDirectoryRecursive(FSNode node, int depth, const Path& prefix, IndexState *index = nullptr) const;
+	bool listDirectory(const FSNode &node, FSList &list, IndexState *index) const;
+	bool loadIndex() const;
+	void clearCache() const;
 
 	// fill cache if not already cached
 	void ensureCached() const;
@@ -398,6 +404,18 @@ public:
 	 */
 	FSNode getFSNode() const;
 
+	/**
+	 * Keep the listing of the directory tree in @p indexFile, and build the
+	 * cache from it the next time instead of listing the tree again, as long
+	 * as none of the directories in it were modified since. This makes a
+	 * large tree on a slow file system quicker to open, at the cost of
+	 * checking each directory's modification time.
+	 *
+	 * Does nothing on file systems that do not support it. Must be called
+	 * before the directory is used.
+	 */
+	void setIndexFile(const Path &indexFile);
+
 	/**
 	 * Create a new FSDirectory pointing to a subdirectory of the instance.
 	 * @return A new FSDirectory instance.
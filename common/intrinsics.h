@@ -94,6 +94,26 @@ inline int intLog2(uint32 v) {
 }
 #endif
 
+/**
+ * The number of zero bits below the lowest bit set in a non-zero value,
+ * that is the index of that bit.
+ */
+#if defined(__GNUC__)
+inline int countTrailingZeros(uint32 v) {
+	return __builtin_ctz(v);
+}
+#elif defined(_MSC_VER)
+inline int countTrailingZeros(uint32 v) {
+	unsigned long result = 0;
+	_BitScanForward(&result, v);
+	return result;
+}
+#else
+inline int countTrailingZeros(uint32 v) {
+	return intLog2(v & (0 - v));
+}
+#endif
+
 } // End of namespace Common
 
 #endif // COMMON_INTRINSICS_H
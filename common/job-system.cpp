@@ -0,0 +1,226 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/job-system.h"
+#include "common/textconsole.h"
+
+namespace Common {
+
+JobSystem::JobSystem(JobWorkersInternal *workers, uint numThreads)
+	: _workers(workers), _numThreads(workers ? numThreads : 0),
+	  _groupMutex(nullptr), _idleMutex(nullptr), _idle(0), _quit(false), _inlined(0) {
+	if (_numThreads == 0) {
+		delete _workers;
+		_workers = nullptr;
+		return;
+	}
+
+	_groupMutex = _workers->createMutex();
+	_idleMutex = _workers->createMutex();
+	for (uint i = 0; i <= _numThreads; i++) {
+		Deque *deque = new Deque();
+		deque->mutex = _workers->createMutex();
+		deque->top = deque->bottom = 0;
+		deque->spawned = deque->stolen = 0;
+		_deques.push_back(deque);
+	}
+
+	if (!_workers->start(this, _numThreads)) {
+		warning("JobSystem: Could not start %u worker threads, running jobs serially", _numThreads);
+		stopWorkers();
+		_numThreads = 0;
+	}
+}
+
+JobSystem::~JobSystem() {
+	if (_workers) {
+		if (_numThreads)
+			stopWorkers();
+
+		for (uint i = 0; i < _deques.size(); i++) {
+			assert(_deques[i]->top == _deques[i]->bottom);
+			delete _deques[i]->mutex;
+			delete _deques[i];
+		}
+		delete _groupMutex;
+		delete _idleMutex;
+		delete _workers;
+	}
+}
+
+void JobSystem::stopWorkers() {
+	{
+		StackLock lock(_idleMutex);
+		_quit = true;
+	}
+	for (uint i = 0; i < _numThreads; i++)
+		_workers->signal();
+	_workers->join();
+}
+
+uint JobSystem::getCurrentDeque() {
+	const int worker = _workers->getCurrentWorker();
+	return worker >= 0 ? (uint)worker : _numThreads;
+}
+
+void JobSystem::spawn(JobGroup &group, JobProc proc, void *arg) {
+	if (_numThreads == 0) {
+		_inlined++;
+		proc(arg);
+		return;
+	}
+
+	// Counted first, so that it cannot finish before it is.
+	{
+		StackLock lock(_groupMutex);
+		group._pending++;
+	}
+
+	Deque &deque = *_deques[getCurrentDeque()];
+	bool pushed = false;
+	{
+		StackLock lock(deque.mutex);
+		if (deque.bottom - deque.top < Deque::kSize) {
+			Job &job = deque.jobs[deque.bottom % Deque::kSize];
+			job.proc = proc;
+			job.arg = arg;
+			job.group = &group;
+			deque.bottom++;
+			deque.spawned++;
+			pushed = true;
+		}
+	}
+
+	if (!pushed) {
+		// Too many waiting: the work is better done here than queued.
+		proc(arg);
+		StackLock lock(_groupMutex);
+		group._pending--;
+		_inlined++;
+		return;
+	}
+
+	bool wake;
+	{
+		StackLock lock(_idleMutex);
+		wake = _idle > 0;
+	}
+	if (wake)
+		_workers->signal();
+}
+
+bool JobSystem::findJob(uint self, Job &job) {
+	// Our own newest job first, as it is likely to use what we just used.
+	{
+		Deque &deque = *_deques[self];
+		StackLock lock(deque.mutex);
+		if (deque.bottom != deque.top) {
+			deque.bottom--;
+			job = deque.jobs[deque.bottom % Deque::kSize];
+			return true;
+		}
+	}
+
+	// Otherwise, the oldest job of another thread.
+	for (uint i = 1; i < _deques.size(); i++) {
+		Deque &deque = *_deques[(self + i) % _deques.size()];
+		StackLock lock(deque.mutex);
+		if (deque.bottom != deque.top) {
+			job = deque.jobs[deque.top % Deque::kSize];
+			deque.top++;
+			deque.stolen++;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::runJob(const Job &job) {
+	job.proc(job.arg);
+
+	StackLock lock(_groupMutex);
+	assert(job.group->_pending > 0);
+	job.group->_pending--;
+}
+
+bool JobSystem::isDone(const JobGroup &group) {
+	StackLock lock(_groupMutex);
+	return group._pending == 0;
+}
+
+void JobSystem::wait(JobGroup &group) {
+	if (_numThreads == 0)
+		return;
+
+	const uint self = getCurrentDeque();
+	Job job;
+	while (!isDone(group)) {
+		if (findJob(self, job))
+			runJob(job);
+		else
+			_workers->yield();
+	}
+}
+
+void JobSystem::runWorker(uint index) {
+	Job job;
+	for (;;) {
+		if (findJob(index, job)) {
+			runJob(job);
+			continue;
+		}
+
+		{
+			StackLock lock(_idleMutex);
+			if (_quit)
+				return;
+			_idle++;
+		}
+
+		// Look again: a job spawned before we were counted as idle did not
+		// signal us.
+		const bool found = findJob(index, job);
+		if (!found)
+			_workers->wait();
+
+		{
+			StackLock lock(_idleMutex);
+			_idle--;
+		}
+
+		if (found)
+			runJob(job);
+	}
+}
+
+JobSystem::Stats JobSystem::getStats() const {
+	Stats stats;
+	stats.spawned = stats.stolen = 0;
+	stats.inlined = _inlined;
+	for (uint i = 0; i < _deques.size(); i++) {
+		StackLock lock(_deques[i]->mutex);
+		stats.spawned += _deques[i]->spawned;
+		stats.stolen += _deques[i]->stolen;
+	}
+	return stats;
+}
+
+} // End of namespace Common
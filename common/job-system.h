@@ -0,0 +1,272 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_JOB_SYSTEM_H
+#define COMMON_JOB_SYSTEM_H
+
+#include "common/array.h"
+#include "common/mutex.h"
+#include "common/noncopyable.h"
+#include "common/scummsys.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_job_system Job system
+ * @ingroup common
+ *
+ * @brief A pool of worker threads that run small jobs.
+ *
+ * Each worker has its own deque of jobs: it takes the newest job from its
+ * own, and when that is empty, steals the oldest from another's. A thread
+ * waiting for jobs to finish runs jobs too, so jobs can spawn and wait for
+ * jobs of their own.
+ *
+ * Create one with OSystem::createJobSystem(). Backends that do not support
+ * threads give one that runs every job on the calling thread as it is
+ * spawned, so code using it works the same everywhere.
+ * @{
+ */
+
+class JobSystem;
+
+/** A job: called with the argument it was spawned with. */
+typedef void (*JobProc)(void *arg);
+
+/**
+ * The worker threads of a JobSystem, implemented by a backend.
+ */
+class JobWorkersInternal {
+public:
+	virtual ~JobWorkersInternal() {}
+
+	/**
+	 * Start the worker threads. The i-th one calls system->runWorker(i)
+	 * and ends when it returns.
+	 *
+	 * @return True if all the threads were started.
+	 */
+	virtual bool start(JobSystem *system, uint count) = 0;
+
+	/** Wait for all the worker threads to end. */
+	virtual void join() = 0;
+
+	/** Get the index of the calling worker thread, or -1 for other threads. */
+	virtual int getCurrentWorker() = 0;
+
+	/** Block the calling worker until signal() is called (a semaphore). */
+	virtual void wait() = 0;
+
+	/** Let one wait() return, now or when it is next called. */
+	virtual void signal() = 0;
+
+	/** Give up the rest of the calling thread's time slice. */
+	virtual void yield() = 0;
+
+	/** Create a mutex that works between the worker threads. */
+	virtual MutexInternal *createMutex() = 0;
+};
+
+/**
+ * Jobs that are waited for together with JobSystem::wait().
+ */
+class JobGroup : NonCopyable {
+	friend class JobSystem;
+
+	uint _pending; ///< Spawned, but not yet finished.
+
+public:
+	JobGroup() : _pending(0) {}
+	~JobGroup() { assert(_pending == 0); }
+};
+
+class JobSystem : NonCopyable {
+public:
+	struct Stats {
+		uint32 spawned; ///< Jobs put on a deque.
+		uint32 stolen;  ///< Of those, taken from another thread's deque.
+		uint32 inlined; ///< Jobs run as they were spawned.
+	};
+
+	/**
+	 * Create a job system with @p numThreads worker threads from
+	 * @p workers, which it takes ownership of. Without either, every job
+	 * is run when it is spawned.
+	 */
+	JobSystem(JobWorkersInternal *workers = nullptr, uint numThreads = 0);
+	~JobSystem();
+
+	/** Get the number of worker threads; 0 if jobs are run serially. */
+	uint getNumThreads() const { return _numThreads; }
+
+	bool isSerial() const { return _numThreads == 0; }
+
+	/**
+	 * Add a job to a group. The job may run at once, on this thread, if
+	 * the system is serial or this thread's deque is full.
+	 */
+	void spawn(JobGroup &group, JobProc proc, void *arg);
+
+	/** Run jobs until all of a group's jobs have finished. */
+	void wait(JobGroup &group);
+
+	/**
+	 * Call body(first, last) for consecutive ranges covering [begin, end)
+	 * of at most @p grain elements each, on all the threads, and return
+	 * when all are done. The ranges are split in halves, so that idle
+	 * threads steal the biggest pieces. When serial, they are run in order.
+	 */
+	template<class T>
+	void parallelFor(uint begin, uint end, uint grain, T &body);
+
+	/** Run a() as a job and b() on this thread, and return when both are done. */
+	template<class A, class B>
+	void forkJoin(A &a, B &b);
+
+	/** Get the counts of jobs so far (exact only when none are running). */
+	Stats getStats() const;
+
+	/** The body of the worker threads, for JobWorkersInternal. */
+	void runWorker(uint index);
+
+private:
+	struct Job {
+		JobProc proc;
+		void *arg;
+		JobGroup *group;
+	};
+
+	/**
+	 * A worker's jobs. Its owner pushes and pops at the bottom; other
+	 * threads steal from the top.
+	 */
+	struct Deque {
+		enum {
+			kSize = 1024
+		};
+
+		MutexInternal *mutex;
+		Job jobs[kSize];
+		uint top, bottom; ///< Counting up forever; the index is mod kSize.
+		uint32 spawned, stolen;
+	};
+
+	JobWorkersInternal *_workers;
+	uint _numThreads;
+	Array<Deque *> _deques; ///< One per worker, then one for other threads.
+	MutexInternal *_groupMutex; ///< For JobGroup::_pending.
+	MutexInternal *_idleMutex;  ///< For _idle and _quit.
+	uint _idle;                 ///< Workers that are going to wait().
+	bool _quit;
+	uint32 _inlined;
+
+	void stopWorkers();
+	uint getCurrentDeque();
+	bool findJob(uint self, Job &job);
+	void runJob(const Job &job);
+	bool isDone(const JobGroup &group);
+
+	template<class T>
+	struct ParallelFor {
+		struct Task {
+			ParallelFor *self;
+			uint first, last; ///< Chunks, of _grain elements.
+		};
+
+		JobSystem *_system;
+		JobGroup _group;
+		T *_body;
+		uint _begin, _end, _grain;
+		Array<Task> _tasks; ///< Each chunk's, if it starts a job.
+
+		static void run(void *arg);
+	};
+
+	template<class A>
+	static void runFunctor(void *arg) { (*(A *)arg)(); }
+};
+
+template<class T>
+void JobSystem::ParallelFor<T>::run(void *arg) {
+	const Task *task = (const Task *)arg;
+	ParallelFor *self = task->self;
+	uint first = task->first, last = task->last;
+
+	// Hand the upper halves to other threads, and keep the first chunk.
+	while (last - first > 1) {
+		const uint mid = first + (last - first) / 2;
+		Task &upper = self->_tasks[mid];
+		upper.self = self;
+		upper.first = mid;
+		upper.last = last;
+		self->_system->spawn(self->_group, &run, &upper);
+		last = mid;
+	}
+
+	const uint begin = self->_begin + first * self->_grain;
+	const uint end = self->_end - begin > self->_grain ? begin + self->_grain : self->_end;
+	(*self->_body)(begin, end);
+}
+
+template<class T>
+void JobSystem::parallelFor(uint begin, uint end, uint grain, T &body) {
+	if (begin >= end)
+		return;
+	if (grain == 0)
+		grain = 1;
+
+	const uint chunks = (end - begin + grain - 1) / grain;
+	if (isSerial() || chunks == 1) {
+		while (begin < end) {
+			const uint last = end - begin > grain ? begin + grain : end;
+			body(begin, last);
+			begin = last;
+		}
+		return;
+	}
+
+	ParallelFor<T> job;
+	job._system = this;
+	job._body = &body;
+	job._begin = begin;
+	job._end = end;
+	job._grain = grain;
+	job._tasks.resize(chunks);
+	job._tasks[0].self = &job;
+	job._tasks[0].first = 0;
+	job._tasks[0].last = chunks;
+	ParallelFor<T>::run(&job._tasks[0]);
+	wait(job._group);
+}
+
+template<class A, class B>
+void JobSystem::forkJoin(A &a, B &b) {
+	JobGroup group;
+	spawn(group, &runFunctor<A>, &a);
+	b();
+	wait(group);
+}
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -93,6 +93,10 @@ public:
 	int64 size() const { return _size; }
 
 	bool seek(int64 offs, int whence = SEEK_SET);
+
+	const byte *getDataRange(int64 begin, int64 end) {
+		return (begin >= 0 && begin <= end && end <= _size) ? _ptrOrig.get() + begin : nullptr;
+	}
 };
 
 
@@ -16,6 +16,7 @@ MODULE_OBJS := \
 	fs.o \
 	gui_options.o \
 	hashmap.o \
+	job-system.o \
 	language.o \
 	localization.o \
 	macresman.o \
@@ -292,6 +292,18 @@ bool SeekableSubReadStream::seek(int64 offset, int whence) {
 	return ret;
 }
 
+const byte *SeekableSubReadStream::getDataRange(int64 begin, int64 end) {
+	if (begin < 0 || begin > end || end > size())
+		return nullptr;
+	return _parentStream->getDataRange(_begin + begin, _begin + end);
+}
+
+SeekableReadStream *SeekableSubReadStream::createSubView(int64 begin, int64 end) {
+	if (begin < 0 || begin > end || end > size())
+		return nullptr;
+	return _parentStream->createSubView(_begin + begin, _begin + end);
+}
+
 uint32 SafeSeekableSubReadStream::read(void *dataPtr, uint32 dataSize) {
 	// Make sure the parent stream is at the right position
 	seek(0, SEEK_CUR);
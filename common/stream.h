@@ -792,6 +792,29 @@ public:
 	 */
 	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
 
+	/**
+	 * Obtain a pointer to the bytes [begin, end) of the stream, for streams
+	 * that have all their data in memory (such as memory-mapped files).
+	 * Nothing is copied, and the stream position indicator is not changed.
+	 *
+	 * @return The data, valid as long as the stream is, or nullptr if the
+	 *         range is out of bounds or the stream does not support this.
+	 */
+	virtual const byte *getDataRange(int64 begin, int64 end) { return nullptr; }
+
+	/**
+	 * Create a stream for the bytes [begin, end) of this stream that shares
+	 * its data rather than copying it, such as a part of a memory-mapped file.
+	 * Unlike a SeekableSubReadStream, it has its own position indicator and
+	 * may outlive this stream.
+	 *
+	 * Archives can use it to hand out their members without reading them.
+	 *
+	 * @return The new stream, or nullptr if the range is out of bounds or
+	 *         the stream does not support this.
+	 */
+	virtual SeekableReadStream *createSubView(int64 begin, int64 end) { return nullptr; }
+
 	/**
 	 * Read at most one less than the number of characters specified
 	 * by @p bufSize from the stream and store them in the string buffer.
@@ -86,6 +86,9 @@ public:
 	virtual int64 size() const { return _end - _begin; }
 
 	virtual bool seek(int64 offset, int whence = SEEK_SET);
+
+	virtual const byte *getDataRange(int64 begin, int64 end);
+	virtual SeekableReadStream *createSubView(int64 begin, int64 end);
 };
 
 /**
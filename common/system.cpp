@@ -25,6 +25,7 @@
 #include "common/events.h"
 #include "common/fs.h"
 #include "common/file.h"
+#include "common/job-system.h"
 #include "common/savefile.h"
 #include "common/str.h"
 #include "common/taskbar.h"
@@ -255,6 +256,10 @@ bool OSystem::isConnectionLimited() {
 	return false;
 }
 
+Common::JobSystem *OSystem::createJobSystem(uint numThreads) {
+	return new Common::JobSystem();
+}
+
 Common::TimerManager *OSystem::getTimerManager() {
 	return _timerManager;
 }
@@ -54,6 +54,7 @@ class Store;
 
 namespace Common {
 class EventManager;
+class JobSystem;
 class MutexInternal;
 struct Rect;
 class SaveFileManager;
@@ -1619,6 +1620,28 @@ public:
 	/** @} */
 
 
+	/**
+	 * @defgroup common_system_jobs Job system
+	 * @ingroup common_system
+	 * @{
+	 */
+
+	/**
+	 * Create a job system, to run jobs on a pool of worker threads.
+	 *
+	 * The default implementation returns one that runs every job on the
+	 * calling thread, for backends without threads.
+	 *
+	 * @param numThreads Number of worker threads, or 0 for one less than
+	 *                   the number of CPUs.
+	 *
+	 * @return The newly created job system. The caller owns it.
+	 */
+	virtual Common::JobSystem *createJobSystem(uint numThreads = 0);
+
+	/** @} */
+
+
 
 	/** @defgroup common_system_sound Sound
 	 *  @ingroup common_system
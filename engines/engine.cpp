@@ -27,6 +27,7 @@
 #include "common/config-manager.h"
 #include "common/events.h"
 #include "common/file.h"
+#include "common/fs.h"
 #include "common/system.h"
 #include "common/str.h"
 #include "common/ustr.h"
@@ -224,7 +225,18 @@ Engine::~Engine() {
 }
 
 void Engine::initializePath(const Common::FSNode &gamePath) {
-	SearchMan.addDirectory(gamePath, 0, 4);
+	if (!gamePath.exists() || !gamePath.isDirectory())
+		return;
+
+	Common::FSDirectory *dir = new Common::FSDirectory(gamePath, 4);
+
+	// Listing a big game directory again at each launch can be slow, so
+	// keep the listing where the backend lets us
+	const Common::Path indexPath = ConfMan.getPath("dirindexpath");
+	if (!indexPath.empty())
+		dir->setIndexFile(indexPath.join(Common::String::format("%08x.idx", gamePath.getPath().hash())));
+
+	SearchMan.add(gamePath.getPath().toString(), dir, 0);
 }
 
 bool Engine::enhancementEnabled(int32 cls) {
@@ -34,7 +34,9 @@
 #include "ignore_unused_variable_warning.h"
 #include "monstinf.h"
 #include "party.h"
+#include "pathqueue.h"
 #include "paths.h"
+#include "schedule.h"
 #include "ucmachine.h"
 
 #include <cstdlib>
@@ -168,6 +170,9 @@ Path_walking_actor_action::Path_walking_actor_action(
  */
 
 Path_walking_actor_action::~Path_walking_actor_action() {
+	if (path_ticket >= 0) {
+		Path_request_queue::get_instance()->cancel(path_ticket);
+	}
 	delete path;
 	delete subseq;
 	subseq       = nullptr;    // (Debugging).
@@ -203,6 +208,27 @@ Path_walking_actor_action* Path_walking_actor_action::create_path(
  */
 
 int Path_walking_actor_action::handle_event(Actor* actor) {
+	if (path_ticket >= 0) {    // Still looking for a path?
+		std::vector<Tile_coord> found;
+		switch (Path_request_queue::get_instance()->poll(path_ticket, found)) {
+		case Path_request_queue::pending:
+			return 100;    // Check back later.
+		case Path_request_queue::found:
+			path_ticket = -1;
+			static_cast<Astar*>(path)->set_path(
+					path->get_src(), path->get_dest(), std::move(found));
+			break;
+		case Path_request_queue::failed:
+			path_ticket = -1;
+			if (Schedule* schedule = actor->get_schedule()) {
+				schedule->path_not_found();
+			}
+			return 0;
+		default:
+			path_ticket = -1;
+			return 0;
+		}
+	}
 	if (subseq) {    // Going through a door?
 		const int delay = subseq->handle_event(actor);
 		if (delay) {
@@ -449,6 +475,10 @@ Actor_action* Path_walking_actor_action::walk_to_tile(
 		int               dist,    // Distance to get to within dest.
 		bool ignnpc    // If pathfinder should ignore NPCs in many cases.
 ) {
+	if (path_ticket >= 0) {    // Forget earlier search.
+		Path_request_queue::get_instance()->cancel(path_ticket);
+		path_ticket = -1;
+	}
 	blocked        = 0;        // Clear 'blocked' count.
 	reached_end    = false;    // Starting new path.
 	get_party      = false;
@@ -489,7 +519,7 @@ Actor_action* Path_walking_actor_action::walk_to_tile(
 		if (!path->set_backwards()) {
 			return nullptr;
 		}
-	} else {
+	} else if (!async_ok || !find_path_async(npc, src, dest, dist, ignnpc)) {
 		Actor_pathfinder_client cost(npc, dist, ignnpc);
 		if (!path->NewPath(src, dest, &cost)) {
 			return nullptr;
@@ -501,6 +531,52 @@ Actor_action* Path_walking_actor_action::walk_to_tile(
 	return this;
 }
 
+/*
+ *  Paths longer than this are looked for on Path_request_queue's threads.
+ */
+const int c_async_path_dist = 24;
+
+/**
+ *  Start searching for a path on Path_request_queue's threads, if it's
+ *  far enough to be worth it but near enough not to be planned by chunk.
+ *  handle_event() waits for the result, and ends the action if there's no
+ *  path.
+ *
+ *  @return     true if queued.
+ */
+
+bool Path_walking_actor_action::find_path_async(
+		Actor* npc, const Tile_coord& src, const Tile_coord& dest, int dist,
+		bool ignnpc) {
+	auto*               astar = dynamic_cast<Astar*>(path);
+	const int           len   = src.distance_2d(dest);
+	Path_request_queue* queue = Path_request_queue::get_instance();
+	if (!astar || len <= c_async_path_dist || len > Astar::c_long_path_dist
+		|| !queue || !queue->is_enabled()) {
+		return false;
+	}
+	Game_window* gwin     = Game_window::get_instance();
+	auto         snapshot = std::make_shared<const Path_snapshot>(
+            gwin->get_map(), src, dest, ignnpc);
+	if (!snapshot->is_valid()) {
+		return false;
+	}
+	const Shape_info& info  = npc->get_info();
+	const int         frame = npc->get_framenum();
+	const Path_request request{
+			src,
+			dest,
+			npc->get_type_flags(),
+			info.get_3d_xtiles(frame),
+			info.get_3d_ytiles(frame),
+			info.get_3d_height(),
+			dist,
+			(gwin->get_width() / c_tilesize) * 2 * 3};
+	path_ticket = queue->submit(request, std::move(snapshot));
+	astar->set_path(src, dest, {});    // So get_dest() works meanwhile.
+	return true;
+}
+
 /**
  *  Return current destination.
  *
@@ -130,12 +130,18 @@ private:
 	unsigned char    blocked_frame = 0;             // Frame for blocked tile.
 	unsigned char    persistence;
 	Tile_coord       blocked_tile;    // Tile to retry.
-	
+	int              path_ticket = -1;    // Path_request_queue search.
+	bool             async_ok    = false;    // May find path in background.
+
 	void set_subseq(Actor_action* sub) {
 		delete subseq;
 		subseq = sub;
 	}
 
+	bool find_path_async(
+			Actor* npc, const Tile_coord& src, const Tile_coord& dest,
+			int dist, bool ignnpc);
+
 public:
 	Path_walking_actor_action(
 			PathFinder* p = nullptr, int maxblk = 3, int pers = 0);
@@ -147,6 +153,12 @@ public:
 	int  handle_event(Actor* actor) override;
 	bool open_door(Actor* actor, Game_object* door);
 	void stop(Actor* actor) override;    // Stop moving.
+	// Let walk_to_tile() return before a path is found, for callers that
+	//   can live with the action ending at once if there isn't one.
+	void allow_async_path() {
+		async_ok = true;
+	}
+
 	// Set simple path to destination.
 	Actor_action* walk_to_tile(
 			Actor* npc, const Tile_coord& src, const Tile_coord& dest,
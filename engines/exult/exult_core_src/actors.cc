@@ -1314,10 +1314,16 @@ int Actor::walk_path_to_tile(
 		int               speed,    // Time between frames (msecs).
 		int               delay,    // Delay before starting (msecs) (only
 		//   if not already moving).
-		int dist,     // Distance to get within dest.
-		int maxblk    // Max. # retries if blocked.
+		int  dist,      // Distance to get within dest.
+		int  maxblk,    // Max. # retries if blocked.
+		bool async      // Caller can handle finding out later that it
+						//   failed.
 ) {
-	set_action(new Path_walking_actor_action(new Astar(), maxblk));
+	auto* walk = new Path_walking_actor_action(new Astar(), maxblk);
+	if (async) {
+		walk->allow_async_path();
+	}
+	set_action(walk);
 	set_action(action->walk_to_tile(this, src, dest, dist));
 	if (action) {    // Successful at setting path?
 		start(speed, delay);
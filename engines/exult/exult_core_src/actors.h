@@ -423,10 +423,11 @@ public:
 		walk_to_tile(Tile_coord(tx, ty, tz), speed, delay, maxblk);
 	}
 
-	// Get there, avoiding obstacles.
+	// Get there, avoiding obstacles.  If async, the path may be found in
+	//   the background, and the walk just ends if there isn't one.
 	int walk_path_to_tile(
 			const Tile_coord& src, const Tile_coord& dest, int speed = 250,
-			int delay = 0, int dist = 0, int maxblk = 3);
+			int delay = 0, int dist = 0, int maxblk = 3, bool async = false);
 
 	int walk_path_to_tile(
 			const Tile_coord& dest, int speed = 250, int delay = 0,
@@ -893,6 +894,7 @@ using Main_actor_shared = std::shared_ptr<Main_actor>;
 class Npc_actor : public Actor {
 	bool nearby;    // Queued as a 'nearby' NPC.  This is
 					//   to avoid being added twice.
+	Time_queue::Handle nearby_entry;    // Its entry in the time queue.
 protected:
 	unsigned char    num_schedules;    // # entries below.
 	Schedule_change* schedules;        // List of schedule changes.
@@ -914,6 +916,14 @@ public:
 		return nearby;
 	}
 
+	void set_nearby_entry(Time_queue::Handle entry) {
+		nearby_entry = entry;
+	}
+
+	Time_queue::Handle get_nearby_entry() const {
+		return nearby_entry;
+	}
+
 	// Set schedule list.
 	void set_schedules(Schedule_change* list, int cnt) override;
 	void set_schedule_time_type(int time, int type) override;
@@ -20,10 +20,12 @@
 
 #include "Audio.h"
 
+#include "AudioChannel.h"
 #include "AudioMixer.h"
 #include "AudioSample.h"
 #include "Configuration.h"
 #include "Flex.h"
+#include "RawAudioSample.h"
 #include "actors.h"
 #include "conv.h"
 #include "databuf.h"
@@ -39,6 +41,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <climits>
 #include <cstdio>
 #include <cstdlib>
@@ -76,6 +79,18 @@ const int* Audio::bg2si_songs = nullptr;
 
 //----- SFX ----------------------------------------------------------
 
+SFX_cache_manager::SFX_cache_manager() : generation(0) {
+	int kb;
+	config->value("config/audio/effects/cache_kb", kb, 8192);
+	budget = static_cast<size_t>(std::max(kb, 0)) * 1024;
+}
+
+SFX_cache_manager::~SFX_cache_manager() {
+	cancel_jobs();
+	jobs.reset();    // Waits.  Those not started are skipped.
+	flush();
+}
+
 // Tries to locate a sfx in the cache based on sfx num.
 SFX_cache_manager::SFX_cached* SFX_cache_manager::find_sfx(int id) {
 	auto found = cache.find(id);
@@ -85,102 +100,241 @@ SFX_cache_manager::SFX_cached* SFX_cache_manager::find_sfx(int id) {
 	return &(found->second);
 }
 
-SFX_cache_manager::~SFX_cache_manager() {
-	flush();
+// Add a decoded sfx to the cache, as the most recently used.
+void SFX_cache_manager::add(int id, AudioSample* sample, size_t bytes) {
+	lru.push_front(id);
+	cache[id] = SFX_cached{sample, bytes, lru.begin(), false};
+	stats.bytes += bytes;
+	stats.peak_bytes = std::max(stats.peak_bytes, stats.bytes);
 }
 
-// For SFX played through 'play_wave_sfx'. Searched cache for
-// the sfx first, then loads from the sfx file if needed.
-AudioSample* SFX_cache_manager::request(Flex* sfx_file, int id) {
-	SFX_cached* loaded = find_sfx(id);
-	if (!loaded) {
-		SFX_cached& new_sfx = cache[id];
-		new_sfx.first       = 0;
-		new_sfx.second      = nullptr;
-		loaded              = &new_sfx;
+// Move what has been decoded ahead into the cache.  They're about to be
+// played, so they're added as the most recently used, and older ones are
+// dropped if that goes over the budget.
+void SFX_cache_manager::take_ready() {
+	std::map<int, Decoded> done;
+	{
+		const std::lock_guard<std::mutex> lock(mutex);
+		done.swap(ready);
+		ready_bytes = 0;
 	}
-
-	if (!loaded->second) {
-		garbage_collect();
-
-		size_t wavlen;    // Read .wav file.
-		auto   wavbuf = sfx_file->retrieve(id, wavlen);
-		loaded->second
-				= AudioSample::createAudioSample(std::move(wavbuf), wavlen);
+	if (done.empty()) {
+		return;
 	}
-
-	if (!loaded->second) {
-		return nullptr;
+	for (auto& [id, decoded] : done) {
+		if (find_sfx(id)) {    // Decoded when it was played.
+			decoded.sample->Release();
+		} else {
+			add(id, decoded.sample, decoded.bytes);
+		}
 	}
+	evict();
+}
 
-	// Increment counter
-	++loaded->first;
-
-	return loaded->second;
+// Drop sfx waiting to be decoded, and those decoded.
+void SFX_cache_manager::cancel_jobs() {
+	const std::lock_guard<std::mutex> lock(mutex);
+	generation++;    // So those being decoded are dropped, too.
+	queued.clear();
+	for (auto& [id, decoded] : ready) {
+		decoded.sample->Release();
+	}
+	ready.clear();
+	ready_bytes = 0;
 }
 
-// Empties the cache.
-void SFX_cache_manager::flush(AudioMixer* mixer) {
-	for (auto it = cache.begin(); it != cache.end(); it = cache.begin()) {
-		if (it->second.second) {
-			if (it->second.second->getRefCount() != 1 && mixer) {
-				mixer->stopSample(it->second.second);
-			}
-			it->second.second->Release();
+// Decode a sfx, and convert it to the mixer's rate and channels.
+SFX_cache_manager::Decoded SFX_cache_manager::decode(
+		std::unique_ptr<uint8[]> data, size_t len, uint32 rate, bool stereo) {
+	AudioSample* sample = AudioSample::createAudioSample(std::move(data), len);
+	if (!sample) {
+		return Decoded{nullptr, 0};
+	}
+	// Play it through a channel of our own, which does the resampling as
+	// the mixer would.
+	AudioChannel channel(rate, stereo);
+	channel.playSample(
+			sample, 0, 0, false, AUDIO_DEF_PITCH, AUDIO_MAX_VOLUME,
+			AUDIO_MAX_VOLUME, -1);
+	const size_t frame_bytes = stereo ? 4 : 2;
+	// Its length is known once it's started.  The resampler runs a little
+	// past it, and stops if the buffer ends as the sample does.
+	size_t bytes = (uint64(sample->getPlaybackLength()) * rate
+						/ std::max<uint32>(sample->getRate(), 1)
+					+ 16)
+				   * frame_bytes;
+	sample->Release();    // The channel has it.
+	// Mixed into, so it starts as silence (which make_unique() gives).
+	auto   buf  = std::make_unique<uint8[]>(bytes);
+	size_t done = 0;
+	while (channel.isPlaying()) {
+		if (done == bytes) {    // Length was wrong.  Add 1/10 sec.
+			const size_t more  = (rate / 10) * frame_bytes;
+			auto         grown = std::make_unique<uint8[]>(bytes + more);
+			std::memcpy(grown.get(), buf.get(), bytes);
+			buf = std::move(grown);
+			bytes += more;
 		}
-		it->second.second = nullptr;
-		cache.erase(it);
+		channel.resampleAndMix(
+				reinterpret_cast<sint16*>(buf.get() + done), bytes - done);
+		done = bytes;
 	}
+	return Decoded{
+			new RawAudioSample(std::move(buf), bytes, rate, true, stereo, 16),
+			bytes};
 }
 
-// Remove unused sounds from the cache.
-void SFX_cache_manager::garbage_collect() {
-	// Maximum 'stable' number of sounds we will cache (actual
-	// count may be higher if all of the cached sounds are
-	// being played).
-	const int max_fixed = 6;
-
-	std::multiset<int> sorted;
-
-	for (auto& it : cache) {
-		if (it.second.second && it.second.second->getRefCount() == 1) {
-			sorted.insert(it.second.first);
+// Decode a sfx on one of the job system's threads.
+void SFX_cache_manager::run_job(void* arg) {
+	std::unique_ptr<Job> job(static_cast<Job*>(arg));
+	SFX_cache_manager*   cache = job->cache;
+	// Is it still wanted?
+	auto wanted = [&job, cache]() {
+		return job->generation == cache->generation
+			   && cache->queued.count(job->id);
+	};
+	{
+		const std::lock_guard<std::mutex> lock(cache->mutex);
+		if (!wanted()) {
+			return;
 		}
 	}
-
-	if (sorted.empty()) {
+	const Decoded decoded
+			= decode(std::move(job->data), job->len, job->rate, job->stereo);
+	const std::lock_guard<std::mutex> lock(cache->mutex);
+	if (!wanted()) {
+		if (decoded.sample) {
+			decoded.sample->Release();
+		}
+		return;
+	}
+	cache->queued.erase(job->id);
+	if (!decoded.sample) {
+		return;
+	}
+	// Older ones are dropped for those decoded ahead (see evict()), but
+	// these can't take more than the whole budget by themselves.
+	if (cache->ready_bytes + decoded.bytes > cache->budget) {
+		decoded.sample->Release();
 		return;
 	}
+	cache->ready[job->id] = decoded;
+	cache->ready_bytes += decoded.bytes;
+}
 
-	int threshold = INT_MAX;
-	int count     = 0;
+// Set the mixer's rate and channels, which SFX are converted to.
+void SFX_cache_manager::set_output(uint32 rate_, bool stereo_) {
+	if (rate_ == rate && stereo_ == stereo) {
+		return;
+	}
+	flush();
+	const std::lock_guard<std::mutex> lock(mutex);
+	rate   = rate_;
+	stereo = stereo_;
+}
 
-	for (auto it = sorted.rbegin(); it != sorted.rend(); ++it) {
-		if (count < max_fixed) {
-			threshold = *it;
-			count++;
-		} else if (*it == threshold) {
-			count++;
+// For SFX played through 'play_wave_sfx'. Searched cache for
+// the sfx first, then loads from the sfx file if needed.
+AudioSample* SFX_cache_manager::request(Flex* sfx_file, int id) {
+	take_ready();
+	SFX_cached* loaded = find_sfx(id);
+	if (loaded) {
+		if (loaded->used) {
+			stats.hits++;
 		} else {
-			break;
+			stats.prefetched++;
 		}
+		loaded->used = true;
+		lru.splice(lru.begin(), lru, loaded->lru_pos);
+		return loaded->sample;
+	}
+	garbage_collect();    // Make room first, so this one stays.
+	size_t     wavlen;    // Read .wav file.
+	auto       wavbuf  = sfx_file->retrieve(id, wavlen);
+	const auto decoded = decode(std::move(wavbuf), wavlen, rate, stereo);
+	if (!decoded.sample) {
+		return nullptr;
 	}
+	stats.misses++;
+	add(id, decoded.sample, decoded.bytes);
+	cache[id].used = true;
+	return decoded.sample;
+}
 
-	if (count <= max_fixed) {
+// Start decoding a sfx that may be played soon.
+void SFX_cache_manager::prefetch(Flex* sfx_file, int id) {
+	if (!budget || no_threads) {
+		return;
+	}
+	take_ready();    // So those done don't wait outside the cache.
+	if (find_sfx(id)) {
 		return;
 	}
+	if (!jobs) {
+		jobs = std::make_unique<Job_pool>(1);
+		if (jobs->is_serial()) {
+			// Decoding now, on this thread, is no better than when played.
+			jobs.reset();
+			no_threads = true;
+			return;
+		}
+	}
+	unsigned gen;
+	{
+		const std::lock_guard<std::mutex> lock(mutex);
+		if (ready.count(id) || !queued.insert(id).second) {
+			return;
+		}
+		gen = generation;
+	}
+	size_t wavlen;    // Read .wav file.
+	auto   wavbuf = sfx_file->retrieve(id, wavlen);
+	jobs->spawn(
+			&SFX_cache_manager::run_job,
+			new Job{this, id, gen, std::move(wavbuf), wavlen, rate, stereo});
+}
 
-	for (auto& it : cache) {
-		if (it.second.second) {
-			if (it.second.first < threshold) {
-				it.second.second->Release();
-				it.second.second = nullptr;
-			} else if (it.second.first == threshold && count > max_fixed) {
-				it.second.second->Release();
-				it.second.second = nullptr;
-				count--;
-			}
+// Empties the cache.
+void SFX_cache_manager::flush(AudioMixer* mixer) {
+	cancel_jobs();
+	for (auto& [id, cached] : cache) {
+		if (cached.sample->getRefCount() != 1 && mixer) {
+			mixer->stopSample(cached.sample);
 		}
+		cached.sample->Release();
+	}
+	cache.clear();
+	lru.clear();
+	stats.bytes = 0;
+}
+
+// Remove unused sounds from the cache, to get within the budget.
+void SFX_cache_manager::garbage_collect() {
+	take_ready();
+	evict();
+}
+
+// Drop the least recently used sounds until within the budget, counting
+// those decoded ahead, which are to be added.  Those being played stay (so
+// it may take more).
+void SFX_cache_manager::evict() {
+	size_t pending;
+	{
+		const std::lock_guard<std::mutex> lock(mutex);
+		pending = ready_bytes;
+	}
+	for (auto it = lru.end();
+		 it != lru.begin() && stats.bytes + pending > budget;) {
+		--it;
+		auto found = cache.find(*it);
+		if (found->second.sample->getRefCount() != 1) {
+			continue;    // Playing.
+		}
+		found->second.sample->Release();
+		stats.bytes -= found->second.bytes;
+		stats.evicted++;
+		cache.erase(found);
+		it = lru.erase(it);
 	}
 }
 
@@ -266,6 +420,7 @@ void Audio::Init(int _samplerate, int _channels) {
 
 	mixer = std::make_unique<AudioMixer>(
 			_samplerate, _channels == 2, MIXER_CHANNELS);
+	sfxs->set_output(mixer->getSampleRate(), mixer->getStereo());
 
 	COUT("Audio initialisation OK");
 
@@ -709,6 +864,24 @@ int Audio::play_wave_sfx(
 	return instance_id;
 }
 
+/*
+ *	Have a .wav sfx decoded ahead, since it may be played soon.
+ */
+void Audio::prefetch_sound_effect(int num) {
+	if (!audio_enabled || !effects_enabled || !sfx_file || !mixer || num < 0
+		|| static_cast<unsigned>(num) >= sfx_file->number_of_objects()) {
+		return;
+	}
+#ifdef ENABLE_MIDISFX
+	string v;
+	config->value("config/audio/effects/midi", v, "no");
+	if (v != "no" && mixer->getMidiPlayer()) {
+		return;
+	}
+#endif
+	sfxs->prefetch(sfx_file.get(), num);
+}
+
 /*
  *	This returns a 'unique' ID, but only for .wav SFX's (for now).
  */
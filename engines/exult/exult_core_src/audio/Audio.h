@@ -34,10 +34,14 @@
 #include "Midi.h"
 #include "exceptions.h"
 #include "exult_constants.h"
+#include "jobpool.h"
 
 #include <functional>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <vector>
 
 namespace Pentagram {
@@ -46,7 +50,6 @@ namespace Pentagram {
 struct File_spec;
 class Game_object;
 class MyMidiPlayer;
-class SFX_cached;
 class Tile_coord;
 
 #define MAX_SOUND_FALLOFF 24
@@ -65,33 +68,96 @@ enum Combat_song {
 };
 
 /*
- *	This is a resource-management class for SFX. Maybe make it a
- *	template class and use for other resources also?
- *	Based on code by Sam Lantinga et al on:
- *	http://www.ibm.com/developerworks/library/l-pirates2/
+ *	This is a resource-management class for SFX.  They are kept already
+ *	decoded and resampled to the mixer's rate (16 bit, with its number of
+ *	channels), so playing one only has to mix it in.  The least recently
+ *	used ones that aren't playing are dropped when all take more than the
+ *	budget ("config/audio/effects/cache_kb").  Those that objects nearby
+ *	may play are decoded ahead, as jobs on a Job_pool, and count against
+ *	the budget from when they're done.
  */
 class SFX_cache_manager {
-	using SFX_cached = std::pair<int, Pentagram::AudioSample*>;
+	struct SFX_cached {
+		Pentagram::AudioSample*  sample;
+		size_t                   bytes;      // Size of decoded data.
+		std::list<int>::iterator lru_pos;    // In 'lru'.
+		bool                     used;       // False if only prefetched.
+	};
+
+	struct Job {
+		SFX_cache_manager*       cache;
+		int                      id;
+		unsigned                 generation;    // Dropped if it changed.
+		std::unique_ptr<uint8[]> data;          // As read from the sfx file.
+		size_t                   len;
+		uint32                   rate;
+		bool                     stereo;
+	};
+
+	struct Decoded {
+		Pentagram::AudioSample* sample;
+		size_t                  bytes;
+	};
+
+public:
+	struct Stats {
+		unsigned long hits       = 0;    // Found in the cache.
+		unsigned long prefetched = 0;    // Decoded ahead before needed.
+		unsigned long misses     = 0;    // Decoded when played.
+		unsigned long evicted    = 0;
+		size_t        bytes      = 0;    // Now cached.
+		size_t        peak_bytes = 0;
+	};
 
+private:
 	std::map<int, SFX_cached> cache;
+	std::list<int>            lru;    // Most recently used first.
+	size_t                    budget;
+	uint32                    rate   = 22050;    // Mixer's.
+	bool                      stereo = true;
+	Stats                     stats;
+
+	std::unique_ptr<Job_pool> jobs;    // Created when first needed.
+	bool                      no_threads = false;    // Then don't prefetch.
+
+	std::mutex             mutex;         // Protects all below.
+	std::set<int>          queued;        // Not yet decoded.
+	std::map<int, Decoded> ready;         // Decoded ahead.
+	size_t                 ready_bytes = 0;    // Taken by 'ready'.
+	unsigned               generation;    // Changed when jobs are cancelled.
 
 	// Tries to locate a sfx in the cache based on sfx num.
 	SFX_cached* find_sfx(int id);
+	void        add(int id, Pentagram::AudioSample* sample, size_t bytes);
+	void        take_ready();
+	void        cancel_jobs();
+	void        evict();
+	static void run_job(void* arg);
+
+	static Decoded decode(
+			std::unique_ptr<uint8[]> data, size_t len, uint32 rate,
+			bool stereo);
 
 public:
-	SFX_cache_manager() = default;
+	SFX_cache_manager();
 	~SFX_cache_manager();
-	SFX_cache_manager(const SFX_cache_manager&)            = default;
-	SFX_cache_manager(SFX_cache_manager&&)                 = default;
-	SFX_cache_manager& operator=(const SFX_cache_manager&) = default;
-	SFX_cache_manager& operator=(SFX_cache_manager&&)      = default;
+	SFX_cache_manager(const SFX_cache_manager&)            = delete;
+	SFX_cache_manager& operator=(const SFX_cache_manager&) = delete;
+	// Set the mixer's rate and channels, which SFX are converted to.
+	void set_output(uint32 rate, bool stereo);
 	// For SFX played through 'play_wave_sfx'. Searched cache for
 	// the sfx first, then loads from the sfx file if needed.
 	Pentagram::AudioSample* request(Flex* sfx_file, int id);
+	// Start decoding a sfx that may be played soon.
+	void prefetch(Flex* sfx_file, int id);
 	// Empties the cache.
 	void flush(Pentagram::AudioMixer* mixer = nullptr);
-	// Remove unused sounds from the cache.
+	// Remove unused sounds from the cache, to get within the budget.
 	void garbage_collect();
+
+	const Stats& get_stats() const {
+		return stats;
+	}
 };
 
 //---- Audio -----------------------------------------------------------
@@ -178,6 +244,8 @@ public:
 	int play_sound_effect(
 			int num, const Tile_coord& tile, int volume = AUDIO_MAX_VOLUME,
 			int repeat = 0);
+	// Have a sfx decoded ahead, since it may be played soon.
+	void prefetch_sound_effect(int num);
 	// These two do not cache the SFX, and play it directly from the file.
 	int play_sound_effect(
 			const File_spec& sfxfile, int num, int volume = AUDIO_MAX_VOLUME,
@@ -149,8 +149,11 @@ namespace Pentagram {
 		do {
 			int startpos = position;
 
-			// 8 bit resampling
-			if (sample->getBits() == 8) {
+			// Already at our rate, as the SFX cache makes them?
+			if (sample->getBits() == 16 && sample->isStereo() == stereo
+				&& fp_speed == 0x10000) {
+				mixFrame16(stream, bytes);
+			} else if (sample->getBits() == 8) {    // 8 bit resampling
 				if (!sample->isStereo() && stereo) {
 					resampleFrameM8toS(
 							stream, bytes);    // Mono Sample to Stereo Output
@@ -239,6 +242,53 @@ namespace Pentagram {
 		}
 	}
 
+	// Mix a frame of 16bit that's at our rate and channels, so there's no
+	// need to resample it.
+	void AudioChannel::mixFrame16(sint16*& stream, uint32& bytes) {
+		uint8* src     = frames[frame_evenodd] + position;
+		uint8* src_end = frames[frame_evenodd] + frame0_size;
+
+		int lvol = this->lvol;
+		int rvol = this->rvol;
+
+		calculate2DVolume(lvol, rvol);
+
+		if (!stereo) {
+			const int volume = (rvol + lvol) / 2;
+			for (; bytes != 0 && src != src_end; src += 2, bytes -= 2) {
+				int result = *stream + (ReadSample(src) * volume) / 256;
+				if (result < -32768) {
+					result = -32768;
+				} else if (result > 32767) {
+					result = 32767;
+				}
+				*stream++ = result;
+			}
+		} else {
+			for (; bytes != 0 && src != src_end; src += 4, bytes -= 4) {
+				int lresult = *(stream + 0) + (ReadSample(src) * lvol) / 256;
+				int rresult
+						= *(stream + 1) + (ReadSample(src + 2) * rvol) / 256;
+				if (lresult < -32768) {
+					lresult = -32768;
+				} else if (lresult > 32767) {
+					lresult = 32767;
+				}
+
+				if (rresult < -32768) {
+					rresult = -32768;
+				} else if (rresult > 32767) {
+					rresult = 32767;
+				}
+
+				*stream++ = lresult;
+				*stream++ = rresult;
+			}
+		}
+
+		position = frame0_size - (src_end - src);
+	}
+
 	//
 	// 8 Bit
 	//
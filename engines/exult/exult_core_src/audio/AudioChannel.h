@@ -235,6 +235,7 @@ namespace Pentagram {
 		int               fp_pos   = 0;
 		int               fp_speed = 0;
 
+		void mixFrame16(sint16*& stream, uint32& bytes);
 		void resampleFrameM8toS(sint16*& stream, uint32& bytes);
 		void resampleFrameM8toM(sint16*& stream, uint32& bytes);
 		void resampleFrameS8toM(sint16*& stream, uint32& bytes);
@@ -26,7 +26,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "AudioMixer.h"
 #include "LowLevelMidiDriver.h"
 #include "MidiDriver.h"
+#include "MidiEventCache.h"
 #include "OggAudioSample.h"
+#include "XMidiEventList.h"
 #include "conv.h"
 #include "convmusic.h"
 #include "data/exult_flx.h"
@@ -207,15 +209,18 @@ bool MyMidiPlayer::start_music(
 		return false;
 	}
 
-	XMidiFile midfile(
-			mid_data.get(), setup_timbre_for_track(flex),
-			midi_driver->getName());
+	const int   convert = setup_timbre_for_track(flex);
+	std::string name    = get_system_path(flex);
+	name += ':';
+	name += std::to_string(num);
+	XMidiEventList* eventlist = get_event_cache().get(
+			mid_data.get(), name, 0, convert, midi_driver->getName());
 
 	// Now give the xmidi object to the midi device
 
-	XMidiEventList* eventlist = midfile.GetEventList(0);
 	if (eventlist) {
 		midi_driver->startSequence(SEQ_NUM_MUSIC, eventlist, repeat, 255);
+		eventlist->decrementCounter();
 		return true;
 	}
 	return false;
@@ -289,13 +294,15 @@ bool MyMidiPlayer::start_music(
 		return false;
 	}
 
-	XMidiFile midfile(
-			&mid_data, setup_timbre_for_track(fname), midi_driver->getName());
+	const int       convert   = setup_timbre_for_track(fname);
+	XMidiEventList* eventlist = get_event_cache().get(
+			&mid_data, get_system_path(fname), num, convert,
+			midi_driver->getName());
 
 	// Now give the xmidi object to the midi device
-	XMidiEventList* eventlist = midfile.GetEventList(num);
 	if (eventlist) {
 		midi_driver->startSequence(SEQ_NUM_MUSIC, eventlist, repeat, 255);
+		eventlist->decrementCounter();
 		return true;
 	}
 	return false;
@@ -841,6 +848,16 @@ MyMidiPlayer::MyMidiPlayer() {
 	init_device(false);
 }
 
+MidiEventCache& MyMidiPlayer::get_event_cache() {
+	if (!event_cache) {
+		string s;
+		config->value("config/audio/midi/event_cache", s, "yes");
+		event_cache = std::make_unique<MidiEventCache>(
+				s == "no" ? string() : string(XMIDICACHE));
+	}
+	return *event_cache;
+}
+
 MyMidiPlayer::~MyMidiPlayer() {
 	ogg_stop_track();
 	if (midi_driver) {
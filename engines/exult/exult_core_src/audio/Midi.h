@@ -25,10 +25,12 @@
 #include "exult_constants.h"
 #include "fnames.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
 class MidiDriver;
+class MidiEventCache;
 
 namespace Pentagram {
 	class AudioSample;
@@ -160,6 +162,11 @@ private:
 	int           effects_conversion = XMIDIFILE_CONVERT_GS127_TO_GS;
 	int           setup_timbre_for_track(std::string& str);
 
+	// Music converted for the driver, kept in XMIDICACHE unless
+	//   "config/audio/midi/event_cache" is "no".
+	std::unique_ptr<MidiEventCache> event_cache;
+	MidiEventCache&                 get_event_cache();
+
 	// Ogg Stuff
 	bool        ogg_enabled     = false;
 	sint32      ogg_instance_id = -1;
@@ -0,0 +1,241 @@
+/*
+ *  MidiEventCache.cc - Music tracks kept as the event lists they convert to.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+// Includes Pentagram headers so we must include pent_include.h
+#include "pent_include.h"
+
+#include "MidiEventCache.h"
+
+#include "XMidiEventList.h"
+#include "XMidiFile.h"
+#include "crc.h"
+#include "databuf.h"
+#include "exceptions.h"
+#include "utils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+/*
+ *  XMIDICACHE is:
+ *      4 bytes:    "XMEC".
+ *      4 bytes:    Version.
+ *      4 bytes:    Number of lists.
+ *  Then for each list:
+ *      2 bytes:    Length of key.
+ *      n bytes:    Key.
+ *      4 bytes:    CRC of the data it was converted from.
+ *      4 bytes:    CRC of the list.
+ *      4 bytes:    Offset of the list in the file.
+ *      4 bytes:    Length of the list.
+ *      2 bytes:    Number of times the cache was saved without it being used.
+ *  Then the lists, as written by XMidiEventList::serialize().
+ */
+namespace {
+	const char   cache_magic[4]    = {'X', 'M', 'E', 'C'};
+	const uint32 cache_version     = 2;
+	const size_t header_size       = 12;
+	const size_t index_header_size = 20;    // Not counting the key.
+	// Lists not used in this many saves are dropped, so those of tracks whose
+	// data or settings changed don't stay in the file for good.
+	const unsigned max_unused_saves = 8;
+}    // namespace
+
+MidiEventCache::MidiEventCache(std::string name) : fname(std::move(name)) {}
+
+MidiEventCache::~MidiEventCache() {
+	if (dirty) {
+		save();
+	}
+}
+
+/*
+ *  Read the index.  The lists are read too, but left as they are until used.
+ */
+
+void MidiEventCache::load() {
+	loaded = true;
+	if (fname.empty() || !U7exists(fname)) {
+		return;
+	}
+	IFileDataSource ds(fname);
+	if (!ds.good()) {
+		return;
+	}
+	const size_t size = ds.getSize();
+	if (size < header_size) {
+		return;
+	}
+	file_data = ds.readN(size);
+	IBufferDataView index(file_data, size);
+	char            magic[sizeof(cache_magic)];
+	index.read(magic, sizeof(magic));
+	if (std::memcmp(magic, cache_magic, sizeof(magic)) != 0
+		|| index.read4() != cache_version) {
+		file_data.reset();
+		return;
+	}
+	const uint32 count = index.read4();
+	for (uint32 i = 0; i < count; i++) {
+		if (index.getAvail() < 2) {
+			break;
+		}
+		const size_t keylen = index.read2();
+		if (index.getAvail() < keylen + index_header_size - 2) {
+			break;
+		}
+		std::string key;
+		index.read(key, keylen);
+		Entry entry;
+		entry.source_crc    = index.read4();
+		entry.crc           = index.read4();
+		const uint32 offset = index.read4();
+		entry.len           = index.read4();
+		entry.unused_saves  = index.read2();
+		if (offset > size || entry.len > size - offset) {
+			break;
+		}
+		entry.data    = file_data.get() + offset;
+		entry.checked = false;
+		entry.used    = false;
+		entries[std::move(key)] = entry;
+	}
+}
+
+/*
+ *  Write the whole cache out, leaving out lists that haven't been used for
+ *  max_unused_saves saves.  It's only done when the cache goes, and only if
+ *  a track was converted, so appending isn't worth it.
+ */
+
+void MidiEventCache::save() {
+	dirty = false;
+	if (fname.empty()) {
+		return;
+	}
+	for (auto it = entries.begin(); it != entries.end();) {
+		Entry& entry = it->second;
+		if (entry.used) {
+			entry.unused_saves = 0;
+		} else if (++entry.unused_saves > max_unused_saves) {
+			it = entries.erase(it);
+			continue;
+		}
+		++it;
+	}
+	try {
+		auto   out    = U7open_out(fname.c_str());
+		size_t offset = header_size;
+		for (const auto& [key, entry] : entries) {
+			offset += key.size() + index_header_size;
+		}
+		OStreamDataSource ds(out.get());
+		ds.write(cache_magic, sizeof(cache_magic));
+		ds.write4(cache_version);
+		ds.write4(entries.size());
+		for (const auto& [key, entry] : entries) {
+			ds.write2(key.size());
+			ds.write(key);
+			ds.write4(entry.source_crc);
+			ds.write4(entry.crc);
+			ds.write4(offset);
+			ds.write4(entry.len);
+			ds.write2(entry.unused_saves);
+			offset += entry.len;
+		}
+		for (const auto& [key, entry] : entries) {
+			ds.write(entry.data, entry.len);
+		}
+		ds.flush();
+		if (!ds.good()) {
+			throw file_write_exception(fname);
+		}
+	} catch (const exult_exception& e) {
+		std::cerr << "Couldn't save MIDI event cache: " << e.what()
+				  << std::endl;
+		U7remove(fname.c_str());
+	}
+}
+
+/*
+ *  Get a track's event list, from the cache if it has one made from the
+ *  same data with the same settings, else by converting it.
+ */
+
+XMidiEventList* MidiEventCache::get(
+		IDataSource* source, const std::string& name, int track, int convert,
+		std::string_view driver) {
+	if (!loaded) {
+		load();
+	}
+	const size_t size = source->getSize();
+	source->seek(0);
+	auto         data       = source->readN(size);
+	const uint32 source_crc = crc32(data.get(), size);
+
+	// The settings XMidiFile will use change the events too.
+	const XMidiFile::Settings settings = XMidiFile::ReadSettings(driver);
+	char                      buf[80];
+	snprintf(
+			buf, sizeof(buf), "|%d|%d|%d|%d|%d|%d|%.4f|", track, convert,
+			settings.do_reverb, settings.reverb_value, settings.do_chorus,
+			settings.chorus_value, settings.gamma);
+	std::string key = name;
+	key += buf;
+	key += driver;
+
+	auto it = entries.find(key);
+	if (it != entries.end() && it->second.source_crc == source_crc) {
+		Entry& entry = it->second;
+		if (!entry.checked) {
+			entry.checked = crc32(entry.data, entry.len) == entry.crc;
+		}
+		if (entry.checked) {
+			IBufferDataView ds(entry.data, entry.len);
+			XMidiEventList* list = XMidiEventList::deserialize(&ds);
+			if (list) {
+				entry.used = true;
+				stats.hits++;
+				return list;
+			}
+		}
+	}
+
+	IBufferDataView ds(data, size);
+	XMidiFile       midfile(&ds, convert, driver);
+	XMidiEventList* list = midfile.GetEventList(track);
+	if (!list) {
+		return nullptr;
+	}
+	list->incrementCounter();    // Keep it when midfile goes.
+	stats.converted++;
+
+	const uint32 len  = list->serialize(nullptr);
+	auto         copy = std::make_unique<unsigned char[]>(len);
+	OBufferDataSpan out(copy, len);
+	list->serialize(&out);
+	// This replaces a list made from older data.
+	entries[key] = Entry{
+			source_crc, crc32(copy.get(), len), copy.get(), len, true, true, 0};
+	added.push_back(std::move(copy));
+	dirty = true;
+	return list;
+}
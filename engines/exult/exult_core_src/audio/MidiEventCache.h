@@ -0,0 +1,98 @@
+/*
+ *  MidiEventCache.h - Music tracks kept as the event lists they convert to.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef MIDIEVENTCACHE_H
+#define MIDIEVENTCACHE_H
+
+#include "common_types.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class IDataSource;
+class XMidiEventList;
+
+/*
+ *  The event lists XMidiFile makes of music tracks, saved to XMIDICACHE so
+ *  a track isn't converted again each time it's played, even after a
+ *  restart.  Each is found by what it came from (file, track, conversion,
+ *  and the driver and its settings), and is only used if the CRC of the
+ *  track's data still matches.  The file is an index followed by the lists,
+ *  all found by offset, so it's read in one go and nothing is parsed until
+ *  a list is used.  Lists converted while running are only written out
+ *  when the cache goes, and lists that haven't been used for a while are
+ *  dropped then.
+ */
+class MidiEventCache {
+	struct Entry {
+		uint32               source_crc;    // Of the data converted.
+		uint32               crc;           // Of the list's data.
+		const unsigned char* data;          // In file_data or added.
+		uint32               len;
+		bool                 checked;       // Its CRC is right.
+		bool                 used;          // Since it was read.
+		uint16               unused_saves;  // Saves it wasn't used before.
+	};
+
+	std::string fname;    // XMIDICACHE, or empty to not keep it.
+	bool        loaded = false;
+	bool        dirty  = false;    // Lists were added since it was read.
+	std::unique_ptr<unsigned char[]> file_data;    // As it was read.
+	// Lists converted since it was read.
+	std::vector<std::unique_ptr<unsigned char[]>> added;
+	std::unordered_map<std::string, Entry>        entries;    // By key.
+
+	void load();
+	void save();
+
+public:
+	struct Stats {
+		unsigned long hits      = 0;
+		unsigned long converted = 0;
+	};
+
+private:
+	Stats stats;
+
+public:
+	// 'name' is the file to keep it in; if empty, it's only kept while
+	//   running.
+	explicit MidiEventCache(std::string name);
+	~MidiEventCache();    // Saves it if lists were added.
+	MidiEventCache(const MidiEventCache&)            = delete;
+	MidiEventCache& operator=(const MidiEventCache&) = delete;
+
+	// Get a track's event list, converting it if it isn't cached.  The
+	//   caller has a reference to it (XMidiEventList::decrementCounter()).
+	//   Output: nullptr if it couldn't be converted.
+	XMidiEventList* get(
+			IDataSource* source,          // The XMIDI or MIDI.
+			const std::string& name,      // Of it (e.g., flex and index).
+			int track, int convert, std::string_view driver);
+
+	const Stats& get_stats() const {
+		return stats;
+	}
+};
+
+#endif
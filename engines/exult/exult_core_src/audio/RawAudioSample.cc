@@ -30,15 +30,15 @@ namespace Pentagram {
 
 	RawAudioSample::RawAudioSample(
 			std::unique_ptr<uint8[]> buffer_, uint32 size_, uint32 rate_,
-			bool signeddata_, bool stereo_)
+			bool signeddata_, bool stereo_, uint32 bits_)
 			: AudioSample(std::move(buffer_), size_), signeddata(signeddata_) {
 		sample_rate        = rate_;
-		bits               = 8;
+		bits               = bits_;
 		stereo             = stereo_;
 		frame_size         = 512;
 		decompressor_size  = sizeof(RawDecompData);
 		decompressor_align = alignof(RawDecompData);
-		length             = size_;
+		length             = bits == 16 ? size_ / (stereo ? 4 : 2) : size_;
 		start_pos          = 0;
 		byte_swap          = false;
 	}
@@ -27,7 +27,7 @@ namespace Pentagram {
 	public:
 		RawAudioSample(
 				std::unique_ptr<uint8[]> buffer, uint32 size, uint32 rate,
-				bool signeddata, bool stereo);
+				bool signeddata, bool stereo, uint32 bits = 8);
 		void   initDecompressor(void* DecompData) const override;
 		uint32 decompressFrame(void* DecompData, void* samples) const override;
 		void   freeDecompressor(void* DecompData) const override;
@@ -25,6 +25,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "databuf.h"
 
 #include <cstdlib>
+#include <unordered_map>
+#include <vector>
 
 using std::endl;
 using std::size_t;
@@ -218,6 +220,187 @@ uint32 XMidiEventList::convertListToMTrk(ODataSource* dest) {
 	return i;
 }
 
+//
+// serialize
+//
+// Writes the events with all that XMidiFile worked out for them, followed by
+// the branch and patch/bank lists as indices into the events. Returns the size
+// and dest can be nullptr
+//
+uint32 XMidiEventList::serialize(ODataSource* dest) {
+	std::unordered_map<const XMidiEvent*, uint32> index;
+	for (XMidiEvent* event = events; event; event = event->next) {
+		index.emplace(event, index.size());
+	}
+
+	uint32 i = 10;
+	if (dest) {
+		dest->write4(index.size());
+		dest->write2(chan_mask);
+		dest->write4(length);
+	}
+
+	for (XMidiEvent* event = events; event; event = event->next) {
+		if (dest) {
+			dest->write4(event->time);
+			dest->write1(event->status);
+			dest->write1(event->data[0]);
+			dest->write1(event->data[1]);
+		}
+		i += 7;
+
+		switch (event->getStatusType()) {
+		case MidiStatus::NoteOn:
+			if (dest) {
+				dest->write4(event->ex.note_on.duration);
+			}
+			i += 4;
+			break;
+
+		case MidiStatus::Sysex:
+			if (dest) {
+				dest->write4(event->ex.sysex_data.len);
+				if (event->ex.sysex_data.len) {
+					dest->write(
+							event->ex.sysex_data.buffer(),
+							event->ex.sysex_data.len);
+				}
+			}
+			i += 4 + event->ex.sysex_data.len;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	// The lists are written in their own order, which isn't the events'
+	uint32 count = 0;
+	for (XMidiEvent* b = branches; b; b = b->ex.branch_index.next_branch) {
+		count++;
+	}
+	if (dest) {
+		dest->write4(count);
+		for (XMidiEvent* b = branches; b; b = b->ex.branch_index.next_branch) {
+			dest->write4(index[b]);
+		}
+	}
+	i += 4 + count * 4;
+
+	count = 0;
+	for (XMidiEvent* e = x_patch_bank; e; e = e->next_patch_bank) {
+		count++;
+	}
+	if (dest) {
+		dest->write4(count);
+		for (XMidiEvent* e = x_patch_bank; e; e = e->next_patch_bank) {
+			dest->write4(index[e]);
+		}
+	}
+	i += 4 + count * 4;
+
+	return i;
+}
+
+XMidiEventList* XMidiEventList::deserialize(IDataSource* source) {
+	if (source->getAvail() < 10) {
+		return nullptr;
+	}
+	const uint32 num_events = source->read4();
+	auto*        eventlist  = XMidiEventList::Create();
+	eventlist->chan_mask    = source->read2();
+	eventlist->length       = source->read4();
+
+	// Each event is at least 7 bytes
+	bool valid = num_events <= source->getAvail() / 7;
+
+	std::vector<XMidiEvent*> index;
+	index.reserve(valid ? num_events : 0);
+	XMidiEvent** link = &eventlist->events;
+	for (uint32 n = 0; valid && n < num_events; n++) {
+		if (source->getAvail() < 7) {
+			valid = false;
+			break;
+		}
+		auto* event    = XMidiEvent::Create();
+		*link          = event;
+		link           = &event->next;
+		event->time    = source->read4();
+		event->status  = source->read1();
+		event->data[0] = source->read1();
+		event->data[1] = source->read1();
+		index.push_back(event);
+
+		switch (event->getStatusType()) {
+		case MidiStatus::NoteOn:
+			if (source->getAvail() < 4) {
+				valid = false;
+				break;
+			}
+			event->ex.note_on.duration = source->read4();
+			break;
+
+		case MidiStatus::Sysex: {
+			if (source->getAvail() < 4) {
+				valid = false;
+				break;
+			}
+			const uint32 len = source->read4();
+			if (len > source->getAvail()) {
+				valid = false;
+				break;
+			}
+			if (len) {
+				source->read(event->ex.sysex_data.set_len(len), len);
+			}
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+
+	// Relink the branch and patch/bank lists
+	XMidiEvent** branch = &eventlist->branches;
+	XMidiEvent** patch  = &eventlist->x_patch_bank;
+	for (int list = 0; valid && list < 2; list++) {
+		if (source->getAvail() < 4) {
+			valid = false;
+			break;
+		}
+		const uint32 count = source->read4();
+		if (count > source->getAvail() / 4) {
+			valid = false;
+			break;
+		}
+		for (uint32 n = 0; n < count; n++) {
+			const uint32 i = source->read4();
+			if (i >= index.size()) {
+				valid = false;
+				break;
+			}
+			if (list == 0) {
+				*branch = index[i];
+				branch  = &index[i]->ex.branch_index.next_branch;
+			} else {
+				*patch = index[i];
+				patch  = &index[i]->next_patch_bank;
+			}
+		}
+	}
+
+	if (!valid) {
+		if (eventlist->events) {
+			eventlist->events->FreeThis();
+			eventlist->events = nullptr;
+		}
+		eventlist->FreeThis();
+		return nullptr;
+	}
+	return eventlist;
+}
+
 void XMidiEventList::decrementCounter() {
 	if (--counter < 0) {
 		// Lock the mutex here
@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #ifndef XMIDIEVENTLIST_H_INCLUDED
 #define XMIDIEVENTLIST_H_INCLUDED
 
+class IDataSource;
 class ODataSource;
 
 #include "XMidiEvent.h"
@@ -50,6 +51,16 @@ public:
 	//! Write the list to a DataSource
 	int write(ODataSource* dest);
 
+	//! Write the list as it is, to be read back by deserialize()
+	//! \param dest The DataSource to write to, or 0 to just get the size
+	//! \return The number of bytes written
+	uint32 serialize(ODataSource* dest);
+
+	//! Read a list written by serialize()
+	//! \param source The DataSource to read from
+	//! \return The list, or 0 if the data isn't valid
+	static XMidiEventList* deserialize(IDataSource* source);
+
 	//! Increments the counter
 	void incrementCounter() {
 		counter++;
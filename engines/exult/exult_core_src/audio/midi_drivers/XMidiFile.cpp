@@ -1557,13 +1557,9 @@ int XMidiFile::ExtractTracksFromMid(
 	return num;
 }
 
-int XMidiFile::ExtractTracks(IDataSource* source, std::string_view drivername) {
-	const int format_hint = convert_type;
-
-	if (convert_type >= XMIDIFILE_HINT_U7VOICE_MT_FILE) {
-		convert_type = XMIDIFILE_CONVERT_NOCONVERSION;
-	}
-	string s;
+XMidiFile::Settings XMidiFile::ReadSettings(std::string_view drivername) {
+	Settings settings{};
+	string   s;
 
 	config->value("config/audio/midi/reverb/enabled", s, "no");
 	std::string config_key;
@@ -1576,7 +1572,7 @@ int XMidiFile::ExtractTracks(IDataSource* source, std::string_view drivername) {
 	}
 
 	if (s == "yes") {
-		do_reverb = true;
+		settings.do_reverb = true;
 	};
 	if (!config_key.empty()) {
 		config->set(config_key, s, false);
@@ -1598,16 +1594,16 @@ int XMidiFile::ExtractTracks(IDataSource* source, std::string_view drivername) {
 		config->set(config_key, s, false);
 	}
 
-	reverb_value = atoi(s.c_str());
-	if (reverb_value > 127) {
-		changed      = true;
-		reverb_value = 127;
-	} else if (reverb_value < 0) {
-		reverb_value = 0;
-		changed      = true;
+	settings.reverb_value = atoi(s.c_str());
+	if (settings.reverb_value > 127) {
+		changed               = true;
+		settings.reverb_value = 127;
+	} else if (settings.reverb_value < 0) {
+		settings.reverb_value = 0;
+		changed               = true;
 	}
 	if (!config_key.empty()) {
-		config->set(config_key, reverb_value, false);
+		config->set(config_key, settings.reverb_value, false);
 	}
 	config->value("config/audio/midi/chorus/enabled", s, "no");
 	if (!drivername.empty()) {
@@ -1618,7 +1614,7 @@ int XMidiFile::ExtractTracks(IDataSource* source, std::string_view drivername) {
 	}
 
 	if (s == "yes") {
-		do_chorus = true;
+		settings.do_chorus = true;
 	}
 	if (!config_key.empty()) {
 		config->set(config_key, s, false);
@@ -1635,16 +1631,16 @@ int XMidiFile::ExtractTracks(IDataSource* source, std::string_view drivername) {
 		config->value("config/audio/midi/chorus", s, "16");
 		changed = true;
 	}
-	chorus_value = atoi(s.c_str());
-	if (chorus_value > 127) {
-		chorus_value = 127;
-		changed      = true;
-	} else if (chorus_value < 0) {
-		chorus_value = 0;
-		changed      = true;
+	settings.chorus_value = atoi(s.c_str());
+	if (settings.chorus_value > 127) {
+		settings.chorus_value = 127;
+		changed               = true;
+	} else if (settings.chorus_value < 0) {
+		settings.chorus_value = 0;
+		changed               = true;
 	}
 	if (!config_key.empty()) {
-		config->set(config_key, chorus_value, false);
+		config->set(config_key, settings.chorus_value, false);
 	}
 
 	config->value("config/audio/midi/volume_curve", s, "---");
@@ -1653,7 +1649,8 @@ int XMidiFile::ExtractTracks(IDataSource* source, std::string_view drivername) {
 		changed = true;
 	}
 	VolumeCurve.set_gamma(atof(s.c_str()));
-	const int igam = std::lround(VolumeCurve.get_gamma() * 10000);
+	settings.gamma = VolumeCurve.get_gamma();
+	const int igam = std::lround(settings.gamma * 10000);
 	char      buf[32];
 	snprintf(buf, sizeof(buf), "%d.%04d", igam / 10000, igam % 10000);
 	config->set("config/audio/midi/volume_curve", buf, false);
@@ -1661,7 +1658,23 @@ int XMidiFile::ExtractTracks(IDataSource* source, std::string_view drivername) {
 	if (changed) {
 		config->write_back();
 	}
+	return settings;
+}
+
+int XMidiFile::ExtractTracks(IDataSource* source, std::string_view drivername) {
+	const int format_hint = convert_type;
+
+	if (convert_type >= XMIDIFILE_HINT_U7VOICE_MT_FILE) {
+		convert_type = XMIDIFILE_CONVERT_NOCONVERSION;
+	}
+
+	const Settings settings = ReadSettings(drivername);
+	do_reverb               = settings.do_reverb;
+	do_chorus               = settings.do_chorus;
+	reverb_value            = settings.reverb_value;
+	chorus_value            = settings.chorus_value;
 
+	char buf[32];
 	// Read first 4 bytes of header
 	source->read(buf, 4);
 
@@ -89,6 +89,19 @@ public:
 		return tmp;
 	}
 
+	//! Settings from the config that change how tracks are converted
+	struct Settings {
+		bool   do_reverb;
+		bool   do_chorus;
+		int    reverb_value;
+		int    chorus_value;
+		double gamma;    // Of the volume curve
+	};
+
+	//! Read the settings used for a driver, writing back any defaults
+	//! \param drivername The name of the driver, or empty for the global ones
+	static Settings ReadSettings(std::string_view drivername);
+
 	// Not yet implimented
 	// int apply_patch (int track, DataSource *source);
 
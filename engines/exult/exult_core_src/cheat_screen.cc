@@ -1087,11 +1087,13 @@ void CheatScreen::NormalDisplay() {
 	const int offsety1 = 108;
 	const int offsety2 = 54;
 	const int offsety3 = 0;
+	const int offsety4 = 153;
 #else
 	const int offsetx  = 0;
 	const int offsety1 = 0;
 	const int offsety2 = 0;
 	const int offsety3 = 45;
+	const int offsety4 = 90;
 #endif
 	const int        curmap = gwin->get_map()->get_num();
 	const Tile_coord t      = gwin->get_main_actor()->get_tile();
@@ -1146,6 +1148,17 @@ void CheatScreen::NormalDisplay() {
 			buf, sizeof(buf), "Coords in dec (%04i, %04i, %02i)", t.tx, t.ty,
 			t.tz);
 	font->paint_text_fixedwidth(ibuf, buf, offsetx, 81 - offsety2, 8);
+
+	const Vga_file::Frame_cache_stats& frames
+			= Shape_manager::get_instance()
+					  ->get_shapes()
+					  .get_frame_cache_stats();
+	const unsigned long uses = frames.hits + frames.misses;
+	snprintf(
+			buf, sizeof(buf), "Shapes %zuK, %lu%% hits, %lu freed",
+			frames.bytes >> 10, uses ? frames.hits * 100 / uses : 0,
+			frames.evictions);
+	font->paint_text_fixedwidth(ibuf, buf, offsetx, offsety4, 8);
 }
 
 void CheatScreen::NormalMenu() {
@@ -52,6 +52,7 @@
 #include "fnames.h"
 #include "font.h"
 #include "game.h"
+#include "gameclk.h"
 #include "gamemap.h"
 #include "gamemgr/modmgr.h"
 #include "gamewin.h"
@@ -60,6 +61,7 @@
 #include "items.h"
 #include "keyactions.h"
 #include "keys.h"
+#include "mapprefetch.h"
 #include "mouse.h"
 #include "palette.h"
 #include "party.h"
@@ -73,8 +75,10 @@
 #include "version.h"
 
 #include <cctype>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
+#include <limits>
 
 #ifdef __GNUC__
 #	pragma GCC diagnostic push
@@ -176,6 +180,8 @@ bool combat_trace = false;    // show combat messages?
 // Save game compression level
 int  save_compression = 1;
 bool ignore_crc       = false;
+// Game minutes between writes to 'gamedat' (0 = never).
+static int autosave_minutes = 0;
 
 TouchUI* touchui = nullptr;
 
@@ -217,6 +223,9 @@ static void Drop_dragged_npc(int npcnum, int x, int y);
 static void Drop_dragged_combo(int cnt, U7_combo_data* combo, int x, int y);
 #endif
 static void BuildGameMap(BaseGameInfo* game, int mapnum);
+static void BenchGameMap(BaseGameInfo* game, int mapnum);
+static void Activate_tqueue(uint32 ticks);
+static void Autosave();
 static void Handle_events();
 static void Handle_event(SDL_Event& event);
 
@@ -232,6 +241,7 @@ static string arg_gamename = "default";    // cmdline arguments
 static string arg_modname  = "default";    // cmdline arguments
 static string arg_configfile;
 static int    arg_buildmap     = -1;
+static int    arg_benchmap     = -1;
 static int    arg_mapnum       = -1;
 static bool   arg_nomenu       = false;
 static bool   arg_edit_mode    = false;    // Start up ExultStudio.
@@ -310,6 +320,7 @@ int main(int argc, char* argv[]) {
 	parameters.declare("--game", &arg_gamename, "default");
 	parameters.declare("--mod", &arg_modname, "default");
 	parameters.declare("--buildmap", &arg_buildmap, -1);
+	parameters.declare("--benchmap", &arg_benchmap, -1);
 	parameters.declare("--mapnum", &arg_mapnum, -1);
 	parameters.declare("--nocrc", &ignore_crc, true);
 	parameters.declare("-c", &arg_configfile, "");
@@ -339,7 +350,9 @@ int main(int argc, char* argv[]) {
 			 << "             [--bg|--fov|--si|--ss|--sib|--game <game>] "
 				"[--mod <mod>]"
 			 << endl
-			 << "             [--nomenu] [--buildmap 0|1|2] [--mapnum <num>]"
+			 << "             [--nomenu] [--buildmap 0|1|2] [--benchmap <N>]"
+			 << endl
+			 << "             [--mapnum <num>]"
 			 << endl
 			 << "             [--nocrc] [--edit] [--write-xml] [--reset-video]"
 			 << endl
@@ -380,8 +393,15 @@ int main(int argc, char* argv[]) {
 			 << "\t\t'--mod <mod>' (WARNING: requires big amounts of RAM, HD"
 			 << endl
 			 << "\t\tspace and time!)" << endl
-			 << "--mapnum <N>\tThis must be used with '--buildmap'. Selects "
-				"which map"
+			 << "--benchmap <N>\tTime reading the objects of superchunk N "
+				"(0-143)"
+			 << endl
+			 << "\t\tOnly valid if used together with '--bg', '--fov', '--si', "
+				"'--ss', '--sib'"
+			 << endl
+			 << "\t\tor '--game <game>'" << endl
+			 << "--mapnum <N>\tThis must be used with '--buildmap' or "
+				"'--benchmap'. Selects which map"
 			 << endl
 			 << "\t\t(for multimap games or mods) whose map is desired" << endl
 			 << "--nocrc\t\tDon't check crc's of .flx files" << endl
@@ -420,6 +440,15 @@ int main(int argc, char* argv[]) {
 				"--sib or --game!"
 			 << endl;
 		exit(1);
+	} else if (arg_benchmap >= 0 && gameparam == 0) {
+		cerr << "Error: --benchmap requires one of --bg, --fov, --si, --ss, "
+				"--sib or --game!"
+			 << endl;
+		exit(1);
+	} else if (arg_benchmap >= c_num_schunks * c_num_schunks) {
+		cerr << "Error: --benchmap takes a superchunk from 0 to "
+			 << c_num_schunks * c_num_schunks - 1 << "!" << endl;
+		exit(1);
 	} else if (arg_verify_files && gameparam == 0) {
 		cerr << "Error: --verify-files requires one of --bg, --fov, --si, "
 				"--ss, --sib or --game!"
@@ -427,8 +456,9 @@ int main(int argc, char* argv[]) {
 		exit(1);
 	}
 
-	if (arg_mapnum >= 0 && arg_buildmap < 0) {
-		cerr << "Error: '--mapnum' requires '--buildmap'!" << endl;
+	if (arg_mapnum >= 0 && arg_buildmap < 0 && arg_benchmap < 0) {
+		cerr << "Error: '--mapnum' requires '--buildmap' or '--benchmap'!"
+			 << endl;
 		exit(1);
 	} else if (arg_mapnum < 0) {
 		arg_mapnum = 0;    // Sane default.
@@ -636,6 +666,10 @@ int exult_main(const char* runpath) {
 		save_compression = 1;
 	}
 	config->set("config/disk/save_compression_level", save_compression, false);
+	config->value("config/disk/autosave_minutes", autosave_minutes, 0);
+	if (autosave_minutes < 0) {
+		autosave_minutes = 0;
+	}
 #ifdef USECODE_DEBUGGER
 	// Enable usecode debugger
 	config->value("config/debug/debugger/enable", usecode_debugging);
@@ -836,7 +870,7 @@ static void Init() {
 	// Load games and mods; also stores system paths:
 	gamemanager = new GameManager();
 
-	if (arg_buildmap < 0 && !arg_verify_files) {
+	if (arg_buildmap < 0 && arg_benchmap < 0 && !arg_verify_files) {
 		string gr;
 		string gg;
 		string gb;
@@ -956,6 +990,10 @@ static void Init() {
 			BuildGameMap(newgame, arg_mapnum);
 			exit(0);
 		}
+		if (arg_benchmap >= 0) {
+			BenchGameMap(newgame, arg_mapnum);
+			exit(0);
+		}
 		if (arg_verify_files) {
 			newgame->setup_game_paths();
 			exit(verify_files(newgame));
@@ -1210,6 +1248,45 @@ static void Select_for_combo(
 
 #endif
 
+/*
+ *  Activate what's due in the time queue.
+ */
+
+static void Activate_tqueue(uint32 ticks) {
+	// In map-edit mode, only the avatar (and 'always' entries) move.
+	gwin->get_tqueue()->activate(
+			ticks, cheat.in_map_editor() ? gwin->get_main_actor() : nullptr);
+}
+
+/*
+ *  Write 'gamedat' every "config/disk/autosave_minutes" game minutes, when
+ *  nothing is going on.  Only what changed is written (see Gamedat_delta).
+ */
+
+static void Autosave() {
+	// Game time, in minutes.
+	static unsigned long last_save = std::numeric_limits<unsigned long>::max();
+	if (!autosave_minutes) {
+		return;
+	}
+	const unsigned long now = gwin->get_clock()->get_total_minutes();
+	if (now < last_save) {    // Just started, or a game was restored.
+		last_save = now;
+	}
+	if (now - last_save < static_cast<unsigned long>(autosave_minutes)
+		|| gwin->get_gump_man()->modal_gump_mode()
+		|| gwin->get_usecode()->in_usecode()
+		|| !gwin->main_actor_can_act()) {
+		return;
+	}
+	last_save = now;
+	try {
+		gwin->write(true);
+	} catch (exult_exception& e) {
+		cerr << "Autosave failed: " << e.what() << endl;
+	}
+}
+
 /*
  *  Handle events until a flag is set.
  */
@@ -1218,7 +1295,9 @@ static void Handle_events() {
 	uint32 last_repaint = 0;    // For insuring animation repaints.
 	uint32 last_rest    = 0;
 #ifdef DEBUG
-	uint32 last_fps = 0;
+	uint32 last_fps    = 0;
+	uint32 last_frame  = 0;
+	uint32 worst_frame = 0;    // Longest time between loops (a stutter).
 #endif
 	/*
 	 *  Main event loop.
@@ -1249,13 +1328,45 @@ static void Handle_events() {
 #endif
 		Game::set_ticks(ticks);
 #ifdef DEBUG
+		if (last_frame && ticks - last_frame > worst_frame) {
+			worst_frame = ticks - last_frame;
+		}
+		last_frame = ticks;
 		if (last_fps == 0 || ticks >= last_fps + 10000) {
 			const double fps = (gwin->blits * 1000.0) / (ticks - last_fps);
 			cerr << "***#ticks = " << ticks - last_fps
 				 << ", blits = " << gwin->blits << ", ";
-			cerr << "FPS:  " << fps << endl;
-			last_fps    = ticks;
-			gwin->blits = 0;
+			cerr << "FPS:  " << fps;
+			// How much of the window was scaled for each blit.
+			Image_window8* win = gwin->get_win();
+			if (gwin->blits) {
+				cerr << ", scaled pixels/blit:  "
+					 << win->get_scaled_pixels() / gwin->blits;
+			}
+			cerr << ", worst frame:  " << worst_frame << "ms";
+			cerr << ", chunk paint orders reused/rebuilt:  "
+				 << gwin->paint_order_hits << "/" << gwin->paint_order_rebuilds;
+			Schunk_prefetch* prefetch = Schunk_prefetch::get_instance();
+			if (prefetch && prefetch->is_enabled()) {
+				cerr << ", superchunks prefetched:  "
+					 << prefetch->get_num_used() << "/"
+					 << prefetch->get_num_requested();
+			}
+			if (const SFX_cache_manager* sfxs
+				= Audio::get_ptr()->get_sfx_cache()) {
+				const SFX_cache_manager::Stats& st = sfxs->get_stats();
+				cerr << ", sfx hits/prefetched/misses/evicted:  " << st.hits
+					 << "/" << st.prefetched << "/" << st.misses << "/"
+					 << st.evicted << " (" << st.bytes / 1024 << "/"
+					 << st.peak_bytes / 1024 << "K)";
+			}
+			cerr << endl;
+			win->clear_scaled_pixels();
+			worst_frame                = 0;
+			gwin->paint_order_hits     = 0;
+			gwin->paint_order_rebuilds = 0;
+			last_fps                   = ticks;
+			gwin->blits                = 0;
 		}
 #endif
 
@@ -1266,7 +1377,8 @@ static void Handle_events() {
 
 		// Animate unless dormant.
 		if (gwin->have_focus() && !dragging) {
-			gwin->get_tqueue()->activate(ticks);
+			Activate_tqueue(ticks);
+			Autosave();
 		}
 
 		// Moved this out of the animation loop, since we want movement to be
@@ -2160,7 +2272,7 @@ void Wait_for_arrival(
 			timeout = true;
 		}
 		if (gwin->have_focus()) {
-			gwin->get_tqueue()->activate(ticks);
+			Activate_tqueue(ticks);
 		}
 		// Show animation every 1/20 sec.
 		if (ticks > last_repaint + 50 || gwin->was_painted()) {
@@ -2275,7 +2387,7 @@ void Wizard_eye(long msecs    // Length of time in milliseconds.
 			timeout = true;
 		}
 		if (gwin->have_focus()) {
-			gwin->get_tqueue()->activate(ticks);
+			Activate_tqueue(ticks);
 		}
 		// Show animation every 1/20 sec.
 		if (ticks > last_repaint + 50 || gwin->was_painted()) {
@@ -2514,6 +2626,45 @@ void BuildGameMap(BaseGameInfo* game, int mapnum) {
 	}
 }
 
+/*
+ *  Time reading a superchunk's objects from its ifix and ireg files, as
+ *  when the avatar first comes near it.  Busy ones (towns) spend most of
+ *  it adding rendering dependencies.
+ */
+
+void BenchGameMap(BaseGameInfo* game, int mapnum) {
+	const int rounds = 20;
+	const int w      = 320;    // The view doesn't matter.
+	const int h      = 200;
+	gwin             = new Game_window(
+            w, h, false, w, h, 1, Image_window::point, Image_window::Fit,
+            Image_window::point);
+	Audio::Init();
+	Game::create_game(game);
+	gwin->init_files(false);    // init, but don't show plasma
+	gwin->get_map()->init();
+	gwin->set_map(mapnum);
+	Game_map* map = gwin->get_map();
+	double    best  = 0;
+	double    total = 0;
+	for (int i = 0; i < rounds; i++) {
+		map->clear();
+		map->init();
+		const auto start = std::chrono::steady_clock::now();
+		map->get_superchunk_objects(arg_benchmap);
+		const std::chrono::duration<double, std::milli> elapsed
+				= std::chrono::steady_clock::now() - start;
+		total += elapsed.count();
+		if (i == 0 || elapsed.count() < best) {
+			best = elapsed.count();
+		}
+	}
+	cout << "--benchmap read superchunk 0x" << std::hex << arg_benchmap
+		 << std::dec << " " << rounds << " times: best " << best
+		 << " ms, average " << total / rounds << " ms" << endl;
+	Audio::Destroy();
+}
+
 /*
  *  Most of the game setable video configuration stuff is stored here so
  *  it isn't duplicated all over the place. fullscreen is determined
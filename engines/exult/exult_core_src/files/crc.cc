@@ -117,9 +117,12 @@ static inline uint32 crc32_internal(IDataSource&& in) {
 	return crc32val;
 }
 
-// unsigned int crc32(const unsigned char *s, unsigned int len) {
-// 	return crc32_internal(IBufferDataView(s, len));
-// }
+uint32 crc32(const unsigned char* s, size_t len, uint32 crc) {
+	while (len--) {
+		crc = crc32_tab[(crc ^ *s++) & 0xff] ^ (crc >> 8);
+	}
+	return crc;
+}
 
 uint32 crc32(const char* filename) {
 	IFileDataSource crcfile(filename);
@@ -3,6 +3,10 @@
 
 #include "common_types.h"
 
+#include <cstddef>
+
 uint32 crc32(const char* filename);
+// Continue 'crc' over a buffer.
+uint32 crc32(const unsigned char* s, size_t len, uint32 crc = 0);
 
 #endif
@@ -170,6 +170,7 @@ struct file_in_zip_read_info_s {
 	FILE* file;                   /* io structore of the zipfile */
 	uLong compression_method;     /* compression method (0==store) */
 	uLong byte_before_the_zipfile; /* byte before the zipfile, (>0 for sfx)*/
+	int   raw;                     /* not 0 to read the compressed data */
 };
 
 /* unz_s contain internal information about the zipfile
@@ -840,6 +841,41 @@ extern int ZEXPORT unzLocateFile(
 	return err;
 }
 
+/*
+  Get where the current file is in the central dir.
+  return UNZ_OK if there is no problem
+*/
+extern int ZEXPORT unzGetFilePos(unzFile file, unz_file_pos* file_pos) {
+	if (file == nullptr || file_pos == nullptr) {
+		return UNZ_PARAMERROR;
+	}
+	if (!file->current_file_ok) {
+		return UNZ_END_OF_LIST_OF_FILE;
+	}
+	file_pos->pos_in_zip_directory = file->pos_in_central_dir;
+	file_pos->num_of_file          = file->num_file;
+	return UNZ_OK;
+}
+
+/*
+  Set the current file to one whose position came from unzGetFilePos.
+  return UNZ_OK if there is no problem
+*/
+extern int ZEXPORT unzGoToFilePos(unzFile file, const unz_file_pos* file_pos) {
+	int err;
+
+	if (file == nullptr || file_pos == nullptr) {
+		return UNZ_PARAMERROR;
+	}
+	file->pos_in_central_dir = file_pos->pos_in_zip_directory;
+	file->num_file           = file_pos->num_of_file;
+	err                      = unzlocal_GetCurrentFileInfoInternal(
+            file, &file->cur_file_info, &file->cur_file_info_internal, nullptr,
+            0, nullptr, 0, nullptr, 0);
+	file->current_file_ok = (err == UNZ_OK);
+	return err;
+}
+
 /*
   Read the local header of the current zipfile
   Check the coherency of the local header and info in the end of central
@@ -955,6 +991,15 @@ static int unzlocal_CheckCurrentFileCoherencyHeader(
   If there is no error and the file is opened, the return value is UNZ_OK.
 */
 extern int ZEXPORT unzOpenCurrentFile(unzFile file) {
+	return unzOpenCurrentFile2(file, nullptr, nullptr, 0);
+}
+
+/*
+  Same as unzOpenCurrentFile, but if raw is not 0, the compressed data is
+  read as it is.
+*/
+extern int ZEXPORT
+		unzOpenCurrentFile2(unzFile file, int* method, int* level, int raw) {
 	int                      err = UNZ_OK;
 	bool                     Store;
 	uInt                     iSizeVar;
@@ -1001,7 +1046,25 @@ extern int ZEXPORT unzOpenCurrentFile(unzFile file) {
 		&& (file->cur_file_info.compression_method != Z_DEFLATED)) {
 		err = UNZ_BADZIPFILE;
 	}
-	Store = file->cur_file_info.compression_method == 0;
+	Store = file->cur_file_info.compression_method == 0 || raw;
+
+	if (method != nullptr) {
+		*method = static_cast<int>(file->cur_file_info.compression_method);
+	}
+	if (level != nullptr) {
+		*level = 6;
+		switch (file->cur_file_info.flag & 0x06) {
+		case 6:
+			*level = 1;
+			break;
+		case 4:
+			*level = 2;
+			break;
+		case 2:
+			*level = 9;
+			break;
+		}
+	}
 
 	pfile_in_zip_read_info->crc32_wait = file->cur_file_info.crc;
 	pfile_in_zip_read_info->crc32      = 0;
@@ -1010,6 +1073,7 @@ extern int ZEXPORT unzOpenCurrentFile(unzFile file) {
 	pfile_in_zip_read_info->file = file->file;
 	pfile_in_zip_read_info->byte_before_the_zipfile
 			= file->byte_before_the_zipfile;
+	pfile_in_zip_read_info->raw = raw;
 
 	pfile_in_zip_read_info->stream.total_out = 0;
 
@@ -1032,8 +1096,10 @@ extern int ZEXPORT unzOpenCurrentFile(unzFile file) {
 	}
 	pfile_in_zip_read_info->rest_read_compressed
 			= file->cur_file_info.compressed_size;
+	// Raw data ends where the compressed data does.
 	pfile_in_zip_read_info->rest_read_uncompressed
-			= file->cur_file_info.uncompressed_size;
+			= raw ? file->cur_file_info.compressed_size
+				  : file->cur_file_info.uncompressed_size;
 
 	pfile_in_zip_read_info->pos_in_zipfile
 			= file->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER
@@ -1115,7 +1181,8 @@ extern int ZEXPORT unzReadCurrentFile(unzFile file, voidp buf, unsigned len) {
 			pfile_in_zip_read_info->stream.avail_in = uReadThis;
 		}
 
-		if (pfile_in_zip_read_info->compression_method == 0) {
+		if (pfile_in_zip_read_info->compression_method == 0
+			|| pfile_in_zip_read_info->raw) {
 			uInt uDoCopy;
 			uInt i;
 			if (pfile_in_zip_read_info->stream.avail_out
@@ -1298,7 +1365,8 @@ extern int ZEXPORT unzCloseCurrentFile(unzFile file) {
 		return UNZ_PARAMERROR;
 	}
 
-	if (pfile_in_zip_read_info->rest_read_uncompressed == 0) {
+	if (pfile_in_zip_read_info->rest_read_uncompressed == 0
+		&& !pfile_in_zip_read_info->raw) {
 		if (pfile_in_zip_read_info->crc32
 			!= pfile_in_zip_read_info->crc32_wait) {
 			err = UNZ_CRCERROR;
@@ -105,6 +105,13 @@ struct unz_file_info {
 	tm_unz tmu_date;
 };
 
+/* unz_file_pos is where a file is in the central dir, to get back to it
+   without searching */
+struct unz_file_pos {
+	uLong pos_in_zip_directory; /* offset in zip file directory */
+	uLong num_of_file;          /* # of file */
+};
+
 extern int ZEXPORT unzStringFileNameCompare(
 		const char* fileName1, const char* fileName2, int iCaseSensitivity);
 /*
@@ -192,6 +199,18 @@ extern int ZEXPORT unzGetCurrentFileInfo(
   szComment (commentBufferSize is the size of the buffer)
 */
 
+extern int ZEXPORT unzGetFilePos(unzFile file, unz_file_pos* file_pos);
+/*
+  Get where the current file is in the central dir.
+  return UNZ_OK if there is no problem
+*/
+
+extern int ZEXPORT unzGoToFilePos(unzFile file, const unz_file_pos* file_pos);
+/*
+  Set the current file to one whose position came from unzGetFilePos.
+  return UNZ_OK if there is no problem
+*/
+
 /***************************************************************************/
 /* for reading the content of the current zipfile, you can open it, read data
    from it, and close it (you can close it before reading all the file)
@@ -203,6 +222,15 @@ extern int ZEXPORT unzOpenCurrentFile(unzFile file);
   If there is no error, the return value is UNZ_OK.
 */
 
+extern int ZEXPORT
+		unzOpenCurrentFile2(unzFile file, int* method, int* level, int raw);
+/*
+  Same as unzOpenCurrentFile, but if raw is not 0, unzReadCurrentFile will
+	give the compressed data as it is, without the CRC check on closing.
+  if method!=nullptr, *method is set to the compression method
+  if level!=nullptr, *level is set to the compression level
+*/
+
 extern int ZEXPORT unzCloseCurrentFile(unzFile file);
 /*
   Close the file in zip opened with unzOpenCurrentFile
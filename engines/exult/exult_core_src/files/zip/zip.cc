@@ -120,6 +120,7 @@ struct curfile_info {
 									  writ*/
 	uLong dosDate;
 	uLong crc32;
+	int   raw; /* not 0 if the data written is already compressed */
 };
 
 struct zip_internal {
@@ -301,6 +302,17 @@ extern int ZEXPORT zipOpenNewFileInZip(
 		const void* extrafield_local, uInt size_extrafield_local,
 		const void* extrafield_global, uInt size_extrafield_global,
 		const char* comment, int method, int level) {
+	return zipOpenNewFileInZip2(
+			file, filename, zipfi, extrafield_local, size_extrafield_local,
+			extrafield_global, size_extrafield_global, comment, method, level,
+			0);
+}
+
+extern int ZEXPORT zipOpenNewFileInZip2(
+		zipFile file, const char* filename, const zip_fileinfo* zipfi,
+		const void* extrafield_local, uInt size_extrafield_local,
+		const void* extrafield_global, uInt size_extrafield_global,
+		const char* comment, int method, int level, int raw) {
 	uInt size_filename;
 	uInt size_comment;
 	uInt i;
@@ -356,6 +368,7 @@ extern int ZEXPORT zipOpenNewFileInZip(
 
 	file->ci.crc32                = 0;
 	file->ci.method               = method;
+	file->ci.raw                  = raw;
 	file->ci.stream_initialised   = 0;
 	file->ci.pos_in_buffered_data = 0;
 	file->ci.pos_local_header     = ftell(file->filezip);
@@ -477,7 +490,7 @@ extern int ZEXPORT zipOpenNewFileInZip(
 	file->ci.stream.total_in  = 0;
 	file->ci.stream.total_out = 0;
 
-	if ((err == ZIP_OK) && (file->ci.method == Z_DEFLATED)) {
+	if ((err == ZIP_OK) && (file->ci.method == Z_DEFLATED) && !raw) {
 		file->ci.stream.zalloc = nullptr;
 		file->ci.stream.zfree  = nullptr;
 		file->ci.stream.opaque = nullptr;
@@ -522,7 +535,7 @@ extern int ZEXPORT zipWriteInFileInZip(zipFile file, voidpc buf, unsigned len) {
 			file->ci.stream.next_out      = file->ci.buffered_data;
 		}
 
-		if (file->ci.method == Z_DEFLATED) {
+		if (file->ci.method == Z_DEFLATED && !file->ci.raw) {
 			const uLong uTotalOutBefore = file->ci.stream.total_out;
 			err                         = deflate(&file->ci.stream, Z_NO_FLUSH);
 			file->ci.pos_in_buffered_data
@@ -552,6 +565,11 @@ extern int ZEXPORT zipWriteInFileInZip(zipFile file, voidpc buf, unsigned len) {
 }
 
 extern int ZEXPORT zipCloseFileInZip(zipFile file) {
+	return zipCloseFileInZipRaw(file, 0, 0);
+}
+
+extern int ZEXPORT zipCloseFileInZipRaw(
+		zipFile file, uLong uncompressed_size, uLong crc) {
 	int err = ZIP_OK;
 
 	if (file == nullptr) {
@@ -563,7 +581,7 @@ extern int ZEXPORT zipCloseFileInZip(zipFile file) {
 	}
 	file->ci.stream.avail_in = 0;
 
-	if (file->ci.method == Z_DEFLATED) {
+	if (file->ci.method == Z_DEFLATED && !file->ci.raw) {
 		while (err == ZIP_OK) {
 			uLong uTotalOutBefore;
 			if (file->ci.stream.avail_out == 0) {
@@ -595,18 +613,23 @@ extern int ZEXPORT zipCloseFileInZip(zipFile file) {
 		}
 	}
 
-	if ((file->ci.method == Z_DEFLATED) && (err == ZIP_OK)) {
+	if ((file->ci.method == Z_DEFLATED) && !file->ci.raw && (err == ZIP_OK)) {
 		err                         = deflateEnd(&file->ci.stream);
 		file->ci.stream_initialised = 0;
 	}
 
+	if (!file->ci.raw) {
+		crc               = file->ci.crc32;
+		uncompressed_size = file->ci.stream.total_in;
+	}
+
 	ziplocal_putValue_inmemory(
-			file->ci.central_header + 16, file->ci.crc32, 4); /*crc*/
+			file->ci.central_header + 16, crc, 4); /*crc*/
 	ziplocal_putValue_inmemory(
 			file->ci.central_header + 20, file->ci.stream.total_out,
 			4); /*compr size*/
 	ziplocal_putValue_inmemory(
-			file->ci.central_header + 24, file->ci.stream.total_in,
+			file->ci.central_header + 24, uncompressed_size,
 			4); /*uncompr size*/
 
 	if (err == ZIP_OK) {
@@ -625,7 +648,7 @@ extern int ZEXPORT zipCloseFileInZip(zipFile file) {
 
 		if (err == ZIP_OK) {
 			err = ziplocal_putValue(
-					file->filezip, file->ci.crc32, 4); /* crc 32, unknown */
+					file->filezip, crc, 4); /* crc 32, unknown */
 		}
 
 		if (err == ZIP_OK) { /* compressed size, unknown */
@@ -634,7 +657,7 @@ extern int ZEXPORT zipCloseFileInZip(zipFile file) {
 		}
 
 		if (err == ZIP_OK) { /* uncompressed size, unknown */
-			err = ziplocal_putValue(file->filezip, file->ci.stream.total_in, 4);
+			err = ziplocal_putValue(file->filezip, uncompressed_size, 4);
 		}
 
 		if (fseek(file->filezip, cur_pos_inzip, SEEK_SET) != 0) {
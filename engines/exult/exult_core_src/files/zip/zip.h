@@ -115,6 +115,17 @@ extern int ZEXPORT zipOpenNewFileInZip(
   level contain the level of compression (can be Z_DEFAULT_COMPRESSION)
 */
 
+extern int ZEXPORT zipOpenNewFileInZip2(
+		zipFile file, const char* filename, const zip_fileinfo* zipfi,
+		const void* extrafield_local, uInt size_extrafield_local,
+		const void* extrafield_global, uInt size_extrafield_global,
+		const char* comment, int method, int level, int raw);
+/*
+  Same as zipOpenNewFileInZip, but if raw is not 0, the data written is
+	already compressed with method (as read by unzOpenCurrentFile2 in raw
+	mode), and the file must be closed with zipCloseFileInZipRaw.
+*/
+
 extern int ZEXPORT zipWriteInFileInZip(zipFile file, voidpc buf, unsigned len);
 /*
   Write data in the zipfile
@@ -125,6 +136,13 @@ extern int ZEXPORT zipCloseFileInZip(zipFile file);
   Close the current file in the zipfile
 */
 
+extern int ZEXPORT zipCloseFileInZipRaw(
+		zipFile file, uLong uncompressed_size, uLong crc);
+/*
+  Close a file opened in raw mode, giving the size and crc32 of its
+	uncompressed data
+*/
+
 extern int ZEXPORT zipClose(zipFile file, const char* global_comment);
 /*
   Close the zipfile
@@ -96,6 +96,7 @@
 #define INTROMUS_AD     "<STATIC>/introadm.dat"
 #define XMIDI_AD        "<STATIC>/xmidi.ad"
 #define XMIDI_MT        "<STATIC>/xmidi.mt"
+#define XMIDICACHE      "<SAVEHOME>/xmidicache.dat"
 #define U7SPEECH        "<STATIC>/u7speech.spc"
 #define SISPEECH        "<STATIC>/sispeech.spc"
 #define PATCH_U7SPEECH  "<PATCH>/u7speech.spc"
@@ -104,6 +105,7 @@
 #define PATCH_XFORMS    "<PATCH>/xform.tbl"
 #define BLENDS          "<STATIC>/blends.dat"
 #define PATCH_BLENDS    "<PATCH>/blends.dat"
+#define XFORMS_CACHE    "<SAVEGAME>/xforms.cache"
 #define MONSTERS        "<STATIC>/monsters.dat"
 #define PATCH_MONSTERS  "<PATCH>/monsters.dat"
 #define EQUIP           "<STATIC>/equip.dat"
@@ -143,6 +145,8 @@
 #define GNEWGAMEVER "<GAMEDAT>/newgame.ver"
 #define KEYRINGDAT  "<GAMEDAT>/keyring.dat"
 #define NOTEBOOKXML "<GAMEDAT>/notebook.xml"
+#define GPENDZIP    "<GAMEDAT>/pendzip.txt"
+#define GDELTA      "<GAMEDAT>/delta.dat"
 
 #define TEXTMSGS       "<STATIC>/textmsg.txt"
 #define PATCH_TEXTMSGS "<PATCH>/textmsg.txt"
@@ -22,6 +22,7 @@
 #	include <config.h>
 #endif
 
+#include "Configuration.h"
 #include "Flex.h"
 #include "Newfile_gump.h"
 #include "Yesno_gump.h"
@@ -32,6 +33,8 @@
 #include "fnames.h"
 #include "game.h"
 #include "gameclk.h"
+#include "gamedatdelta.h"
+#include "gamedatzip.h"
 #include "gamemap.h"
 #include "gamewin.h"
 #include "listfiles.h"
@@ -40,6 +43,7 @@
 #include "utils.h"
 #include "version.h"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdio>
@@ -85,6 +89,26 @@ using std::tm;
 // Save game compression level
 extern int save_compression;
 
+/*
+ *  Get the Gamedat_delta for 'gamedat'.  (It's here so that gamedatdelta.cc
+ *  can be used without the game.)
+ */
+
+Gamedat_delta& Gamedat_delta::get_instance() {
+	static std::unique_ptr<Gamedat_delta> instance;
+	if (!instance) {
+		std::string yn;
+		config->value("config/disk/save_delta", yn, "yes");
+		int kb;
+		config->value("config/disk/save_delta_kb", kb, 4096);
+		// Exult Studio reads 'gamedat' while map-editing.
+		instance = std::make_unique<Gamedat_delta>(
+				yn == "yes" && !Game::is_editing(),
+				static_cast<size_t>(std::max(kb, 0)) * 1024);
+	}
+	return *instance;
+}
+
 /*
  *  Write files from flex assuming first 13 characters of
  *  each flex object are an 8.3 filename.
@@ -209,6 +233,8 @@ void Game_window::restore_gamedat(const char* fname    // Name of savegame file.
 		return;
 	}
 
+	Gamedat_zip::get_instance().clear();    // It's all being replaced.
+	Gamedat_delta::get_instance().clear();
 	U7remove(USEDAT);
 	U7remove(USEVARS);
 	U7remove(U7NBUF_DAT);
@@ -314,6 +340,8 @@ void Game_window::save_gamedat(
 		const char* fname,      // File to create.
 		const char* savename    // User's savegame name.
 ) {
+	// Files saved to GDELTA go to their own files first.
+	Gamedat_delta::get_instance().compact();
 	// First check for compressed save game
 #ifdef HAVE_ZIP_SUPPORT
 	if (save_compression > 0 && save_gamedat_zip(fname, savename)) {
@@ -321,6 +349,11 @@ void Game_window::save_gamedat(
 	}
 #endif
 
+	// Superchunks still in a zipped savegame are needed now.
+	if (!Gamedat_zip::get_instance().fetch_all()) {
+		throw file_read_exception(fname);
+	}
+
 	// setup correct file list
 	tcb::span<const char* const> savefiles;
 	if (Game::get_game_type() == BLACK_GATE) {
@@ -867,6 +900,8 @@ bool Game_window::restore_gamedat_zip(
 	U7mkdir("<GAMEDAT>", 0755);    // Create dir. if not already there. Don't
 	// use GAMEDAT define cause that's got a
 	// trailing slash
+	Gamedat_zip::get_instance().clear();    // It's all being replaced.
+	Gamedat_delta::get_instance().clear();
 	U7remove(USEDAT);
 	U7remove(USEVARS);
 	U7remove(U7NBUF_DAT);
@@ -893,7 +928,9 @@ bool Game_window::restore_gamedat_zip(
 	char  oname[50];    // Set up name.
 	char* oname2 = oname + sizeof(GAMEDAT) - 1;
 	strcpy(oname, GAMEDAT);
-	bool level2zip = false;
+	bool         level2zip = false;
+	Gamedat_zip& pending   = Gamedat_zip::get_instance();
+	const bool   lazy      = Gamedat_zip::is_enabled();
 
 	do {
 		unz_file_info file_info;
@@ -949,6 +986,13 @@ bool Game_window::restore_gamedat_zip(
 			}
 		}
 
+		// Superchunks' objects can wait until they're read.
+		if (lazy && Gamedat_zip::is_lazy_member(oname2)) {
+			U7remove(oname);    // Any from another game.
+			pending.leave(oname, unzipfile);
+			continue;
+		}
+
 		// Open the file in the zip
 		if (unzOpenCurrentFile(unzipfile) != UNZ_OK) {
 			abort("Error opening current from zipfile '%s'.", fname);
@@ -979,7 +1023,9 @@ bool Game_window::restore_gamedat_zip(
 		cycle_load_palette();
 	} while (unzGoToNextFile(unzipfile) == UNZ_OK);
 
-	unzClose(unzipfile);
+	if (!pending.take(fname, unzipfile)) {
+		unzClose(unzipfile);
+	}
 
 	cout.flush();
 
@@ -1104,9 +1150,20 @@ bool Game_window::save_gamedat_zip(
 		savefiles = sisavefiles;
 	}
 
+	// Superchunks still in the savegame we restored are copied from it as
+	// they are for level 1, so if it's being overwritten, write to a new
+	// file first.
+	Gamedat_zip& pending = Gamedat_zip::get_instance();
+	if (save_compression == 2 && !pending.fetch_all()) {
+		throw file_read_exception(fname);
+	}
+	const bool        replacing = pending.is_reading(fname);
+	const std::string outname
+			= replacing ? std::string(fname) + ".tmp" : std::string(fname);
+
 	// Name
 	{
-		auto out = U7open_out(fname);
+		auto out = U7open_out(outname.c_str());
 		if (out) {
 			std::string title(savename);
 			title.resize(0x50, '\0');
@@ -1114,9 +1171,25 @@ bool Game_window::save_gamedat_zip(
 		}
 	}
 
-	const std::string filestr = get_system_path(fname);
+	const std::string filestr = get_system_path(outname);
 	zipFile           zipfile = zipOpen(filestr.c_str(), 1);
 
+	// If saving fails, close the file, and remove it if it was to replace
+	// the savegame.
+	struct Partial_save {
+		zipFile     zipfile;
+		const char* tmpname;
+
+		~Partial_save() {
+			if (zipfile) {
+				zipClose(zipfile, nullptr);
+			}
+			if (tmpname) {
+				U7remove(tmpname);
+			}
+		}
+	} partial{zipfile, replacing ? outname.c_str() : nullptr};
+
 	// We need to explicitly save these as they are no longer included in
 	// savefiles and they should always be stored first and as level 1
 	// Screenshot may not exist so only include it if it exists
@@ -1141,8 +1214,12 @@ bool Game_window::save_gamedat_zip(
 				// Check to see if the ireg exists before trying to
 				// save it; prevents crash when creating new maps
 				// for existing games
-				if (U7exists(
-							map->get_schunk_file_name(U7IREG, schunk, iname))) {
+				map->get_schunk_file_name(U7IREG, schunk, iname);
+				if (pending.is_pending(iname)) {
+					if (!pending.copy(zipfile, iname)) {
+						throw file_read_exception(iname);
+					}
+				} else if (U7exists(iname)) {
 					Save_level1(zipfile, iname);
 				}
 			}
@@ -1183,9 +1260,13 @@ bool Game_window::save_gamedat_zip(
 	}
 
 	// ++++Better error system needed??
+	partial.zipfile = nullptr;
 	if (zipClose(zipfile, savename) != ZIP_OK) {
 		throw file_write_exception(fname);
 	}
+	// Read the rest from the new one.
+	pending.moved_to(fname, replacing ? outname.c_str() : nullptr);
+	partial.tmpname = nullptr;
 
 	return true;
 }
@@ -1232,6 +1313,10 @@ void Game_window::MakeEmergencySave(const char* savename) {
 		auto gamedatpath   = get_system_path("<GAMEDAT>");
 		auto crashtemppath = get_system_path("<GAMEDAT>.crashtemp");
 
+		// Empty GDELTA into gamedat before it's copied, and close it
+		Gamedat_delta& delta = Gamedat_delta::get_instance();
+		delta.compact();
+
 		// change <GAMEDAT> to point to crashtemp
 		add_system_path("<GAMEDAT>", crashtemppath);
 
@@ -1269,5 +1354,8 @@ void Game_window::MakeEmergencySave(const char* savename) {
 
 		// Put <GAMEDAT> back to how it was
 		add_system_path("<GAMEDAT>", gamedatpath);
+
+		// What it knows was saved to crashtemp, not gamedat
+		delta.clear();
 	}
 }
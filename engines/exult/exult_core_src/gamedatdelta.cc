@@ -0,0 +1,204 @@
+/*
+ *  gamedatdelta.cc - Quick saves of only the 'gamedat' files that changed.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "gamedatdelta.h"
+
+#include "crc.h"
+#include "databuf.h"
+#include "exceptions.h"
+#include "fnames.h"
+#include "utils.h"
+
+#include <cstring>
+#include <ostream>
+
+/*
+ *  Each record in GDELTA is:
+ *      2 bytes:    Length of name.
+ *      n bytes:    Name ("<GAMEDAT>/...").
+ *      4 bytes:    Length of data.
+ *      4 bytes:    CRC of data (so a record cut off by a crash is seen).
+ *      n bytes:    Data.
+ *  A later record for a file replaces an earlier one.
+ */
+namespace {
+	const size_t record_header_size = 10;
+}    // namespace
+
+/*
+ *  Write a whole file.
+ */
+
+static void Write_file(
+		const char* name, const unsigned char* data, size_t len) {
+	auto out = U7open_out(name);
+	if (!out) {
+		throw file_write_exception(name);
+	}
+	out->write(reinterpret_cast<const char*>(data), len);
+	if (!out->good()) {
+		throw file_write_exception(name);
+	}
+}
+
+Gamedat_delta::Gamedat_delta(bool delta, size_t max)
+		: use_delta(delta), max_size(max) {}
+
+Gamedat_delta::~Gamedat_delta() = default;
+
+/*
+ *  Add a record to GDELTA.
+ */
+
+void Gamedat_delta::append(
+		const char* name, const unsigned char* data, size_t len, uint32 crc) {
+	if (!out) {
+		out = U7open_out(GDELTA);
+		if (!out) {
+			throw file_write_exception(GDELTA);
+		}
+	}
+	const size_t      namelen = std::strlen(name);
+	OStreamDataSource ds(out.get());
+	ds.write2(namelen);
+	ds.write(name, namelen);
+	ds.write4(len);
+	ds.write4(crc);
+	ds.write(data, len);
+	ds.flush();
+	if (!ds.good()) {
+		throw file_write_exception(GDELTA);
+	}
+	size += record_header_size + namelen + len;
+}
+
+/*
+ *  Save a file, unless it's what was saved last time.
+ *
+ *  Output: true if it was saved.  Throws an exception if error.
+ */
+
+bool Gamedat_delta::save(
+		const char* name,    // "<GAMEDAT>/...".
+		const void* data, size_t len) {
+	const auto*  bytes = static_cast<const unsigned char*>(data);
+	const uint32 crc   = crc32(bytes, len);
+	auto         it    = saved.find(name);
+	if (it != saved.end() && it->second.crc == crc && it->second.len == len) {
+		return false;
+	}
+	if (use_delta) {
+		append(name, bytes, len, crc);
+		files[name].assign(bytes, bytes + len);
+	} else {
+		Write_file(name, bytes, len);
+	}
+	if (it != saved.end()) {
+		it->second = Saved{crc, len};
+	} else {
+		saved.emplace(name, Saved{crc, len});
+	}
+	if (size > max_size) {
+		compact();
+	}
+	return true;
+}
+
+/*
+ *  Write a file from GDELTA to its own file, if it's there.
+ */
+
+void Gamedat_delta::fetch(const char* name) {
+	auto it = files.find(name);
+	if (it != files.end()) {
+		Write_file(name, it->second.data(), it->second.size());
+		files.erase(it);
+	}
+}
+
+/*
+ *  Write everything in GDELTA to its own file, and empty it.
+ */
+
+void Gamedat_delta::compact() {
+	for (const auto& [name, data] : files) {
+		Write_file(name.c_str(), data.data(), data.size());
+	}
+	files.clear();
+	out.reset();
+	if (size) {
+		U7remove(GDELTA);
+		size = 0;
+	}
+}
+
+/*
+ *  Forget everything, since 'gamedat' is being replaced.
+ */
+
+void Gamedat_delta::clear() {
+	files.clear();
+	saved.clear();
+	out.reset();
+	size = 0;
+	U7remove(GDELTA);
+}
+
+/*
+ *  After a restart, write out the files GDELTA has.  Records after one
+ *  that's bad (cut off when we stopped) are dropped.
+ */
+
+void Gamedat_delta::replay() {
+	files.clear();
+	saved.clear();
+	out.reset();
+	size = 0;
+	{
+		IFileDataSource ds(GDELTA);
+		if (!ds.good()) {
+			return;
+		}
+		const size_t total = ds.getSize();
+		while (ds.getPos() + record_header_size <= total) {
+			const size_t namelen = ds.read2();
+			std::string  name;
+			ds.read(name, namelen);
+			const uint32 len = ds.read4();
+			const uint32 crc = ds.read4();
+			if (!ds.good() || len > total - ds.getPos()) {
+				break;
+			}
+			std::vector<unsigned char> data(len);
+			ds.read(data.data(), len);
+			if (!ds.good() || crc32(data.data(), len) != crc) {
+				break;
+			}
+			files[name] = std::move(data);
+			saved[name] = Saved{crc, len};
+		}
+		size = total;
+	}
+	compact();
+}
@@ -0,0 +1,95 @@
+/*
+ *  gamedatdelta.h - Quick saves of only the 'gamedat' files that changed.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GAMEDATDELTA_H
+#define GAMEDATDELTA_H
+
+#include "common_types.h"
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ *  Saves the biggest 'gamedat' files (the superchunks' objects and the
+ *  NPCs) for Game_window::write().  One that's the same as when it was last
+ *  saved is skipped, and the rest are appended to GDELTA rather than each
+ *  file being rewritten.  They go to their own files when 'gamedat' is read
+ *  as a whole (restoring, or saving to a savegame), or when GDELTA gets
+ *  too big.
+ */
+class Gamedat_delta {
+	struct Saved {    // What was last saved of a file.
+		uint32 crc;
+		size_t len;
+	};
+
+	bool   use_delta;    // Else, files are written directly.
+	size_t max_size;     // Compact when GDELTA gets bigger.
+	// Newest data of those not yet in their own files, by name.
+	std::map<std::string, std::vector<unsigned char>, std::less<>> files;
+	std::map<std::string, Saved, std::less<>> saved;       // By name.
+	std::unique_ptr<std::ostream>             out;         // GDELTA, if open.
+	size_t                                    size = 0;    // Of GDELTA.
+
+	void append(
+			const char* name, const unsigned char* data, size_t len,
+			uint32 crc);
+
+public:
+	Gamedat_delta(bool delta, size_t max);
+	~Gamedat_delta();
+	Gamedat_delta(const Gamedat_delta&)            = delete;
+	Gamedat_delta& operator=(const Gamedat_delta&) = delete;
+
+	// Get the one for 'gamedat'.  GDELTA is used unless map-editing or
+	//   "config/disk/save_delta" is "no", and is compacted at
+	//   "config/disk/save_delta_kb".  (In gamedat.cc.)
+	static Gamedat_delta& get_instance();
+
+	// Save a file, unless it's what was last saved.  Output: true if saved.
+	bool save(const char* name, const void* data, size_t len);
+	bool save(const char* name, const std::string& data) {
+		return save(name, data.data(), data.size());
+	}
+
+	bool is_pending(const char* name) const {
+		return files.find(name) != files.end();
+	}
+
+	// Write a file from GDELTA, if it's there.
+	void fetch(const char* name);
+	// Write all to their own files, and empty GDELTA.
+	void compact();
+	// Forget all ('gamedat' is being replaced).
+	void clear();
+	// After a restart, write out what's in GDELTA.
+	void replay();
+
+	size_t get_size() const {
+		return size;
+	}
+};
+
+#endif
@@ -0,0 +1,442 @@
+/*
+ *  gamedatzip.cc - 'gamedat' files left in a zipped savegame until needed.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "gamedatzip.h"
+
+#include "Configuration.h"
+#include "exceptions.h"
+#include "fnames.h"
+#include "ignore_unused_variable_warning.h"
+#include "utils.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+#ifdef HAVE_ZIP_SUPPORT
+#	include "files/zip/unzip.h"
+#	include "files/zip/zip.h"
+#endif
+
+/*
+ *  Write GPENDZIP.
+ *
+ *  Output: false if error.
+ */
+
+static bool Write_pendzip(const std::string& zipname) {
+	auto out = U7open_out(GPENDZIP, true);
+	if (!out) {
+		return false;
+	}
+	*out << zipname << std::endl;
+	return out->good();
+}
+
+#ifdef HAVE_ZIP_SUPPORT
+/*
+ *  Go through the files in a zip, making each the current one and passing
+ *  its name within the zip.
+ */
+
+template <typename Func>
+static void For_each_member(unzFile uzf, Func&& func) {
+	int err = unzGoToFirstFile(uzf);
+	while (err == UNZ_OK) {
+		char member[256]{};
+		unzGetCurrentFileInfo(
+				uzf, nullptr, member, sizeof(member) - 1, nullptr, 0, nullptr,
+				0);
+		func(member);
+		err = unzGoToNextFile(uzf);
+	}
+}
+#endif
+
+Gamedat_zip::~Gamedat_zip() {
+	close_zip();
+}
+
+/*
+ *  Get the one for 'gamedat'.
+ */
+
+Gamedat_zip& Gamedat_zip::get_instance() {
+	static Gamedat_zip instance;
+	return instance;
+}
+
+/*
+ *  Should restoring a zipped savegame leave files in it?
+ */
+
+bool Gamedat_zip::is_enabled() {
+	std::string yn;
+	config->value("config/disk/lazy_restore", yn, "yes");
+	return yn == "yes";
+}
+
+/*
+ *  Is a file one that may be left in the zip?  Only the superchunks' objects
+ *  are; the rest are all read as soon as a game is restored.
+ */
+
+bool Gamedat_zip::is_lazy_member(const char* name) {
+	const char* base = std::strrchr(name, '/');
+	base             = base ? base + 1 : name;
+	// "u7ireg", without the "<GAMEDAT>/".
+	const char* prefix = U7IREG + sizeof(GAMEDAT) - 1;
+	return !std::strncmp(base, prefix, std::strlen(prefix));
+}
+
+/*
+ *  Open a savegame to read from.
+ *
+ *  Output: false if error.
+ */
+
+bool Gamedat_zip::open_zip(const char* fname) {
+	close_zip();
+#ifdef HAVE_ZIP_SUPPORT
+	const std::string filestr = get_system_path(fname);
+	unzFile           uzf     = unzOpen(filestr.c_str());
+	if (!uzf) {
+		return false;
+	}
+	zipname   = fname;
+	unzipfile = uzf;
+	return true;
+#else
+	ignore_unused_variable_warning(fname);
+	return false;
+#endif
+}
+
+void Gamedat_zip::close_zip() {
+#ifdef HAVE_ZIP_SUPPORT
+	if (unzipfile) {
+		unzClose(static_cast<unzFile>(unzipfile));
+	}
+#endif
+	unzipfile = nullptr;
+}
+
+/*
+ *  Leave the current file of a zip being restored in it.
+ */
+
+void Gamedat_zip::leave(
+		const char* name,    // Name in 'gamedat'.
+		void*       uzf      // The zip, an unzFile.
+) {
+#ifdef HAVE_ZIP_SUPPORT
+	unz_file_pos pos;
+	if (unzGetFilePos(static_cast<unzFile>(uzf), &pos) == UNZ_OK) {
+		pending[name] = Member{pos.pos_in_zip_directory, pos.num_of_file};
+	}
+#else
+	ignore_unused_variable_warning(name, uzf);
+#endif
+}
+
+/*
+ *  Done restoring from a zip.  If files were left in it, keep it open to
+ *  read them from.
+ *
+ *  Output: true if it was taken over (and mustn't be closed by the caller).
+ */
+
+bool Gamedat_zip::take(
+		const char* fname,    // Savegame.
+		void*       uzf       // It, open as an unzFile.
+) {
+	if (pending.empty()) {
+		return false;
+	}
+	close_zip();
+	zipname   = fname;
+	unzipfile = uzf;
+	if (!Write_pendzip(zipname)) {
+		// Can't find them after a restart, so get them now.
+		std::cerr << "Couldn't write '" << GPENDZIP << "'" << std::endl;
+		fetch_all();
+	}
+	return true;
+}
+
+/*
+ *  Forget all files left in a zip.
+ */
+
+void Gamedat_zip::clear() {
+	pending.clear();
+	close_zip();
+	zipname.clear();
+	U7remove(GPENDZIP);
+}
+
+/*
+ *  After a restart, find the files still in the zip named by GPENDZIP.
+ *  They're those it has that aren't in 'gamedat'.
+ */
+
+void Gamedat_zip::resume() {
+	pending.clear();
+	close_zip();
+	std::string fname;
+	try {
+		auto pIn = U7open_in(GPENDZIP, true);
+		if (pIn) {
+			std::getline(*pIn, fname);
+		}
+	} catch (const file_exception& /*f*/) {
+		return;    // None left.
+	}
+	if (fname.empty()) {
+		return;
+	}
+	if (!open_zip(fname.c_str())) {
+		std::cerr << "Couldn't open '" << fname
+				  << "' for the rest of 'gamedat'." << std::endl;
+		clear();
+		return;
+	}
+#ifdef HAVE_ZIP_SUPPORT
+	auto* uzf = static_cast<unzFile>(unzipfile);
+	For_each_member(uzf, [&](const char* member) {
+		const std::string name = std::string(GAMEDAT) + member;
+		if (is_lazy_member(member) && !U7exists(name)) {
+			leave(name.c_str(), uzf);
+		}
+	});
+#endif
+	if (pending.empty()) {
+		clear();
+	}
+}
+
+/*
+ *  Is this the savegame files are being read from?
+ */
+
+bool Gamedat_zip::is_reading(const char* fname) const {
+	return unzipfile && get_system_path(fname) == get_system_path(zipname);
+}
+
+/*
+ *  Write a file to 'gamedat' if it's still in the zip.
+ *
+ *  Output: false if error (reported).
+ */
+
+bool Gamedat_zip::fetch(const char* name) {
+	auto it = pending.find(name);
+	if (it == pending.end()) {
+		return true;
+	}
+#ifdef HAVE_ZIP_SUPPORT
+	auto*              uzf = static_cast<unzFile>(unzipfile);
+	const unz_file_pos pos{it->second.dir_pos, it->second.num};
+	unz_file_info      info;
+	if (unzGoToFilePos(uzf, &pos) != UNZ_OK
+		|| unzGetCurrentFileInfo(
+				   uzf, &info, nullptr, 0, nullptr, 0, nullptr, 0)
+				   != UNZ_OK
+		|| unzOpenCurrentFile(uzf) != UNZ_OK) {
+		std::cerr << "Couldn't find '" << name << "' in '" << zipname << "'"
+				  << std::endl;
+		return false;
+	}
+	std::vector<char> buf(info.uncompressed_size);
+	const int         len = unzReadCurrentFile(uzf, buf.data(), buf.size());
+	if (unzCloseCurrentFile(uzf) != UNZ_OK
+		|| len != static_cast<int>(buf.size())) {
+		std::cerr << "Error reading '" << name << "' from '" << zipname << "'"
+				  << std::endl;
+		return false;
+	}
+	auto out = U7open_out(name);
+	if (!out) {
+		std::cerr << "Couldn't open '" << name << "'" << std::endl;
+		return false;
+	}
+	out->write(buf.data(), buf.size());
+	if (!out->good()) {
+		std::cerr << "Error writing '" << name << "'" << std::endl;
+		return false;
+	}
+#endif
+	pending.erase(it);
+	if (pending.empty()) {
+		clear();
+	}
+	return true;
+}
+
+/*
+ *  Write all files still in the zip to 'gamedat'.
+ *
+ *  Output: false if error (reported).
+ */
+
+bool Gamedat_zip::fetch_all() {
+	while (!pending.empty()) {
+		if (!fetch(pending.begin()->first.c_str())) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ *  Copy a file still in the zip to one being written, without inflating
+ *  and deflating it again.
+ *
+ *  Output: false if error.
+ */
+
+bool Gamedat_zip::copy(
+		void*       zipfile,    // A zipFile.
+		const char* name        // Name in 'gamedat'.
+) {
+	auto it = pending.find(name);
+	if (it == pending.end()) {
+		return false;
+	}
+#ifdef HAVE_ZIP_SUPPORT
+	auto*              uzf = static_cast<unzFile>(unzipfile);
+	auto*              zf  = static_cast<zipFile>(zipfile);
+	const unz_file_pos pos{it->second.dir_pos, it->second.num};
+	unz_file_info      info;
+	char               member[256]{};
+	int                method;
+	int                level;
+	if (unzGoToFilePos(uzf, &pos) != UNZ_OK
+		|| unzGetCurrentFileInfo(
+				   uzf, &info, member, sizeof(member) - 1, nullptr, 0,
+				   nullptr, 0)
+				   != UNZ_OK
+		|| unzOpenCurrentFile2(uzf, &method, &level, 1) != UNZ_OK) {
+		return false;
+	}
+	int err = zipOpenNewFileInZip2(
+			zf, member, nullptr, nullptr, 0, nullptr, 0, nullptr, method,
+			level, 1);
+	std::vector<char> buf(16384);
+	int               len = 0;
+	while (err == ZIP_OK) {
+		len = unzReadCurrentFile(uzf, buf.data(), buf.size());
+		if (len <= 0) {
+			break;
+		}
+		err = zipWriteInFileInZip(zf, buf.data(), len);
+	}
+	const bool read_ok = unzCloseCurrentFile(uzf) == UNZ_OK && len == 0;
+	if (zipCloseFileInZipRaw(zf, info.uncompressed_size, info.crc) != ZIP_OK) {
+		err = ZIP_ERRNO;
+	}
+	return read_ok && err == ZIP_OK;
+#else
+	ignore_unused_variable_warning(zipfile);
+	return false;
+#endif
+}
+
+/*
+ *  A savegame was written with copies of all files still in the zip.  Read
+ *  them from it from now on, since the old one may be deleted.
+ */
+
+void Gamedat_zip::moved_to(
+		const char* fname,     // Savegame.
+		const char* written    // Where it was written, to be renamed to
+							   //   fname, or null.
+) {
+	if (pending.empty()) {
+		return;
+	}
+	// It may be the one being replaced, which can't be open for that on
+	//   some systems.
+	const std::string from = zipname;
+	close_zip();
+	if (written) {
+		std::error_code ec;
+		std::filesystem::rename(
+				get_system_path(written), get_system_path(fname), ec);
+		if (ec) {
+			// Keep reading from the old one.
+			if (!open_zip(from.c_str())) {
+				std::cerr << "Couldn't reopen '" << from
+						  << "' for the rest of 'gamedat'." << std::endl;
+				clear();
+			}
+			throw file_write_exception(fname);
+		}
+	}
+	// They may be in other places in the new one.
+	std::map<std::string, Member, std::less<>> old;
+	old.swap(pending);
+	if (!open_zip(fname)) {
+		std::cerr << "Couldn't open '" << fname
+				  << "' for the rest of 'gamedat'." << std::endl;
+		clear();
+		return;
+	}
+#ifdef HAVE_ZIP_SUPPORT
+	auto* uzf = static_cast<unzFile>(unzipfile);
+	For_each_member(uzf, [&](const char* member) {
+		const std::string name = std::string(GAMEDAT) + member;
+		if (old.find(name) != old.end()) {
+			leave(name.c_str(), uzf);
+		}
+	});
+#endif
+	if (pending.size() != old.size()) {
+		std::cerr << "Files missing from '" << fname << "'" << std::endl;
+	}
+	if (pending.empty()) {
+		clear();
+	} else if (!Write_pendzip(zipname)) {
+		std::cerr << "Couldn't write '" << GPENDZIP << "'" << std::endl;
+		fetch_all();
+	}
+}
+
+/*
+ *  A savegame is about to be deleted.  If files are still being read from
+ *  it, get them all now.
+ */
+
+void Gamedat_zip::release(const char* fname) {
+	if (!is_reading(fname)) {
+		return;
+	}
+	if (!fetch_all()) {
+		std::cerr << "Files in '" << fname << "' were lost from 'gamedat'."
+				  << std::endl;
+	}
+	clear();
+}
@@ -0,0 +1,89 @@
+/*
+ *  gamedatzip.h - 'gamedat' files left in a zipped savegame until needed.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef GAMEDATZIP_H
+#define GAMEDATZIP_H
+
+#include <functional>
+#include <map>
+#include <string>
+
+/*
+ *  The 'u7ireg' files of a zipped savegame that haven't been written to
+ *  'gamedat' yet.  Restoring leaves them in the zip; each is inflated when
+ *  its superchunk is first read, and those never read are copied to the
+ *  next save still compressed.  GPENDZIP names the zip, so that 'Journey
+ *  Onwards' can find them after a restart.
+ */
+class Gamedat_zip {
+	struct Member {    // Where it is in the zip (an unz_file_pos).
+		unsigned long dir_pos;
+		unsigned long num;
+	};
+
+	std::string zipname;                // Savegame (a U7 path).
+	void*       unzipfile = nullptr;    // It's open, as an unzFile.
+	// By their names in 'gamedat'.
+	std::map<std::string, Member, std::less<>> pending;
+
+	bool open_zip(const char* fname);
+	void close_zip();
+
+public:
+	Gamedat_zip() = default;
+	~Gamedat_zip();
+	Gamedat_zip(const Gamedat_zip&)            = delete;
+	Gamedat_zip& operator=(const Gamedat_zip&) = delete;
+
+	static Gamedat_zip& get_instance();
+	// Should restoring leave files in the zip ("config/disk/lazy_restore")?
+	static bool is_enabled();
+	// Is it a file that may be left in the zip (name within the zip)?
+	static bool is_lazy_member(const char* name);
+
+	// Leave the current file of a zip being restored in it, to be written
+	//   as 'name'.
+	void leave(const char* name, void* uzf);
+	// Done restoring from a zip.  Output: true if it was kept open.
+	bool take(const char* fname, void* uzf);
+	// Forget all ('gamedat' is being replaced).
+	void clear();
+	// After a restart, find what's still in the zip GPENDZIP names.
+	void resume();
+
+	bool is_pending(const char* name) const {
+		return pending.find(name) != pending.end();
+	}
+
+	// Is this the savegame being read from?
+	bool is_reading(const char* fname) const;
+	// Write a file to 'gamedat' if it's still in the zip.
+	bool fetch(const char* name);
+	bool fetch_all();
+	// Copy a file still in the zip, compressed, to a new one (a zipFile).
+	bool copy(void* zipfile, const char* name);
+	// A savegame was written with all pending files copied into it, to
+	//   'written' (if not null) and then to be renamed to 'fname'.
+	void moved_to(const char* fname, const char* written);
+	// A savegame is about to be deleted.
+	void release(const char* fname);
+};
+
+#endif
@@ -39,19 +39,24 @@
 #include "exceptions.h"
 #include "fnames.h"
 #include "game.h"
+#include "gamedatdelta.h"
+#include "gamedatzip.h"
 #include "gamewin.h" /* With some work, could get rid of this. */
 #include "ios_state.hpp"
 #include "jawbone.h"
+#include "mapprefetch.h"
 #include "mappatch.h"
 #include "objiter.cc" /* Yes we #include the .cc here on purpose! Please don't "fix" this */
 #include "objiter.h"
 #include "objs.h"
+#include "portals.h"
 #include "shapeinf.h"
 #include "spellbook.h"
 #include "ucsched.h"
 #include "virstone.h"
 #include "weaponinf.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -133,7 +138,8 @@ Chunk_terrain* Game_map::read_terrain(
 
 Game_map::Game_map(int n)
 		: num(n), didinit(false), map_modified(false), caching_out(0),
-		  map_patches(std::make_unique<Map_patch_collection>()) {}
+		  map_patches(std::make_unique<Map_patch_collection>()),
+		  portals(std::make_unique<Chunk_portals>(this)) {}
 
 /*
  *  Deleting map.
@@ -293,6 +299,12 @@ void Game_map::clear() {
 			obj.reset();
 		}
 	}
+	portals->clear();
+	if (Schunk_prefetch* prefetch = Schunk_prefetch::get_instance()) {
+		prefetch->forget(num);
+	}
+	prefetch_tx  = -1;
+	prefetch_ty  = -1;
 	didinit      = false;
 	map_modified = false;
 	// Clear 'read' flags.
@@ -345,6 +357,93 @@ void Game_map::read_map_data() {
 			}
 		}
 	}
+	prefetch_ahead();
+}
+
+/*
+ *  Watch how fast the view is moving, and start reading the superchunks
+ *  it will reach in the next couple of seconds on the prefetcher's thread.
+ */
+
+void Game_map::prefetch_ahead() {
+	Schunk_prefetch* prefetch = Schunk_prefetch::get_instance();
+	if (!prefetch || Game::is_editing()) {
+		return;
+	}
+	const unsigned int sample_ms    = 100;     // Sample this often.
+	const unsigned int lookahead_ms = 2000;    // Read this far ahead.
+	Game_window*       gwin         = Game_window::get_instance();
+	const int          scrolltx     = gwin->get_scrolltx();
+	const int          scrollty     = gwin->get_scrollty();
+	const unsigned int ticks        = Game::get_ticks();
+	const unsigned int elapsed      = ticks - prefetch_ticks;
+	if (prefetch_tx >= 0 && elapsed < sample_ms) {
+		return;
+	}
+	// Tiles moved, watching for wrapping.
+	auto delta = [](int from, int to) {
+		int d = to - from;
+		if (d > c_num_tiles / 2) {
+			d -= c_num_tiles;
+		} else if (d < -c_num_tiles / 2) {
+			d += c_num_tiles;
+		}
+		return d;
+	};
+	const int  dx = delta(prefetch_tx, scrolltx);
+	const int  dy = delta(prefetch_ty, scrollty);
+	const bool ok = prefetch_tx >= 0 && elapsed < 4 * sample_ms
+					&& std::abs(dx) < c_tiles_per_schunk
+					&& std::abs(dy) < c_tiles_per_schunk;
+	prefetch_tx    = scrolltx;
+	prefetch_ty    = scrollty;
+	prefetch_ticks = ticks;
+	if (!ok || (!dx && !dy)) {
+		return;    // Not moving, or teleported.
+	}
+	if (!prefetch->is_enabled()) {
+		return;
+	}
+	// Where it will be at this speed.
+	const int ms     = static_cast<int>(elapsed);
+	const int aheadx = std::clamp(
+			dx * static_cast<int>(lookahead_ms) / ms, -c_tiles_per_schunk,
+			c_tiles_per_schunk);
+	const int aheady = std::clamp(
+			dy * static_cast<int>(lookahead_ms) / ms, -c_tiles_per_schunk,
+			c_tiles_per_schunk);
+	// Superchunks under the view, moved ahead.
+	const int firsttx = scrolltx + aheadx - 1 + c_num_tiles;
+	const int firstty = scrollty + aheady - 1 + c_num_tiles;
+	const int lasttx  = firsttx + gwin->get_width() / c_tilesize + 2;
+	const int lastty  = firstty + gwin->get_height() / c_tilesize + 2;
+	char      fname[128];
+	for (int ty = firstty; ty < lastty + c_tiles_per_schunk;
+		 ty += c_tiles_per_schunk) {
+		const int sy = (std::min(ty, lastty) / c_tiles_per_schunk)
+					   % c_num_schunks;
+		for (int tx = firsttx; tx < lasttx + c_tiles_per_schunk;
+			 tx += c_tiles_per_schunk) {
+			const int sx = (std::min(tx, lasttx) / c_tiles_per_schunk)
+						   % c_num_schunks;
+			const int schunk = 12 * sy + sx;
+			if (schunk_read[schunk] || prefetch->is_requested(num, schunk)) {
+				continue;
+			}
+			const std::string ifix_name
+					= get_system_path(get_ifix_file_name(schunk, fname));
+			// Cached ireg data is newer than the file, and one still in a
+			// savegame or GDELTA is left for get_ireg_objects() to write.
+			get_schunk_file_name(U7IREG, schunk, fname);
+			const bool skip_ireg
+					= schunk_cache[schunk]
+					  || Gamedat_zip::get_instance().is_pending(fname)
+					  || Gamedat_delta::get_instance().is_pending(fname);
+			const std::string ireg_name
+					= skip_ireg ? std::string() : get_system_path(fname);
+			prefetch->request(num, schunk, ifix_name, ireg_name);
+		}
+	}
 }
 
 /*
@@ -571,40 +670,75 @@ void Game_map::write_ifix_objects(int schunk    // Superchunk # (0-143).
  *  Read in the objects for a superchunk from one of the "u7ifix" files.
  */
 
-void Game_map::get_ifix_objects(int schunk    // Superchunk # (0-143).
+void Game_map::get_ifix_objects(
+		int                 schunk,    // Superchunk # (0-143).
+		const Schunk_files* staged     // File read by Schunk_prefetch, or null.
 ) {
-	char fname[128];    // Set up name.
-	if (!is_system_path_defined("<PATCH>") ||
-		// First check for patch.
-		!U7exists(get_schunk_file_name(PATCH_U7IFIX, schunk, fname))) {
-		get_schunk_file_name(U7IFIX, schunk, fname);
-	}
-	IFileDataSource ifix(fname);
-	if (!ifix.good()) {
-		if (!Game::is_editing()) {    // Ok if map-editing.
-			cerr << "Ifix file '" << fname << "' not found." << endl;
+	std::unique_ptr<IDataSource> ifix;
+	if (staged && staged->ifix) {
+		ifix = std::make_unique<IBufferDataView>(
+				staged->ifix, staged->ifix_len);
+	} else {
+		char fname[128];    // Set up name.
+		ifix = std::make_unique<IFileDataSource>(
+				get_ifix_file_name(schunk, fname));
+		if (!ifix->good()) {
+			if (!Game::is_editing()) {    // Ok if map-editing.
+				cerr << "Ifix file '" << fname << "' not found." << endl;
+			}
+			return;
 		}
+	}
+	const int count = c_chunks_per_schunk * c_chunks_per_schunk;
+	if (ifix->getSize() < Flex_header::FLEX_HEADER_LEN + 8 * count) {
 		return;
 	}
-	FlexFile  flex(fname);
-	const int vers = static_cast<int>(flex.get_vers());
-	const int scy  = 16 * (schunk / 12);    // Get abs. chunk coords.
-	const int scx  = 16 * (schunk % 12);
+	// Get the version and the index from the flex header.
+	Flex_header hdr;
+	ifix->seek(Flex_header::FLEX_TITLE_LEN + 8);
+	hdr.magic2_val = ifix->read4();
+	const int vers = static_cast<int>(hdr.get_vers());
+	uint32    offsets[count];
+	uint32    lens[count];
+	ifix->seek(Flex_header::FLEX_HEADER_LEN);
+	for (int i = 0; i < count; i++) {
+		offsets[i] = ifix->read4();
+		lens[i]    = ifix->read4();
+	}
+	const int scy = 16 * (schunk / 12);    // Get abs. chunk coords.
+	const int scx = 16 * (schunk % 12);
 	// Go through chunks.
 	for (int cy = 0; cy < 16; cy++) {
 		for (int cx = 0; cx < 16; cx++) {
 			// Get to index entry for chunk.
-			const int    chunk_num = cy * 16 + cx;
-			size_t       len;
-			const uint32 offset = flex.get_entry_info(chunk_num, len);
-			if (len) {
+			const int chunk_num = cy * 16 + cx;
+			if (lens[chunk_num]) {
 				get_ifix_chunk_objects(
-						&ifix, vers, offset, len, scx + cx, scy + cy);
+						ifix.get(), vers, offsets[chunk_num], lens[chunk_num],
+						scx + cx, scy + cy);
 			}
 		}
 	}
 }
 
+/*
+ *  Get the name of the "ifix" file to read for a superchunk.
+ *
+ *  Output: fname.
+ */
+
+char* Game_map::get_ifix_file_name(
+		int   schunk,    // Superchunk # (0-143).
+		char* fname      // Name is stored here.
+) {
+	if (!is_system_path_defined("<PATCH>") ||
+		// First check for patch.
+		!U7exists(get_schunk_file_name(PATCH_U7IFIX, schunk, fname))) {
+		get_schunk_file_name(U7IFIX, schunk, fname);
+	}
+	return fname;
+}
+
 /*
  *  Get the objects from one ifix chunk entry onto the screen.
  */
@@ -755,12 +889,9 @@ void Game_map::write_ireg() {
 		if (schunk_cache[schunk] && schunk_cache_sizes[schunk] >= 0) {
 			// It's loaded in a memory buffer
 			char fname[128];    // Set up name.
-			auto ireg_stream
-					= U7open_out(get_schunk_file_name(U7IREG, schunk, fname));
-			if (ireg_stream) {
-				ireg_stream->write(
-						schunk_cache[schunk], schunk_cache_sizes[schunk]);
-			}
+			Gamedat_delta::get_instance().save(
+					get_schunk_file_name(U7IREG, schunk, fname),
+					schunk_cache[schunk], schunk_cache_sizes[schunk]);
 		} else if (schunk_read[schunk]) {
 			// It's active
 			write_ireg_objects(schunk);
@@ -769,17 +900,20 @@ void Game_map::write_ireg() {
 }
 
 /*
- *  Write out one of the "u7ireg" files.
+ *  Write out one of the "u7ireg" files.  It goes through Gamedat_delta, so
+ *  one that hasn't changed isn't rewritten.
  *
  *  Output: 0 if error, which is reported.
  */
 
 void Game_map::write_ireg_objects(int schunk    // Superchunk # (0-143).
 ) {
-	char            fname[128];    // Set up name.
-	OFileDataSource ireg(get_schunk_file_name(U7IREG, schunk, fname));
+	char fname[128];    // Set up name.
+	get_schunk_file_name(U7IREG, schunk, fname);
+	std::stringstream buf;
+	OStreamDataSource ireg(&buf);
 	write_ireg_objects(schunk, &ireg);
-	ireg.flush();
+	Gamedat_delta::get_instance().save(fname, buf.str());
 }
 
 /*
@@ -813,7 +947,9 @@ void Game_map::write_ireg_objects(
  *  (These are the moveable objects.)
  */
 
-void Game_map::get_ireg_objects(int schunk    // Superchunk # (0-143).
+void Game_map::get_ireg_objects(
+		int                 schunk,    // Superchunk # (0-143).
+		const Schunk_files* staged     // File read by Schunk_prefetch, or null.
 ) {
 	char                         fname[128];    // Set up name.
 	std::unique_ptr<IDataSource> ireg;
@@ -829,9 +965,15 @@ void Game_map::get_ireg_objects(int schunk    // Superchunk # (0-143).
 		std::cout << "Reading " << get_schunk_file_name(U7IREG, schunk, fname)
 				  << " from memory" << std::endl;
 #endif
+	} else if (staged && staged->ireg) {
+		ireg = std::make_unique<IBufferDataView>(
+				staged->ireg, staged->ireg_len);
 	} else {
-		ireg = std::make_unique<IFileDataSource>(
-				get_schunk_file_name(U7IREG, schunk, fname));
+		get_schunk_file_name(U7IREG, schunk, fname);
+		// It may still be in a savegame or GDELTA.
+		Gamedat_zip::get_instance().fetch(fname);
+		Gamedat_delta::get_instance().fetch(fname);
+		ireg = std::make_unique<IFileDataSource>(fname);
 		if (!ireg->good()) {
 			return;    // Just don't show them.
 		}
@@ -1260,11 +1402,17 @@ Ifix_game_object_shared Game_map::create_ifix_object(
 
 void Game_map::get_superchunk_objects(int schunk    // Superchunk #.
 ) {
-	get_map_objects(schunk);       // Get map objects/scenery.
-	get_ifix_objects(schunk);      // Get objects from ifix.
-	get_ireg_objects(schunk);      // Get moveable objects.
-	schunk_read[schunk] = true;    // Done this one now.
-	map_patches->apply(schunk);    // Move/delete objects.
+	// Use the files if the prefetcher has already read them.
+	Schunk_files     staged;
+	Schunk_prefetch* prefetch = Schunk_prefetch::get_instance();
+	if (prefetch) {
+		prefetch->take(num, schunk, staged);
+	}
+	get_map_objects(schunk);              // Get map objects/scenery.
+	get_ifix_objects(schunk, &staged);    // Get objects from ifix.
+	get_ireg_objects(schunk, &staged);    // Get moveable objects.
+	schunk_read[schunk] = true;           // Done this one now.
+	map_patches->apply(schunk);           // Move/delete objects.
 }
 
 /*
@@ -34,6 +34,7 @@
 #include <string>    // STL string
 #include <vector>
 
+class Chunk_portals;
 class Chunk_terrain;
 class Map_patch_collection;
 class Game_object;
@@ -45,6 +46,7 @@ class Shapes_vga_file;
 class IDataSource;
 class ODataSource;
 class Shape;
+struct Schunk_files;
 
 using Ireg_game_object_shared = std::shared_ptr<Ireg_game_object>;
 using Ifix_game_object_shared = std::shared_ptr<Ifix_game_object>;
@@ -75,7 +77,12 @@ class Game_map {
 	char* schunk_cache[144];
 	int   schunk_cache_sizes[144];
 	int   caching_out;    // >0 in 'cache_out_schunk'.
+	// Where the view was when last sampled by prefetch_ahead().
+	int          prefetch_tx    = -1;
+	int          prefetch_ty    = -1;
+	unsigned int prefetch_ticks = 0;
 	std::unique_ptr<Map_patch_collection> map_patches;
+	std::unique_ptr<Chunk_portals>        portals;    // For long paths.
 
 	Map_chunk*            create_chunk(int cx, int cy);
 	static Chunk_terrain* read_terrain(int chunk_num);
@@ -83,6 +90,10 @@ class Game_map {
 	// Create a 192x192 viewable map.
 	void create_minimap(Shape* minimaps, const unsigned char* chunk_pixels);
 	void cache_out_schunk(int schunk);
+	// Get name of "ifix" file for a superchunk (patch, if there's one).
+	char* get_ifix_file_name(int schunk, char* fname);
+	// Start reading superchunks the view is heading for.
+	void prefetch_ahead();
 
 public:
 	Game_map(int n);
@@ -113,6 +124,10 @@ public:
 		return *map_patches;
 	}
 
+	Chunk_portals& get_portals() {
+		return *portals;
+	}
+
 	void set_map_modified() {
 		map_modified = true;
 	}
@@ -204,7 +219,7 @@ public:
 	// Write (static) map objects.
 	void write_ifix_objects(int schunk);
 	// Get "ifix" objects for a superchunk.
-	void get_ifix_objects(int schunk);
+	void get_ifix_objects(int schunk, const Schunk_files* staged = nullptr);
 	// Get "ifix" objs. for given chunk.
 	void get_ifix_chunk_objects(
 			IDataSource* ifix, int vers, long filepos, int len, int cx, int cy);
@@ -221,7 +236,7 @@ public:
 	// Write moveable objects to datasource.
 	void write_ireg_objects(int schunk, ODataSource* ireg);
 	// Get moveable objects.
-	void get_ireg_objects(int schunk);
+	void get_ireg_objects(int schunk, const Schunk_files* staged = nullptr);
 	// Read scheduled script(s) for obj.
 	void read_special_ireg(IDataSource* ireg, Game_object* obj);
 	void read_ireg_objects(
@@ -36,9 +36,12 @@
 #include "gamemap.h"
 #include "gamewin.h"
 #include "ignore_unused_variable_warning.h"
+#include "mouse.h"
 #include "objiter.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <vector>
 
 /*
  *  Paint just the map with given top-left-corner tile.
@@ -205,7 +208,7 @@ int Game_render::paint_map(
 	Game_map*      map  = gwin->map;
 	Shape_manager* sman = gwin->shape_man;
 	render_seq++;    // Increment sequence #.
-	gwin->painted = true;
+	gwin->set_painted(TileRect(x, y, w, h));
 
 	const int scrolltx      = gwin->scrolltx;
 	const int scrollty      = gwin->scrollty;
@@ -239,17 +242,39 @@ int Game_render::paint_map(
 	}
 	int cx;
 	int cy;    // Chunk #'s.
-	// Paint all the flat scenery.
+	// Eggs and barges being shown draw some flats straight to the window.
+	const bool banded = !gwin->paint_eggs;
+	// Paint all the flat scenery.  Banded, the chunks' flats are just
+	//   found here, and copied below.
+	struct Chunk_flats {
+		Image_buffer8* flats;
+		int            xoff, yoff;
+	};
+
+	std::vector<Chunk_flats> flats;
 	for (cy = start_chunky; cy != stop_chunky; cy = INCR_CHUNK(cy)) {
 		const int yoff
 				= Figure_screen_offset(cy, scrollty) - gwin->get_scrollty_lo();
 		for (cx = start_chunkx; cx != stop_chunkx; cx = INCR_CHUNK(cx)) {
 			const int xoff = Figure_screen_offset(cx, scrolltx)
 							 - gwin->get_scrolltx_lo();
-			paint_chunk_flats(cx, cy, xoff, yoff);
+			if (!banded) {
+				paint_chunk_flats(cx, cy, xoff, yoff);
+				continue;
+			}
+			Image_buffer8* cflats
+					= map->get_chunk(cx, cy)->get_rendered_flats();
+			if (cflats) {
+				flats.push_back(Chunk_flats{cflats, xoff, yoff});
+			}
 		}
 	}
-	// Now the flat RLE terrain.
+	// Now the flat RLE terrain.  Banded, their frames are looked up here,
+	//   as the shapes cache is only safe on this thread, and recorded.
+	Shape_paint_list rles;
+	if (banded) {
+		sman->record_paints(&rles);
+	}
 	for (cy = start_chunky; cy != stop_chunky; cy = INCR_CHUNK(cy)) {
 		const int yoff
 				= Figure_screen_offset(cy, scrollty) - gwin->get_scrollty_lo();
@@ -259,6 +284,25 @@ int Game_render::paint_map(
 			paint_chunk_flat_rles(cx, cy, xoff, yoff);
 		}
 	}
+	if (banded) {
+		sman->record_paints(nullptr);
+		// None of this depends on anything outside the pixels it covers,
+		//   so bands of rows are painted at once, each through its own
+		//   view of the window clipped to its rows, in the same order.
+		Image_buffer8* ib8 = gwin->win->get_ib8();
+		gwin->win->run_in_bands(
+				y, h,
+				[&](int by, int bh) {
+					Image_buffer8 band(*ib8, x, by, w, bh);
+					for (const auto& each : flats) {
+						band.copy8(
+								each.flats->get_bits(), c_chunksize,
+								c_chunksize, each.xoff, each.yoff);
+					}
+					sman->paint(rles, &band);
+				},
+				c_tilesize * 4);
+	}
 	// Draw the chunk grid in Map editor cheat mode.
 	if (cheat.in_map_editor()) {
 		for (cy = start_chunky; cy != stop_chunky; cy = INCR_CHUNK(cy)) {
@@ -437,6 +481,7 @@ void Game_window::paint(
 
 	win->EndPaintIntoGuardBand();
 	win->clear_clip();
+	set_painted(TileRect(x, y, w, h));
 }
 
 /*
@@ -584,7 +629,6 @@ void Game_render::paint_chunk_flat_rles(
 int Game_render::paint_chunk_objects(
 		int cx, int cy    // Chunk coords (0 - 12*16).
 ) {
-	Game_object*      obj;
 	Game_window*      gwin          = Game_window::get_instance();
 	Map_chunk*        olist         = gwin->map->get_chunk(cx, cy);
 	int               light_sources = 0;    // Also check for light sources.
@@ -601,11 +645,28 @@ int Game_render::paint_chunk_objects(
 		}
 	}
 	skip = gwin->get_render_skip_lift();
-	Nonflat_object_iterator next(olist);
-
-	while ((obj = next.get_next()) != nullptr) {
+	// Use the order from before if nothing it depends on changed.
+	Chunk_paint_order& order = olist->get_paint_order();
+	bool               valid = order.skip == skip;
+	for (const auto& [chunk, version] : order.chunks) {
+		if (!valid) {
+			break;
+		}
+		valid = chunk->get_deps_version() == version;
+	}
+	if (valid) {
+		gwin->paint_order_hits++;
+	} else {
+		order_chunk_objects(olist);
+		gwin->paint_order_rebuilds++;
+	}
+	// Objects painted already (as other chunks' dependencies) are skipped,
+	//   along with all they depend on, so this is the same as painting
+	//   each after its dependencies.
+	for (auto* obj : order.objs) {
 		if (obj->render_seq != render_seq) {
-			paint_object(obj);
+			obj->render_seq = render_seq;
+			obj->paint();
 		}
 	}
 
@@ -614,26 +675,56 @@ int Game_render::paint_chunk_objects(
 }
 
 /*
- *  Render an object after first rendering any that it depends on.
+ *  Figure the order to paint a chunk's nonflats in:  each after the ones it
+ *  depends on (which may be in other chunks).
  */
 
-void Game_render::paint_object(Game_object* obj) {
+void Game_render::order_chunk_objects(Map_chunk* olist) {
+	Chunk_paint_order& order = olist->get_paint_order();
+	order.objs.clear();
+	order.chunks.clear();
+	order.skip = skip;
+	order.chunks.emplace_back(olist, olist->get_deps_version());
+	order_seq++;
+	Nonflat_object_iterator next(olist);
+	Game_object*            obj;
+	while ((obj = next.get_next()) != nullptr) {
+		if (obj->order_seq != order_seq) {
+			order_object(obj, order);
+		}
+	}
+}
+
+/*
+ *  Add an object to a chunk's paint order, after first adding any that it
+ *  depends on.
+ */
+
+void Game_render::order_object(Game_object* obj, Chunk_paint_order& order) {
 	const int lift = obj->get_lift();
 	if (lift >= skip) {
 		return;
 	}
-	obj->render_seq                          = render_seq;
-	const Game_object::Game_object_set& deps = obj->get_dependencies();
-	for (auto* dep : deps) {
-		if (dep && dep->render_seq != render_seq) {
-			paint_object(dep);
+	obj->order_seq = order_seq;
+	for (auto* dep : obj->get_dependencies()) {
+		if (dep && dep->order_seq != order_seq) {
+			order_object(dep, order);
 		}
 	}
-	obj->paint();    // Finally, paint this one.
+	order.objs.push_back(obj);
+	// Note other chunks it came from.
+	const Map_chunk* chunk = obj->get_chunk();
+	if (std::none_of(
+				order.chunks.begin(), order.chunks.end(),
+				[chunk](const std::pair<const Map_chunk*, uint32>& each) {
+					return each.first == chunk;
+				})) {
+		order.chunks.emplace_back(chunk, chunk->get_deps_version());
+	}
 }
 
 /*
- *  Paint 'dirty' rectangle.
+ *  Paint 'dirty' rectangles.
  */
 
 void Game_window::paint_dirty() {
@@ -645,13 +736,45 @@ void Game_window::paint_dirty() {
 
 	effects->update_dirty_text();
 
-	TileRect box = clip_to_win(dirty);
-	if (box.w > 0 && box.h > 0) {
-		paint(box);    // (Could create new dirty rects.)
+	if (!dirty.empty()) {
+		// Keep the frames we're about to paint.
+		shape_man->get_shapes().new_frame_epoch();
+		const Dirty_region area = dirty;    // (Could create new dirty rects.)
+		for (const auto& each : area) {
+			TileRect box = clip_to_win(each);
+			if (box.w > 0 && box.h > 0) {
+				paint(box);
+			}
+		}
 	}
 	clear_dirty();
 }
 
+/*
+ *  Blit what was painted to the screen.  Unless the whole window was, just
+ *  the painted rectangles are scaled.
+ *
+ *  Output: true if blit occurred.
+ */
+
+bool Game_window::show(bool force) {
+	if (painted || force) {
+		win->show();
+	} else if (!painted_area.empty()) {
+		// The caller won't blit the mouse after us.
+		if (Mouse::mouse) {
+			painted_area.add(Mouse::mouse->get_dirty());
+		}
+		win->show(painted_area);
+	} else {
+		return false;
+	}
+	++blits;
+	painted = false;
+	painted_area.clear();
+	return true;
+}
+
 /*
  *  Dungeon Blacking
  *
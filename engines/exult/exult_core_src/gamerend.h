@@ -23,6 +23,8 @@
 #define GAMEREND_H 1
 
 class Game_object;
+class Map_chunk;
+struct Chunk_paint_order;
 
 /*
  *  A helper-class for rendering.
@@ -31,6 +33,12 @@ class Game_render {
 	unsigned long render_seq = 0;     // For marking rendered objects.
 	int           skip       = 31;    // Set for each render.  We skip
 									  //   painting at or above this.
+	unsigned long order_seq  = 0;     // For marking objects being ordered.
+	// Figure the order to paint a chunk's objects in.
+	void order_chunk_objects(Map_chunk* olist);
+	// Add an obj. to the order after its dependencies.
+	void order_object(Game_object* obj, Chunk_paint_order& order);
+
 public:
 	void paint_terrain_only(
 			int start_chunkx, int start_chunky, int stop_chunkx,
@@ -46,8 +54,6 @@ public:
 	// Paint objects in given chunk at
 	//   given lift.
 	int paint_chunk_objects(int cx, int cy);
-	// Paint an obj. after dependencies.
-	void paint_object(Game_object* obj);
 	// Render dungeon blackness
 	void paint_blackness(
 			int start_chunkx, int start_chunky, int stop_chunkx,
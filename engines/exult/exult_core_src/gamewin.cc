@@ -60,18 +60,22 @@
 #include "fnames.h"
 #include "game.h"
 #include "gameclk.h"
+#include "gamedatdelta.h"
+#include "gamedatzip.h"
 #include "gamemap.h"
 #include "gamerend.h"
 #include "items.h"
 #include "keyactions.h"
 #include "keys.h"
 #include "mappatch.h"
+#include "mapprefetch.h"
 #include "monsters.h"
 #include "monstinf.h"
 #include "mouse.h"
 #include "npcnear.h"
 #include "objiter.h"
 #include "party.h"
+#include "pathqueue.h"
 #include "paths.h"
 #include "schedule.h"
 #include "spellbook.h"
@@ -298,7 +302,7 @@ Game_window::Game_window(
 		  in_dungeon(0), num_npcs1(0), std_delay(c_std_delay), time_stopped(0),
 		  special_light(0), theft_warnings(0), theft_cx(255), theft_cy(255),
 		  moving_barge(nullptr), main_actor(nullptr), camera_actor(nullptr),
-		  npcs(0), bodies(0), scrolltx(0), scrollty(0), dirty(0, 0, 0, 0),
+		  npcs(0), bodies(0), scrolltx(0), scrollty(0),
 		  save_names{}, mouse3rd(false), fastmouse(false),
 		  double_click_closes_gumps(false), text_bg(false), step_tile_delta(8),
 		  allow_right_pathfind(2), scroll_with_mouse(false),
@@ -306,13 +310,15 @@ Game_window::Game_window(
 		  extended_intro(false), load_palette_timer(0), plasma_start_color(0),
 		  plasma_cycle_range(0), skip_lift(255), paint_eggs(false),
 		  armageddon(false), walk_in_formation(false), debug(0), blits(0),
-		  scrolltx_l(0), scrollty_l(0), scrolltx_lp(0), scrollty_lp(0),
-		  scrolltx_lo(0), scrollty_lo(0), avposx_ld(0), avposy_ld(0),
-		  lerping_enabled(0) {
+		  paint_order_hits(0), paint_order_rebuilds(0), scrolltx_l(0),
+		  scrollty_l(0), scrolltx_lp(0), scrollty_lp(0), scrolltx_lo(0),
+		  scrollty_lo(0), avposx_ld(0), avposy_ld(0), lerping_enabled(0) {
 	game_window = this;    // Set static ->.
 	clock       = new Game_clock(tqueue);
 	shape_man   = new Shape_manager();    // Create the single instance.
 	maps.push_back(map);                  // Map #0.
+	path_queue   = new Path_request_queue();
+	map_prefetch = new Schunk_prefetch();
 	// Create window.
 	win = new Image_window8(
 			width, height, gwidth, gheight, scale, fullscreen, scaler, fillmode,
@@ -529,6 +535,8 @@ Game_window::~Game_window() {
 	delete npc_prox;
 	delete effects;
 	delete render;
+	delete path_queue;      // After all that might be waiting for a path.
+	delete map_prefetch;    // After the maps.
 }
 
 /*
@@ -1357,6 +1365,10 @@ bool Game_window::init_gamedat(bool create) {
 		if (static_identity != gamedat_identity) {
 			return false;
 		}
+		// Files saved since the last full write may be in GDELTA, and
+		// superchunks may still be in the savegame it was restored from.
+		Gamedat_delta::get_instance().replay();
+		Gamedat_zip::get_instance().resume();
 		// scroll coords.
 	}
 	read_save_names();    // Read in saved-game names.
@@ -1407,7 +1419,8 @@ void Game_window::read() {
 	// Display red plasma during load...
 	setup_load_palette();
 
-	clear_world(true);    // Wipe clean.
+	Gamedat_delta::get_instance().compact();    // Reads files directly.
+	clear_world(true);                          // Wipe clean.
 	read_gwin();          // Read our data.
 	// DON'T do anything that might paint()
 	// before calling read_npcs!!
@@ -1603,8 +1616,9 @@ void Game_window::view_right() {
 	win->copy(c_tilesize, 0, w - c_tilesize, h, 0, 0);
 	// Paint 1 column to right.
 	paint(w - c_tilesize, 0, c_tilesize, h);
-	dirty.x -= c_tilesize;    // Shift dirty rect.
-	dirty = clip_to_win(dirty);
+	dirty.shift(-c_tilesize, 0);    // Shift dirty rects.
+	dirty.intersect(get_full_rect());
+	set_painted();    // The whole image moved.
 	// New chunk?
 	const int new_rcx = ((scrolltx + (w - 1) / c_tilesize) / c_tiles_per_chunk)
 						% c_num_chunks;
@@ -1626,8 +1640,9 @@ void Game_window::view_left() {
 	win->copy(0, 0, get_width() - c_tilesize, get_height(), c_tilesize, 0);
 	const int h = get_height();
 	paint(0, 0, c_tilesize, h);
-	dirty.x += c_tilesize;    // Shift dirty rect.
-	dirty = clip_to_win(dirty);
+	dirty.shift(c_tilesize, 0);    // Shift dirty rects.
+	dirty.intersect(get_full_rect());
+	set_painted();    // The whole image moved.
 	// New chunk?
 	const int new_lcx = (scrolltx / c_tiles_per_chunk) % c_num_chunks;
 	if (new_lcx != old_lcx) {
@@ -1650,8 +1665,9 @@ void Game_window::view_down() {
 	map->read_map_data();    // Be sure objects are present.
 	win->copy(0, c_tilesize, w, h - c_tilesize, 0, 0);
 	paint(0, h - c_tilesize, w, c_tilesize);
-	dirty.y -= c_tilesize;    // Shift dirty rect.
-	dirty = clip_to_win(dirty);
+	dirty.shift(0, -c_tilesize);    // Shift dirty rects.
+	dirty.intersect(get_full_rect());
+	set_painted();    // The whole image moved.
 	// New chunk?
 	const int new_bcy = ((scrollty + (h - 1) / c_tilesize) / c_tiles_per_chunk)
 						% c_num_chunks;
@@ -1673,8 +1689,9 @@ void Game_window::view_up() {
 	const int w = get_width();
 	win->copy(0, 0, w, get_height() - c_tilesize, 0, c_tilesize);
 	paint(0, 0, w, c_tilesize);
-	dirty.y += c_tilesize;    // Shift dirty rect.
-	dirty = clip_to_win(dirty);
+	dirty.shift(0, c_tilesize);    // Shift dirty rects.
+	dirty.intersect(get_full_rect());
+	set_painted();    // The whole image moved.
 	// New chunk?
 	const int new_tcy = (scrollty / c_tiles_per_chunk) % c_num_chunks;
 	if (new_tcy != old_tcy) {
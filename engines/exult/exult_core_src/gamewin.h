@@ -71,6 +71,8 @@ class Dragging_info;
 class Game_map;
 class Shape_manager;
 class Party_manager;
+class Path_request_queue;
+class Schunk_prefetch;
 class ShapeID;
 class Shape_info;
 class Game_render;
@@ -101,6 +103,8 @@ class Game_window {
 	Image_window8*         win;          // Window to display into.
 	Npc_proximity_handler* npc_prox;     // Handles nearby NPC's.
 	Palette*               pal;
+	Path_request_queue*    path_queue;   // Finds paths on other threads.
+	Schunk_prefetch*       map_prefetch; // Reads superchunks ahead.
 	Shape_manager*         shape_man;    // Manages shape file.
 	Time_queue*            tqueue;       // Time-based queue.
 	Time_sensitive*        background_noise;
@@ -109,7 +113,7 @@ class Game_window {
 	bool combat;                // true if in combat.
 	bool focus;                 // Do we have focus?
 	bool ice_dungeon;           // true if inside ice dungeon
-	bool painted;               // true if we updated image buffer.
+	bool painted;               // true if we updated all of image buffer.
 	bool ambient_light;         // Permanent version of special_light.
 	bool infravision_active;    // Infravision flag.
 	// Game state values:
@@ -128,9 +132,10 @@ class Game_window {
 	std::vector<Actor_shared> npcs;      // Array of NPC's + the Avatar.
 	std::vector<Dead_body*>   bodies;    // Corresponding Dead_body's.
 	// Rendering info:
-	int      scrolltx, scrollty;    // Top-left tile of screen.
-	TileRect scroll_bounds;         // Walking outside this scrolls.
-	TileRect dirty;                 // Dirty rectangle.
+	int          scrolltx, scrollty;    // Top-left tile of screen.
+	TileRect     scroll_bounds;         // Walking outside this scrolls.
+	Dirty_region dirty;                 // Dirty rectangles.
+	Dirty_region painted_area;          // To show, if not all 'painted'.
 	// Savegames:
 	std::array<std::string, 10> save_names;    // Names of saved games.
 	// Options:
@@ -177,6 +182,9 @@ public:
 	bool   walk_in_formation;    // Use Party_manager for walking.
 	int    debug;
 	uint32 blits;    // For frame-counting.
+	// Chunks painted in the order from before, or after figuring it again.
+	uint32 paint_order_hits;
+	uint32 paint_order_rebuilds;
 	/*
 	 *  Class maintenance:
 	 */
@@ -599,26 +607,23 @@ public:
 		painted = true;
 	}
 
-	inline bool was_painted() const {
-		return painted;
+	// Just this part needs a blit.
+	void set_painted(const TileRect& r) {
+		painted_area.add(r);
 	}
 
-	bool show(bool force = false) {    // Returns true if blit occurred.
-		if (painted || force) {
-			win->show();
-			++blits;
-			painted = false;
-			return true;
-		}
-		return false;
+	inline bool was_painted() const {
+		return painted || !painted_area.empty();
 	}
 
-	void clear_dirty() {    // Clear dirty rectangle.
-		dirty.w = 0;
+	bool show(bool force = false);    // Returns true if blit occurred.
+
+	void clear_dirty() {    // Clear dirty rectangles.
+		dirty.clear();
 	}
 
 	bool is_dirty() const {
-		return dirty.w > 0;
+		return !dirty.empty();
 	}
 
 	// Paint scene at given tile.
@@ -633,17 +638,16 @@ public:
 	}
 
 	void paint();    // Paint whole image.
-	// Paint 'dirty' rectangle.
+	// Paint 'dirty' rectangles.
 	void paint_dirty();
 
 	void set_all_dirty() {    // Whole window.
-		dirty = TileRect(
-				win->get_start_x(), win->get_start_y(), win->get_full_width(),
-				win->get_full_height());
+		dirty.clear();
+		dirty.add(get_full_rect());
 	}
 
 	void add_dirty(const TileRect& r) {    // Add rectangle to dirty area.
-		dirty = dirty.w > 0 ? dirty.add(r) : r;
+		dirty.add(r);
 	}
 
 	// Add dirty rect. for obj. Rets. false
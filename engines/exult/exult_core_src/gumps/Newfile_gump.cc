@@ -33,6 +33,7 @@
 #include "exult_flx.h"
 #include "game.h"
 #include "gameclk.h"
+#include "gamedatzip.h"
 #include "gamewin.h"
 #include "listfiles.h"
 #include "miscinf.h"
@@ -274,6 +275,8 @@ void Newfile_gump::delete_file() {
 		return;
 	}
 
+	// 'gamedat' may still need files from it.
+	Gamedat_zip::get_instance().release(games[selected].filename);
 	U7remove(games[selected].filename);
 	filename    = nullptr;
 	is_readable = false;
@@ -16,8 +16,8 @@
  *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
-#ifndef COMMON_TYPES_H
-#define COMMON_TYPES_H
+#ifndef EXULT_COMMON_TYPES_H
+#define EXULT_COMMON_TYPES_H
 
 #ifdef HAVE_CONFIG_H
 #	include <config.h>
@@ -72,4 +72,4 @@ using sintptr = intptr_t;
 #	endif
 #endif
 
-#endif    // COMMON_TYPES_H
+#endif    // EXULT_COMMON_TYPES_H
@@ -27,8 +27,10 @@
 
 #include "common_types.h"
 #include "endianio.h"
+#include "ibuf8_simd.h"
 #include "ignore_unused_variable_warning.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -36,6 +38,30 @@
 using std::cerr;
 using std::endl;
 
+// The kernels take an array of Xform_palettes as one table after another.
+static_assert(sizeof(Xform_palette) == 256, "Xform_palette must be packed");
+
+/*
+ *  Create a view of another buffer's pixels.
+ */
+
+Image_buffer8::Image_buffer8(
+		Image_buffer8& base,          // Buffer whose pixels we use.
+		int x, int y, int w, int h    // Clip to this within base's clip.
+		)
+		: Image_buffer(base), is_view(true) {
+	int clx;
+	int cly;
+	int clw;
+	int clh;
+	base.get_clip(clx, cly, clw, clh);
+	const int left   = std::max(x, clx);
+	const int top    = std::max(y, cly);
+	const int right  = std::min(x + w, clx + clw);
+	const int bottom = std::min(y + h, cly + clh);
+	set_clip(left, top, std::max(right - left, 0), std::max(bottom - top, 0));
+}
+
 /*
  *  Copy an area of the image within itself.
  */
@@ -437,15 +463,13 @@ void Image_buffer8::copy_hline_translucent8(
 	}
 	unsigned char*       to   = bits + desty * line_width + destx;
 	const unsigned char* from = src_pixels + srcx;
-	for (int i = srcw; i; i--) {
-		// Get char., and transform.
-		unsigned char c = Read1(from);
-		if (c >= first_translucent && c <= last_translucent) {
-			// Use table to shift existing pixel.
-			c = xforms[c - first_translucent][*to];
-		}
-		Write1(to, c);
+	if (first_translucent > last_translucent) {
+		std::memcpy(to, from, srcw);
+		return;
 	}
+	Ibuf8_kernels::get().copy_translucent(
+			to, from, srcw, first_translucent, last_translucent,
+			xforms->colors);
 }
 
 /*
@@ -464,10 +488,7 @@ void Image_buffer8::fill_hline_translucent8(
 		return;
 	}
 	unsigned char* pixels = bits + desty * line_width + destx;
-	while (srcw--) {
-		*pixels = xform[*pixels];
-		pixels++;
-	}
+	Ibuf8_kernels::get().xform(pixels, srcw, xform.colors);
 }
 
 /*
@@ -485,13 +506,11 @@ void Image_buffer8::fill_translucent8(
 	if (!clip(srcx, srcy, srcw, srch, destx, desty)) {
 		return;
 	}
-	unsigned char* pixels  = bits + desty * line_width + destx;
-	const int      to_next = line_width - srcw;    // # pixels to next line.
-	while (srch--) {                               // Do each line.
-		for (int cnt = srcw; cnt; cnt--, pixels++) {
-			*pixels = xform[*pixels];
-		}
-		pixels += to_next;    // Get to start of next line.
+	const Ibuf8_kernels& kernels = Ibuf8_kernels::get();
+	unsigned char*       pixels  = bits + desty * line_width + destx;
+	while (srch--) {    // Do each line.
+		kernels.xform(pixels, srcw, xform.colors);
+		pixels += line_width;    // Get to start of next line.
 	}
 }
 
@@ -568,11 +587,8 @@ void Image_buffer8::paint_rle(int xoff, int yoff, const unsigned char* inptr) {
 				// Is there anything to put on the screen?
 				if (skip < scanlen) {
 					unsigned char* dest = bits + scany * line_width + scanx;
-					const unsigned char* end = in + scanlen - skip;
-					while (in < end) {
-						Write1(dest, Read1(in));
-					}
-					in += skip;
+					std::memcpy(dest, in, scanlen - skip);
+					in += scanlen;
 					continue;
 				}
 			}
@@ -608,10 +624,8 @@ void Image_buffer8::paint_rle(int xoff, int yoff, const unsigned char* inptr) {
 						// Is there anything to put on the screen?
 						if (skip < bcnt) {
 							const unsigned char col = Read1(in);
-							unsigned char*      end = dest + bcnt - skip;
-							while (dest < end) {
-								Write1(dest, col);
-							}
+							std::memset(dest, col, bcnt - skip);
+							dest += bcnt - skip;
 
 							// dest += skip; - Don't need it
 							scanx += bcnt;
@@ -646,12 +660,10 @@ void Image_buffer8::paint_rle(int xoff, int yoff, const unsigned char* inptr) {
 
 						// Is there anything to put on the screen?
 						if (skip < bcnt) {
-							unsigned char* end = dest + bcnt - skip;
-							while (dest < end) {
-								Write1(dest, Read1(in));
-							}
+							std::memcpy(dest, in, bcnt - skip);
+							dest += bcnt - skip;
 							// dest += skip; - Don't need it
-							in += skip;
+							in += bcnt;
 							scanx += bcnt;
 							scanlen -= bcnt;
 							continue;
@@ -688,10 +700,11 @@ void Image_buffer8::paint_rle(int xoff, int yoff, const unsigned char* inptr) {
 void Image_buffer8::paint_rle_remapped(
 		int xoff, int yoff, const unsigned char* inptr,
 		const unsigned char*& trans) {
-	const uint8* in = inptr;
-	int          scanlen;
-	const int    right  = clipx + clipw;
-	const int    bottom = clipy + cliph;
+	const Ibuf8_kernels& kernels = Ibuf8_kernels::get();
+	const uint8*         in      = inptr;
+	int                  scanlen;
+	const int            right   = clipx + clipw;
+	const int            bottom  = clipy + cliph;
 
 	while ((scanlen = little_endian::Read2(in)) != 0) {
 		// Get length of scan line.
@@ -727,11 +740,8 @@ void Image_buffer8::paint_rle_remapped(
 				// Is there anything to put on the screen?
 				if (skip < scanlen) {
 					unsigned char* dest = bits + scany * line_width + scanx;
-					const unsigned char* end = in + scanlen - skip;
-					while (in < end) {
-						Write1(dest, trans[Read1(in)]);
-					}
-					in += skip;
+					kernels.remap(dest, in, scanlen - skip, trans);
+					in += scanlen;
 					continue;
 				}
 			}
@@ -767,10 +777,8 @@ void Image_buffer8::paint_rle_remapped(
 						// Is there anything to put on the screen?
 						if (skip < bcnt) {
 							const unsigned char col = Read1(in);
-							unsigned char*      end = dest + bcnt - skip;
-							while (dest < end) {
-								Write1(dest, trans[col]);
-							}
+							std::memset(dest, trans[col], bcnt - skip);
+							dest += bcnt - skip;
 
 							// dest += skip; - Don't need it
 							scanx += bcnt;
@@ -805,12 +813,10 @@ void Image_buffer8::paint_rle_remapped(
 
 						// Is there anything to put on the screen?
 						if (skip < bcnt) {
-							unsigned char* end = dest + bcnt - skip;
-							while (dest < end) {
-								Write1(dest, trans[Read1(in)]);
-							}
+							kernels.remap(dest, in, bcnt - skip, trans);
+							dest += bcnt - skip;
 							// dest += skip; - Don't need it
-							in += skip;
+							in += bcnt;
 							scanx += bcnt;
 							scanlen -= bcnt;
 							continue;
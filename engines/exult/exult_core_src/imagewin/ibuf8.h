@@ -28,6 +28,8 @@
  *  An 8-bit image buffer:
  */
 class Image_buffer8 : public Image_buffer {
+	bool is_view = false;    // Bits belong to another buffer.
+
 	// Private ctor. for Image_window8.
 	Image_buffer8(unsigned int w, unsigned int h, Image_buffer*)
 			: Image_buffer(w, h, 8) {}
@@ -36,6 +38,17 @@ public:
 	Image_buffer8(unsigned int w, unsigned int h) : Image_buffer(w, h, 8) {
 		bits = new unsigned char[w * h];
 	}
+
+	// A view of base's pixels, clipped to where rect. (x, y, w, h) is in
+	//   base's clip.  Views with disjoint clips may be painted at once on
+	//   different threads.  It must not outlive base.
+	Image_buffer8(Image_buffer8& base, int x, int y, int w, int h);
+
+	~Image_buffer8() override {
+		if (is_view) {
+			bits = nullptr;    // Not ours to delete.
+		}
+	}
 	friend class Image_window8;
 
 	/*
@@ -0,0 +1,81 @@
+/*
+ *  ibuf8_avx2.cc - AVX2 inner loops for painting into 8-bit buffers.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "ibuf8_simd.h"
+
+#include "common/scummsys.h"    // For SCUMMVM_AVX2.
+
+#ifdef SCUMMVM_AVX2
+
+#	include <immintrin.h>
+
+#	if defined(__clang__)
+#		pragma clang attribute push(                                           \
+				__attribute__((target("avx2"))), apply_to = function)
+#	elif defined(__GNUC__)
+#		pragma GCC push_options
+#		pragma GCC target("avx2")
+#	endif
+
+/*
+ *  Copy a run, shifting what's under the translucent colors.  Blocks of 32
+ *  with none are just stored.
+ */
+
+static void Copy_translucent_avx2(
+		unsigned char* to, const unsigned char* from, int cnt, int first,
+		int last, const unsigned char* xforms) {
+	const __m256i vfirst = _mm256_set1_epi8(static_cast<char>(first));
+	const __m256i vrange = _mm256_set1_epi8(static_cast<char>(last - first));
+	const __m256i zero   = _mm256_setzero_si256();
+	for (; cnt >= 32; cnt -= 32, to += 32, from += 32) {
+		const __m256i src
+				= _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from));
+		// c is translucent if (c - first) <= (last - first), unsigned.
+		const __m256i over
+				= _mm256_subs_epu8(_mm256_sub_epi8(src, vfirst), vrange);
+		const unsigned mask
+				= _mm256_movemask_epi8(_mm256_cmpeq_epi8(over, zero));
+		if (!mask) {
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(to), src);
+		} else {
+			Ibuf8_copy_translucent_block(to, from, 32, mask, first, xforms);
+		}
+	}
+	Ibuf8_copy_translucent_scalar(to, from, cnt, first, last, xforms);
+}
+
+// Table lookups on vpshufb take 16 shuffles and blends per 32 bytes, which
+//   is no faster than the scalar loop, so they stay scalar.
+const Ibuf8_kernels Ibuf8_kernels::avx2
+		= {"avx2", Ibuf8_remap_scalar, Ibuf8_xform_scalar,
+		   Copy_translucent_avx2};
+
+#	if defined(__clang__)
+#		pragma clang attribute pop
+#	elif defined(__GNUC__)
+#		pragma GCC pop_options
+#	endif
+
+#endif    // SCUMMVM_AVX2
@@ -0,0 +1,156 @@
+/*
+ *  ibuf8_neon.cc - NEON inner loops for painting into 8-bit buffers.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "ibuf8_simd.h"
+
+#include "common/scummsys.h"    // For SCUMMVM_NEON.
+
+#ifdef SCUMMVM_NEON
+
+#	include <arm_neon.h>
+
+#	if !defined(__aarch64__) && !defined(__ARM_NEON)
+#		if defined(__clang__)
+#			pragma clang attribute push(                                       \
+					__attribute__((target("neon"))), apply_to = function)
+#		elif defined(__GNUC__)
+#			pragma GCC push_options
+#			pragma GCC target("fpu=neon")
+#		endif
+#	endif
+
+#	ifdef __aarch64__
+namespace {
+	/*
+	 *  A 256-byte table, as 4 quarters for TBL/TBX.
+	 */
+	struct Table_quarters {
+		uint8x16x4_t quarters[4];
+
+		explicit Table_quarters(const unsigned char* table) {
+			for (int i = 0; i < 4; i++) {
+				for (int j = 0; j < 4; j++) {
+					quarters[i].val[j] = vld1q_u8(table + 64 * i + 16 * j);
+				}
+			}
+		}
+
+		// Look up 16 bytes.  TBX leaves a lane alone when its index is out
+		//   of range, so each quarter fills in only its own.
+		uint8x16_t lookup(uint8x16_t idx) const {
+			const uint8x16_t step = vdupq_n_u8(64);
+			uint8x16_t       out  = vqtbl4q_u8(quarters[0], idx);
+			for (int i = 1; i < 4; i++) {
+				idx = vsubq_u8(idx, step);
+				out = vqtbx4q_u8(out, quarters[i], idx);
+			}
+			return out;
+		}
+	};
+
+	// Below this, loading the quarters costs more than it saves.
+	const int min_lookup_run = 32;
+}    // namespace
+
+/*
+ *  Remap a run through a table.
+ */
+
+static void Remap_neon(
+		unsigned char* to, const unsigned char* from, int cnt,
+		const unsigned char* table) {
+	if (cnt >= min_lookup_run) {
+		const Table_quarters quarters(table);
+		for (; cnt >= 16; cnt -= 16, to += 16, from += 16) {
+			vst1q_u8(to, quarters.lookup(vld1q_u8(from)));
+		}
+	}
+	Ibuf8_remap_scalar(to, from, cnt, table);
+}
+
+/*
+ *  Transform a run in place.
+ */
+
+static void Xform_neon(
+		unsigned char* to, int cnt, const unsigned char* table) {
+	if (cnt >= min_lookup_run) {
+		const Table_quarters quarters(table);
+		for (; cnt >= 16; cnt -= 16, to += 16) {
+			vst1q_u8(to, quarters.lookup(vld1q_u8(to)));
+		}
+	}
+	Ibuf8_xform_scalar(to, cnt, table);
+}
+#	endif    // __aarch64__
+
+/*
+ *  Copy a run, shifting what's under the translucent colors.  Blocks of 16
+ *  with none are just stored.
+ */
+
+static void Copy_translucent_neon(
+		unsigned char* to, const unsigned char* from, int cnt, int first,
+		int last, const unsigned char* xforms) {
+	const uint8x16_t vfirst = vdupq_n_u8(static_cast<uint8_t>(first));
+	const uint8x16_t vrange = vdupq_n_u8(static_cast<uint8_t>(last - first));
+	for (; cnt >= 16; cnt -= 16, to += 16, from += 16) {
+		const uint8x16_t src = vld1q_u8(from);
+		// c is translucent if (c - first) <= (last - first), unsigned.
+		const uint8x16_t trans = vcleq_u8(vsubq_u8(src, vfirst), vrange);
+		const uint64x2_t wide  = vreinterpretq_u64_u8(trans);
+		if (!(vgetq_lane_u64(wide, 0) | vgetq_lane_u64(wide, 1))) {
+			vst1q_u8(to, src);
+			continue;
+		}
+		unsigned char lanes[16];
+		vst1q_u8(lanes, trans);
+		unsigned mask = 0;
+		for (int i = 0; i < 16; i++) {
+			mask |= (lanes[i] & 1u) << i;
+		}
+		Ibuf8_copy_translucent_block(to, from, 16, mask, first, xforms);
+	}
+	Ibuf8_copy_translucent_scalar(to, from, cnt, first, last, xforms);
+}
+
+#	ifdef __aarch64__
+const Ibuf8_kernels Ibuf8_kernels::neon
+		= {"neon", Remap_neon, Xform_neon, Copy_translucent_neon};
+#	else
+// 32-bit NEON's table lookups only reach 32 bytes, so they stay scalar.
+const Ibuf8_kernels Ibuf8_kernels::neon
+		= {"neon", Ibuf8_remap_scalar, Ibuf8_xform_scalar,
+		   Copy_translucent_neon};
+#	endif
+
+#	if !defined(__aarch64__) && !defined(__ARM_NEON)
+#		if defined(__clang__)
+#			pragma clang attribute pop
+#		elif defined(__GNUC__)
+#			pragma GCC pop_options
+#		endif
+#	endif
+
+#endif    // SCUMMVM_NEON
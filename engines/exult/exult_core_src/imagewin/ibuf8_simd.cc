@@ -0,0 +1,98 @@
+/*
+ *  ibuf8_simd.cc - Inner loops for painting shapes into 8-bit buffers.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "ibuf8_simd.h"
+
+#include "common/system.h"    // For g_system->hasFeature().
+
+/*
+ *  Remap a run through a table.
+ */
+
+void Ibuf8_remap_scalar(
+		unsigned char* to, const unsigned char* from, int cnt,
+		const unsigned char* table) {
+	while (cnt--) {
+		*to++ = table[*from++];
+	}
+}
+
+/*
+ *  Transform a run in place.
+ */
+
+void Ibuf8_xform_scalar(
+		unsigned char* to, int cnt, const unsigned char* table) {
+	while (cnt--) {
+		*to = table[*to];
+		to++;
+	}
+}
+
+/*
+ *  Copy a run, shifting what's under the translucent colors.
+ */
+
+void Ibuf8_copy_translucent_scalar(
+		unsigned char* to, const unsigned char* from, int cnt, int first,
+		int last, const unsigned char* xforms) {
+	while (cnt--) {
+		unsigned char c = *from++;
+		if (c >= first && c <= last) {
+			c = xforms[(c - first) * 256 + *to];
+		}
+		*to++ = c;
+	}
+}
+
+const Ibuf8_kernels Ibuf8_kernels::scalar
+		= {"scalar", Ibuf8_remap_scalar, Ibuf8_xform_scalar,
+		   Ibuf8_copy_translucent_scalar};
+
+/*
+ *  Get the fastest kernels this CPU can run.
+ */
+
+const Ibuf8_kernels& Ibuf8_kernels::get() {
+	static const Ibuf8_kernels* best = nullptr;
+	if (!best) {
+		best = &scalar;
+#ifdef SCUMMVM_NEON
+		if (g_system->hasFeature(OSystem::kFeatureCpuNEON)) {
+			best = &neon;
+		}
+#endif
+#ifdef SCUMMVM_SSE2
+		if (g_system->hasFeature(OSystem::kFeatureCpuSSE2)) {
+			best = &sse2;
+		}
+#endif
+#ifdef SCUMMVM_AVX2
+		if (g_system->hasFeature(OSystem::kFeatureCpuAVX2)) {
+			best = &avx2;
+		}
+#endif
+	}
+	return *best;
+}
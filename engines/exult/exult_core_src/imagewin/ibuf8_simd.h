@@ -0,0 +1,75 @@
+/*
+ *  ibuf8_simd.h - Inner loops for painting shapes into 8-bit buffers.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef INCL_IBUF8_SIMD
+#define INCL_IBUF8_SIMD 1
+
+/*
+ *  The per-pixel loops of Image_buffer8's RLE and translucency painters.
+ *  'scalar' is the reference; the others give the same pixels, and get()
+ *  picks the best one the CPU has the first time it's called.  Tables are
+ *  256 bytes (an Xform_palette's colors); 'xforms' holds one for each
+ *  color from 'first' to 'last', which must be 0 <= first <= last <= 255.
+ */
+struct Ibuf8_kernels {
+	const char* name;
+	// to[i] = table[from[i]].
+	void (*remap)(
+			unsigned char* to, const unsigned char* from, int cnt,
+			const unsigned char* table);
+	// to[i] = table[to[i]].
+	void (*xform)(unsigned char* to, int cnt, const unsigned char* table);
+	// Copy, but colors first..last shift what's under them instead.
+	void (*copy_translucent)(
+			unsigned char* to, const unsigned char* from, int cnt, int first,
+			int last, const unsigned char* xforms);
+
+	static const Ibuf8_kernels& get();
+
+	static const Ibuf8_kernels scalar;
+	// Only defined where the build has them (SCUMMVM_SSE2, etc.).
+	static const Ibuf8_kernels sse2;
+	static const Ibuf8_kernels avx2;
+	static const Ibuf8_kernels neon;
+};
+
+// The reference loops, which the others use for their leftovers.
+void Ibuf8_remap_scalar(
+		unsigned char* to, const unsigned char* from, int cnt,
+		const unsigned char* table);
+void Ibuf8_xform_scalar(unsigned char* to, int cnt, const unsigned char* table);
+void Ibuf8_copy_translucent_scalar(
+		unsigned char* to, const unsigned char* from, int cnt, int first,
+		int last, const unsigned char* xforms);
+
+/*
+ *  Copy a block of 'cnt' pixels where bit i of 'mask' is set if from[i] is
+ *  translucent.
+ */
+inline void Ibuf8_copy_translucent_block(
+		unsigned char* to, const unsigned char* from, int cnt, unsigned mask,
+		int first, const unsigned char* xforms) {
+	for (int i = 0; i < cnt; i++) {
+		const unsigned char c = from[i];
+		to[i] = (mask >> i) & 1 ? xforms[(c - first) * 256 + to[i]] : c;
+	}
+}
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ *  ibuf8_sse2.cc - SSE2 inner loops for painting into 8-bit buffers.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "ibuf8_simd.h"
+
+#include "common/scummsys.h"    // For SCUMMVM_SSE2.
+
+#ifdef SCUMMVM_SSE2
+
+#	include <emmintrin.h>
+
+#	if !defined(__x86_64__)
+#		if defined(__clang__)
+#			pragma clang attribute push(                                       \
+					__attribute__((target("sse2"))), apply_to = function)
+#		elif defined(__GNUC__)
+#			pragma GCC push_options
+#			pragma GCC target("sse2")
+#		endif
+#	endif
+
+/*
+ *  Copy a run, shifting what's under the translucent colors.  Blocks of 16
+ *  with none (the usual case away from a shape's edges) are just stored.
+ */
+
+static void Copy_translucent_sse2(
+		unsigned char* to, const unsigned char* from, int cnt, int first,
+		int last, const unsigned char* xforms) {
+	const __m128i vfirst = _mm_set1_epi8(static_cast<char>(first));
+	const __m128i vrange = _mm_set1_epi8(static_cast<char>(last - first));
+	const __m128i zero   = _mm_setzero_si128();
+	for (; cnt >= 16; cnt -= 16, to += 16, from += 16) {
+		const __m128i src
+				= _mm_loadu_si128(reinterpret_cast<const __m128i*>(from));
+		// c is translucent if (c - first) <= (last - first), unsigned.
+		const __m128i  over = _mm_subs_epu8(_mm_sub_epi8(src, vfirst), vrange);
+		const unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(over, zero));
+		if (!mask) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(to), src);
+		} else {
+			Ibuf8_copy_translucent_block(to, from, 16, mask, first, xforms);
+		}
+	}
+	Ibuf8_copy_translucent_scalar(to, from, cnt, first, last, xforms);
+}
+
+// SSE2 has no byte shuffle, so table lookups stay scalar.
+const Ibuf8_kernels Ibuf8_kernels::sse2
+		= {"sse2", Ibuf8_remap_scalar, Ibuf8_xform_scalar,
+		   Copy_translucent_sse2};
+
+#	if !defined(__x86_64__)
+#		if defined(__clang__)
+#			pragma clang attribute pop
+#		elif defined(__GNUC__)
+#			pragma GCC pop_options
+#		endif
+#	endif
+
+#endif    // SCUMMVM_SSE2
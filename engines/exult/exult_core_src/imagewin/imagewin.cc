@@ -37,10 +37,12 @@ Boston, MA  02111-1307, USA.
 #include "istring.h"
 #include "manip.h"
 #include "mouse.h"
+#include "scale_bands.h"
 
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <thread>
 
 // Simulate HighDPI mode without OS or Display Support for it
 // uncomment the define and set to a value greater than 1.0 to multiply the
@@ -102,6 +104,9 @@ int Image_window::windowed      = 0;
 // so we need to define the default
 float Image_window::nativescale = 1.0f;
 
+int                           Image_window::scaler_threads = 1;
+std::unique_ptr<Scaler_bands> Image_window::scaler_bands;
+
 SDL_PixelFormat*
 		  ManipBase::fmt;    // Format of dest. pixels (and src for rgb src).
 SDL_Color ManipBase::colors[256];    // Palette for source window.
@@ -114,7 +119,7 @@ Image_window::ScalerVector::ScalerVector() {
 	// enum
 	const ScalerInfo point = {"Point", 0xFFFFFFFF, new Pentagram::PointScaler(),
 							  nullptr, nullptr,    nullptr,
-							  nullptr, nullptr};
+							  nullptr, nullptr,    false};
 	push_back(point);
 
 	const ScalerInfo Interlaced
@@ -125,13 +130,14 @@ Image_window::ScalerVector::ScalerVector() {
 			   &Image_window::show_scaled8to555_interlace,
 			   &Image_window::show_scaled8to16_interlace,
 			   &Image_window::show_scaled8to32_interlace,
-			   &Image_window::show_scaled8to8_interlace};
+			   &Image_window::show_scaled8to8_interlace,
+			   false};
 	push_back(Interlaced);
 
 	const ScalerInfo Bilinear
 			= {"Bilinear", 0xFFFFFFFF, new Pentagram::BilinearScaler::Scaler(),
 			   nullptr,    nullptr,    nullptr,
-			   nullptr,    nullptr};
+			   nullptr,    nullptr,    false};
 	push_back(Bilinear);
 
 	const ScalerInfo BilinearPlus
@@ -142,7 +148,8 @@ Image_window::ScalerVector::ScalerVector() {
 			   &Image_window::show_scaled8to555_BilinearPlus,
 			   &Image_window::show_scaled8to16_BilinearPlus,
 			   &Image_window::show_scaled8to32_BilinearPlus,
-			   nullptr};
+			   nullptr,
+			   false};
 	push_back(BilinearPlus);
 
 	const ScalerInfo _2xSaI
@@ -153,7 +160,8 @@ Image_window::ScalerVector::ScalerVector() {
 			   &Image_window::show_scaled8to555_2xSaI,
 			   &Image_window::show_scaled8to16_2xSaI,
 			   &Image_window::show_scaled8to32_2xSaI,
-			   nullptr};
+			   nullptr,
+			   false};
 	push_back(_2xSaI);
 
 	const ScalerInfo SuperEagle
@@ -164,7 +172,8 @@ Image_window::ScalerVector::ScalerVector() {
 			   &Image_window::show_scaled8to555_SuperEagle,
 			   &Image_window::show_scaled8to16_SuperEagle,
 			   &Image_window::show_scaled8to32_SuperEagle,
-			   nullptr};
+			   nullptr,
+			   false};
 	push_back(SuperEagle);
 
 	const ScalerInfo Super2xSaI
@@ -175,7 +184,8 @@ Image_window::ScalerVector::ScalerVector() {
 			   &Image_window::show_scaled8to555_Super2xSaI,
 			   &Image_window::show_scaled8to16_Super2xSaI,
 			   &Image_window::show_scaled8to32_Super2xSaI,
-			   nullptr};
+			   nullptr,
+			   false};
 	push_back(Super2xSaI);
 
 	const ScalerInfo Scale2X
@@ -186,7 +196,8 @@ Image_window::ScalerVector::ScalerVector() {
 			   &Image_window::show_scaled8to555_2x_noblur,
 			   &Image_window::show_scaled8to16_2x_noblur,
 			   &Image_window::show_scaled8to32_2x_noblur,
-			   &Image_window::show_scaled8to8_2x_noblur};
+			   &Image_window::show_scaled8to8_2x_noblur,
+			   false};
 	push_back(Scale2X);
 
 #ifdef USE_HQ2X_SCALER
@@ -198,7 +209,8 @@ Image_window::ScalerVector::ScalerVector() {
 			   &Image_window::show_scaled8to555_Hq2x,
 			   &Image_window::show_scaled8to16_Hq2x,
 			   &Image_window::show_scaled8to32_Hq2x,
-			   nullptr};
+			   nullptr,
+			   true};
 	push_back(Hq2x);
 #endif
 
@@ -211,7 +223,8 @@ Image_window::ScalerVector::ScalerVector() {
 			   &Image_window::show_scaled8to555_Hq3x,
 			   &Image_window::show_scaled8to16_Hq3x,
 			   &Image_window::show_scaled8to32_Hq3x,
-			   nullptr};
+			   nullptr,
+			   true};
 	push_back(Hq3x);
 #endif
 
@@ -224,7 +237,8 @@ Image_window::ScalerVector::ScalerVector() {
 			   &Image_window::show_scaled8to555_Hq4x,
 			   &Image_window::show_scaled8to16_Hq4x,
 			   &Image_window::show_scaled8to32_Hq4x,
-			   nullptr};
+			   nullptr,
+			   true};
 	push_back(Hq4x);
 #endif
 
@@ -237,7 +251,8 @@ Image_window::ScalerVector::ScalerVector() {
 			   &Image_window::show_scaled8to555_2xBR,
 			   &Image_window::show_scaled8to16_2xBR,
 			   &Image_window::show_scaled8to32_2xBR,
-			   nullptr};
+			   nullptr,
+			   true};
 	push_back(_2xbr);
 	const ScalerInfo _3xbr
 			= {"3xBR",
@@ -247,7 +262,8 @@ Image_window::ScalerVector::ScalerVector() {
 			   &Image_window::show_scaled8to555_3xBR,
 			   &Image_window::show_scaled8to16_3xBR,
 			   &Image_window::show_scaled8to32_3xBR,
-			   nullptr};
+			   nullptr,
+			   true};
 	push_back(_3xbr);
 	const ScalerInfo _4xbr
 			= {"4xBR",
@@ -257,7 +273,8 @@ Image_window::ScalerVector::ScalerVector() {
 			   &Image_window::show_scaled8to555_4xBR,
 			   &Image_window::show_scaled8to16_4xBR,
 			   &Image_window::show_scaled8to32_4xBR,
-			   nullptr};
+			   nullptr,
+			   true};
 	push_back(_4xbr);
 #endif
 }
@@ -491,6 +508,15 @@ void Image_window::static_init() {
 	} else if (force_bpp != 0) {
 		cout << "Forcing bit depth to " << force_bpp << " bpp" << endl;
 	}
+
+	// Threads for the hq and xBR scalers; 0 picks from the CPU count.
+	config->value("config/video/scaler_threads", scaler_threads, 0);
+	if (scaler_threads <= 0) {
+		scaler_threads = std::thread::hardware_concurrency();
+		scaler_threads = scaler_threads < 1   ? 1
+						 : scaler_threads > 4 ? 4
+											  : scaler_threads;
+	}
 }
 
 /*
@@ -890,10 +916,67 @@ void Image_window::show(int x, int y, int w, int h) {
 	// call EndPaintIntoGuardBand just in case. It is safe to call it when not needed 
 	EndPaintIntoGuardBand();
 
+	if (scale_area(x, y, w, h)) {
+		blit_area(x, y, w, h);
+	}
+}
+
+/*
+ *   Repaint the rectangles of a region, scaling each on its own but
+ *   blitting just once.
+ */
+
+void Image_window::show(const Dirty_region& area) {
+	if (!ready()) {
+		return;
+	}
+	EndPaintIntoGuardBand();
+
+	TileRect scaled(0, 0, 0, 0);
+	for (const auto& each : area) {
+		int x = each.x;
+		int y = each.y;
+		int w = each.w;
+		int h = each.h;
+		if (scale_area(x, y, w, h)) {
+			const TileRect r(x, y, w, h);
+			scaled = scaled.w > 0 ? scaled.add(r) : r;
+		}
+	}
+	if (scaled.w > 0) {
+		blit_area(scaled.x, scaled.y, scaled.w, scaled.h);
+	}
+}
+
+/*
+ *  Run a function over bands of rows, at once on the scaler threads (which
+ *  are started the first time) if there's more than one.
+ */
+
+void Image_window::run_in_bands(
+		int y, int h,    // Rows to cover.
+		const std::function<void(int, int)>& fun, int min_band) {
+	if (scaler_threads <= 1) {
+		fun(y, h);
+		return;
+	}
+	if (!scaler_bands) {
+		scaler_bands = std::make_unique<Scaler_bands>(scaler_threads);
+	}
+	scaler_bands->run(y, h, fun, min_band);
+}
+
+/*
+ *   Scale a portion of the window (phase 1 of show()).
+ *
+ *   Output: false if it's all clipped.  Else, the area on inter_surface.
+ */
+
+bool Image_window::scale_area(int& x, int& y, int& w, int& h) {
 	int srcx = 0;
 	int srcy = 0;
 	if (!ibuf->clip(srcx, srcy, w, h, x, y)) {
-		return;
+		return false;
 	}
 	x -= get_start_x();
 	y -= get_start_y();
@@ -940,6 +1023,7 @@ void Image_window::show(int x, int y, int w, int h) {
 	// Phase 1 blit from draw_surface to inter_surface
 	if (draw_surface != inter_surface) {
 		const ScalerInfo& sel_scaler = Scalers[scaler];
+		scaled_pixels += w * h;
 
 		// Need to apply an offset to compensate for the guard_band
 		if (inter_surface == display_surface) {
@@ -987,7 +1071,17 @@ void Image_window::show(int x, int y, int w, int h) {
 				show_scaled = sel_scaler.fun8to8;
 			}
 
-			(this->*show_scaled)(x, y, w, h);
+			if (sel_scaler.banded && scaler_threads > 1) {
+				// Set up the palette before the bands read it.
+				ManipBase::set_formats(
+						paletted_surface->format->palette->colors,
+						inter_surface->format);
+				run_in_bands(y, h, [&](int by, int bh) {
+					(this->*show_scaled)(x, by, w, bh);
+				});
+			} else {
+				(this->*show_scaled)(x, y, w, h);
+			}
 		}
 
 		// Undo guard_band offset
@@ -1003,7 +1097,14 @@ void Image_window::show(int x, int y, int w, int h) {
 		w *= scale;
 		h *= scale;
 	}
+	return true;
+}
+
+/*
+ *   Blit a portion of inter_surface to the screen (the rest of show()).
+ */
 
+void Image_window::blit_area(int x, int y, int w, int h) {
 	// Phase 2 blit from inter_surface to display_surface
 	if (inter_surface != display_surface) {
 		const ScalerInfo& sel_scaler = Scalers[fill_scaler];
@@ -31,6 +31,7 @@ Boston, MA  02111-1307, USA.
 #include "ignore_unused_variable_warning.h"
 #include "imagebuf.h"
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -58,6 +59,8 @@ namespace Pentagram {
 	class ArbScaler;
 }
 
+class Scaler_bands;
+
 class Image_window {
 public:
 	// Firstly just some public scaler stuff
@@ -101,6 +104,7 @@ public:
 		Image_window::scalefun fun8to16;
 		Image_window::scalefun fun8to32;
 		Image_window::scalefun fun8to8;
+		bool                   banded;    // Can scale bands on threads.
 	};
 
 	struct Resolution {
@@ -209,6 +213,8 @@ protected:
 	SDL_Surface* inter_surface;    // Post scaled/pre stretch surface  (960x600)
 	SDL_Surface* draw_surface;     // Pre scaled surface               (320x200)
 
+	uint64 scaled_pixels = 0;    // For get_scaled_pixels().
+
 	/*
 	 *   Scaled blits:
 	 */
@@ -301,6 +307,9 @@ protected:
 	void free_surface();    // Free it.
 	bool create_scale_surfaces(int w, int h, int bpp);
 	bool try_scaler(int w, int h);
+	// Parts of show().
+	bool scale_area(int& x, int& y, int& w, int& h);
+	void blit_area(int x, int y, int w, int h);
 
 	static void static_init();
 
@@ -308,6 +317,9 @@ protected:
 	static int   desktop_depth;
 	static int   windowed;
 	static float nativescale;
+	static int   scaler_threads;    // 1 to scale on the main thread only.
+
+	static std::unique_ptr<Scaler_bands> scaler_bands;
 
 public:
 	inline struct SDL_Window* get_screen_window() const {
@@ -437,6 +449,23 @@ public:
 
 	// Repaint rectangle.
 	void show(int x, int y, int w, int h);
+	// Repaint rectangles.
+	void show(const Dirty_region& area);
+	// Call fun(band_y, band_h) for bands of rows [y, y + h), at once on the
+	//   scaler threads if there are several.  The bands must not write to
+	//   the same pixels.
+	void run_in_bands(
+			int y, int h, const std::function<void(int, int)>& fun,
+			int min_band = 16);
+
+	// Source pixels run through the scaler since the last clear.
+	uint64 get_scaled_pixels() const {
+		return scaled_pixels;
+	}
+
+	void clear_scaled_pixels() {
+		scaled_pixels = 0;
+	}
 
 	void toggle_fullscreen();
 
@@ -61,13 +61,21 @@ protected:
 	static SDL_Color colors[256];    // Palette for source window.
 
 	ManipBase(SDL_Color* c, SDL_PixelFormat* f) {
-		fmt = f;
-		if (c) {
+		set_formats(c, f);
+	}
+
+public:
+	// Only writes what changed, so that once called on the main thread,
+	//   scalers running on others just read the formats.
+	static void set_formats(SDL_Color* c, SDL_PixelFormat* f) {
+		if (fmt != f) {
+			fmt = f;
+		}
+		if (c && std::memcmp(colors, c, sizeof(colors)) != 0) {
 			std::memcpy(colors, c, sizeof(colors));
 		}
 	}
 
-public:
 	static SDL_Color* get_colors() {
 		return colors;
 	}
@@ -0,0 +1,124 @@
+/*
+ *  scale_bands.cc - Run a scaler over bands of a window on worker threads.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "scale_bands.h"
+
+/*
+ *  Start the workers.
+ */
+
+Scaler_bands::Scaler_bands(int num_threads) {
+	for (int i = 1; i < num_threads; i++) {
+		workers.emplace_back(&Scaler_bands::work, this);
+	}
+}
+
+/*
+ *  Stop the workers.
+ */
+
+Scaler_bands::~Scaler_bands() {
+	{
+		const std::lock_guard<std::mutex> lock(mutex);
+		quitting = true;
+	}
+	wake.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+/*
+ *  Scale bands until there are none left to hand out.  'lock' is held on
+ *  entry and exit, but not while scaling.
+ */
+
+void Scaler_bands::run_bands(std::unique_lock<std::mutex>& lock) {
+	while (next_band < num_bands) {
+		const int       band = next_band++;
+		const Band_fun& fun  = *job;
+		const int       y    = starty + band * band_h;
+		const int       h    = band == num_bands - 1 ? stopy - y : band_h;
+		lock.unlock();
+		fun(y, h);
+		lock.lock();
+		if (--pending == 0) {
+			done.notify_one();
+		}
+	}
+}
+
+/*
+ *  Worker thread's loop.
+ */
+
+void Scaler_bands::work() {
+	std::unique_lock<std::mutex> lock(mutex);
+	unsigned                     last_job = job_num;
+	for (;;) {
+		wake.wait(lock, [this, last_job] {
+			return quitting || job_num != last_job;
+		});
+		if (quitting) {
+			return;
+		}
+		last_job = job_num;
+		run_bands(lock);
+	}
+}
+
+/*
+ *  Scale an area in bands.
+ */
+
+void Scaler_bands::run(
+		int y, int h,           // Rows to scale.
+		const Band_fun& fun,    // Does the scaling.
+		int min_band            // Min. rows in a band.
+) {
+	// Bands of 4n rows, as show() lines up the area that way.
+	int bands = h / (min_band > 4 ? min_band : 4);
+	if (bands > get_num_threads()) {
+		bands = get_num_threads();
+	}
+	if (bands <= 1) {
+		fun(y, h);
+		return;
+	}
+	std::unique_lock<std::mutex> lock(mutex);
+	job       = &fun;
+	starty    = y;
+	stopy     = y + h;
+	band_h    = ((h + bands - 1) / bands + 3) & ~3;
+	num_bands = (h + band_h - 1) / band_h;
+	next_band = 0;
+	pending   = num_bands;
+	job_num++;
+	wake.notify_all();
+	run_bands(lock);
+	done.wait(lock, [this] {
+		return pending == 0;
+	});
+	job = nullptr;
+}
@@ -0,0 +1,76 @@
+/*
+ *  scale_bands.h - Run a scaler over bands of a window on worker threads.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef INCL_SCALE_BANDS_H
+#define INCL_SCALE_BANDS_H 1
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ *  Splits an area into horizontal bands and scales them at once, on the
+ *  calling thread and a few workers.  The scalers read the rows above and
+ *  below a band (the overlap they need) straight from the source, which
+ *  isn't changed while they run, and each band writes its own rows of the
+ *  destination; so the result is the same as scaling the whole area.
+ */
+class Scaler_bands {
+public:
+	// Scales rows [y, y + h) of the area.
+	using Band_fun = std::function<void(int y, int h)>;
+
+private:
+	std::mutex               mutex;    // Protects all below.
+	std::condition_variable  wake;     // For workers, when there's a job.
+	std::condition_variable  done;     // For run(), when the bands are.
+	std::vector<std::thread> workers;
+	const Band_fun*          job       = nullptr;
+	unsigned                 job_num   = 0;    // Changes for each job.
+	int                      starty    = 0;    // Area being scaled.
+	int                      band_h    = 0;
+	int                      stopy     = 0;
+	int                      num_bands = 0;
+	int                      next_band = 0;    // Next to hand out.
+	int                      pending   = 0;    // Bands not yet finished.
+	bool                     quitting  = false;
+
+	void work();    // Worker thread's loop.
+	void run_bands(std::unique_lock<std::mutex>& lock);
+
+public:
+	// Use this many threads in all (including the caller's).
+	explicit Scaler_bands(int num_threads);
+	~Scaler_bands();
+	Scaler_bands(const Scaler_bands&)            = delete;
+	Scaler_bands& operator=(const Scaler_bands&) = delete;
+
+	int get_num_threads() const {
+		return workers.size() + 1;
+	}
+
+	// Scale rows [y, y + h) in bands (multiples of 4 rows, but for the
+	//   last) of at least 'min_band' rows, returning when all are done.
+	void run(int y, int h, const Band_fun& fun, int min_band = 16);
+};
+
+#endif
@@ -301,13 +301,17 @@ void Scale_xBR(
 ) {
 	// the following are static because we don't want to be freeing and
 	// reallocating space on each call, as new[]s are usually very
-	// expensive; we do allow it to grow though
-	static int                        buff_size       = 0;
-	static RGBColor<Manip_pixels, 2>* rgb_row_minus_2 = nullptr;
-	static RGBColor<Manip_pixels, 2>* rgb_row_minus_1 = nullptr;
-	static RGBColor<Manip_pixels, 2>* rgb_row_current = nullptr;
-	static RGBColor<Manip_pixels, 2>* rgb_row_plus_1  = nullptr;
-	static RGBColor<Manip_pixels, 2>* rgb_row_plus_2  = nullptr;
+	// expensive; we do allow it to grow though.  They are per thread, as
+	// bands of the window can be scaled at once (see Scaler_bands).
+	static thread_local int                        buff_size = 0;
+	static thread_local RGBColor<Manip_pixels, 2>* rgb_row_minus_2
+			= nullptr;
+	static thread_local RGBColor<Manip_pixels, 2>* rgb_row_minus_1
+			= nullptr;
+	static thread_local RGBColor<Manip_pixels, 2>* rgb_row_current
+			= nullptr;
+	static thread_local RGBColor<Manip_pixels, 2>* rgb_row_plus_1 = nullptr;
+	static thread_local RGBColor<Manip_pixels, 2>* rgb_row_plus_2 = nullptr;
 	if (buff_size < sline_pixels) {
 		delete[] rgb_row_minus_2;
 		delete[] rgb_row_minus_1;
@@ -0,0 +1,127 @@
+/*
+ *  scalebench.cc - Time the Hq2x scaler on one thread and in bands.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/*
+ *  Usage:  scalebench [frames [threads]]
+ *
+ *  Scales a 320x200 game window (with its guard band, as Image_window
+ *  has) 'frames' times (200 by default) to 32 bits with Hq2x, first on
+ *  this thread and then with a Scaler_bands of 'threads' (4 by default),
+ *  and checks that both give the same pixels.  (The other hq scalers
+ *  can't be included alongside, and the xBR ones live in scale_xbr.cc,
+ *  but they band the same way.)
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "ignore_unused_variable_warning.h"
+#include "manip.h"
+#include "scale_bands.h"
+#include "scale_hq2x.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::vector;
+
+// Usually in imagewin.cc.
+SDL_PixelFormat* ManipBase::fmt;
+SDL_Color        ManipBase::colors[256];
+
+int main(int argc, char* argv[]) {
+	const int frames  = argc > 1 ? std::atoi(argv[1]) : 200;
+	const int threads = argc > 2 ? std::atoi(argv[2]) : 4;
+#ifdef USE_HQ2X_SCALER
+	const int guard_band = 4;
+	const int width      = 320;
+	const int height     = 200;
+	const int sline      = width + 2 * guard_band;
+	const int srows      = height + 2 * guard_band;
+	const int dline      = 2 * sline;
+
+	SDL_Color palette[256];
+	for (int i = 0; i < 256; i++) {
+		palette[i].r = i;
+		palette[i].g = (i * 3) & 0xff;
+		palette[i].b = 255 - i;
+		palette[i].a = 255;
+	}
+	SDL_PixelFormat* fmt = SDL_AllocFormat(SDL_PIXELFORMAT_RGB888);
+	if (!fmt) {
+		cerr << "SDL_AllocFormat failed: " << SDL_GetError() << endl;
+		return 1;
+	}
+	const Manip8to32 manip(palette, fmt);
+	// Blocks of color, with some noise, like terrain and shapes.
+	vector<uint8> src(sline * srows);
+	unsigned int  seed = 12345;
+	for (int y = 0; y < srows; y++) {
+		for (int x = 0; x < sline; x++) {
+			seed = seed * 1103515245u + 12345u;
+			const int block = ((x / 8) * 7 + (y / 8) * 13) & 0xff;
+			const int noise = (seed >> 16) & 0xff;
+			src[y * sline + x] = (seed >> 24) < 32 ? noise : block;
+		}
+	}
+	// Scale rows [y, y + h) of the window, as show_scaled8to32_Hq2x does.
+	auto scale = [&](uint32* dest, int y, int h) {
+		Scale_Hq2x<uint32, Manip8to32>(
+				src.data(), guard_band, y + guard_band, width, h, sline,
+				height + guard_band, dest, dline, manip);
+	};
+	vector<uint32> serial(dline * 2 * srows);
+	vector<uint32> banded(serial.size());
+	Scaler_bands   bands(threads);
+
+	const auto t0 = std::chrono::steady_clock::now();
+	for (int f = 0; f < frames; f++) {
+		scale(serial.data(), 0, height);
+	}
+	const auto t1 = std::chrono::steady_clock::now();
+	for (int f = 0; f < frames; f++) {
+		bands.run(0, height, [&](int y, int h) {
+			scale(banded.data(), y, h);
+		});
+	}
+	const auto   t2   = std::chrono::steady_clock::now();
+	const double ser  = std::chrono::duration<double>(t1 - t0).count();
+	const double par  = std::chrono::duration<double>(t2 - t1).count();
+	const bool   same = serial == banded;
+	cout << "Hq2x:  1 thread " << (frames / ser) << " fps, "
+		 << bands.get_num_threads() << " threads " << (frames / par)
+		 << " fps (" << (ser / par) << "x)" << endl;
+	if (!same) {
+		cerr << "Bands don't match the serial result!" << endl;
+	}
+	SDL_FreeFormat(fmt);
+	return same ? 0 : 1;
+#else
+	ignore_unused_variable_warning(frames, threads);
+	cerr << "Built without USE_HQ2X_SCALER" << endl;
+	return 1;
+#endif
+}
@@ -0,0 +1,58 @@
+/*
+ *  jobpool.cc - Run jobs on the backend's worker threads.
+ *
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "jobpool.h"
+
+#include "common/job-system.h"
+#include "common/system.h"
+
+Job_pool::Job_pool(int num_threads)
+		: jobs(g_system->createJobSystem(num_threads)),
+		  group(new Common::JobGroup()) {}
+
+Job_pool::Job_pool(Common::JobSystem* js)
+		: jobs(js), group(new Common::JobGroup()) {}
+
+Job_pool::~Job_pool() {
+	wait();
+	delete group;
+	delete jobs;
+}
+
+bool Job_pool::is_serial() const {
+	return jobs->isSerial();
+}
+
+int Job_pool::get_num_threads() const {
+	return jobs->getNumThreads();
+}
+
+void Job_pool::spawn(void (*proc)(void*), void* arg) {
+	jobs->spawn(*group, proc, arg);
+}
+
+void Job_pool::wait() {
+	jobs->wait(*group);
+}
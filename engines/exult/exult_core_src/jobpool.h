@@ -0,0 +1,61 @@
+/*
+ *  jobpool.h - Run jobs on the backend's worker threads.
+ *
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef JOBPOOL_H
+#define JOBPOOL_H
+
+namespace Common {
+	class JobGroup;
+	class JobSystem;
+}    // namespace Common
+
+/*
+ *  A Common::JobSystem and one group of jobs on it, for headers and sources
+ *  that can't include the common headers:  "common/system.h" declares an
+ *  'Audio' namespace, which clashes with our Audio class, and
+ *  "common/scummsys.h" forbids rand() and the like in all that follows it.
+ */
+class Job_pool {
+	Common::JobSystem* jobs;
+	Common::JobGroup*  group;
+
+public:
+	// Start the worker threads (none if the backend has no threads).  If
+	//   num_threads is 0, it's one less than the number of CPUs.
+	explicit Job_pool(int num_threads);
+	// Use the given job system, taking ownership of it.
+	explicit Job_pool(Common::JobSystem* js);
+	// Waits for the jobs.
+	~Job_pool();
+	Job_pool(const Job_pool&)            = delete;
+	Job_pool& operator=(const Job_pool&) = delete;
+
+	// Are jobs run as they're spawned, on the caller's thread?
+	bool is_serial() const;
+	// Worker threads (0 if serial).
+	int get_num_threads() const;
+	// Run proc(arg) on a worker thread.
+	void spawn(void (*proc)(void*), void* arg);
+	// Wait for all that were spawned.
+	void wait();
+};
+
+#endif
@@ -0,0 +1,215 @@
+/*
+ *  mapprefetch.cc - Read superchunks' files ahead of time.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "mapprefetch.h"
+
+#include "Configuration.h"
+#include "exceptions.h"
+#include "utils.h"
+
+#include <istream>
+
+/*
+ *  Read a whole file.
+ *
+ *  Output: False if it couldn't be opened or read.
+ */
+
+static bool Read_whole_file(
+		const std::string& name, std::unique_ptr<unsigned char[]>& buf,
+		size_t& len) {
+	std::unique_ptr<std::istream> in;
+	try {
+		in = U7open_in(name.c_str());
+	} catch (const file_exception&) {
+		return false;
+	}
+	in->seekg(0, std::ios::end);
+	const std::streamoff size = in->tellg();
+	if (size <= 0) {
+		return false;
+	}
+	in->seekg(0);
+	buf = std::make_unique<unsigned char[]>(size);
+	in->read(reinterpret_cast<char*>(buf.get()), size);
+	if (!in->good()) {
+		buf.reset();
+		return false;
+	}
+	len = size;
+	return true;
+}
+
+Schunk_prefetch* Schunk_prefetch::instance = nullptr;
+
+/*
+ *  Start the thread to read on.  One is plenty for reading files.
+ */
+
+Schunk_prefetch::Schunk_prefetch() : jobs(1) {
+	instance = this;
+}
+
+Schunk_prefetch::Schunk_prefetch(Common::JobSystem* js) : jobs(js) {
+	instance = this;
+}
+
+/*
+ *  Wait for the reads that have started.  Those not yet started are
+ *  skipped.
+ */
+
+Schunk_prefetch::~Schunk_prefetch() {
+	{
+		const std::lock_guard<std::mutex> lock(mutex);
+		quitting = true;
+		pending.clear();
+	}
+	jobs.wait();
+	instance = nullptr;
+}
+
+bool Schunk_prefetch::is_enabled() const {
+	// Without a thread, reading early would only stall sooner.
+	if (jobs.is_serial()) {
+		return false;
+	}
+	std::string yn;
+	config->value("config/gameplay/prefetch_map", yn, "yes");
+	return yn == "yes";
+}
+
+/*
+ *  Is a superchunk queued, being read, or waiting to be taken?
+ */
+
+bool Schunk_prefetch::is_requested(int map, int schunk) {
+	const Key                         key(map, schunk);
+	const std::lock_guard<std::mutex> lock(mutex);
+	return results.count(key) || pending.count(key);
+}
+
+/*
+ *  Queue reading a superchunk's files.
+ */
+
+void Schunk_prefetch::request(
+		int map, int schunk, const std::string& ifix_name,
+		const std::string& ireg_name) {
+	const Key     key(map, schunk);
+	unsigned long ticket;
+	{
+		const std::lock_guard<std::mutex> lock(mutex);
+		ticket       = next_ticket++;
+		pending[key] = ticket;    // Any older job's result is dropped.
+		results.erase(key);
+		stats.requested++;
+	}
+	jobs.spawn(
+			&Schunk_prefetch::read,
+			new Job{this, key, ticket, ifix_name, ireg_name});
+}
+
+/*
+ *  Get a superchunk's files if they've been read.  Otherwise, the request is
+ *  dropped, since the caller is about to read them itself.
+ *
+ *  Output: True if 'files' was filled in.
+ */
+
+bool Schunk_prefetch::take(int map, int schunk, Schunk_files& files) {
+	const Key                         key(map, schunk);
+	const std::lock_guard<std::mutex> lock(mutex);
+	auto                              it = results.find(key);
+	if (it != results.end()) {
+		files = std::move(it->second);
+		results.erase(it);
+		stats.used++;
+		return true;
+	}
+	pending.erase(key);    // Skip it, or drop result when done.
+	return false;
+}
+
+/*
+ *  Forget everything for a map, as when it's cleared.
+ */
+
+void Schunk_prefetch::forget(int map) {
+	const std::lock_guard<std::mutex> lock(mutex);
+	for (auto it = results.begin(); it != results.end();) {
+		if (it->first.first == map) {
+			it = results.erase(it);
+		} else {
+			++it;
+		}
+	}
+	for (auto it = pending.begin(); it != pending.end();) {
+		if (it->first.first == map) {
+			it = pending.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+/*
+ *  Wait for all the reads, as when the results are needed at once.
+ */
+
+void Schunk_prefetch::wait() {
+	jobs.wait();
+}
+
+/*
+ *  Read a superchunk's files on one of the job system's threads.
+ */
+
+void Schunk_prefetch::read(void* arg) {
+	std::unique_ptr<Job> job(static_cast<Job*>(arg));
+	Schunk_prefetch*     prefetch = job->prefetch;
+	// Is this job's result still wanted?
+	auto wanted = [&job, prefetch]() {
+		auto it = prefetch->pending.find(job->key);
+		return it != prefetch->pending.end() && it->second == job->ticket;
+	};
+	{
+		const std::lock_guard<std::mutex> lock(prefetch->mutex);
+		if (prefetch->quitting || !wanted()) {
+			return;
+		}
+	}
+	Schunk_files files;
+	if (!job->ifix_name.empty()) {
+		Read_whole_file(job->ifix_name, files.ifix, files.ifix_len);
+	}
+	if (!job->ireg_name.empty()) {
+		Read_whole_file(job->ireg_name, files.ireg, files.ireg_len);
+	}
+	const std::lock_guard<std::mutex> lock(prefetch->mutex);
+	if (wanted()) {
+		prefetch->pending.erase(job->key);
+		prefetch->results[job->key] = std::move(files);
+	}
+}
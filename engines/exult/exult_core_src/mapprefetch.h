@@ -0,0 +1,121 @@
+/*
+ *  mapprefetch.h - Read superchunks' files ahead of time.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef MAPPREFETCH_H
+#define MAPPREFETCH_H
+
+#include "jobpool.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+/*
+ *  The raw "ifix" and "ireg" files for a superchunk.  A null buffer means
+ *  the file wasn't read (it's missing, or wasn't asked for).
+ */
+struct Schunk_files {
+	std::unique_ptr<unsigned char[]> ifix;
+	size_t                           ifix_len = 0;
+	std::unique_ptr<unsigned char[]> ireg;
+	size_t                           ireg_len = 0;
+};
+
+/*
+ *  Reads the files for superchunks that Game_map expects to need soon, as
+ *  jobs on a Job_pool.  Only the reading is done there:  making the objects
+ *  needs the shape info and the chunk lists, so it's still left to
+ *  Game_map, on the game thread.  Game_window creates the one prefetcher
+ *  and deletes it, after the maps.
+ */
+class Schunk_prefetch {
+	using Key = std::pair<int, int>;    // Map #, superchunk #.
+
+	struct Job {
+		Schunk_prefetch* prefetch;
+		Key              key;
+		unsigned long    ticket;
+		std::string      ifix_name;    // Full paths, or empty to skip.
+		std::string      ireg_name;
+	};
+
+	struct Stats {
+		unsigned long requested = 0;
+		unsigned long used      = 0;    // Taken before the game read it.
+	};
+
+	static Schunk_prefetch* instance;
+
+	Job_pool jobs;    // All the reads.
+
+	std::mutex mutex;    // Protects all below.
+	// Queued or being read, with the ticket of the job whose result is
+	//   wanted.  Taking or forgetting a key just drops it from here.
+	std::map<Key, unsigned long> pending;
+	std::map<Key, Schunk_files>  results;
+	unsigned long                next_ticket = 0;
+	Stats                        stats;
+	bool                         quitting = false;
+
+	static void read(void* arg);    // Runs a Job.
+
+public:
+	Schunk_prefetch();
+	// Read on the given job system, taking ownership of it.
+	explicit Schunk_prefetch(Common::JobSystem* js);
+	~Schunk_prefetch();
+	Schunk_prefetch(const Schunk_prefetch&)            = delete;
+	Schunk_prefetch& operator=(const Schunk_prefetch&) = delete;
+
+	static Schunk_prefetch* get_instance() {
+		return instance;
+	}
+
+	// Is it on ("config/gameplay/prefetch_map"), with a thread to read on?
+	bool is_enabled() const;
+
+	// Is it queued, being read, or ready?
+	bool is_requested(int map, int schunk);
+	// Queue reading the files (names from get_system_path()).
+	void request(
+			int map, int schunk, const std::string& ifix_name,
+			const std::string& ireg_name);
+	// Get the files if they've been read, forgetting them.  If they're
+	//   still being read, they'll be dropped.
+	bool take(int map, int schunk, Schunk_files& files);
+	// Forget all for a map (when it's cleared).
+	void forget(int map);
+	// Wait until all that was requested has been read.
+	void wait();
+
+	unsigned long get_num_requested() {
+		const std::lock_guard<std::mutex> lock(mutex);
+		return stats.requested;
+	}
+
+	unsigned long get_num_used() {
+		const std::lock_guard<std::mutex> lock(mutex);
+		return stats.used;
+	}
+};
+
+#endif
@@ -146,8 +146,13 @@ public:
 	// coords to the game coords expected by this function
 	void move(int& gx, int& gy);
 
+	TileRect get_dirty() const {    // Area to blit for last move.
+		return TileRect(dirty.x - 1, dirty.y - 1, dirty.w + 2, dirty.h + 2);
+	}
+
 	void blit_dirty() {    // Blit dirty area.
-		iwin->show(dirty.x - 1, dirty.y - 1, dirty.w + 2, dirty.h + 2);
+		const TileRect r = get_dirty();
+		iwin->show(r.x, r.y, r.w, r.h);
 	}
 
 protected:
@@ -69,7 +69,7 @@ void Npc_proximity_handler::add(
 	}
 	unsigned long newtime = curtime + (msecs * gwin->get_std_delay() / 100);
 	newtime += additional_ticks * gwin->get_std_delay();
-	gwin->get_tqueue()->add(newtime, this, npc);
+	npc->set_nearby_entry(gwin->get_tqueue()->add(newtime, this, npc));
 }
 
 /*
@@ -78,7 +78,7 @@ void Npc_proximity_handler::add(
 
 void Npc_proximity_handler::remove(Npc_actor* npc) {
 	npc->clear_nearby();
-	gwin->get_tqueue()->remove(this, npc);
+	gwin->get_tqueue()->remove(npc->get_nearby_entry());
 }
 
 /*
@@ -40,6 +40,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "gamewin.h"
 #include "sfxinf.h"
 
+#include <algorithm>
 #include <map>
 #include <string>
 
@@ -181,6 +182,23 @@ inline void Shape_sfx::set_looping() {
 					 : false;
 }
 
+/*
+ *  Have the SFX we may play decoded ahead, since we're nearby.
+ */
+void Shape_sfx::prefetch() {
+	if (!sfxinf) {
+		return;
+	}
+	Audio*    audio = Audio::get_ptr();
+	const int range = std::max(sfxinf->get_sfx_range(), 1);
+	for (int i = 0; i < range; i++) {
+		audio->prefetch_sound_effect(sfxinf->get_sfx() + i);
+	}
+	if (sfxinf->play_horly_ticks()) {
+		audio->prefetch_sound_effect(sfxinf->get_extra_sfx());
+	}
+}
+
 /*
  *  Update distance/direction information. Also starts playing
  *  the sound effect if needed.
@@ -77,6 +77,7 @@ public:
 			last_sfx = 0;
 		}
 		set_looping();    // To avoid including sfxinf.h.
+		prefetch();
 	}
 
 	int get_sfxnum() {
@@ -89,6 +90,7 @@ public:
 
 	void update(bool play);    // Set to new object.
 	void set_looping();
+	void prefetch();    // Have our SFX decoded ahead.
 	void stop();
 };
 
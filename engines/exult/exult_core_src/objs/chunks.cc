@@ -43,8 +43,16 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "objiter.h"
 #include "objs.h"
 #include "ordinfo.h"
+#include "portals.h"
 #include "shapeinf.h"
 
+#include <algorithm>
+#include <iterator>
+
+#if __cplusplus >= 202002L && __has_include(<bit>)
+#	include <bit>
+#endif
+
 using std::rand;
 using std::vector;
 
@@ -52,7 +60,7 @@ using std::vector;
  *  Create the cached data storage for a chunk.
  */
 
-Chunk_cache::Chunk_cache() : egg_objects(4), eggs{} {}
+Chunk_cache::Chunk_cache() : obj_list(nullptr), egg_objects(4), eggs{} {}
 
 /*
  *  This mask gives the low bits (b0) for a given # of ztiles.
@@ -66,8 +74,10 @@ unsigned long tmasks[8]
  *      10 => 11,   11 => 11.
  *  So: newb0 = !b0 OR b1,
  *      newb1 =  b1 OR b0
+ *
+ *  Output: The tile's new counts.
  */
-inline void Set_blocked_tile(
+inline uint16 Set_blocked_tile(
 		Chunk_cache::blocked8z& blocked,    // 16x16 flags,
 		int tx, int ty,                     // Tile #'s (0-15).
 		int lift,                           // Starting lift to set.
@@ -82,7 +92,8 @@ inline void Set_blocked_tile(
 	const uint16 val1s  = val & mask1;
 	const uint16 newval = val1s | (val0s << 1) | Nval0s | (val1s >> 1);
 	// Replace old values with new.
-	blocked[ty * c_tiles_per_chunk + tx] = (val & ~(mask0 | mask1)) | newval;
+	return blocked[ty * c_tiles_per_chunk + tx]
+		   = (val & ~(mask0 | mask1)) | newval;
 }
 
 /*
@@ -91,8 +102,10 @@ inline void Set_blocked_tile(
  *      10 => 01,   11 => 10.
  *  So: newb0 =  b1 AND !b0
  *      newb1 =  b1 AND  b0
+ *
+ *  Output: The tile's new counts.
  */
-inline void Clear_blocked_tile(
+inline uint16 Clear_blocked_tile(
 		Chunk_cache::blocked8z& blocked,    // 16x16 flags,
 		int tx, int ty,                     // Tile #'s (0-15).
 		int lift,                           // Starting lift to set.
@@ -107,7 +120,8 @@ inline void Clear_blocked_tile(
 	const uint16 val1s  = val & mask1;
 	const uint16 newval = (val1s & (val0s << 1)) | ((val1s >> 1) & Nval0s);
 	// Replace old values with new.
-	blocked[ty * c_tiles_per_chunk + tx] = (val & ~(mask0 | mask1)) | newval;
+	return blocked[ty * c_tiles_per_chunk + tx]
+		   = (val & ~(mask0 | mask1)) | newval;
 }
 
 /*
@@ -123,6 +137,51 @@ Chunk_cache::blocked8z& Chunk_cache::new_blocked_level(int zlevel) {
 	return blocked[zlevel];
 }
 
+/*
+ *  Set a tile's 'occupied' bits for 8 lifts from its 'blocked' counts.
+ *
+ *  Output: True if they changed.
+ */
+
+bool Chunk_cache::update_occupied(
+		int    zlevel,    // Which 8 lifts.
+		int    index,     // Tile # within chunk.
+		uint16 counts     // 2 bits for each lift.
+) {
+	// Squeeze to a bit per lift:  set if its count isn't 0.
+	unsigned bits = (counts | (counts >> 1)) & 0x5555;
+	bits          = (bits | (bits >> 1)) & 0x3333;
+	bits          = (bits | (bits >> 2)) & 0x0f0f;
+	bits          = (bits | (bits >> 4)) & 0x00ff;
+	const unsigned band = zlevel / 8;
+	if (band >= occupied.size()) {
+		if (!bits) {
+			return false;
+		}
+		occupied.resize(band + 1);
+	}
+	auto& level = occupied[band];
+	if (!level) {
+		if (!bits) {
+			return false;
+		}
+		level = std::make_unique<uint64[]>(256);
+	}
+	const int    shift = 8 * (zlevel % 8);
+	const uint64 old   = level[index];
+	level[index] = (old & ~(uint64(0xff) << shift)) | (uint64(bits) << shift);
+	return level[index] != old;
+}
+
+/*
+ *  Is a tile along a chunk's edge?
+ */
+
+inline bool On_edge(int tx, int ty) {
+	return tx == 0 || ty == 0 || tx == c_tiles_per_chunk - 1
+		   || ty == c_tiles_per_chunk - 1;
+}
+
 /*
  *  Set/unset the blocked flags in a region.
  */
@@ -132,7 +191,8 @@ void Chunk_cache::set_blocked(
 		int endx, int endy,        // Ending tile #'s.
 		int lift, int ztiles       // Lift, height info.
 ) {
-	int z = lift;
+	int  z            = lift;
+	bool edge_changed = false;
 	while (ztiles) {
 		const int zlevel = z / 8;
 		const int thisz  = z % 8;
@@ -143,12 +203,20 @@ void Chunk_cache::set_blocked(
 		auto& block = need_blocked_level(zlevel);
 		for (int y = starty; y <= endy; y++) {
 			for (int x = startx; x <= endx; x++) {
-				Set_blocked_tile(block, x, y, thisz, zcnt);
+				if (update_occupied(
+							zlevel, y * c_tiles_per_chunk + x,
+							Set_blocked_tile(block, x, y, thisz, zcnt))
+					&& On_edge(x, y)) {
+					edge_changed = true;
+				}
 			}
 		}
 		z += zcnt;
 		ztiles -= zcnt;
 	}
+	if (edge_changed) {
+		blocked_changed();
+	}
 }
 
 void Chunk_cache::clear_blocked(
@@ -156,7 +224,8 @@ void Chunk_cache::clear_blocked(
 		int endx, int endy,        // Ending tile #'s.
 		int lift, int ztiles       // Lift, height info.
 ) {
-	int z = lift;
+	int  z            = lift;
+	bool edge_changed = false;
 	while (ztiles) {
 		const unsigned int zlevel = z / 8;
 		const int          thisz  = z % 8;
@@ -171,13 +240,35 @@ void Chunk_cache::clear_blocked(
 		if (block) {
 			for (int y = starty; y <= endy; y++) {
 				for (int x = startx; x <= endx; x++) {
-					Clear_blocked_tile(block, x, y, thisz, zcnt);
+					if (update_occupied(
+								zlevel, y * c_tiles_per_chunk + x,
+								Clear_blocked_tile(block, x, y, thisz, zcnt))
+						&& On_edge(x, y)) {
+						edge_changed = true;
+					}
 				}
 			}
 		}
 		z += zcnt;
 		ztiles -= zcnt;
 	}
+	if (edge_changed) {
+		blocked_changed();
+	}
+}
+
+/*
+ *  Blocking along the chunk's edges changed, so the portals to its
+ *  neighbors have to be figured again.  Not while this cache is set up,
+ *  though, as there weren't any figured from it, nor while the map's
+ *  objects are being removed to cache it out, as kill_cache() does it.
+ */
+
+void Chunk_cache::blocked_changed() {
+	if (obj_list && !setting_up && !obj_list->get_map()->is_caching_out()) {
+		obj_list->get_map()->get_portals().invalidate(
+				obj_list->get_cx(), obj_list->get_cy());
+	}
 }
 
 /*
@@ -210,11 +301,22 @@ void Chunk_cache::update_object(
 	const int lift   = obj->get_lift();
 	// Simplest case?
 	if (xtiles == 1 && ytiles == 1 && ztiles <= 8 - lift % 8) {
+		const int index   = endy * c_tiles_per_chunk + endx;
+		bool      changed = false;
 		if (add) {
-			Set_blocked_tile(
-					need_blocked_level(lift / 8), endx, endy, lift % 8, ztiles);
+			changed = update_occupied(
+					lift / 8, index,
+					Set_blocked_tile(
+							need_blocked_level(lift / 8), endx, endy, lift % 8,
+							ztiles));
 		} else if (blocked[lift / 8]) {
-			Clear_blocked_tile(blocked[lift / 8], endx, endy, lift % 8, ztiles);
+			changed = update_occupied(
+					lift / 8, index,
+					Clear_blocked_tile(
+							blocked[lift / 8], endx, endy, lift % 8, ztiles));
+		}
+		if (changed && On_edge(endx, endy)) {
+			blocked_changed();
 		}
 		return;
 	}
@@ -353,6 +455,8 @@ void Chunk_cache::update_egg(
  */
 
 void Chunk_cache::setup(Map_chunk* chunk) {
+	obj_list   = chunk;
+	setting_up = true;
 	Game_object*    obj;    // Set 'blocked' tiles.
 	Object_iterator next(chunk->get_objects());
 	while ((obj = next.get_next()) != nullptr) {
@@ -362,162 +466,143 @@ void Chunk_cache::setup(Map_chunk* chunk) {
 			update_object(chunk, obj, true);
 		}
 	}
-
-	obj_list = chunk;
-}
-
-//	Temp. storage for 'blocked' flags for a single tile.
-static uint16 tflags[256 / 8];
-static int    tflags_maxz;
-//	Test for given z-coord. (lift)
-#define TEST_TFLAGS(i) (tflags[(i) / 8] & (3 << (2 * ((i) % 8))))
-
-inline void Chunk_cache::set_tflags(int tx, int ty, int maxz) {
-	int       zlevel = maxz / 8;
-	const int bsize  = blocked.size();
-	if (zlevel >= bsize) {
-		memset(tflags + bsize, 0, (zlevel - bsize + 1) * sizeof(uint16));
-		zlevel = bsize - 1;
-	}
-	while (zlevel >= 0) {
-		auto& block      = blocked[zlevel];
-		tflags[zlevel--] = block ? block[ty * c_tiles_per_chunk + tx] : 0;
-	}
-	tflags_maxz = maxz;
+	setting_up = false;
 }
 
 /*
- *  Get highest blocked lift below a given level for a given tile.
- *
- *  Output: Highest lift that's blocked by an object, or -1 if none.
+ *  Bit #'s of the lowest/highest bits set in a (nonzero) word.
  */
 
-inline int Chunk_cache::get_highest_blocked(int lift    // Look below this lift.
-) {
-	int i;    // Look downwards.
-	for (i = lift - 1; i >= 0 && !TEST_TFLAGS(i); i--)
-		;
-	return i;
+inline int Lowest_bit(uint64 val) {
+#if defined(__cpp_lib_bitops) && __cpp_lib_bitops >= 201907L
+	return std::countr_zero(val);
+#elif defined(__GNUG__)
+	return __builtin_ctzll(val);
+#else
+	int n = 0;
+	for (; !(val & 1); val >>= 1) {
+		n++;
+	}
+	return n;
+#endif
+}
+
+inline int Highest_bit(uint64 val) {
+#if defined(__cpp_lib_bitops) && __cpp_lib_bitops >= 201907L
+	return 63 - std::countl_zero(val);
+#elif defined(__GNUG__)
+	return 63 - __builtin_clzll(val);
+#else
+	int n = 0;
+	while (val >>= 1) {
+		n++;
+	}
+	return n;
+#endif
 }
 
 /*
- *  Get highest blocked lift below a given level for a given tile.
- *
- *  Output: Highest lift that's blocked by an object, or -1 if none.
+ *  Fill in the bits for a tile from per-64-lift levels.
  */
 
-int Chunk_cache::get_highest_blocked(
-		int lift,         // Look below this lift.
-		int tx, int ty    // Square to test.
+void Blocked_column::set(
+		const uint64* const* levels,    // ->256 words, or null.
+		int num_levels, int index,      // Tile # within chunk.
+		int mz                          // Fill in lifts 0-mz.
 ) {
-	set_tflags(tx, ty, lift);
-	return get_highest_blocked(lift);
+	maxz = mz < 255 ? mz : 255;
+	for (int zlevel = 0; zlevel <= maxz / 64; zlevel++) {
+		const uint64* level = zlevel < num_levels ? levels[zlevel] : nullptr;
+		bits[zlevel]        = level ? level[index] : 0;
+	}
 }
 
 /*
- *  Get lowest blocked lift above a given level for a given tile.
+ *  Get highest blocked lift below a given level.
  *
  *  Output: Highest lift that's blocked by an object, or -1 if none.
  */
 
-inline int Chunk_cache::get_lowest_blocked(int lift    // Look above this lift.
-) {
-	int i;    // Look upward.
-	for (i = lift; i <= tflags_maxz && !TEST_TFLAGS(i); i++)
-		;
-	if (i > tflags_maxz) {
-		return -1;
+int Blocked_column::get_highest_blocked(int lift    // Look below this lift.
+) const {
+	// Look downwards, a word at a time.
+	for (int top = std::min(lift - 1, maxz); top >= 0;) {
+		const int    zlevel = top / 64;
+		const uint64 found  = bits[zlevel] & (~uint64(0) >> (63 - top % 64));
+		if (found) {
+			return zlevel * 64 + Highest_bit(found);
+		}
+		top = zlevel * 64 - 1;
 	}
-	return i;
+	return -1;
 }
 
 /*
- *  Get lowest blocked lift above a given level for a given tile.
+ *  Get lowest blocked lift above a given level.
  *
  *  Output: Lowest lift that's blocked by an object, or -1 if none.
  */
 
-int Chunk_cache::get_lowest_blocked(
-		int lift,         // Look above this lift.
-		int tx, int ty    // Square to test.
-) {
-	set_tflags(tx, ty, 255);    // FOR NOW, look up to max.
-	return get_lowest_blocked(lift);
-}
-
-/*
- *  See if a tile is water or land.
- */
-
-inline int Check_terrain(
-		Map_chunk* nlist,    // Chunk.
-		int tx, int ty       // Tile within chunk.
-							 //   bit2 if solid.
-) {
-	ShapeID flat = nlist->get_flat(tx, ty);
-	// Sets: bit0 if land, bit1 if water,
-	int terrain = 0;
-	if (!flat.is_invalid()) {
-		if (flat.get_info().is_water()) {
-			terrain |= 2;
-		} else if (flat.get_info().is_solid()) {
-			terrain |= 4;
-		} else {
-			terrain |= 1;
+int Blocked_column::get_lowest_blocked(int lift    // Look above this lift.
+) const {
+	// Look upward, a word at a time.
+	for (int bottom = std::max(lift, 0); bottom <= maxz;) {
+		const int    zlevel = bottom / 64;
+		const uint64 found  = bits[zlevel] & (~uint64(0) << (bottom % 64));
+		if (found) {
+			const int z = zlevel * 64 + Lowest_bit(found);
+			return z <= maxz ? z : -1;
 		}
+		bottom = (zlevel + 1) * 64;
 	}
-	return terrain;
+	return -1;
 }
 
 /*
- *  Is a given square occupied at a given lift?
- *
- *  Output: true if so, else false.
- *      If false (tile is free), new_lift contains the new height that
- *         an actor will be at if he walks onto the tile.
+ *  Figure the highest lift something can rise to in one move.
  */
 
-bool Chunk_cache::is_blocked(
-		int height,    // Height (in tiles) of obj. being
-		//   tested.
-		int lift,              // Given lift.
-		int tx, int ty,        // Square to test.
-		int&      new_lift,    // New lift returned.
+int Blocked_column::get_max_lift(
+		int       lift,    // Given lift.
 		const int move_flags,
 		int       max_drop,    // Max. drop/rise allowed.
 		int       max_rise     // Max. rise, or -1 to use old beha-
 							   //   viour (max_drop if FLY, else 1).
 ) {
-	const bool is_ethereal   = (move_flags & MOVE_ETHEREAL) != 0;
-	const bool in_mapedit    = (move_flags & MOVE_MAPEDIT) != 0;
-	const bool can_walk      = (move_flags & MOVE_WALK) != 0;
-	const bool can_swim      = (move_flags & MOVE_SWIM) != 0;
-	const bool can_fly       = (move_flags & MOVE_FLY) != 0;
-	const bool is_levitating = (move_flags & MOVE_LEVITATE) != 0;
-	// Ethereal beings always return not blocked
-	// and can only move horizontally
-	if (is_ethereal) {
-		new_lift = lift;
-		return false;
-	}
 	// Figure max lift allowed.
 	if (max_rise == -1) {
-		if (in_mapedit || can_fly) {
+		if ((move_flags & (MOVE_MAPEDIT | MOVE_FLY)) != 0) {
 			max_rise = max_drop;
-		} else if (can_walk) {
+		} else if ((move_flags & MOVE_WALK) != 0) {
 			max_rise = 1;
 		} else {
 			// Swim.
 			max_rise = 0;
 		}
 	}
-	int max_lift = lift + max_rise;
-	if (max_lift > 255) {
-		max_lift = 255;    // As high as we can go.
-	}
-	set_tflags(tx, ty, max_lift + height);
+	const int max_lift = lift + max_rise;
+	return max_lift > 255 ? 255 : max_lift;    // As high as we can go.
+}
+
+/*
+ *  Find the lift an object would be at after moving onto this tile.
+ *
+ *  Output: true if blocked, else false with new_lift set.
+ */
+
+bool Blocked_column::find_lift(
+		int height,    // Height (in tiles) of obj. being
+		//   tested.
+		int       lift,        // Given lift.
+		int       max_lift,    // From get_max_lift().
+		int&      new_lift,    // New lift returned.
+		const int move_flags,
+		int       max_drop    // Max. drop allowed.
+) const {
+	const bool in_mapedit    = (move_flags & MOVE_MAPEDIT) != 0;
+	const bool is_levitating = (move_flags & MOVE_LEVITATE) != 0;
 	for (new_lift = lift; new_lift <= max_lift; new_lift++) {
-		if (!TEST_TFLAGS(new_lift)) {
+		if (!test(new_lift)) {
 			// Not blocked?
 			const int new_high = get_lowest_blocked(new_lift);
 			// Not blocked above?
@@ -555,9 +640,23 @@ bool Chunk_cache::is_blocked(
 			return true;
 		}
 	}
+	return false;
+}
 
-	// Found a new place to go, lets test if we can actually move there
+/*
+ *  Found a new place to go; can we actually move there?
+ *
+ *  Output: true if not.
+ */
 
+bool Blocked_column::is_blocked_at(
+		int new_lift, const int move_flags,
+		int terrain    // bit0 if land, bit1 if water, bit2 if solid.
+) {
+	const bool in_mapedit = (move_flags & MOVE_MAPEDIT) != 0;
+	const bool can_walk   = (move_flags & MOVE_WALK) != 0;
+	const bool can_swim   = (move_flags & MOVE_SWIM) != 0;
+	const bool can_fly    = (move_flags & MOVE_FLY) != 0;
 	// Lift 0 tests
 	if (new_lift == 0) {
 		if (in_mapedit) {
@@ -567,16 +666,15 @@ bool Chunk_cache::is_blocked(
 			// Cannot move at all, like Reapers in BG.
 			return true;
 		}
-		const int ter = Check_terrain(obj_list, tx, ty);
-		if (can_swim && !can_walk && !can_fly && (ter & 2) == 0) {
+		if (can_swim && !can_walk && !can_fly && (terrain & 2) == 0) {
 			// Can only swim; do not allow to move outside of water.
 			return true;
 		}
-		if (can_walk && !can_swim && !can_fly && (ter & 2) != 0) {
+		if (can_walk && !can_swim && !can_fly && (terrain & 2) != 0) {
 			// Can only walk; do not allow to move into water.
 			return true;
 		}
-		if (!can_swim && !can_fly && (ter & 4) != 0) {
+		if (!can_swim && !can_fly && (terrain & 4) != 0) {
 			// Can only walk and terrain is solid (and 0-height).
 			return true;
 		}
@@ -586,6 +684,212 @@ bool Chunk_cache::is_blocked(
 	return !can_walk && !can_fly;
 }
 
+//	Temp. storage for 'blocked' flags for a single tile.
+static Blocked_column tflags;
+
+inline void Chunk_cache::set_tflags(int tx, int ty, int maxz) {
+	const uint64* levels[256 / 64];
+	const int     bsize = occupied.size();
+	for (int i = 0; i < bsize; i++) {
+		levels[i] = occupied[i].get();
+	}
+	tflags.set(levels, bsize, ty * c_tiles_per_chunk + tx, maxz);
+}
+
+/*
+ *  Get highest blocked lift below a given level for a given tile.
+ *
+ *  Output: Highest lift that's blocked by an object, or -1 if none.
+ */
+
+int Chunk_cache::get_highest_blocked(
+		int lift,         // Look below this lift.
+		int tx, int ty    // Square to test.
+) {
+	set_tflags(tx, ty, lift);
+	return tflags.get_highest_blocked(lift);
+}
+
+/*
+ *  Get lowest blocked lift above a given level for a given tile.
+ *
+ *  Output: Lowest lift that's blocked by an object, or -1 if none.
+ */
+
+int Chunk_cache::get_lowest_blocked(
+		int lift,         // Look above this lift.
+		int tx, int ty    // Square to test.
+) {
+	set_tflags(tx, ty, 255);    // FOR NOW, look up to max.
+	return tflags.get_lowest_blocked(lift);
+}
+
+/*
+ *  See if a tile is water or land.
+ */
+
+inline int Check_terrain(
+		Map_chunk* nlist,    // Chunk.
+		int tx, int ty       // Tile within chunk.
+							 //   bit2 if solid.
+) {
+	ShapeID flat = nlist->get_flat(tx, ty);
+	// Sets: bit0 if land, bit1 if water,
+	int terrain = 0;
+	if (!flat.is_invalid()) {
+		if (flat.get_info().is_water()) {
+			terrain |= 2;
+		} else if (flat.get_info().is_solid()) {
+			terrain |= 4;
+		} else {
+			terrain |= 1;
+		}
+	}
+	return terrain;
+}
+
+/*
+ *  Is a given square occupied at a given lift?
+ *
+ *  Output: true if so, else false.
+ *      If false (tile is free), new_lift contains the new height that
+ *         an actor will be at if he walks onto the tile.
+ */
+
+bool Chunk_cache::is_blocked(
+		int height,    // Height (in tiles) of obj. being
+		//   tested.
+		int lift,              // Given lift.
+		int tx, int ty,        // Square to test.
+		int&      new_lift,    // New lift returned.
+		const int move_flags,
+		int       max_drop,    // Max. drop/rise allowed.
+		int       max_rise     // Max. rise, or -1 to use old beha-
+							   //   viour (max_drop if FLY, else 1).
+) {
+	// Ethereal beings always return not blocked
+	// and can only move horizontally
+	if ((move_flags & MOVE_ETHEREAL) != 0) {
+		new_lift = lift;
+		return false;
+	}
+	const int max_lift
+			= Blocked_column::get_max_lift(lift, move_flags, max_drop, max_rise);
+	set_tflags(tx, ty, max_lift + height);
+	if (tflags.find_lift(
+				height, lift, max_lift, new_lift, move_flags, max_drop)) {
+		return true;
+	}
+	// Found a new place to go, lets test if we can actually move there
+	const int ter = new_lift == 0 ? Check_terrain(obj_list, tx, ty) : 0;
+	return Blocked_column::is_blocked_at(new_lift, move_flags, ter);
+}
+
+/*
+ *  See if each tile in a rectangle has something right below 'lift' and
+ *  nothing from 'lift' up through the object's height, so that is_blocked()
+ *  would leave the object at 'lift' (if it can rise at all) and would only
+ *  have to check whether it can move there.  This tests a row of tiles'
+ *  bits at once.
+ *
+ *  Output: true if so.
+ */
+
+bool Chunk_cache::is_area_level(
+		int height,                // Height (in tiles) of obj.
+		int lift,                  // Given lift.
+		int startx, int starty,    // Starting tile #'s.
+		int endx, int endy         // Ending tile #'s.
+) const {
+	const int top = lift + (height > 0 ? height : 1);    // Clear below this.
+	if (lift <= 0 || top > 256) {
+		return false;
+	}
+	for (int zlevel = (lift - 1) / 64; zlevel <= (top - 1) / 64; zlevel++) {
+		const int bottom = zlevel * 64;
+		// Bit that must be set, and bits that must be clear.
+		const uint64 under = (lift - 1) / 64 == zlevel
+									 ? uint64(1) << ((lift - 1) % 64)
+									 : 0;
+		const int from  = std::max(lift, bottom) - bottom;
+		const int count = std::min(top, bottom + 64) - bottom - from;
+		uint64    above = 0;
+		if (count > 0) {
+			above = (count == 64 ? ~uint64(0) : (uint64(1) << count) - 1)
+					<< from;
+		}
+		const uint64  mask  = under | above;
+		const uint64* level = static_cast<unsigned>(zlevel) < occupied.size()
+									  ? occupied[zlevel].get()
+									  : nullptr;
+		if (!level) {
+			if (under) {
+				return false;    // Nothing to stand on.
+			}
+			continue;
+		}
+		for (int y = starty; y <= endy; y++) {
+			const uint64* row  = level + y * c_tiles_per_chunk;
+			bool          good = true;
+			for (int x = startx; x <= endx; x++) {
+				good &= (row[x] & mask) == under;
+			}
+			if (!good) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/*
+ *  Is any square in a rectangle occupied or inaccessible at a given lift?
+ *
+ *  Output: true if so, else false.
+ *      If false, new_lift contains the highest one that an actor
+ *         will be at if he walks onto the tiles.
+ */
+
+bool Chunk_cache::is_blocked_area(
+		int height,    // Height (in tiles) of obj. being
+		//   tested.
+		int lift,                  // Given lift.
+		int startx, int starty,    // Starting tile #'s.
+		int endx, int endy,        // Ending tile #'s.
+		int&      new_lift,        // New lift returned.
+		const int move_flags,
+		int       max_drop,    // Max. drop/rise allowed.
+		int       max_rise     // Max. rise, or -1 to use old beha-
+							   //   viour (max_drop if FLY, else 1).
+) {
+	if ((move_flags & MOVE_ETHEREAL) != 0) {
+		new_lift = lift;
+		return false;
+	}
+	// Usually, it's flat there.
+	if (max_drop >= 0
+		&& Blocked_column::get_max_lift(lift, move_flags, max_drop, max_rise)
+				   >= lift
+		&& is_area_level(height, lift, startx, starty, endx, endy)) {
+		new_lift = lift;
+		return Blocked_column::is_blocked_at(lift, move_flags, 0);
+	}
+	new_lift = 0;
+	for (int ty = starty; ty <= endy; ty++) {
+		for (int tx = startx; tx <= endx; tx++) {
+			int this_lift;
+			if (is_blocked(
+						height, lift, tx, ty, this_lift, move_flags, max_drop,
+						max_rise)) {
+				return true;
+			}
+			// Take highest one.
+			new_lift = this_lift > new_lift ? this_lift : new_lift;
+		}
+	}
+	return false;
+}
+
 /*
  *  Activate nearby eggs.
  */
@@ -683,6 +987,8 @@ Game_object* Chunk_cache::find_door(const Tile_coord& tile) {
 	return nullptr;
 }
 
+uint32 Map_chunk::deps_clock = 0;
+
 /*
  *  Create list for a given chunk.
  */
@@ -692,7 +998,8 @@ Map_chunk::Map_chunk(
 		int chunkx, int chunky    // Absolute chunk coords.
 		)
 		: map(m), terrain(nullptr), objects(nullptr), first_nonflat(nullptr),
-		  from_below(0), from_right(0), from_below_right(0), ice_dungeon(0x00),
+		  from_below(0), from_right(0), from_below_right(0),
+		  deps_version(++deps_clock), ice_dungeon(0x00),
 		  dungeon_levels(nullptr), cache(nullptr), roof(0), cx(chunkx),
 		  cy(chunky), selected(false) {}
 
@@ -746,19 +1053,47 @@ void Map_chunk::set_terrain(Chunk_terrain* ter) {
 }
 
 /*
- *  Add rendering dependencies for a new object.
+ *  Get the area an object in this chunk covers, in pixels relative to the
+ *  chunk's upper-left corner, as Game_window::get_shape_rect() would with
+ *  the view scrolled there.
+ */
+
+TileRect Map_chunk::get_area(Game_object* obj) {
+	Shape_frame* s = obj->get_shape();
+	if (!s) {
+		return TileRect(0, 0, 0, 0);
+	}
+	const int lftpix = (c_tilesize * obj->get_lift()) / 2;
+	return gwin->get_shape_rect(
+			s, (obj->get_tx() + 1) * c_tilesize - 1 - lftpix,
+			(obj->get_ty() + 1) * c_tilesize - 1 - lftpix);
+}
+
+/*
+ *  Add rendering dependencies for a new object.  Only nonflats whose
+ *  areas overlap newinfo.area (which must be relative to this chunk) are
+ *  compared.
  */
 
 void Map_chunk::add_dependencies(
 		Game_object*   newobj,    // Object to add.
 		Ordering_info& newinfo    // Info. for new object's ordering.
 ) {
-	Game_object*            obj;    // Figure dependencies.
-	Nonflat_object_iterator next(this);
-	while ((obj = next.get_next()) != nullptr) {
-		// cout << "Here " << __LINE__ << " " << obj << endl;
+	// Newest first, as they're stored in 'objects'.
+	for (auto it = nonflat_areas.rbegin(); it != nonflat_areas.rend(); ++it) {
+		Game_object* obj = it->obj;
+		if (it->framenum != obj->get_framenum()
+			|| it->shapenum != obj->get_shapenum()) {
+			// Changed (animated?) since it was added.
+			it->area     = get_area(obj);
+			it->shapenum = obj->get_shapenum();
+			it->framenum = obj->get_framenum();
+		}
+		if (!newinfo.area.intersects(it->area)) {
+			continue;    // No overlap on screen.
+		}
 		/* Compare returns -1 if lt, 0 if dont_care, 1 if gt. */
-		int cmp = Game_object::compare(newinfo, obj);
+		int cmp = Game_object::compare(newinfo, obj, it->area);
 		// TODO: Fix this properly, instead of with an ugly hack.
 		// This fixes relative ordering between the Y depression and the Y
 		// shapes in SI. Done so in a way that the depression is not clickable.
@@ -767,11 +1102,13 @@ void Map_chunk::add_dependencies(
 			cmp = 1;
 		}
 		if (cmp == 1) {    // Bigger than this object?
-			newobj->dependencies.insert(obj);
-			obj->dependors.insert(newobj);
+			newobj->dependencies.push_back(obj);
+			obj->dependors.push_back(newobj);
+			set_deps_changed();
 		} else if (cmp == -1) {    // Smaller than?
-			obj->dependencies.insert(newobj);
-			newobj->dependors.insert(obj);
+			obj->dependencies.push_back(newobj);
+			newobj->dependors.push_back(obj);
+			set_deps_changed();
 		}
 	}
 }
@@ -789,7 +1126,22 @@ inline Map_chunk* Map_chunk::add_outside_dependencies(
 		Ordering_info& newinfo    // Info. for new object's ordering.
 ) {
 	Map_chunk* chunk = gmap->get_chunk(cx, cy);
-	chunk->add_dependencies(newobj, newinfo);
+	// Make the area relative to that chunk, watching for wrapping.
+	int dx = newobj->get_chunk()->cx - cx;
+	int dy = newobj->get_chunk()->cy - cy;
+	if (dx > 1) {
+		dx -= c_num_chunks;
+	} else if (dx < -1) {
+		dx += c_num_chunks;
+	}
+	if (dy > 1) {
+		dy -= c_num_chunks;
+	} else if (dy < -1) {
+		dy += c_num_chunks;
+	}
+	Ordering_info info = newinfo;
+	info.area.shift(dx * c_chunksize, dy * c_chunksize);
+	chunk->add_dependencies(newobj, info);
 	return chunk;
 }
 
@@ -802,7 +1154,8 @@ inline Map_chunk* Map_chunk::add_outside_dependencies(
 void Map_chunk::add(Game_object* newobj    // Object to add.
 ) {
 	newobj->chunk = this;    // Set object's chunk.
-	Ordering_info            ord(gwin, newobj);
+	TileRect                 area = get_area(newobj);
+	Ordering_info            ord(gwin, newobj, area);
 	const Game_object_shared newobj_shared = newobj->shared_from_this();
 	// Put past flats.
 	if (first_nonflat) {
@@ -843,6 +1196,10 @@ void Map_chunk::add(Game_object* newobj    // Object to add.
 					->from_below++;
 		}
 		first_nonflat = newobj;    // Inserted before old first_nonflat.
+		set_deps_changed();
+		nonflat_areas.push_back(Nonflat_area{
+				newobj, area, static_cast<short>(newobj->get_shapenum()),
+				static_cast<short>(newobj->get_framenum())});
 	}
 	if (cache) {    // Add to cache.
 		cache->update_object(this, newobj, true);
@@ -893,7 +1250,24 @@ void Map_chunk::remove(Game_object* remove) {
 	if (cache) {    // Remove from cache.
 		cache->update_object(this, remove, false);
 	}
+	// Paint orders with those it touches have to be figured again.
+	auto changed = [](const Game_object_vector& objs) {
+		for (auto* obj : objs) {
+			if (obj->chunk) {
+				obj->chunk->set_deps_changed();
+			}
+		}
+	};
+	changed(remove->dependencies);
+	changed(remove->dependors);
 	remove->clear_dependencies();    // Remove all dependencies.
+	for (auto it = nonflat_areas.rbegin(); it != nonflat_areas.rend(); ++it) {
+		if (it->obj == remove) {
+			nonflat_areas.erase(std::next(it).base());
+			set_deps_changed();
+			break;
+		}
+	}
 	Game_map*         gmap = gwin->get_map();
 	const Shape_info& info = remove->get_info();
 	// See if it extends outside.
@@ -950,33 +1324,72 @@ bool Map_chunk::is_blocked(
 							   //   viour (max_drop if FLY, else 1).
 ) {
 	Game_map* gmap = gwin->get_map();
-	int       tx;
-	int       ty;
-	new_lift = 0;
-	startx   = (startx + c_num_tiles) % c_num_tiles;    // Watch for wrapping.
-	starty   = (starty + c_num_tiles) % c_num_tiles;
-	const int stopy = (starty + ytiles) % c_num_tiles;
-	const int stopx = (startx + xtiles) % c_num_tiles;
-	for (ty = starty; ty != stopy; ty = INCR_TILE(ty)) {
-		// Get y chunk, tile-in-chunk.
-		const int cy  = ty / c_tiles_per_chunk;
+	new_lift       = 0;
+	startx = (startx + c_num_tiles) % c_num_tiles;    // Watch for wrapping.
+	starty = (starty + c_num_tiles) % c_num_tiles;
+	// Do the part in each chunk at once.
+	for (int y = 0; y < ytiles;) {
+		const int ty  = (starty + y) % c_num_tiles;
 		const int rty = ty % c_tiles_per_chunk;
-		for (tx = startx; tx != stopx; tx = INCR_TILE(tx)) {
-			int        this_lift;
-			Map_chunk* olist = gmap->get_chunk(tx / c_tiles_per_chunk, cy);
-			olist->setup_cache();
-			if (olist->is_blocked(
-						height, lift, tx % c_tiles_per_chunk, rty, this_lift,
-						move_flags, max_drop, max_rise)) {
+		const int h   = std::min(ytiles - y, c_tiles_per_chunk - rty);
+		for (int x = 0; x < xtiles;) {
+			const int  tx    = (startx + x) % c_num_tiles;
+			const int  rtx   = tx % c_tiles_per_chunk;
+			const int  w     = std::min(xtiles - x, c_tiles_per_chunk - rtx);
+			Map_chunk* olist = gmap->get_chunk(
+					tx / c_tiles_per_chunk, ty / c_tiles_per_chunk);
+			int this_lift;
+			if (olist->need_cache()->is_blocked_area(
+						height, lift, rtx, rty, rtx + w - 1, rty + h - 1,
+						this_lift, move_flags, max_drop, max_rise)) {
 				return true;
 			}
 			// Take highest one.
 			new_lift = this_lift > new_lift ? this_lift : new_lift;
+			x += w;
 		}
+		y += h;
 	}
 	return false;
 }
 
+/*
+ *  See if an object would stay at 'lift' on each tile of a rectangle,
+ *  from Chunk_cache::is_area_level().
+ *
+ *  Output: true if so.
+ */
+
+static bool Is_area_level(
+		Game_map* gmap,
+		int       height,          // Height (along lift) to check.
+		int       lift,            // Starting lift.
+		int startx, int starty,    // Starting tile coords.
+		int stopx, int stopy       // Tile coords past the end.
+) {
+	const int xtiles = (stopx - startx + c_num_tiles) % c_num_tiles;
+	const int ytiles = (stopy - starty + c_num_tiles) % c_num_tiles;
+	for (int y = 0; y < ytiles;) {
+		const int ty  = (starty + y) % c_num_tiles;
+		const int rty = ty % c_tiles_per_chunk;
+		const int h   = std::min(ytiles - y, c_tiles_per_chunk - rty);
+		for (int x = 0; x < xtiles;) {
+			const int  tx    = (startx + x) % c_num_tiles;
+			const int  rtx   = tx % c_tiles_per_chunk;
+			const int  w     = std::min(xtiles - x, c_tiles_per_chunk - rtx);
+			Map_chunk* olist = gmap->get_chunk(
+					tx / c_tiles_per_chunk, ty / c_tiles_per_chunk);
+			if (!olist->need_cache()->is_area_level(
+						height, lift, rtx, rty, rtx + w - 1, rty + h - 1)) {
+				return false;
+			}
+			x += w;
+		}
+		y += h;
+	}
+	return true;
+}
+
 /*
  *  Check an absolute tile position.
  *
@@ -1074,6 +1487,27 @@ bool Map_chunk::is_blocked(
 	assert(Tile_coord::gte(verty1, verty0));
 	assert(Tile_coord::gte(vertx1, vertx0));
 #endif
+	// Usually, it's flat ground:  then test the footprint's new tiles a row
+	//   at a time, as they'll all leave us at the same lift.
+	const bool no_horiz = horizx0 == horizx1 || horizy0 == horizy1;
+	const bool no_vert  = vertx0 == vertx1 || verty0 == verty1;
+	if ((!no_horiz || !no_vert) && (move_flags & MOVE_ETHEREAL) == 0
+		&& max_drop >= 0
+		&& Blocked_column::get_max_lift(from.tz, move_flags, max_drop, max_rise)
+				   >= from.tz
+		&& (no_horiz
+			|| Is_area_level(
+					gmap, ztiles, from.tz, horizx0, horizy0, horizx1,
+					horizy1))
+		&& (no_vert
+			|| Is_area_level(
+					gmap, ztiles, from.tz, vertx0, verty0, vertx1, verty1))) {
+		if (Blocked_column::is_blocked_at(from.tz, move_flags, 0)) {
+			return true;
+		}
+		to.tz = from.tz;
+		return false;
+	}
 	for (y = horizy0; y != horizy1; y = INCR_TILE(y)) {
 		// Get y chunk, tile-in-chunk.
 		const int cy  = y / c_tiles_per_chunk;
@@ -1531,11 +1965,61 @@ void Map_chunk::kill_cache() {
 
 	// Now remove the cachce
 	cache.reset();
+	map->get_portals().invalidate(cx, cy);
 
 	// Delete dungeon bits
 	dungeon_levels.reset();
 }
 
+/*
+ *  Copy what's needed to test blocking away from the game thread.
+ */
+
+void Map_chunk::copy_blocked(
+		vector<uint64>& levels,    // Gets 256 words for each 64 lifts.
+		unsigned char*  terrain,    // 256 entries.
+		int             door_bit    // Terrain bit to set for doors.
+) {
+	Chunk_cache* cache = need_cache();
+	levels.assign(cache->occupied.size() * 256, 0);
+	for (size_t z = 0; z < cache->occupied.size(); z++) {
+		if (cache->occupied[z]) {
+			std::copy_n(
+					cache->occupied[z].get(), 256, levels.begin() + z * 256);
+		}
+	}
+	for (int ty = 0; ty < c_tiles_per_chunk; ty++) {
+		for (int tx = 0; tx < c_tiles_per_chunk; tx++) {
+			terrain[ty * c_tiles_per_chunk + tx] = Check_terrain(this, tx, ty);
+		}
+	}
+	const TileRect area(
+			cx * c_tiles_per_chunk, cy * c_tiles_per_chunk, c_tiles_per_chunk,
+			c_tiles_per_chunk);
+	for (Game_object* door : cache->doors) {
+		if (!door->is_closed_door() || door->get_framenum() % 4 >= 2) {
+			continue;    // Open or locked.
+		}
+		TileRect foot = door->get_footprint();
+		// Actors can't pass either end of a door.
+		if (foot.h == 1) {
+			foot.x++;
+			foot.w -= 2;
+		} else if (foot.w == 1) {
+			foot.y++;
+			foot.h -= 2;
+		}
+		foot = foot.intersect(area);
+		for (int ty = foot.y; ty < foot.y + foot.h; ty++) {
+			for (int tx = foot.x; tx < foot.x + foot.w; tx++) {
+				terrain[(ty % c_tiles_per_chunk) * c_tiles_per_chunk
+						+ tx % c_tiles_per_chunk]
+						|= door_bit;
+			}
+		}
+	}
+}
+
 int Map_chunk::get_obj_actors(
 		vector<Game_object*>& removes, vector<Actor*>& actors) {
 	int  buf_size = 0;
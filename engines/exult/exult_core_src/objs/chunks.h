@@ -34,6 +34,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include <memory>
 #include <set>
+#include <utility>
+#include <vector>
 
 class Map_chunk;
 class Egg_object;
@@ -46,6 +48,39 @@ class Chunk_terrain;
 class ODataSource;
 class Ordering_info;
 
+/*
+ *  Which lifts of a single tile are blocked (a bit for each), for figuring
+ *  out where something can stand on it.  Filled from a Chunk_cache, or
+ *  from a copy of its data (see Path_snapshot).
+ */
+class Blocked_column {
+	uint64 bits[256 / 64];
+	int    maxz = -1;    // Highest lift filled in.
+
+public:
+	// Fill in lifts 0-maxz from per-64-lift levels (any of which may be
+	//   null) for tile 'index' (ty * c_tiles_per_chunk + tx).
+	void set(const uint64* const* levels, int num_levels, int index, int mz);
+
+	bool test(int lift) const {    // Anything at this lift?
+		return (bits[lift / 64] >> (lift % 64)) & 1;
+	}
+
+	int get_highest_blocked(int lift) const;
+	int get_lowest_blocked(int lift) const;
+	// Highest lift that is_blocked() might move up to.
+	static int get_max_lift(
+			int lift, const int move_flags, int max_drop, int max_rise);
+	// Where would an object of 'height' end up?  Must be filled in up to
+	//   get_max_lift() + height.  Output: true if blocked.
+	bool find_lift(
+			int height, int lift, int max_lift, int& new_lift,
+			const int move_flags, int max_drop) const;
+	// Does moving to new_lift fail anyway?  'terrain' is from
+	//   Map_chunk::get_terrain_bits(), and only used at lift 0.
+	static bool is_blocked_at(int new_lift, const int move_flags, int terrain);
+};
+
 /*
  *  Data cached for a chunk to speed up processing, but which doesn't need
  *  to be saved to disk:
@@ -57,11 +92,17 @@ public:
 	// level for #objs blocking there, so
 	// 8 lifts are represented.
 	using blocked8z = std::unique_ptr<uint16[]>;
+	// For each tile, a bit for each of 64
+	// lifts, set if its count is nonzero.
+	using occupied64z = std::unique_ptr<uint64[]>;
 
 private:
 	Map_chunk* obj_list;
 	// One for each 8 lifts.
 	std::vector<blocked8z> blocked;
+	// One for each 64 lifts.  These are
+	// what the queries below look at.
+	std::vector<occupied64z> occupied;
 	// ->eggs which influence this chunk.
 	std::vector<Egg_object*> egg_objects;
 	// Bit #i (0-14) set means that the
@@ -71,6 +112,7 @@ private:
 	unsigned short eggs[256];
 	// Keep special list of doors.
 	std::set<Game_object*> doors;
+	bool                   setting_up = false;    // In setup().
 
 	int get_num_eggs() {
 		return egg_objects.size();
@@ -85,11 +127,16 @@ private:
 					   : blocked[zlevel];
 	}
 
+	// Copy a tile's new counts for 8 lifts into 'occupied'.
+	bool update_occupied(int zlevel, int index, uint16 counts);
+
 	// Set/unset blocked region.
 	void set_blocked(
 			int startx, int starty, int endx, int endy, int lift, int ztiles);
 	void clear_blocked(
 			int startx, int starty, int endx, int endy, int lift, int ztiles);
+	// Tell pathfinding when blocking along our edges changes.
+	void blocked_changed();
 	// Add/remove object.
 	void update_object(Map_chunk* chunk, Game_object* obj, bool add);
 	// Set area within egg's influence.
@@ -101,9 +148,7 @@ private:
 	void set_tflags(int tx, int ty, int maxz);    // Setup flags.
 	// Get highest lift blocked below a
 	//   given level for a desired tile.
-	int get_highest_blocked(int lift);
 	int get_highest_blocked(int lift, int tx, int ty);
-	int get_lowest_blocked(int lift);
 	int get_lowest_blocked(int lift, int tx, int ty);
 	// Is a spot occupied or inaccessible
 	//   to an NPC?
@@ -153,11 +198,36 @@ public:
 
 	// Is there something on this tile?
 	inline bool is_tile_occupied(int tx, int ty, int tz) {
-		const auto* b8 = static_cast<unsigned>(tz / 8) < blocked.size()
-								 ? blocked[tz / 8].get()
-								 : nullptr;
-		return b8 && (b8[ty * c_tiles_per_chunk + tx] & (3 << (2 * (tz % 8))));
-	}
+		const auto* b64 = static_cast<unsigned>(tz / 64) < occupied.size()
+								  ? occupied[tz / 64].get()
+								  : nullptr;
+		return b64
+			   && ((b64[ty * c_tiles_per_chunk + tx] >> (tz % 64)) & 1) != 0;
+	}
+
+	// Would each tile in a rectangle leave
+	//   an object at 'lift'?
+	bool is_area_level(
+			int height, int lift, int startx, int starty, int endx,
+			int endy) const;
+	// is_blocked() for each tile in a
+	//   rectangle; new_lift gets highest.
+	bool is_blocked_area(
+			int height, int lift, int startx, int starty, int endx, int endy,
+			int& new_lift, const int move_flags, int max_drop = 1,
+			int max_rise = -1);
+};
+
+/*
+ *  The order Game_render paints a chunk's nonflats in, with those from
+ *  other chunks they depend on.  It's good while none of the chunks it
+ *  used have had render dependencies change.
+ */
+struct Chunk_paint_order {
+	std::vector<Game_object*> objs;
+	// Chunks whose objects are in 'objs', with their deps_version.
+	std::vector<std::pair<const Map_chunk*, uint32>> chunks;
+	int skip = -1;    // Lift it was figured for (see Game_render).
 };
 
 /*
@@ -175,6 +245,20 @@ class Map_chunk : public Game_singletons {
 	// chunks below, to right.
 	Game_object*  first_nonflat;
 	unsigned char from_below, from_right, from_below_right;
+	// The nonflats' areas (pixels, relative to this chunk), oldest first,
+	//   for finding which ones a new object overlaps.
+	struct Nonflat_area {
+		Game_object* obj;
+		TileRect     area;
+		short        shapenum, framenum;    // What 'area' is for.
+	};
+
+	std::vector<Nonflat_area> nonflat_areas;
+	// Changed (from deps_clock) when a nonflat is added or removed, or one's
+	//   dependencies change.
+	uint32            deps_version;
+	static uint32     deps_clock;
+	Chunk_paint_order paint_order;
 	unsigned char ice_dungeon;    // For SI, chunk split into 4 quadrants
 	std::unique_ptr<unsigned char[]>
 			dungeon_levels;    // A 'dungeon' level value for each tile.
@@ -186,6 +270,12 @@ class Map_chunk : public Game_singletons {
 	unsigned char          cx, cy;      // Absolute chunk coords. of this.
 	bool                   selected;    // For 'select_chunks' mode.
 	void add_dungeon_levels(TileRect& tiles, unsigned int lift);
+	static TileRect get_area(Game_object* obj);    // Area rel. to chunk.
+
+	void set_deps_changed() {
+		deps_version = ++deps_clock;
+	}
+
 	void add_dependencies(Game_object* newobj, Ordering_info& newinfo);
 	static Map_chunk* add_outside_dependencies(
 			int cx, int cy, Game_object* newobj, Ordering_info& newinfo);
@@ -237,6 +327,14 @@ public:
 		return selected;
 	}
 
+	uint32 get_deps_version() const {
+		return deps_version;
+	}
+
+	Chunk_paint_order& get_paint_order() {
+		return paint_order;
+	}
+
 	const std::set<Game_object*>& get_dungeon_lights()
 			const {    // Get #lights.
 		return dungeon_lights;
@@ -390,6 +488,12 @@ public:
 
 	// Kill the items and the cache
 	void kill_cache();
+	// Copy the 'occupied' bits (256 words for each 64 lifts) and terrain
+	//   bits (as used by Blocked_column::is_blocked_at()) for each tile,
+	//   adding door_bit where an actor can pass a closed door that isn't
+	//   locked.
+	void copy_blocked(
+			std::vector<uint64>& levels, unsigned char* terrain, int door_bit);
 	// Get all objects and actors for use when writing memory cache.
 	// returns size require to save
 	int get_obj_actors(
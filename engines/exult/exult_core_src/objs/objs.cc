@@ -624,15 +624,21 @@ bool Game_object::swap_positions(Game_object* obj2) {
  */
 
 void Game_object::clear_dependencies() {
+	auto erase = [this](Game_object_vector& vec) {
+		auto it = std::find(vec.begin(), vec.end(), this);
+		if (it != vec.end()) {
+			vec.erase(it);
+		}
+	};
 	// First do those we depend on.
 	for (auto* dependency : dependencies) {
-		dependency->dependors.erase(this);
+		erase(dependency->dependors);
 	}
 	dependencies.clear();
 
 	// Now those who depend on us.
 	for (auto* dependor : dependors) {
-		dependor->dependencies.erase(this);
+		erase(dependor->dependencies);
 	}
 	dependors.clear();
 }
@@ -1302,8 +1308,23 @@ inline void Compare_ranges(
 int Game_object::compare(
 		Ordering_info& inf1,    // Info. for object 1.
 		Game_object*   obj2) {
+	return compare(inf1, obj2, gwin->get_shape_rect(obj2));
+}
+
+/*
+ *  Compare two objects, given the second's area on the screen (or in the
+ *  same coords. as inf1.area).
+ *
+ *  Output: -1 if 1st < 2nd, 0 if dont_care, 1 if 1st > 2nd.
+ */
+
+int Game_object::compare(
+		Ordering_info&  inf1,    // Info. for object 1.
+		Game_object*    obj2,
+		const TileRect& area2    // Object 2's area.
+) {
 	// See if there's no overlap.
-	TileRect r2 = gwin->get_shape_rect(obj2);
+	TileRect r2 = area2;
 	if (!inf1.area.intersects(r2)) {
 		return 0;    // No overlap on screen.
 	}
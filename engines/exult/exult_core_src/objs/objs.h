@@ -90,17 +90,15 @@ private:
 	Game_object_shared next;    // ->next in chunk list or container.
 	Game_object*       prev;
 
-public:
-	using Game_object_set = std::set<Game_object*>;
-
-private:
-	Game_object_set dependencies;    // Objects which must be painted before
-	//   this can be rendered.
-	Game_object_set      dependors;    // Objects which must be painted after.
+	// Objects which must be painted before this can be rendered, and
+	//   those which must be painted after.  Kept in the order found.
+	Game_object_vector   dependencies;
+	Game_object_vector   dependors;
 	static unsigned char rotate[8];    // For getting rotated frame #.
 	std::vector<Object_client*> clients;    // Notify when deleted.
 public:
 	uint32 render_seq = 0;    // Render sequence #.
+	uint32 order_seq  = 0;    // For figuring a chunk's paint order.
 	friend class T_Object_list<Game_object>;
 	friend class T_Object_iterator<Game_object>;
 	friend class T_Flat_object_iterator<Game_object, Map_chunk*>;
@@ -193,6 +191,9 @@ public:
 
 	// Compare for render order.
 	static int compare(Ordering_info& inf1, Game_object* obj2);
+	// The same, given obj2's area in inf1.area's coords.
+	static int compare(
+			Ordering_info& inf1, Game_object* obj2, const TileRect& area2);
 	int        lt(Game_object& obj2);    // Is this less than another in pos.?
 
 	void set_invalid() {    // Set to invalid position.
@@ -232,7 +233,7 @@ public:
 	// Swap positions.
 	bool swap_positions(Game_object* obj2);
 
-	Game_object_set& get_dependencies() {
+	const Game_object_vector& get_dependencies() const {
 		return dependencies;
 	}
 
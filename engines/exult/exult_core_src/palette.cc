@@ -22,6 +22,8 @@
 
 #include "palette.h"
 
+#include "crc.h"
+#include "endianio.h"
 #include "exceptions.h"
 #include "files/U7file.h"
 #include "fnames.h"
@@ -34,6 +36,8 @@
 
 #include <algorithm>
 #include <cstring>
+#include <map>
+#include <vector>
 
 #ifdef __GNUC__
 #	pragma GCC diagnostic push
@@ -50,6 +54,14 @@ using std::string;
 
 unsigned char Palette::border[3] = {0, 0, 0};
 
+namespace {
+	// What load(int) has read from 'palettes.flx', by palette #.
+	std::map<int, std::vector<unsigned char>> palette_cache;
+
+	// Start of XFORMS_CACHE.
+	constexpr const uint32 xforms_cache_magic = 0x43465845u;    // "EXFC".
+}    // namespace
+
 Palette::Palette()
 		: win(Game_window::get_instance()->get_win()), palette(-1),
 		  brightness(100), max_val(63), border255(false), faded_out(false),
@@ -89,7 +101,7 @@ void Palette::fade(
 
 	border255 = (palette >= 0 && palette <= 12) && palette != 9;
 
-	load(PALETTES_FLX, PATCH_PALETTES, pal_num);
+	load(pal_num);
 	if (inout) {
 		fade_in(cycles);
 	} else {
@@ -137,7 +149,7 @@ void Palette::set(
 	}
 
 	// could throw!
-	load(PALETTES_FLX, PATCH_PALETTES, palette);
+	load(palette);
 	set_brightness(brightness);
 	apply(repaint);
 }
@@ -219,9 +231,21 @@ void Palette::loadxform(
  */
 void Palette::set_loaded(
 		const U7multiobject& pal, const char* xfname, int xindex) {
-	size_t               len;
-	auto                 xfbuf = pal.retrieve(len);
-	const unsigned char* buf   = xfbuf.get();
+	size_t     len;
+	const auto xfbuf = pal.retrieve(len);
+	set_loaded(xfbuf.get(), len, xfname, xindex);
+}
+
+/**
+ *  Sets the palette and xform table from what was read.
+ *  @param buf  The palette's data (may be null).
+ *  @param len  Its length.
+ *  @param xfname   xform file name.
+ *  @param xindex   xform index.
+ */
+void Palette::set_loaded(
+		const unsigned char* buf, size_t len, const char* xfname,
+		int xindex) {
 	if (len == 768) {
 		// Simple palette
 		if (xindex >= 0) {
@@ -250,6 +274,34 @@ void Palette::set_loaded(
 	}
 }
 
+/**
+ *  Loads a palette from 'palettes.flx', or its patch, reading it only the
+ *  first time.
+ *  @param index    Index of the palette.
+ */
+void Palette::load(int index) {
+	auto it = palette_cache.find(index);
+	if (it == palette_cache.end()) {
+		const U7multiobject        pal(PALETTES_FLX, PATCH_PALETTES, index);
+		size_t                     len;
+		const auto                 buf = pal.retrieve(len);
+		std::vector<unsigned char> data;
+		if (buf) {
+			data.assign(buf.get(), buf.get() + len);
+		}
+		it = palette_cache.emplace(index, std::move(data)).first;
+	}
+	const std::vector<unsigned char>& data = it->second;
+	set_loaded(data.empty() ? nullptr : data.data(), data.size(), nullptr, -1);
+}
+
+/**
+ *  Forgets the palettes read by load(int).
+ */
+void Palette::clear_cache() {
+	palette_cache.clear();
+}
+
 /**
  *  Loads a palette from the given spec. Optionally loads a
  *  xform from the desired file.
@@ -482,6 +534,61 @@ void Palette::create_trans_table(
 	}
 }
 
+/*
+ *  Create translucency tables for a list of blends, or read them from
+ *  XFORMS_CACHE if it was made from the same palette and blends.
+ */
+
+void Palette::create_trans_tables(
+		const unsigned char* blends,     // 4 bytes each, as in 'blends.dat'.
+		size_t               nblends,    // # of blends.
+		Xform_palette*       xforms      // One for each blend is stored here.
+) const {
+	const uint32 key = crc32(blends, 4 * nblends, crc32(pal1, sizeof(pal1)));
+	if (U7exists(XFORMS_CACHE)) {
+		try {
+			auto         pIn    = U7open_in(XFORMS_CACHE);
+			auto&        in     = *pIn;
+			const uint32 magic  = little_endian::Read4(in);
+			const uint32 crc    = little_endian::Read4(in);
+			const uint32 ntable = little_endian::Read4(in);
+			if (magic == xforms_cache_magic && crc == key
+				&& ntable == nblends) {
+				for (size_t i = 0; i < nblends; i++) {
+					in.read(reinterpret_cast<char*>(xforms[i].colors),
+							sizeof(xforms[i].colors));
+				}
+				if (in.good()) {
+					return;
+				}
+			}
+		} catch (const file_exception&) {
+			// Make them again.
+		}
+	}
+	for (size_t i = 0; i < nblends; i++) {
+		create_trans_table(
+				blends[4 * i + 0] / 4, blends[4 * i + 1] / 4,
+				blends[4 * i + 2] / 4, blends[4 * i + 3], xforms[i].colors);
+	}
+	try {
+		auto pOut = U7open_out(XFORMS_CACHE);
+		if (!pOut) {
+			return;
+		}
+		auto& out = *pOut;
+		little_endian::Write4(out, xforms_cache_magic);
+		little_endian::Write4(out, key);
+		little_endian::Write4(out, nblends);
+		for (size_t i = 0; i < nblends; i++) {
+			out.write(reinterpret_cast<const char*>(xforms[i].colors),
+					  sizeof(xforms[i].colors));
+		}
+	} catch (const file_exception&) {
+		// Not worth complaining about; they'll be made again next time.
+	}
+}
+
 void Palette::show() {
 	for (int x = 0; x < 16; x++) {
 		for (int y = 0; y < 16; y++) {
@@ -515,7 +622,7 @@ const Palette::Ramp* Palette::get_ramps(unsigned int& num_ramps) {
 		if (palette != 0) {
 			Palette palette0;
 			try {
-				palette0.load(PALETTES_FLX, PATCH_PALETTES, 0);
+				palette0.load(0);
 				palette0.palette = 0;
 				return palette0.get_ramps(num_ramps);
 			} catch (...) {
@@ -660,8 +767,8 @@ Palette_transition::Palette_transition(
 		int smin, int stick)
 		: current(nullptr), step(0), max_steps(nsteps), start_hour(sh),
 		  start_minute(smin), start_ticks(stick), rate(r) {
-	start.load(PALETTES_FLX, PATCH_PALETTES, from);
-	end.load(PALETTES_FLX, PATCH_PALETTES, to);
+	start.load(from);
+	end.load(to);
 	set_step(ch, cm, ct);
 }
 
@@ -670,7 +777,7 @@ Palette_transition::Palette_transition(
 		int sh, int smin, int stick)
 		: start(from), current(nullptr), step(0), max_steps(nsteps),
 		  start_hour(sh), start_minute(smin), start_ticks(stick), rate(r) {
-	end.load(PALETTES_FLX, PATCH_PALETTES, to);
+	end.load(to);
 	set_step(ch, cm, ct);
 }
 
@@ -23,6 +23,7 @@
 class Image_window8;
 struct File_spec;
 class U7multiobject;
+class Xform_palette;
 
 #include <memory>
 
@@ -55,6 +56,9 @@ class Palette {
 	bool           faded_out;    // true if faded palette to black.
 	bool           fades_enabled;
 	void set_loaded(const U7multiobject& pal, const char* xfname, int xindex);
+	void set_loaded(
+			const unsigned char* buf, size_t len, const char* xfname,
+			int xindex);
 	void loadxform(const unsigned char* buf, const char* xfname, int& xindex);
 
 	static unsigned char border[3];
@@ -91,6 +95,9 @@ public:
 	}
 
 	void apply(bool repaint = true);
+	// Load # from 'palettes.flx' (or its patch).  Each is read only once,
+	//   until clear_cache().
+	void load(int index);
 	void load(
 			const File_spec& fname0, int index, const char* xfname = nullptr,
 			int xindex = -1);
@@ -102,6 +109,8 @@ public:
 			const File_spec& fname2, int index, const char* xfname = nullptr,
 			int xindex = -1);
 	void set_brightness(int bright);
+	// Forget what load(int) has read, as when files may have changed.
+	static void clear_cache();
 
 	void set_max_val(int max) {
 		max_val = max;
@@ -120,6 +129,12 @@ public:
 	void create_trans_table(
 			unsigned char br, unsigned bg, unsigned bb, int alpha,
 			unsigned char* table) const;
+	// Create a table for each of 'nblends' blends (r, g, b, alpha, as in
+	//   'blends.dat'), or read them from XFORMS_CACHE if it was made with
+	//   the same palette and blends.
+	void create_trans_tables(
+			const unsigned char* blends, size_t nblends,
+			Xform_palette* xforms) const;
 	void show();
 
 	void set_color(int nr, int r, int g, int b);
@@ -22,7 +22,61 @@
 
 #include "Astar.h"
 
+#include "gamemap.h"
+#include "gamewin.h"
+#include "ignore_unused_variable_warning.h"
 #include "path.h"
+#include "portals.h"
+
+#include <tuple>
+
+/*
+ *  How many chunks along the route to refine at a time, and how many times
+ *  to plan around crossings that turned out to be blocked before falling
+ *  back to a plain search.
+ */
+const size_t c_chunks_per_leg = 3;
+const int    c_max_replans    = 8;
+
+/*
+ *  Costs for one piece of a long path:  it's done on reaching a given
+ *  chunk.
+ */
+class Leg_pathfinder_client : public Pathfinder_client {
+	const Pathfinder_client* client;    // For the real costs.
+	int                      chunk;     // Chunk # to get to.
+	Tile_coord               aim;       // Where in it to aim for.
+public:
+	Leg_pathfinder_client(
+			const Pathfinder_client* c, int ch, const Tile_coord& a)
+			: Pathfinder_client(c->get_move_flags()), client(c), chunk(ch),
+			  aim(a) {}
+
+	int get_max_cost(int cost_to_goal) const override {
+		return client->get_max_cost(cost_to_goal);
+	}
+
+	int get_step_cost(const Tile_coord& from, Tile_coord& to) const override {
+		return client->get_step_cost(from, to);
+	}
+
+	int estimate_cost(
+			const Tile_coord& from, const Tile_coord& to) const override {
+		ignore_unused_variable_warning(to);
+		return client->estimate_cost(from, aim);
+	}
+
+	bool at_goal(const Tile_coord& tile, const Tile_coord& goal) const override {
+		ignore_unused_variable_warning(goal);
+		return Chunk_portals::chunk_num(
+					   tile.tx / c_tiles_per_chunk, tile.ty / c_tiles_per_chunk)
+			   == chunk;
+	}
+};
+
+static Chunk_portals& Get_portals() {
+	return Game_window::get_instance()->get_map()->get_portals();
+}
 
 /*
  *  Find path from source to destination.
@@ -32,30 +86,139 @@
 bool Astar::NewPath(
 		const Tile_coord& s, const Tile_coord& d,
 		const Pathfinder_client* client) {
-	auto [new_path, success] = Find_path(s, d, client);
-
 	src        = s;    // Store start, destination.
 	dest       = d;
-	path       = std::move(new_path);
 	next_index = 0;
 	dir        = 1;
-	stop       = path.size();
+	path.clear();
+	stop = 0;
+	end_route();
+	bad_crossings.clear();
+	replans = 0;
+	// Far away?  Then go chunk by chunk if we can keep the costs around.
+	if (s.tx >= 0 && s.ty >= 0 && d.tx >= 0 && d.ty >= 0
+		&& s.distance_2d(d) > c_long_path_dist
+		&& (route_client = client->clone()) != nullptr) {
+		if (plan_route(s) && extend_path()) {
+			return true;
+		}
+		end_route();
+		path.clear();
+		stop = 0;
+	}
+	auto [new_path, success] = Find_path(s, d, client);
+
+	path = std::move(new_path);
+	stop = path.size();
 	return success;
 }
 
+/*
+ *  Follow a path that was found elsewhere (i.e., by Path_request_queue).
+ */
+void Astar::set_path(
+		const Tile_coord& s, const Tile_coord& d, std::vector<Tile_coord> p) {
+	src        = s;
+	dest       = d;
+	next_index = 0;
+	dir        = 1;
+	end_route();
+	bad_crossings.clear();
+	replans = 0;
+	path    = std::move(p);
+	stop    = path.size();
+}
+
+/*
+ *  Plan which chunks to go through.
+ *
+ *  Output: false if no route.
+ */
+bool Astar::plan_route(const Tile_coord& from) {
+	route_index = 0;
+	return Get_portals().find_route(from, dest, bad_crossings, route);
+}
+
+/*
+ *  Find the path through the next few chunks of the route, and add it to
+ *  'path'.  If a piece can't be walked, plan around it.
+ *
+ *  Output: false if there's no way on.
+ */
+bool Astar::extend_path() {
+	while (!route.empty()) {
+		const Tile_coord from = path.empty() ? src : path.back();
+		const size_t     last = route.size() - 1;
+		std::vector<Tile_coord> leg;
+		bool                    success;
+		if (route_index + c_chunks_per_leg >= last) {
+			// Near enough to finish with the real goal.
+			std::tie(leg, success) = Find_path(from, dest, route_client.get());
+			if (success) {
+				path.insert(path.end(), leg.begin(), leg.end());
+				stop = path.size();
+				end_route();
+				return true;
+			}
+		} else {
+			const size_t target = route_index + c_chunks_per_leg;
+			Tile_coord   aim;
+			if (!Get_portals().get_crossing_tile(
+						route[target - 1], route[target], from.tz, aim)) {
+				aim = Tile_coord(
+						(route[target] % c_num_chunks) * c_tiles_per_chunk
+								+ c_tiles_per_chunk / 2,
+						(route[target] / c_num_chunks) * c_tiles_per_chunk
+								+ c_tiles_per_chunk / 2,
+						from.tz);
+			}
+			const Leg_pathfinder_client leg_client(
+					route_client.get(), route[target], aim);
+			std::tie(leg, success) = Find_path(from, aim, &leg_client);
+			if (success) {
+				path.insert(path.end(), leg.begin(), leg.end());
+				stop        = path.size();
+				route_index = target;
+				if (leg.empty()) {
+					continue;    // Already there.
+				}
+				return true;
+			}
+		}
+		// Blocked, so avoid the next crossing and plan again.
+		if (route_index < last) {
+			bad_crossings.emplace(route[route_index], route[route_index + 1]);
+		}
+		if (route_index >= last || ++replans > c_max_replans
+			|| !plan_route(from)) {
+			// Give up on the route, and just search.
+			std::tie(leg, success) = Find_path(from, dest, route_client.get());
+			end_route();
+			if (!success) {
+				return false;
+			}
+			path.insert(path.end(), leg.begin(), leg.end());
+			stop = path.size();
+			return true;
+		}
+	}
+	return false;
+}
+
 /*
  *  Get next point on path to go to (in tile coords).
  *
  *  Output: false if all done.
  */
 bool Astar::GetNextStep(Tile_coord& n, bool& done) {
-	if (next_index == stop) {
+	if (next_index == stop
+		&& (dir != 1 || route.empty() || !extend_path())) {
 		done = true;
 		return false;
 	}
 	n = path[next_index];
 	next_index += dir;
-	done = (next_index == stop);
+	done = (next_index == stop) && route.empty();
 	return true;
 }
 
@@ -65,6 +228,9 @@ bool Astar::GetNextStep(Tile_coord& n, bool& done) {
  *  Output: true always (we succeeded).
  */
 bool Astar::set_backwards() {
+	while (!route.empty() && extend_path()) {
+		// Need the whole path.
+	}
 	dir        = -1;
 	stop       = -1;
 	next_index = path.size() - 1;
@@ -75,5 +241,9 @@ bool Astar::set_backwards() {
  *  Get # steps left.
  */
 int Astar::get_num_steps() {
-	return (stop - next_index) * dir;
+	int steps = (stop - next_index) * dir;
+	if (!route.empty()) {    // Guess at what's not refined yet.
+		steps += (route.size() - 1 - route_index) * c_tiles_per_chunk;
+	}
+	return steps;
 }
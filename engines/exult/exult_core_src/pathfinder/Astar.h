@@ -21,6 +21,9 @@
 
 #include "PathFinder.h"
 
+#include <memory>
+#include <set>
+#include <utility>
 #include <vector>
 
 class Astar : public PathFinder {
@@ -28,13 +31,35 @@ class Astar : public PathFinder {
 	int                     dir        = 0;    // 1 or -1.
 	int                     stop       = 0;    // Index to stop at.
 	int                     next_index = 0;    // Index of next tile to return.
+	// For long paths, the chunks still to go through, planned with the
+	//   map's Chunk_portals.  'path' is extended a few chunks at a time.
+	std::vector<int>                   route;
+	size_t                             route_index = 0;    // Chunk we're in.
+	std::unique_ptr<Pathfinder_client> route_client;    // Costs for refining.
+	std::set<std::pair<int, int>>      bad_crossings;    // Failed to refine.
+	int                                replans = 0;
+
+	bool plan_route(const Tile_coord& from);
+	bool extend_path();    // Refine next piece of 'route'.
+	void end_route() {
+		route.clear();
+		route_client.reset();
+	}
+
 public:
+	// Paths longer than this (in tiles) are planned over chunks first.
+	static constexpr int c_long_path_dist = 4 * c_tiles_per_chunk;
+
 	// Find a path from sx,sy,sz to dx,dy,dz
 	// Return false if no path can be traced.
 	// Return true if path found
 	bool NewPath(
 			const Tile_coord& s, const Tile_coord& d,
 			const Pathfinder_client* client) override;
+	// Use a path found elsewhere (not including s).
+	void set_path(
+			const Tile_coord& s, const Tile_coord& d,
+			std::vector<Tile_coord> p);
 
 	// Retrieve the coordinates of the next step on the path
 	bool GetNextStep(Tile_coord& n, bool& done) override;
@@ -21,6 +21,8 @@
 
 #include "tiles.h"
 
+#include <memory>
+
 /*
  *  This class provides A* cost methods.
  */
@@ -47,6 +49,11 @@ public:
 	// Is tile at the goal?
 	virtual bool at_goal(const Tile_coord& tile, const Tile_coord& goal) const;
 
+	// Copy to keep for refining a path later, or nullptr if not possible.
+	virtual std::unique_ptr<Pathfinder_client> clone() const {
+		return nullptr;
+	}
+
 	int get_move_flags() const {
 		return move_flags;
 	}
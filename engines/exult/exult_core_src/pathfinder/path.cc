@@ -25,10 +25,12 @@
 #include "path.h"
 
 #include "PathFinder.h"
+#include "common_types.h"
 #include "exult_constants.h"
-#include "hash_utils.h"
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 using std::cout;
@@ -80,15 +82,16 @@ class Search_node {
 	Search_node* priority_next;    // ->next with same total_cost, or
 								   //   nullptr if not in 'open' set.
 public:
-	Search_node(const Tile_coord& t, short scost, short gcost, Search_node* p)
-			: tile(t), start_cost(scost), goal_cost(gcost), parent(p),
-			  priority_next(nullptr) {
-		total_cost = gcost + scost;
+	// Nodes live in a Search_node_pool, which calls init() on them.
+	void init(const Tile_coord& t, short scost, short gcost, Search_node* p) {
+		tile          = t;
+		start_cost    = scost;
+		goal_cost     = gcost;
+		total_cost    = gcost + scost;
+		parent        = p;
+		priority_next = nullptr;
 	}
 
-	// For creating a key to search for.
-	Search_node(const Tile_coord& t) : tile(t) {}
-
 	Tile_coord get_tile() const {
 		return tile;
 	}
@@ -225,59 +228,130 @@ public:
 };
 
 /*
- *  Hash function for nodes:
+ *  Storage for the nodes of a search.  Nodes are handed out from fixed-size
+ *  blocks that are kept between searches, so a search only allocates when it
+ *  touches more tiles than any earlier search on the same thread did.
  */
-class Hash_node {
+class Search_node_pool {
+	static constexpr size_t block_size = 1024;
+	vector<std::unique_ptr<Search_node[]>> blocks;
+	size_t                                 used = 0;    // # handed out.
+
 public:
-	size_t operator()(const Search_node* a) const noexcept {
-		const Tile_coord t = a->get_tile();
-		return (t.tz << 24) + (t.ty << 12) + t.tx;
+	Search_node* alloc(
+			const Tile_coord& t, short scost, short gcost, Search_node* p) {
+		const size_t block = used / block_size;
+		if (block == blocks.size()) {
+			blocks.push_back(std::make_unique<Search_node[]>(block_size));
+		}
+		Search_node* nd = &blocks[block][used % block_size];
+		used++;
+		nd->init(t, scost, gcost, p);
+		return nd;
+	}
+
+	void reset() {    // Give back all nodes, keeping the blocks.
+		used = 0;
 	}
 };
 
 /*
- *  For testing if two nodes match.
+ *  Open-addressed table for finding each tile's node.  The slots that get
+ *  filled are remembered, so clearing it costs only what the search touched.
  */
-class Equal_nodes {
+class Search_node_index {
+	vector<Search_node*> slots;
+	vector<uint32>       touched;    // Slots filled since last reset().
+	int                  bits;       // log2(slots.size()).
+
+	static uint32 key(const Tile_coord& t) {
+		return (static_cast<uint32>(t.tz & 0xff) << 24)
+			   | (static_cast<uint32>(t.ty) << 12) | static_cast<uint32>(t.tx);
+	}
+
+	uint32 home(const Tile_coord& t) const {
+		// Fibonacci hashing:  take the high bits of the product.
+		return (key(t) * 2654435761u) >> (32 - bits);
+	}
+
+	void grow() {
+		vector<Search_node*> old;
+		old.swap(slots);
+		bits++;
+		slots.assign(size_t(1) << bits, nullptr);
+		vector<uint32> old_touched;
+		old_touched.swap(touched);
+		for (const uint32 i : old_touched) {
+			insert(old[i]);
+		}
+	}
+
 public:
-	bool operator()(const Search_node* a, const Search_node* b) const noexcept {
-		const Tile_coord ta = a->get_tile();
-		const Tile_coord tb = b->get_tile();
-		return ta == tb;
+	Search_node_index() : slots(4096, nullptr), bits(12) {}
+
+	Search_node* find(const Tile_coord& t) const {
+		const uint32 mask = slots.size() - 1;
+		for (uint32 i = home(t);; i = (i + 1) & mask) {
+			Search_node* nd = slots[i];
+			if (!nd || nd->get_tile() == t) {
+				return nd;
+			}
+		}
+	}
+
+	// Add a node whose tile isn't in the table yet.
+	void insert(Search_node* nd) {
+		if (2 * (touched.size() + 1) > slots.size()) {
+			grow();    // Keep load factor <= 1/2.
+		}
+		const uint32 mask = slots.size() - 1;
+		uint32       i    = home(nd->get_tile());
+		while (slots[i]) {
+			i = (i + 1) & mask;
+		}
+		slots[i] = nd;
+		touched.push_back(i);
+	}
+
+	void reset() {
+		for (const uint32 i : touched) {
+			slots[i] = nullptr;
+		}
+		touched.clear();
 	}
 };
 
 /*
- *  The priority queue for the A* algorithm:
+ *  The priority queue and node lookup for the A* algorithm.  One of these
+ *  is kept per thread and reset between searches.
  */
-class A_star_queue {
+class A_star_context {
 	vector<Search_node*> open;    // Nodes to be done, by priority. Each
 	//   is a ->last node in chain.
-	int best;    // Index of 1st non-null ent. in open.
-	// For finding each tile's node:
-	using Lookup_set = std::unordered_set<Search_node*, Hash_node, Equal_nodes>;
-	Lookup_set lookup;
+	int               best;    // Index of 1st non-null ent. in open.
+	Search_node_pool  pool;
+	Search_node_index lookup;    // For finding each tile's node.
+	bool              busy = false;
 
 public:
-	A_star_queue() : open(256), lookup(1000) {
-		open.insert(open.begin(), 256, nullptr);
+	A_star_context() : open(256, nullptr) {
 		best = open.size();    // Best is past end.
 	}
 
-	~A_star_queue() {
-		/*
-		This _should_ work, but might hang some hash_set implementations.
-		The problem is that on deleting the Search_node, the hash_set can
-		no longer properly evaluate the hash value (since the hash function
-		dereferences the Search_node* stored). This might cause an endless
-		loop.
-		*/
-		for (auto X = lookup.begin(); X != lookup.end();) {
-			Search_node* sn = *X;
-			++X;
-			delete sn;    // only delete this _after_ iterating
-		}
-		lookup.clear();    // Remove all nodes.
+	bool in_use() const {
+		return busy;
+	}
+
+	void begin() {
+		busy = true;
+	}
+
+	void end() {    // Clear out what the last search left behind.
+		std::fill(open.begin(), open.end(), nullptr);
+		best = open.size();
+		pool.reset();
+		lookup.reset();
+		busy = false;
 	}
 
 	void add_open(int pri, Search_node* nd) {
@@ -299,9 +373,13 @@ public:
 		}
 	}
 
-	void add(Search_node* nd) {    // Add new node to 'open' set.
+	// Create a new node and add it to 'open' set.
+	Search_node* add(
+			const Tile_coord& t, short scost, short gcost, Search_node* p) {
+		Search_node* nd = pool.alloc(t, scost, gcost, p);
 		lookup.insert(nd);
 		add_back(nd);
+		return nd;
 	}
 
 	// Remove node from 'open' set.
@@ -352,15 +430,45 @@ public:
 	}
 
 	// Find node for given tile.
-	Search_node* find(const Tile_coord& tile) {
-		Search_node        key(tile);
-		Search_node* const pkey = &key;
-		auto               it   = lookup.find(pkey);
-		if (it != lookup.end()) {
-			return *it;
+	Search_node* find(const Tile_coord& tile) const {
+		return lookup.find(tile);
+	}
+};
+
+/*
+ *  Hands out this thread's search context for the duration of one search.
+ *  A nested search (a client calling Find_path from a cost method) gets a
+ *  private context instead.
+ */
+class A_star_context_lock {
+	std::unique_ptr<A_star_context> own;
+	A_star_context*                 ctx;
+
+public:
+	A_star_context_lock() {
+		static thread_local A_star_context shared;
+		if (shared.in_use()) {
+			own = std::make_unique<A_star_context>();
+			ctx = own.get();
 		} else {
-			return nullptr;
+			ctx = &shared;
 		}
+		ctx->begin();
+	}
+
+	~A_star_context_lock() {
+		ctx->end();
+	}
+
+	A_star_context_lock(const A_star_context_lock&)            = delete;
+	A_star_context_lock& operator=(const A_star_context_lock&) = delete;
+
+	A_star_context& operator*() const {
+		return *ctx;
+	}
+
+	A_star_context* operator->() const {
+		return ctx;
 	}
 };
 
@@ -377,14 +485,14 @@ std::pair<std::vector<Tile_coord>, bool> Find_path(
 		const Tile_coord&        goal,     // Where to end up.
 		const Pathfinder_client* client    // Provides costs.
 ) {
-	A_star_queue nodes;    // The priority queue & hash table.
-	int          max_cost = client->estimate_cost(start, goal);
+	A_star_context_lock nodes;    // The priority queue & node lookup.
+	int                 max_cost = client->estimate_cost(start, goal);
 	// Create start node.
-	nodes.add(new Search_node(start, 0, max_cost, nullptr));
+	nodes->add(start, 0, max_cost, nullptr);
 	// Figure when to give up.
 	max_cost = client->get_max_cost(max_cost);
 	Search_node* node;    // Try 'best' node each iteration.
-	while ((node = nodes.pop()) != nullptr) {
+	while ((node = nodes->pop()) != nullptr) {
 		if (tracing) {
 			cout << "Goal: (" << goal.tx << ", " << goal.ty << ", " << goal.tz
 				 << "), Node: (" << node->get_tile().tx << ", "
@@ -409,7 +517,7 @@ std::pair<std::vector<Tile_coord>, bool> Find_path(
 			// Get cost from start to ntile.
 			const int new_cost = node->get_start_cost() + step_cost;
 			// See if next tile already seen.
-			Search_node* next = nodes.find(ntile);
+			Search_node* next = nodes->find(ntile);
 			// Already there, and cheaper?
 			if (next && next->get_start_cost() <= new_cost) {
 				continue;
@@ -420,13 +528,12 @@ std::pair<std::vector<Tile_coord>, bool> Find_path(
 				continue;
 			}
 			if (!next) {    // Create if necessary.
-				next = new Search_node(ntile, new_cost, new_goal_cost, node);
-				nodes.add(next);
+				nodes->add(ntile, new_cost, new_goal_cost, node);
 			} else {
 				// It's going to move.
-				nodes.remove_from_open(next);
+				nodes->remove_from_open(next);
 				next->update(new_cost, new_goal_cost, node);
-				nodes.add_back(next);
+				nodes->add_back(next);
 			}
 		}
 	}
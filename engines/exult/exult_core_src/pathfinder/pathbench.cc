@@ -0,0 +1,157 @@
+/*
+ *  pathbench.cc - Replay start/goal pairs through Find_path and time it.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/*
+ *  Usage:  pathbench [pairs-file [repeat]]
+ *
+ *  The pairs file has one search per line:  "sx sy sz gx gy gz".  Without
+ *  one, a fixed pseudo-random set of pairs is used.  Searches run over a
+ *  synthetic map of walls with doorways, so results are comparable between
+ *  builds but don't depend on game data.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "PathFinder.h"
+#include "ignore_unused_variable_warning.h"
+#include "path.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::vector;
+
+namespace {
+	/*
+	 *  Walls every 16 tiles in each direction, with a 2-tile gap at a
+	 *  position that varies per wall segment.
+	 */
+	bool Is_wall(int tx, int ty) {
+		const int cx = tx / 16;
+		const int cy = ty / 16;
+		if (tx % 16 == 0) {
+			const int gap = 3 + ((cx * 7 + cy * 13) % 10);
+			return ty % 16 != gap && ty % 16 != gap + 1;
+		}
+		if (ty % 16 == 0) {
+			const int gap = 3 + ((cx * 11 + cy * 5) % 10);
+			return tx % 16 != gap && tx % 16 != gap + 1;
+		}
+		return false;
+	}
+
+	class Bench_client : public Pathfinder_client {
+	public:
+		mutable unsigned long nodes = 0;    // Nodes taken from 'open'.
+
+		Bench_client() : Pathfinder_client(0) {}
+
+		int get_step_cost(
+				const Tile_coord& from, Tile_coord& to) const override {
+			ignore_unused_variable_warning(from);
+			return Is_wall(to.tx, to.ty) ? -1 : 1;
+		}
+
+		int estimate_cost(
+				const Tile_coord& from, const Tile_coord& to) const override {
+			return from.distance_2d(to);
+		}
+
+		bool at_goal(
+				const Tile_coord& tile, const Tile_coord& goal) const override {
+			nodes++;
+			return Pathfinder_client::at_goal(tile, goal);
+		}
+	};
+
+	void Make_pairs(vector<Tile_coord>& pairs) {
+		unsigned int seed = 12345;
+		auto         rnd  = [&seed](int range) {
+			seed = seed * 1103515245u + 12345u;
+			return static_cast<int>((seed >> 8) % range);
+		};
+		for (int i = 0; i < 500; i++) {
+			// Start inside a room of a 10x10-room neighborhood.
+			const Tile_coord s(
+					1024 + 16 * rnd(10) + 1 + rnd(14),
+					1024 + 16 * rnd(10) + 1 + rnd(14), 0);
+			Tile_coord g(s.tx + rnd(64) - 32, s.ty + rnd(64) - 32, 0);
+			if (g.tx % 16 == 0) {
+				g.tx++;
+			}
+			if (g.ty % 16 == 0) {
+				g.ty++;
+			}
+			pairs.push_back(s);
+			pairs.push_back(g);
+		}
+	}
+}    // namespace
+
+int main(int argc, char* argv[]) {
+	vector<Tile_coord> pairs;
+	if (argc > 1) {
+		std::ifstream in(argv[1]);
+		if (!in.good()) {
+			cerr << "Can't open '" << argv[1] << "'" << endl;
+			return 1;
+		}
+		int sx;
+		int sy;
+		int sz;
+		int gx;
+		int gy;
+		int gz;
+		while (in >> sx >> sy >> sz >> gx >> gy >> gz) {
+			pairs.emplace_back(sx, sy, sz);
+			pairs.emplace_back(gx, gy, gz);
+		}
+	} else {
+		Make_pairs(pairs);
+	}
+	const int repeat = argc > 2 ? std::atoi(argv[2]) : 20;
+
+	Bench_client  client;
+	unsigned long found    = 0;
+	unsigned long searches = 0;
+	const auto    t0       = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeat; r++) {
+		for (size_t i = 0; i + 1 < pairs.size(); i += 2) {
+			if (Find_path(pairs[i], pairs[i + 1], &client).second) {
+				found++;
+			}
+			searches++;
+		}
+	}
+	const auto   t1   = std::chrono::steady_clock::now();
+	const double secs = std::chrono::duration<double>(t1 - t0).count();
+	cout << searches << " searches, " << found << " found, " << client.nodes
+		 << " nodes in " << secs << "s (" << (client.nodes / secs)
+		 << " nodes/sec)" << endl;
+	return 0;
+}
@@ -0,0 +1,444 @@
+/*
+ *  pathqueue.cc - Finding paths on worker threads.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "pathqueue.h"
+
+#include "Configuration.h"
+#include "PathFinder.h"
+#include "actors.h"
+#include "chunks.h"
+#include "gamemap.h"
+#include "objiter.h"
+#include "path.h"
+#include "schedule.h"
+#include "shapeinf.h"
+
+#include <algorithm>
+#include <string>
+
+// Last:  these forbid C library calls in the headers after them.
+#include "common/mutex.h"
+
+using std::vector;
+
+/*
+ *  Chunks to add around start and goal, and the most chunks (each way) a
+ *  snapshot may cover.
+ */
+const int c_snapshot_margin     = 2;
+const int c_max_snapshot_chunks = 16;
+
+/*
+ *  Copy the chunks around start and goal.
+ */
+
+Path_snapshot::Path_snapshot(
+		Game_map* map, const Tile_coord& start, const Tile_coord& goal,
+		bool ignore_npcs) {
+	const int scx = start.tx / c_tiles_per_chunk;
+	const int scy = start.ty / c_tiles_per_chunk;
+	const int gcx = goal.tx / c_tiles_per_chunk;
+	const int gcy = goal.ty / c_tiles_per_chunk;
+	cx0           = std::max(0, std::min(scx, gcx) - c_snapshot_margin);
+	cy0           = std::max(0, std::min(scy, gcy) - c_snapshot_margin);
+	cw = std::min(c_num_chunks - 1, std::max(scx, gcx) + c_snapshot_margin)
+		 - cx0 + 1;
+	ch = std::min(c_num_chunks - 1, std::max(scy, gcy) + c_snapshot_margin)
+		 - cy0 + 1;
+	// (Paths across the world's edge are left to Find_path.)
+	if (cw > c_max_snapshot_chunks || ch > c_max_snapshot_chunks) {
+		return;
+	}
+	chunks.resize(cw * ch);
+	for (int cy = 0; cy < ch; cy++) {
+		for (int cx = 0; cx < cw; cx++) {
+			Map_chunk*  chunk = map->get_chunk(cx0 + cx, cy0 + cy);
+			Chunk_data& data  = chunks[cy * cw + cx];
+			chunk->copy_blocked(data.levels, data.terrain, door_bit);
+			// Add what Actor_pathfinder_client gets from the flats.
+			for (int ty = 0; ty < c_tiles_per_chunk; ty++) {
+				for (int tx = 0; tx < c_tiles_per_chunk; tx++) {
+					const ShapeID flat = chunk->get_flat(tx, ty);
+					if (flat.is_invalid()) {
+						continue;
+					}
+					unsigned char& bits
+							= data.terrain[ty * c_tiles_per_chunk + tx];
+					if (flat.get_info().is_poisonous()) {
+						bits |= poison_bit;
+					}
+					if (flat.get_shapenum() == 24
+						&& flat.get_framenum() <= 1) {
+						bits |= cobble_bit;
+					}
+				}
+			}
+		}
+	}
+	if (!ignore_npcs) {
+		return;
+	}
+	// Mark the NPCs Actor_pathfinder_client::check_blocking() lets us walk
+	//   through.  (It checks at the lift we'd be at; we don't.)
+	for (int cy = 0; cy < ch; cy++) {
+		for (int cx = 0; cx < cw; cx++) {
+			Map_chunk*      chunk = map->get_chunk(cx0 + cx, cy0 + cy);
+			Game_object*    obj;
+			Object_iterator next(chunk->get_objects());
+			while ((obj = next.get_next()) != nullptr) {
+				Actor* npc = obj->as_actor();
+				if (!npc) {
+					continue;
+				}
+				const int frnum = npc->get_framenum() & 0xf;
+				if ((frnum >= Actor::sit_frame && frnum <= Actor::sleep_frame)
+					|| npc->get_schedule_type() == Schedule::combat) {
+					continue;
+				}
+				const int      bits = npc->get_frame_time()
+											  ? npc_bit
+											  : npc_bit | idle_npc_bit;
+				const TileRect foot = npc->get_footprint();
+				for (int ty = foot.y; ty < foot.y + foot.h; ty++) {
+					for (int tx = foot.x; tx < foot.x + foot.w; tx++) {
+						const int num = chunk_index(tx, ty);
+						if (num >= 0) {
+							chunks[num].terrain
+									[(ty % c_tiles_per_chunk)
+											 * c_tiles_per_chunk
+									 + tx % c_tiles_per_chunk]
+									|= bits;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+/*
+ *  Get the index in 'chunks' of the chunk holding a tile.
+ *
+ *  Output: -1 if outside the snapshot.
+ */
+
+int Path_snapshot::chunk_index(int tx, int ty) const {
+	const int cx = tx / c_tiles_per_chunk - cx0;
+	const int cy = ty / c_tiles_per_chunk - cy0;
+	if (tx < 0 || ty < 0 || cx < 0 || cy < 0 || cx >= cw || cy >= ch) {
+		return -1;
+	}
+	return cy * cw + cx;
+}
+
+const Path_snapshot::Chunk_data* Path_snapshot::get_chunk(
+		int tx, int ty) const {
+	const int num = chunk_index(tx, ty);
+	return num >= 0 ? &chunks[num] : nullptr;
+}
+
+int Path_snapshot::get_flags(int tx, int ty) const {
+	const Chunk_data* data = get_chunk(tx, ty);
+	return data ? data->terrain
+						  [(ty % c_tiles_per_chunk) * c_tiles_per_chunk
+						   + tx % c_tiles_per_chunk]
+				: 0;
+}
+
+/*
+ *  Same test as Chunk_cache::is_blocked(), for one tile.
+ *
+ *  Output: true if blocked.  Else new_lift is where an actor would be.
+ */
+
+bool Path_snapshot::is_tile_blocked(
+		int tx, int ty, int lift, int height, int move_flags,
+		int& new_lift) const {
+	const Chunk_data* data = get_chunk(tx, ty);
+	if (!data) {
+		return true;    // Outside what we know.
+	}
+	if ((move_flags & MOVE_ETHEREAL) != 0) {
+		new_lift = lift;
+		return false;
+	}
+	const int index = (ty % c_tiles_per_chunk) * c_tiles_per_chunk
+					  + tx % c_tiles_per_chunk;
+	const uint64* levels[256 / 64];
+	const int     nlevels = data->levels.size() / 256;
+	for (int i = 0; i < nlevels; i++) {
+		levels[i] = &data->levels[i * 256];
+	}
+	const int max_lift = Blocked_column::get_max_lift(lift, move_flags, 1, -1);
+	Blocked_column column;
+	column.set(levels, nlevels, index, max_lift + height);
+	return column.find_lift(height, lift, max_lift, new_lift, move_flags, 1)
+		   || Blocked_column::is_blocked_at(
+				   new_lift, move_flags,
+				   new_lift == 0 ? data->terrain[index] & terrain_bits : 0);
+}
+
+/*
+ *  Same test as Actor::is_blocked().  For a footprint bigger than 1x1,
+ *  the tiles it moves onto are checked as in Map_chunk::is_blocked(), and
+ *  they all have to leave it at the same lift.
+ *
+ *  Output: true if blocked.
+ */
+
+bool Path_snapshot::is_blocked(
+		const Tile_coord& from, Tile_coord& to, int xtiles, int ytiles,
+		int height, int move_flags, bool& is_door) const {
+	is_door = false;
+	if (xtiles == 1 && ytiles == 1) {
+		int new_lift;
+		if (is_tile_blocked(
+					to.tx, to.ty, to.tz, height, move_flags, new_lift)) {
+			is_door = (get_flags(to.tx, to.ty) & door_bit) != 0;
+			return true;
+		}
+		to.tz = new_lift;
+		return false;
+	}
+	int new_lift0 = -1;    // All lift changes must be the same.
+	for (int ty = to.ty - ytiles + 1; ty <= to.ty; ty++) {
+		for (int tx = to.tx - xtiles + 1; tx <= to.tx; tx++) {
+			if (tx > from.tx - xtiles && tx <= from.tx
+				&& ty > from.ty - ytiles && ty <= from.ty) {
+				continue;    // Already standing there.
+			}
+			int new_lift;
+			if (is_tile_blocked(
+						tx, ty, from.tz, height, move_flags, new_lift)) {
+				is_door = (get_flags(to.tx, to.ty) & door_bit) != 0;
+				return true;
+			}
+			if (new_lift != from.tz) {
+				if (new_lift0 == -1) {
+					new_lift0 = new_lift;
+				} else if (new_lift != new_lift0) {
+					return true;
+				}
+			}
+		}
+	}
+	to.tz = new_lift0 == -1 ? from.tz : new_lift0;
+	return false;
+}
+
+namespace {
+	/*
+	 *  Costs from a snapshot, following Actor_pathfinder_client.
+	 */
+	class Snapshot_pathfinder_client : public Pathfinder_client {
+		const Path_snapshot& snapshot;
+		const Path_request&  request;
+
+	public:
+		Snapshot_pathfinder_client(
+				const Path_snapshot& s, const Path_request& r)
+				: Pathfinder_client(r.move_flags), snapshot(s), request(r) {}
+
+		int get_max_cost(int cost_to_goal) const override {
+			const int max_cost = 3 * cost_to_goal;
+			return std::max(max_cost, request.min_max_cost);
+		}
+
+		int get_step_cost(
+				const Tile_coord& from, Tile_coord& to) const override {
+			int       cost     = 1;
+			const int old_lift = to.tz;
+			bool      is_door;
+			if (snapshot.is_blocked(
+						from, to, request.xtiles, request.ytiles,
+						request.height, get_move_flags(), is_door)) {
+				// Set only if told to ignore NPCs.
+				const int to_flags   = snapshot.get_flags(to.tx, to.ty);
+				const int from_flags = snapshot.get_flags(from.tx, from.ty);
+				if ((to_flags & Path_snapshot::npc_bit) != 0) {
+					if ((to_flags & Path_snapshot::idle_npc_bit) != 0) {
+						cost++;    // Try to avoid non-moving NPCs.
+					}
+				} else if (
+						!is_door
+						|| (from_flags & Path_snapshot::door_bit) != 0) {
+					return -1;    // Don't walk within doorway.
+				} else {
+					cost++;    // Try to avoid doors.
+				}
+			}
+			if (old_lift != to.tz) {
+				cost++;
+			}
+			// On the diagonal?
+			if (from.tx != to.tx || from.ty != to.ty) {
+				cost *= 3;    // Make it 50% more expensive.
+			} else {
+				cost *= 2;
+			}
+			const int flags = snapshot.get_flags(to.tx, to.ty);
+			if ((flags & Path_snapshot::poison_bit) != 0 && to.tz == 0) {
+				cost *= 2;    // And avoid poison if possible.
+			}
+			if ((flags & Path_snapshot::cobble_bit) != 0) {
+				cost--;    // Cobblestone path in BlackGate.
+			}
+			return cost;
+		}
+
+		int estimate_cost(
+				const Tile_coord& from, const Tile_coord& to) const override {
+			const int dx = std::abs(Tile_coord::delta(from.tx, to.tx));
+			const int dy = std::abs(Tile_coord::delta(from.ty, to.ty));
+			// Straight = 2, diag = 3.
+			return dy <= dx ? 2 * dx + dy : 2 * dy + dx;
+		}
+
+		bool at_goal(
+				const Tile_coord& tile, const Tile_coord& goal) const override {
+			return (goal.tz == -1 ? tile.distance_2d(goal)
+								  : tile.distance(goal))
+				   <= request.dist;
+		}
+	};
+}    // namespace
+
+Path_request_queue* Path_request_queue::instance = nullptr;
+
+/*
+ *  Start the worker threads:  one less than there are CPUs, leaving one
+ *  for the game itself.
+ */
+
+Path_request_queue::Path_request_queue()
+		: jobs(0), mutex(std::make_unique<Common::Mutex>()) {
+	instance = this;
+}
+
+/*
+ *  Wait for the searches that are running.  Those not yet started are
+ *  skipped.
+ */
+
+Path_request_queue::~Path_request_queue() {
+	{
+		const Common::StackLock lock(*mutex);
+		quitting = true;
+	}
+	jobs.wait();
+	instance = nullptr;
+}
+
+bool Path_request_queue::is_enabled() const {
+	// Without threads, searching here gains nothing over searching at once.
+	if (jobs.get_num_threads() == 0) {
+		return false;
+	}
+	std::string yn;
+	config->value("config/gameplay/async_pathfinding", yn, "yes");
+	return yn == "yes";
+}
+
+/*
+ *  Queue a search.  (Where the job system has no threads, it's done now.)
+ *
+ *  Output: Ticket for poll().
+ */
+
+int Path_request_queue::submit(
+		const Path_request&                  request,
+		std::shared_ptr<const Path_snapshot> snapshot) {
+	int ticket;
+	{
+		const Common::StackLock lock(*mutex);
+		ticket = next_ticket++;
+		if (next_ticket < 0) {    // (Wrapped.)
+			next_ticket = 0;
+		}
+		running.insert(ticket);
+	}
+	jobs.spawn(
+			&Path_request_queue::search,
+			new Job{this, ticket, request, std::move(snapshot)});
+	return ticket;
+}
+
+/*
+ *  Check on a search.
+ */
+
+Path_request_queue::Status Path_request_queue::poll(
+		int ticket, vector<Tile_coord>& path) {
+	const Common::StackLock lock(*mutex);
+	auto                              it = results.find(ticket);
+	if (it != results.end()) {
+		const bool success = it->second.success;
+		path               = std::move(it->second.path);
+		results.erase(it);
+		return success ? found : failed;
+	}
+	if (running.count(ticket) && !cancelled.count(ticket)) {
+		return pending;
+	}
+	return unknown;
+}
+
+/*
+ *  Forget about a search.
+ */
+
+void Path_request_queue::cancel(int ticket) {
+	const Common::StackLock lock(*mutex);
+	if (results.erase(ticket)) {
+		return;
+	}
+	if (running.count(ticket)) {
+		cancelled.insert(ticket);    // Skip it, or drop result when done.
+	}
+}
+
+/*
+ *  Run a search on one of the job system's threads.
+ */
+
+void Path_request_queue::search(void* arg) {
+	std::unique_ptr<Job> job(static_cast<Job*>(arg));
+	Path_request_queue*  queue = job->queue;
+	{
+		const Common::StackLock lock(*queue->mutex);
+		if (queue->quitting || queue->cancelled.count(job->ticket)) {
+			queue->running.erase(job->ticket);
+			queue->cancelled.erase(job->ticket);
+			return;
+		}
+	}
+	const Snapshot_pathfinder_client client(*job->snapshot, job->request);
+	auto [path, success]
+			= Find_path(job->request.start, job->request.goal, &client);
+	const Common::StackLock lock(*queue->mutex);
+	queue->running.erase(job->ticket);
+	if (!queue->cancelled.erase(job->ticket)) {
+		queue->results[job->ticket] = Result{success, std::move(path)};
+	}
+}
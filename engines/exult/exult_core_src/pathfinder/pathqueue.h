@@ -0,0 +1,171 @@
+/*
+ *  pathqueue.h - Finding paths on worker threads.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef PATHQUEUE_H
+#define PATHQUEUE_H
+
+#include "common_types.h"
+#include "jobpool.h"
+#include "tiles.h"
+
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+class Game_map;
+
+namespace Common {
+	class Mutex;
+}    // namespace Common
+
+/*
+ *  What to search for.  The costs follow Actor_pathfinder_client's, as far
+ *  as they can be figured from a Path_snapshot.
+ */
+struct Path_request {
+	Tile_coord start;
+	Tile_coord goal;
+	int        move_flags;
+	int        xtiles, ytiles;    // Footprint of the actor.
+	int        height;            // Of the actor, in lifts.
+	int        dist;              // Get within this distance of goal.
+	int        min_max_cost;      // Search at least this far before quitting.
+};
+
+/*
+ *  A copy of the blocking data for a rectangle of chunks, taken on the game
+ *  thread so that searches can run on others.  NPCs block wherever they
+ *  stood when it was taken.
+ */
+class Path_snapshot {
+	struct Chunk_data {
+		std::vector<uint64> levels;    // 'Occupied' bits, 256 per 64 lifts.
+		// Terrain bits from Map_chunk::copy_blocked(), plus the flags below.
+		unsigned char terrain[256];
+	};
+
+	int                     cx0, cy0;    // Upper-left chunk.
+	int                     cw, ch;      // Size in chunks.
+	std::vector<Chunk_data> chunks;
+
+	int               chunk_index(int tx, int ty) const;
+	const Chunk_data* get_chunk(int tx, int ty) const;
+	// Same test as Chunk_cache::is_blocked() for one tile.
+	bool is_tile_blocked(
+			int tx, int ty, int lift, int height, int move_flags,
+			int& new_lift) const;
+
+public:
+	enum {
+		terrain_bits = 7,     // What Blocked_column::is_blocked_at() wants.
+		door_bit     = 8,     // A closed door that can be opened.
+		poison_bit   = 16,    // Flat is poisonous (swamp).
+		cobble_bit   = 32,    // BlackGate's cobblestone path.
+		npc_bit      = 64,    // An NPC we can walk through (see below).
+		idle_npc_bit = 128    // ...and it isn't moving.
+	};
+
+	// Covers the chunks from start to goal, plus a margin.  If ignore_npcs,
+	//   tiles with NPCs that don't stop an actor ignoring them are marked.
+	//   Check is_valid() afterwards:  long paths don't get a snapshot.
+	Path_snapshot(
+			Game_map* map, const Tile_coord& start, const Tile_coord& goal,
+			bool ignore_npcs);
+
+	bool is_valid() const {
+		return !chunks.empty();
+	}
+
+	// Can an actor with an xtiles by ytiles footprint step from 'from' to
+	//   'to' (whose tz may change)?  Sets is_door if it can, but only by
+	//   opening a door.
+	bool is_blocked(
+			const Tile_coord& from, Tile_coord& to, int xtiles, int ytiles,
+			int height, int move_flags, bool& is_door) const;
+	// Terrain bits and flags for a tile (0 if outside the snapshot).
+	int get_flags(int tx, int ty) const;
+};
+
+/*
+ *  Runs Path_requests as jobs on a Job_pool.  Callers get a ticket back,
+ *  and poll() it on later ticks.  Game_window creates the one queue and
+ *  deletes it, after the actors whose searches it runs.
+ */
+class Path_request_queue {
+public:
+	enum Status {
+		pending,    // Queued or being searched.
+		found,
+		failed,
+		unknown    // Bad (or cancelled) ticket.
+	};
+
+private:
+	struct Job {
+		Path_request_queue*                  queue;
+		int                                  ticket;
+		Path_request                         request;
+		std::shared_ptr<const Path_snapshot> snapshot;
+	};
+
+	struct Result {
+		bool                    success;
+		std::vector<Tile_coord> path;
+	};
+
+	static Path_request_queue* instance;
+
+	Job_pool jobs;    // The searches.
+
+	std::unique_ptr<Common::Mutex>  mutex;    // Protects all below.
+	std::set<int>                   running;      // Tickets not done yet.
+	std::set<int>                   cancelled;    // Of those in 'running'.
+	std::unordered_map<int, Result> results;
+	int                             next_ticket = 0;
+	bool                            quitting    = false;
+
+	static void search(void* arg);    // Runs a Job.
+
+public:
+	Path_request_queue();
+	~Path_request_queue();
+	Path_request_queue(const Path_request_queue&)            = delete;
+	Path_request_queue& operator=(const Path_request_queue&) = delete;
+
+	static Path_request_queue* get_instance() {
+		return instance;
+	}
+
+	// Is async pathfinding on ("config/gameplay/async_pathfinding"), with
+	//   threads to do it on?  The setting is looked up each time, so that
+	//   changing it takes effect at once.
+	bool is_enabled() const;
+
+	int submit(
+			const Path_request&                  request,
+			std::shared_ptr<const Path_snapshot> snapshot);
+	// Check on a ticket.  If found, the path (not including the start) is
+	//   moved into 'path' and the ticket is forgotten.
+	Status poll(int ticket, std::vector<Tile_coord>& path);
+	void   cancel(int ticket);
+};
+
+#endif
@@ -0,0 +1,311 @@
+/*
+ *  portals.cc - Chunk-to-chunk connectivity for long-distance pathfinding.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "portals.h"
+
+#include "chunks.h"
+#include "gamemap.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+
+using std::vector;
+
+/*
+ *  # lifts above the floor that have to be clear for a tile to count as
+ *  open.  (Enough for the usual NPC.)
+ */
+const int c_portal_clearance = 3;
+
+/*
+ *  How far (in chunks) a route may stray from the straight way between
+ *  start and goal.  Edges are figured from the chunk caches, so this also
+ *  bounds how many caches a search sets up.
+ */
+const int c_route_margin = 4;
+
+/*
+ *  Give up on a route after looking at this many chunks.
+ */
+const int c_max_route_chunks = 2048;
+
+/*
+ *  Can a tile be stood on at a given lift?
+ */
+
+bool Chunk_portals::is_open(
+		int tx, int ty,    // Absolute tile coords.
+		int lift) {
+	Map_chunk* chunk = map->get_chunk(
+			tx / c_tiles_per_chunk, ty / c_tiles_per_chunk);
+	tx %= c_tiles_per_chunk;
+	ty %= c_tiles_per_chunk;
+	for (int z = lift; z < lift + c_portal_clearance; z++) {
+		if (chunk->is_tile_occupied(tx, ty, z)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ *  Figure the open tiles along a chunk's east and south edges.
+ */
+
+Chunk_portals::Edges Chunk_portals::compute(int cx, int cy, int lift) {
+	const int tx  = cx * c_tiles_per_chunk;
+	const int ty  = cy * c_tiles_per_chunk;
+	const int etx = ((cx + 1) % c_num_chunks) * c_tiles_per_chunk;
+	const int sty = ((cy + 1) % c_num_chunks) * c_tiles_per_chunk;
+	Edges     edges{lift, 0, 0};
+	for (int i = 0; i < c_tiles_per_chunk; i++) {
+		if (is_open(tx + c_tiles_per_chunk - 1, ty + i, lift)
+			&& is_open(etx, ty + i, lift)) {
+			edges.east |= 1 << i;
+		}
+		if (is_open(tx + i, ty + c_tiles_per_chunk - 1, lift)
+			&& is_open(tx + i, sty, lift)) {
+			edges.south |= 1 << i;
+		}
+	}
+	return edges;
+}
+
+/*
+ *  Get (figuring if needed) a chunk's east/south edges for a lift.
+ */
+
+const Chunk_portals::Edges& Chunk_portals::get_edges(
+		int cx, int cy, int lift) {
+	const int num = chunk_num(cx, cy);
+	auto      it  = chunks.find(num);
+	if (it != chunks.end()) {
+		for (const Edges& each : it->second) {
+			if (each.lift == lift) {
+				return each;
+			}
+		}
+	}
+	// Note:  this can set up chunk caches, which can call invalidate().
+	const Edges   edges = compute(cx, cy, lift);
+	vector<Edges>& list = chunks[num];
+	list.push_back(edges);
+	return list.back();
+}
+
+/*
+ *  Get the open tiles along one edge of a chunk.
+ *
+ *  Output: Bit #i set if tile i along the edge can be crossed.
+ */
+
+uint16 Chunk_portals::get_open(int cx, int cy, Edge edge, int lift) {
+	switch (edge) {
+	case north:
+		return get_edges(cx, (cy + c_num_chunks - 1) % c_num_chunks, lift)
+				.south;
+	case east:
+		return get_edges(cx, cy, lift).east;
+	case south:
+		return get_edges(cx, cy, lift).south;
+	case west:
+		return get_edges((cx + c_num_chunks - 1) % c_num_chunks, cy, lift)
+				.east;
+	}
+	return 0;
+}
+
+/*
+ *  Forget the edges a chunk shares with its neighbors.
+ */
+
+void Chunk_portals::invalidate(int cx, int cy) {
+	if (chunks.empty()) {
+		return;
+	}
+	chunks.erase(chunk_num(cx, cy));
+	chunks.erase(chunk_num((cx + c_num_chunks - 1) % c_num_chunks, cy));
+	chunks.erase(chunk_num(cx, (cy + c_num_chunks - 1) % c_num_chunks));
+}
+
+/*
+ *  Distance in chunks (along x plus along y), with world-wrapping.
+ */
+
+static int Chunk_distance(int c1, int c2) {
+	int dx = std::abs(c1 % c_num_chunks - c2 % c_num_chunks);
+	int dy = std::abs(c1 / c_num_chunks - c2 / c_num_chunks);
+	if (dx > c_num_chunks / 2) {
+		dx = c_num_chunks - dx;
+	}
+	if (dy > c_num_chunks / 2) {
+		dy = c_num_chunks - dy;
+	}
+	return dx + dy;
+}
+
+/*
+ *  Get the chunk across a given edge.
+ */
+
+static int Chunk_across(int c, Chunk_portals::Edge edge) {
+	const int cx = c % c_num_chunks;
+	const int cy = c / c_num_chunks;
+	switch (edge) {
+	case Chunk_portals::north:
+		return Chunk_portals::chunk_num(
+				cx, (cy + c_num_chunks - 1) % c_num_chunks);
+	case Chunk_portals::east:
+		return Chunk_portals::chunk_num((cx + 1) % c_num_chunks, cy);
+	case Chunk_portals::south:
+		return Chunk_portals::chunk_num(cx, (cy + 1) % c_num_chunks);
+	case Chunk_portals::west:
+		return Chunk_portals::chunk_num(
+				(cx + c_num_chunks - 1) % c_num_chunks, cy);
+	}
+	return c;
+}
+
+/*
+ *  A* over chunks, going from chunk to chunk through open edges.  Only
+ *  chunks within c_route_margin of the straight way are looked at, so
+ *  a far-off detour isn't found; callers fall back to tile-level paths.
+ *
+ *  Output: true if found, with chunk #'s (including start's and goal's)
+ *      stored in 'route'.
+ */
+
+bool Chunk_portals::find_route(
+		const Tile_coord& start, const Tile_coord& goal,
+		const std::set<Crossing>& avoid, vector<int>& route) {
+	route.clear();
+	const int lift = start.tz;
+	const int from = chunk_num(
+			start.tx / c_tiles_per_chunk, start.ty / c_tiles_per_chunk);
+	const int to
+			= chunk_num(goal.tx / c_tiles_per_chunk, goal.ty / c_tiles_per_chunk);
+	// (Estimated total, chunk #), cheapest first.
+	using Entry = std::pair<int, int>;
+	std::priority_queue<Entry, vector<Entry>, std::greater<Entry>> open;
+	std::unordered_map<int, int> cost;      // Cost from start, by chunk.
+	std::unordered_map<int, int> parent;    // Previous chunk, by chunk.
+	cost[from]   = 0;
+	parent[from] = -1;
+	const int direct = Chunk_distance(from, to);
+	open.emplace(direct, from);
+	int looked = 0;
+	while (!open.empty()) {
+		const auto [total, c] = open.top();
+		open.pop();
+		const int sofar = cost[c];
+		if (total > sofar + Chunk_distance(c, to)) {
+			continue;    // Stale entry.
+		}
+		if (c == to) {    // Got there.
+			for (int each = c; each != -1; each = parent[each]) {
+				route.push_back(each);
+			}
+			std::reverse(route.begin(), route.end());
+			return true;
+		}
+		if (++looked > c_max_route_chunks) {
+			break;
+		}
+		const int cx = c % c_num_chunks;
+		const int cy = c / c_num_chunks;
+		for (int e = north; e <= west; e++) {
+			const auto edge = static_cast<Edge>(e);
+			const int next = Chunk_across(c, edge);
+			// Check this first, so we don't set up caches off the way.
+			if (Chunk_distance(from, next) + Chunk_distance(next, to)
+				> direct + 2 * c_route_margin) {
+				continue;
+			}
+			if (!get_open(cx, cy, edge, lift)) {
+				continue;
+			}
+			if (avoid.find(Crossing(c, next)) != avoid.end()) {
+				continue;
+			}
+			auto it = cost.find(next);
+			if (it != cost.end() && it->second <= sofar + 1) {
+				continue;
+			}
+			cost[next]   = sofar + 1;
+			parent[next] = c;
+			open.emplace(sofar + 1 + Chunk_distance(next, to), next);
+		}
+	}
+	return false;
+}
+
+/*
+ *  Find the tile just inside 'to' for crossing from 'from', picking the open
+ *  one closest to the middle of their shared edge.
+ *
+ *  Output: false if they're not neighbors or the edge is blocked.
+ */
+
+bool Chunk_portals::get_crossing_tile(
+		int from, int to, int lift, Tile_coord& tile) {
+	int edge;
+	for (edge = north; edge <= west; edge++) {
+		if (Chunk_across(from, static_cast<Edge>(edge)) == to) {
+			break;
+		}
+	}
+	if (edge > west) {
+		return false;
+	}
+	const uint16 mask = get_open(
+			from % c_num_chunks, from / c_num_chunks, static_cast<Edge>(edge),
+			lift);
+	// Look outwards from the middle.
+	for (int d = 0; d <= c_tiles_per_chunk; d++) {
+		const int i = c_tiles_per_chunk / 2 + ((d & 1) ? (d + 1) / 2 : -d / 2);
+		if (i < 0 || i >= c_tiles_per_chunk || !(mask & (1 << i))) {
+			continue;
+		}
+		const int tx = (to % c_num_chunks) * c_tiles_per_chunk;
+		const int ty = (to / c_num_chunks) * c_tiles_per_chunk;
+		switch (edge) {
+		case north:
+			tile = Tile_coord(tx + i, ty + c_tiles_per_chunk - 1, lift);
+			break;
+		case east:
+			tile = Tile_coord(tx, ty + i, lift);
+			break;
+		case south:
+			tile = Tile_coord(tx + i, ty, lift);
+			break;
+		default:
+			tile = Tile_coord(tx + c_tiles_per_chunk - 1, ty + i, lift);
+			break;
+		}
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,98 @@
+/*
+ *  portals.h - Chunk-to-chunk connectivity for long-distance pathfinding.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef PORTALS_H
+#define PORTALS_H
+
+#include "common_types.h"
+#include "tiles.h"
+
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Game_map;
+
+/*
+ *  For each pair of neighboring chunks, which tiles along their shared
+ *  edge can be crossed at a given lift.  This is figured from the chunk
+ *  caches' 'blocked' flags when first asked for, and forgotten when the
+ *  blocking along a chunk's edge changes.
+ *
+ *  It's only a coarse guide: it knows nothing about terrain, doors or how
+ *  the tiles inside a chunk connect, so routes found with it still have to
+ *  be walked with the real pathfinder.
+ */
+class Chunk_portals {
+public:
+	enum Edge {
+		north = 0,
+		east  = 1,
+		south = 2,
+		west  = 3
+	};
+
+	// A crossing from one chunk to the next:  (from, to) chunk #'s.
+	using Crossing = std::pair<int, int>;
+
+private:
+	// Open tiles along the east and south edges of a chunk for one lift.
+	//   Bit #i is tile i along the edge.
+	struct Edges {
+		int    lift;
+		uint16 east;
+		uint16 south;
+	};
+
+	Game_map* map;
+	// By chunk # (cy * c_num_chunks + cx).
+	std::unordered_map<int, std::vector<Edges>> chunks;
+
+	bool  is_open(int tx, int ty, int lift);    // Absolute tile coords.
+	Edges compute(int cx, int cy, int lift);
+	const Edges& get_edges(int cx, int cy, int lift);
+
+public:
+	Chunk_portals(Game_map* m) : map(m) {}
+
+	static int chunk_num(int cx, int cy) {
+		return cy * c_num_chunks + cx;
+	}
+
+	// Open tiles along one edge of a chunk.
+	uint16 get_open(int cx, int cy, Edge edge, int lift);
+	// Blocking changed within a chunk.
+	void invalidate(int cx, int cy);
+	void clear() {
+		chunks.clear();
+	}
+
+	// Find a route of chunk #'s from start's chunk to goal's chunk, not
+	//   using any of the 'avoid' crossings.
+	bool find_route(
+			const Tile_coord& start, const Tile_coord& goal,
+			const std::set<Crossing>& avoid, std::vector<int>& route);
+	// Tile just inside 'to' that crosses from 'from' (which must be a
+	//   neighbor) nearest the middle of their edge.
+	bool get_crossing_tile(int from, int to, int lift, Tile_coord& tile);
+};
+
+#endif
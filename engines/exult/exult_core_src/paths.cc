@@ -200,6 +200,14 @@ bool Actor_pathfinder_client::at_goal(
 		   <= dist;
 }
 
+/*
+ *  Copy for Astar to finish a long path with.
+ */
+
+std::unique_ptr<Pathfinder_client> Actor_pathfinder_client::clone() const {
+	return std::make_unique<Actor_pathfinder_client>(npc, dist, ignore_npcs);
+}
+
 /*
  *  Estimate cost from one point to another.
  */
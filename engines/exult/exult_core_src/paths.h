@@ -52,6 +52,7 @@ public:
 			const Tile_coord& from, const Tile_coord& to) const override;
 	// Is tile at the goal?
 	bool at_goal(const Tile_coord& tile, const Tile_coord& goal) const override;
+	std::unique_ptr<Pathfinder_client> clone() const override;
 
 	bool ignores_npcs() const {
 		return ignore_npcs;
@@ -72,6 +73,10 @@ public:
 			const Tile_coord& from, const Tile_coord& to) const override;
 	// Is tile at the goal?
 	bool at_goal(const Tile_coord& tile, const Tile_coord& goal) const override;
+
+	std::unique_ptr<Pathfinder_client> clone() const override {
+		return nullptr;
+	}
 };
 
 /*
@@ -92,6 +97,10 @@ public:
 			const Tile_coord& from, const Tile_coord& to) const override;
 	// Is tile at the goal?
 	bool at_goal(const Tile_coord& tile, const Tile_coord& goal) const override;
+
+	std::unique_ptr<Pathfinder_client> clone() const override {
+		return nullptr;
+	}
 };
 
 /*
@@ -105,6 +114,10 @@ public:
 	Approach_object_pathfinder_client(Actor* from, Game_object* to, int dist);
 	// Is tile at the goal?
 	bool at_goal(const Tile_coord& tile, const Tile_coord& goal) const override;
+
+	std::unique_ptr<Pathfinder_client> clone() const override {
+		return nullptr;
+	}
 };
 
 /*
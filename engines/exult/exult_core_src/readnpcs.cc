@@ -27,6 +27,7 @@
 #include "databuf.h"
 #include "fnames.h"
 #include "game.h"
+#include "gamedatdelta.h"
 #include "gamewin.h"
 #include "miscinf.h"
 #include "monsters.h"
@@ -35,6 +36,7 @@
 #include "utils.h"
 
 #include <cstring>
+#include <sstream>
 // #include "items.h"            /* Debugging only */
 
 using std::cerr;
@@ -144,9 +146,12 @@ void Game_window::read_npcs() {
  */
 
 void Game_window::write_npcs() {
-	const int num_npcs = npcs.size();
+	const int      num_npcs = npcs.size();
+	Gamedat_delta& delta    = Gamedat_delta::get_instance();
 	{
-		OFileDataSource nfile(NPC_DAT);
+		// These go through Gamedat_delta, so unchanged ones aren't rewritten.
+		std::stringstream buf;
+		OStreamDataSource nfile(&buf);
 
 		nfile.write2(num_npcs1);    // Start with counts.
 		nfile.write2(num_npcs - num_npcs1);
@@ -159,12 +164,14 @@ void Game_window::write_npcs() {
 		if (!nfile.good()) {
 			throw file_write_exception(NPC_DAT);
 		}
+		delta.save(NPC_DAT, buf.str());
 	}
 	write_schedules();    // Write schedules
 	{
 		// Now write out monsters in world.
-		OFileDataSource nfile(MONSNPCS);
-		int             cnt = 0;
+		std::stringstream buf;
+		OStreamDataSource nfile(&buf);
+		int               cnt = 0;
 		nfile.write2(0);    // Write 0 as a place holder.
 		for (Monster_actor* mact = Monster_actor::get_first_in_world(); mact;
 			 mact                = mact->get_next_in_world()) {
@@ -179,6 +186,7 @@ void Game_window::write_npcs() {
 		if (!nfile.good()) {
 			throw file_write_exception(MONSNPCS);
 		}
+		delta.save(MONSNPCS, buf.str());
 	}
 }
 
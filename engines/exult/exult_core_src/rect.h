@@ -25,6 +25,7 @@
 #include "exult_constants.h"
 
 #include <algorithm>
+#include <vector>
 
 static inline bool Point_in_strip(int start, int end, int pt) noexcept {
 	start = (start + c_num_tiles) % c_num_tiles;
@@ -142,6 +143,112 @@ public:          // Let's make it all public.
 	}
 };
 
+/*
+ *  A few rectangles that have changed.  Ones that overlap (or nearly so)
+ *  are merged, and when there are too many, the two that waste the least
+ *  area are.
+ */
+class Dirty_region {
+	// Rects. this close get merged, as the scalers enlarge each by 4
+	//   pixels and round it to a multiple of 4.
+	static constexpr int merge_gap = 8;
+	static constexpr int max_rects = 8;
+
+	std::vector<TileRect> rects;
+
+	static long area(const TileRect& r) noexcept {
+		return static_cast<long>(r.w) * r.h;
+	}
+
+public:
+	using const_iterator = std::vector<TileRect>::const_iterator;
+
+	bool empty() const noexcept {
+		return rects.empty();
+	}
+
+	size_t size() const noexcept {
+		return rects.size();
+	}
+
+	const_iterator begin() const noexcept {
+		return rects.begin();
+	}
+
+	const_iterator end() const noexcept {
+		return rects.end();
+	}
+
+	void clear() noexcept {
+		rects.clear();
+	}
+
+	void add(const TileRect& r) {
+		if (r.w <= 0 || r.h <= 0) {
+			return;
+		}
+		TileRect merged = r;
+		for (size_t i = 0; i < rects.size();) {
+			TileRect near = rects[i];
+			if (near.enlarge(merge_gap).intersects(merged)) {
+				merged = merged.add(rects[i]);
+				rects.erase(rects.begin() + i);
+				i = 0;    // It may reach others now.
+			} else {
+				i++;
+			}
+		}
+		if (rects.size() >= max_rects) {
+			// Merge with the one that adds the least.
+			size_t best      = 0;
+			long   best_cost = 0;
+			for (size_t i = 0; i < rects.size(); i++) {
+				const long cost = area(rects[i].add(merged)) - area(rects[i]);
+				if (i == 0 || cost < best_cost) {
+					best      = i;
+					best_cost = cost;
+				}
+			}
+			merged = merged.add(rects[best]);
+			rects.erase(rects.begin() + best);
+			add(merged);
+			return;
+		}
+		rects.push_back(merged);
+	}
+
+	void shift(int deltax, int deltay) noexcept {
+		for (auto& r : rects) {
+			r.shift(deltax, deltay);
+		}
+	}
+
+	// Clip each to 'clip', dropping those left empty.
+	void intersect(const TileRect& clip) {
+		for (auto& r : rects) {
+			r = r.intersect(clip);
+		}
+		rects.erase(
+				std::remove_if(
+						rects.begin(), rects.end(),
+						[](const TileRect& r) {
+							return r.w <= 0 || r.h <= 0;
+						}),
+				rects.end());
+	}
+
+	TileRect get_bounds() const noexcept {    // All of them.
+		if (rects.empty()) {
+			return TileRect(0, 0, 0, 0);
+		}
+		TileRect bounds = rects[0];
+		for (const auto& r : rects) {
+			bounds = bounds.add(r);
+		}
+		return bounds;
+	}
+};
+
 /*
  *  A 3-dim. block.
  */
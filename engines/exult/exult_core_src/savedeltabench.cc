@@ -0,0 +1,159 @@
+/*
+ *  savedeltabench.cc - Time saving 'gamedat' with and without Gamedat_delta.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/*
+ *  Usage:  savedeltabench [saves [ireg-size]]
+ *
+ *  Saves 144 'u7ireg' files of 'ireg-size' bytes (8192 by default) and an
+ *  'npc.dat' 'saves' times (50 by default), in a directory under the
+ *  system's temporary one.  Before each save, some superchunks and the
+ *  NPCs are changed.  Each save is done by rewriting every file, as
+ *  Game_window::write() used to, and through Gamedat_delta.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "exceptions.h"
+#include "gamedatdelta.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace {
+	const int num_schunks = 144;
+
+	unsigned int seed = 12345;
+
+	int Rand(int range) {
+		seed = seed * 1103515245u + 12345u;
+		return static_cast<int>((seed >> 8) % range);
+	}
+
+	// What's saved:  the superchunks, then the NPCs.
+	struct Gamedat_files {
+		vector<string> names;
+		vector<string> data;
+
+		Gamedat_files(int ireg_size) {
+			char fname[40];
+			for (int i = 0; i < num_schunks; i++) {
+				snprintf(fname, sizeof(fname), "<GAMEDAT>/u7ireg%02x", i);
+				names.emplace_back(fname);
+				data.emplace_back(ireg_size, static_cast<char>(i));
+			}
+			names.emplace_back("<GAMEDAT>/npc.dat");
+			data.emplace_back(32768, 0);
+		}
+
+		// Change 'dirty' superchunks, and always the NPCs.
+		void change(int dirty) {
+			for (int i = 0; i < dirty; i++) {
+				string& each = data[Rand(num_schunks)];
+				each[Rand(each.size())]++;
+			}
+			data.back()[Rand(data.back().size())]++;
+		}
+	};
+
+	void Write_all(const Gamedat_files& files) {
+		for (size_t i = 0; i < files.names.size(); i++) {
+			auto out = U7open_out(files.names[i].c_str());
+			if (!out) {
+				throw file_write_exception(files.names[i]);
+			}
+			out->write(files.data[i].data(), files.data[i].size());
+		}
+	}
+
+	void Save_changed(Gamedat_delta& delta, const Gamedat_files& files) {
+		for (size_t i = 0; i < files.names.size(); i++) {
+			delta.save(files.names[i].c_str(), files.data[i]);
+		}
+	}
+
+	// Output: Average msecs. for a save.
+	template <typename Save>
+	double Time_saves(Gamedat_files& files, int dirty, int saves, Save save) {
+		const unsigned int start_seed = seed;
+		double             secs       = 0;
+		for (int s = 0; s < saves; s++) {
+			files.change(dirty);
+			const auto t0 = std::chrono::steady_clock::now();
+			save();
+			const auto t1 = std::chrono::steady_clock::now();
+			secs += std::chrono::duration<double>(t1 - t0).count();
+		}
+		seed = start_seed;    // So both ways see the same changes.
+		return secs * 1000 / saves;
+	}
+}    // namespace
+
+int main(int argc, char* argv[]) {
+	const int saves     = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 50;
+	const int ireg_size = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 8192;
+
+	const std::filesystem::path dir
+			= std::filesystem::temp_directory_path() / "savedeltabench";
+	std::filesystem::create_directories(dir);
+	add_system_path("<GAMEDAT>", dir.string());
+
+	try {
+		for (const int dirty : {0, 1, 4, 16, 64, num_schunks}) {
+			Gamedat_files files(ireg_size);
+			Write_all(files);
+			const double full = Time_saves(
+					files, dirty, saves, [&files]() { Write_all(files); });
+
+			Gamedat_files files2(ireg_size);
+			Write_all(files2);
+			Gamedat_delta delta(true, 4096 * 1024);
+			Save_changed(delta, files2);    // Last full save.
+			delta.compact();
+			const double quick
+					= Time_saves(files2, dirty, saves, [&delta, &files2]() {
+						  Save_changed(delta, files2);
+					  });
+			delta.clear();
+			cout << dirty << " superchunks changed:  " << full
+				 << "ms to write all, " << quick << "ms with Gamedat_delta"
+				 << endl;
+		}
+	} catch (const exult_exception& e) {
+		std::cerr << e.what() << endl;
+		std::filesystem::remove_all(dir);
+		return 1;
+	}
+	std::filesystem::remove_all(dir);
+	return 0;
+}
@@ -5357,7 +5357,8 @@ Walk_to_schedule::Walk_to_schedule(
 		int               new_sched,    // Schedule when we get there.
 		int               delay         // Msecs, or -1 for random delay.
 		)
-		: Schedule(n), dest(d), new_schedule(new_sched), retries(0), legs(0) {
+		: Schedule(n), dest(d), new_schedule(new_sched), retries(0), legs(0),
+		  leg_retries(0), path_failed(false) {
 	// Delay 0-5 secs.
 	first_delay = delay >= 0 ? delay : (rand() % 5000);
 }
@@ -5382,6 +5383,12 @@ void Walk_to_schedule::now_what() {
 		npc->set_schedule_type(new_schedule);
 		return;
 	}
+	if (path_failed) {    // No path for the last leg after all?
+		path_failed = false;
+		// Wait 1 sec., then try again, as when it fails at once.
+		npc->walk_to_tile(dest, gwin->get_std_delay(), 1000);
+		return;
+	}
 	// Get screen rect. in tiles.
 	TileRect screen = gwin->get_win_tile_rect();
 	screen.enlarge(6);    // Enlarge in all dirs.
@@ -5413,9 +5420,11 @@ void Walk_to_schedule::now_what() {
 	blocked = Tile_coord(-1, -1, -1);
 	cout << "Finding path to schedule for " << npc->get_name() << endl;
 	// Create path to dest., delaying
-	//   0 to 1 seconds.
+	//   0 to 1 seconds.  (If it's found in the background and fails, we
+	//   hear of it in path_not_found().)
 	if (!npc->walk_path_to_tile(
-				from, to, gwin->get_std_delay(), first_delay + rand() % 1000)) {
+				from, to, gwin->get_std_delay(), first_delay + rand() % 1000, 0,
+				3, true)) {
 		// Wait 1 sec., then try again.
 #ifdef DEBUG
 		cout << "Failed to find path for " << npc->get_name() << endl;
@@ -5424,11 +5433,24 @@ void Walk_to_schedule::now_what() {
 		retries++;    // Failed.  Try again next tick.
 	} else {          // Okay.  He's walking there.
 		legs++;
-		retries = 0;
+		leg_retries = retries;
+		retries     = 0;
 	}
 	first_delay = 0;
 }
 
+/*
+ *  The path for the leg we just started was looked for in the background,
+ *  and there isn't one.  Count it as a failure, as when walk_path_to_tile()
+ *  fails at once.  The walk has ended, so now_what() comes next.
+ */
+
+void Walk_to_schedule::path_not_found() {
+	legs--;
+	retries     = leg_retries + 1;
+	path_failed = true;
+}
+
 /*
  *  Don't go dormant when walking to a schedule.
  */
@@ -125,6 +125,10 @@ public:
 		ignore_unused_variable_warning(newtype);
 	}
 
+	// A path that walk_path_to_tile() left to be found in the background
+	//   (with 'async') wasn't found.
+	virtual void path_not_found() {}
+
 	virtual void set_weapon(bool removed = false) {    // Set weapon info.
 		ignore_unused_variable_warning(removed);
 	}
@@ -782,6 +786,8 @@ class Walk_to_schedule : public Schedule {
 	int        new_schedule;    // Schedule to set when we get there.
 	int        retries;         // # failures at finding path.
 	int        legs;            // # times restarted walk.
+	int        leg_retries;     // 'retries' before the last leg.
+	bool       path_failed;     // Background search for last leg failed.
 	// Set to walk off screen.
 	void walk_off_screen(TileRect& screen, Tile_coord& goal);
 
@@ -790,6 +796,7 @@ public:
 			Actor* n, const Tile_coord& d, int new_sched, int delay = -1);
 	void now_what() override;      // Now what should NPC do?
 	void im_dormant() override;    // Just went dormant.
+	void path_not_found() override;
 	// For Usecode intrinsic.
 	int get_actual_type(Actor* npc) const override;
 };
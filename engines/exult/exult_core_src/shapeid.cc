@@ -121,11 +121,12 @@ void Shape_manager::load() {
 	}
 
 	shapes.reset_imports();
+	Palette::clear_cache();    // May be a different game.
 
 	// Determine some colors based on the default palette
 	Palette pal;
 	// could throw!
-	pal.load(PALETTES_FLX, PATCH_PALETTES, 0);
+	pal.load(0);
 	// Get a bright green.
 	special_pixels[POISON_PIXEL] = pal.find_color(4, 63, 4);
 	// Get a light gray.
@@ -251,6 +252,15 @@ void Shape_manager::load() {
 	files[SF_GAME_FLX].load(gamedata);
 
 	read_shape_info();
+	// Bound what decoded frames of 'shapes.vga' can take.
+	int cache_mb;
+	config->value("config/video/shape_cache_mb", cache_mb, 64);
+	shapes.set_frame_budget(
+			cache_mb > 0 ? static_cast<size_t>(cache_mb) << 20 : 0,
+			[this](int shapenum, int framenum) {
+				shape_cache[SF_SHAPES_VGA].erase(
+						std::make_pair(shapenum, framenum));
+			});
 
 	fonts = make_unique<Fonts_vga_file>();
 	fonts->init();
@@ -314,12 +324,8 @@ void Shape_manager::load() {
 			}
 		}
 	} else {    // Create algorithmically.
-		gwin->get_pal()->load(PALETTES_FLX, PATCH_PALETTES, 0);
-		for (size_t i = 0; i < nxforms; i++) {
-			gwin->get_pal()->create_trans_table(
-					blends[4 * i + 0] / 4, blends[4 * i + 1] / 4,
-					blends[4 * i + 2] / 4, blends[4 * i + 3], xforms[i].colors);
-		}
+		gwin->get_pal()->load(0);
+		gwin->get_pal()->create_trans_tables(blends, nxforms, xforms.data());
 	}
 
 	invis_xform = &xforms[nxforms - 1 - 0];    // ->entry 0.
@@ -408,6 +414,40 @@ Shape_manager::~Shape_manager() {
 	instance = nullptr;
 }
 
+/*
+ *  Paint shapes recorded by record_paints().  The frames were looked up
+ *  during this paint, so they're kept in the cache until it's done.
+ */
+
+void Shape_manager::paint(
+		const Shape_paint_list& list,    // What to paint.
+		Image_buffer8*          win      // Where to paint it.
+) const {
+	for (const auto& each : list.entries) {
+		Shape_frame* shape = each.shape;
+		switch (each.kind) {
+		case Shape_paint_list::plain:
+			shape->paint(win, each.xoff, each.yoff);
+			break;
+		case Shape_paint_list::remapped:
+			shape->paint_rle_remapped(
+					win, each.xoff, each.yoff, list.tables[each.arg].data());
+			break;
+		case Shape_paint_list::translucent:
+			shape->paint_rle_translucent(
+					win, each.xoff, each.yoff, xforms.data(), xforms.size());
+			break;
+		case Shape_paint_list::invisible:
+			shape->paint_rle_transformed(
+					win, each.xoff, each.yoff, *invis_xform);
+			break;
+		case Shape_paint_list::outline:
+			shape->paint_rle_outline(win, each.xoff, each.yoff, each.arg);
+			break;
+		}
+	}
+}
+
 /*
  *  Text-drawing methods:
  */
@@ -482,6 +522,9 @@ Shape_manager::Cached_shape Shape_manager::cache_shape(
 	using cache_key = std::pair<int, int>;
 	auto iter = shape_cache[shape_kind].find(cache_key(shapenum, framenum));
 	if (iter != shape_cache[shape_kind].cend()) {
+		if (shape_kind == SF_SHAPES_VGA) {
+			sman->shapes.note_frame_use(shapenum, framenum, iter->second.shape);
+		}
 		return iter->second;
 	}
 	if (shape_kind == SF_SHAPES_VGA) {
@@ -25,6 +25,8 @@
 #include "shapevga.h"
 #include "singles.h"
 
+#include <algorithm>
+#include <array>
 #include <memory>
 #include <vector>
 #include <optional>
@@ -62,6 +64,56 @@ enum Pixel_colors {
 	NPIXCOLORS
 };
 
+/*
+ *  Shapes that were to be painted, kept to be painted later (see
+ *  Shape_manager::record_paints()).
+ */
+class Shape_paint_list {
+public:
+	enum Kind {
+		plain,          // Shape_frame::paint().
+		remapped,       // 'arg' is the index of its table.
+		translucent,
+		invisible,
+		outline         // 'arg' is the color.
+	};
+
+private:
+	friend class Shape_manager;
+
+	struct Entry {
+		Shape_frame* shape;
+		int          xoff, yoff;
+		Kind         kind;
+		int          arg;
+	};
+
+	std::vector<Entry>                          entries;
+	std::vector<std::array<unsigned char, 256>> tables;    // For remapping.
+
+	void add(Shape_frame* shape, int xoff, int yoff, Kind kind, int arg = 0) {
+		entries.push_back(Entry{shape, xoff, yoff, kind, arg});
+	}
+
+	void add_remapped(
+			Shape_frame* shape, int xoff, int yoff,
+			const unsigned char* trans) {
+		tables.emplace_back();
+		std::copy_n(trans, tables.back().size(), tables.back().begin());
+		add(shape, xoff, yoff, remapped, tables.size() - 1);
+	}
+
+public:
+	bool empty() const {
+		return entries.empty();
+	}
+
+	void clear() {
+		entries.clear();
+		tables.clear();
+	}
+};
+
 /*
  *  Manage the set of shape files.
  */
@@ -88,7 +140,8 @@ private:
 	//   is found when playing BG
 	using Shape_cache = std::map<std::pair<int, int>, Cached_shape>;
 	Shape_cache shape_cache[static_cast<int>(SF_COUNT)];
-	void        read_shape_info();
+	Shape_paint_list* recording = nullptr;    // Paints go here, if set.
+	void              read_shape_info();
 
 public:
 	friend class ShapeID;
@@ -137,12 +190,32 @@ public:
 		return got_si_shapes;
 	}
 
+	// Keep what's painted with the methods below in 'list', rather than
+	//   painting it, until called again with nullptr.  Looking up the
+	//   shapes is left to the caller's thread this way.
+	void record_paints(Shape_paint_list* list) {
+		recording = list;
+	}
+
+	// Paint what was recorded.  This only reads the shapes, so it can be
+	//   called on several threads at once with different buffers.
+	void paint(const Shape_paint_list& list, Image_buffer8* win) const;
+
 	// Paint shape in window.
 	void paint_shape(
 			int xoff, int yoff, Shape_frame* shape, bool translucent = false,
 			unsigned char* trans = nullptr) {
 		if (!shape || !shape->get_data()) {
 			CERR("nullptr SHAPE!!!");
+		} else if (recording) {
+			if (!shape->is_rle() || (!trans && !translucent)) {
+				recording->add(shape, xoff, yoff, Shape_paint_list::plain);
+			} else if (trans) {
+				recording->add_remapped(shape, xoff, yoff, trans);
+			} else {
+				recording->add(
+						shape, xoff, yoff, Shape_paint_list::translucent);
+			}
 		} else if (!shape->is_rle()) {
 			shape->paint(xoff, yoff);
 		} else if (trans) {
@@ -156,7 +229,9 @@ public:
 	}
 
 	inline void paint_invisible(int xoff, int yoff, Shape_frame* shape) {
-		if (shape) {
+		if (shape && recording) {
+			recording->add(shape, xoff, yoff, Shape_paint_list::invisible);
+		} else if (shape) {
 			shape->paint_rle_transformed(xoff, yoff, *invis_xform);
 		}
 	}
@@ -164,7 +239,11 @@ public:
 	// Paint outline around a shape.
 	inline void paint_outline(
 			int xoff, int yoff, Shape_frame* shape, Pixel_colors pix) {
-		if (shape) {
+		if (shape && recording) {
+			recording->add(
+					shape, xoff, yoff, Shape_paint_list::outline,
+					special_pixels[static_cast<int>(pix)]);
+		} else if (shape) {
 			shape->paint_rle_outline(
 					xoff, yoff, special_pixels[static_cast<int>(pix)]);
 		}
@@ -855,6 +855,16 @@ void Shape::resize(int newsize) {
 	modified   = true;
 }
 
+/*
+ *  Free a frame that was read in.  Shape::get() will read it again.
+ */
+
+void Shape::drop_frame(int framenum) {
+	if (framenum >= 0 && size_t(framenum) < frames.size()) {
+		frames[framenum].reset();
+	}
+}
+
 /*
  *  Call this to set num_frames, frames_size and create 'frames' list.
  */
@@ -1300,18 +1310,117 @@ bool Vga_file::import_shapes(
 }
 
 void Vga_file::reset() {
+	forget_frames();
 	shapes.clear();
 	shape_sources.clear();
 	shape_cnts.clear();
 }
 
 void Vga_file::reset_imports() {
+	forget_frames();
 	imported_shapes.clear();
 	imported_sources.clear();
 	imported_cnts.clear();
 	imported_shape_table.clear();
 }
 
+/*
+ *  Set how many bytes of frames to keep in memory.
+ */
+
+void Vga_file::set_frame_budget(
+		size_t        bytes,     // 0 to keep all.
+		Frame_evicted evicted    // Called for each frame freed.
+) {
+	if (!flex) {
+		return;    // Frames were all preloaded, and can't be read again.
+	}
+	frame_budget  = bytes;
+	frame_evicted = std::move(evicted);
+	if (!frame_budget) {
+		forget_frames();
+	} else {
+		evict_frames();
+	}
+}
+
+/*
+ *  Note that a frame was used, adding it to the ones we track if needed.
+ */
+
+void Vga_file::use_frame(int shapenum, int framenum, Shape_frame* frame) {
+	const uint32 key   = frame_key(shapenum, framenum);
+	auto         found = frame_index.find(key);
+	if (found != frame_index.end()) {
+		frame_stats.hits++;
+		found->second->epoch = frame_epoch;
+		frame_lru.splice(frame_lru.begin(), frame_lru, found->second);
+		return;
+	}
+	frame_stats.misses++;
+	const size_t size = sizeof(Shape_frame) + frame->get_size();
+	frame_lru.push_front(Cached_frame{shapenum, framenum, size, frame_epoch});
+	frame_index[key] = frame_lru.begin();
+	frame_stats.bytes += size;
+	frame_stats.frames++;
+	evict_frames();
+}
+
+/*
+ *  Free least recently used frames until we're within the budget.
+ */
+
+void Vga_file::evict_frames() {
+	while (frame_stats.bytes > frame_budget && !frame_lru.empty()) {
+		const Cached_frame& oldest = frame_lru.back();
+		if (oldest.epoch == frame_epoch) {
+			break;    // The rest are in use now.
+		}
+		Shape* shape = find_shape(oldest.shapenum);
+		// Frames of edited shapes can't be read back, and frame 0 tells
+		//   what kind of shape it is.
+		if (shape && !shape->get_modified() && oldest.framenum != 0) {
+			shape->drop_frame(oldest.framenum);
+			frame_stats.evictions++;
+			if (frame_evicted) {
+				frame_evicted(oldest.shapenum, oldest.framenum);
+			}
+		}
+		frame_stats.bytes -= oldest.size;
+		frame_stats.frames--;
+		frame_index.erase(frame_key(oldest.shapenum, oldest.framenum));
+		frame_lru.pop_back();
+	}
+}
+
+/*
+ *  Stop tracking frames (without freeing them).
+ */
+
+void Vga_file::forget_frames() {
+	frame_lru.clear();
+	frame_index.clear();
+	frame_stats.bytes  = 0;
+	frame_stats.frames = 0;
+}
+
+/*
+ *  Get a shape's frames, whether it's imported or not.
+ *
+ *  Output: ->shape, or nullptr.
+ */
+
+Shape* Vga_file::find_shape(int shapenum) {
+	imported_map data;
+	if (get_imported_shape_data(shapenum, data)) {
+		return data.pointer_offset >= 0 ? &imported_shapes[data.pointer_offset]
+										: nullptr;
+	}
+	return shapenum >= 0 && size_t(shapenum) < shapes.size()
+				   ? &shapes[shapenum]
+				   : nullptr;
+}
+
 // Out-of-line definition to avoid more dependencies on databuf.h.
 Vga_file::~Vga_file() noexcept = default;
 
@@ -28,10 +28,13 @@
 
 #include <cassert>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <list>
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -283,6 +286,8 @@ public:
 	}
 
 	void resize(int newsize);    // Modify #frames.
+	// Free a frame that was read in, so it's read again when needed.
+	void drop_frame(int framenum);
 	// Set frame.
 	void set_frame(std::unique_ptr<Shape_frame> f, int framenum);
 	// Add/insert frame.
@@ -320,6 +325,19 @@ public:
  *  A class for accessing any .vga file:
  */
 class Vga_file {
+public:
+	// How the frame budget (see set_frame_budget()) is doing.
+	struct Frame_cache_stats {
+		size_t        bytes     = 0;    // Held by frames being tracked.
+		size_t        frames    = 0;    // # being tracked.
+		unsigned long hits      = 0;
+		unsigned long misses    = 0;
+		unsigned long evictions = 0;
+	};
+
+	// Told about each frame freed, so copies of its pointer can be dropped.
+	using Frame_evicted = std::function<void(int shapenum, int framenum)>;
+
 protected:
 	struct imported_map {
 		int realshape;
@@ -327,6 +345,14 @@ protected:
 		int source_offset;
 	};
 
+	// A frame that was handed out, in least-recently-used order.
+	struct Cached_frame {
+		int    shapenum;
+		int    framenum;
+		size_t size;     // Bytes it takes.
+		uint32 epoch;    // When last used.
+	};
+
 	std::vector<std::pair<std::unique_ptr<IDataSource>, bool>> shape_sources;
 	std::vector<std::pair<std::unique_ptr<IDataSource>, bool>> imported_sources;
 	std::map<int, imported_map> imported_shape_table;
@@ -341,6 +367,23 @@ protected:
 	// In this case, all frames are pre-
 	//   loaded.
 
+	// For set_frame_budget():
+	size_t                  frame_budget = 0;    // Bytes to keep, or 0 for all.
+	uint32                  frame_epoch  = 0;    // Frames used in it are kept.
+	std::list<Cached_frame> frame_lru;           // Most recently used first.
+	std::unordered_map<uint32, std::list<Cached_frame>::iterator> frame_index;
+	Frame_cache_stats frame_stats;
+	Frame_evicted     frame_evicted;
+
+	static uint32 frame_key(int shapenum, int framenum) {
+		return (static_cast<uint32>(shapenum) << 8) | (framenum & 0xff);
+	}
+
+	void   use_frame(int shapenum, int framenum, Shape_frame* frame);
+	void   evict_frames();
+	void   forget_frames();
+	Shape* find_shape(int shapenum);
+
 public:
 	explicit Vga_file(
 			const char* nm, int u7drag = -1, const char* nm2 = nullptr);
@@ -387,6 +430,28 @@ public:
 		return flex;
 	}
 
+	// Keep only 'bytes' worth of frames read from a flex (0 for no limit),
+	//   freeing the least recently used.  Frames used since the last
+	//   new_frame_epoch() are never freed, nor are frame 0s and the frames
+	//   of modified shapes.
+	void set_frame_budget(size_t bytes, Frame_evicted evicted = nullptr);
+
+	// Start a new paint, so frames it uses are kept.
+	void new_frame_epoch() {
+		frame_epoch++;
+	}
+
+	const Frame_cache_stats& get_frame_cache_stats() const {
+		return frame_stats;
+	}
+
+	// Count a use of a frame (for the budget) by one who cached it.
+	void note_frame_use(int shapenum, int framenum, Shape_frame* frame) {
+		if (frame_budget && frame) {
+			use_frame(shapenum, framenum, frame);
+		}
+	}
+
 	// Get shape.
 	Shape_frame* get_shape(int shapenum, int framenum = 0) {
 		Shape_frame* r;
@@ -409,6 +474,7 @@ public:
 			r = shapes[shapenum].get(
 					shape_sources, shapenum, framenum, shape_cnts, -1);
 		}
+		note_frame_use(shapenum, framenum, r);
 		return r;
 	}
 
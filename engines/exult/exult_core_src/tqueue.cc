@@ -24,11 +24,8 @@
 
 #include "tqueue.h"
 
-#include "actors.h"
-#include "cheat.h"
-#include "gamewin.h"
-
 #include <algorithm>
+#include <utility>
 
 #ifdef __GNUC__
 #	pragma GCC diagnostic push
@@ -40,52 +37,217 @@
 #	pragma GCC diagnostic pop
 #endif    // __GNUC__
 
+/*
+ *  Number of children for each heap node.
+ */
+const int c_heap_arity = 4;
+
+/*
+ *  Move an entry towards the top of the heap until it's in order.
+ */
+
+void Time_queue::sift_up(int pos) {
+	const int e = heap[pos];
+	while (pos > 0) {
+		const int parent = (pos - 1) / c_heap_arity;
+		if (!before(e, heap[parent])) {
+			break;
+		}
+		heap[pos]                   = heap[parent];
+		entries[heap[pos]].heap_pos = pos;
+		pos                         = parent;
+	}
+	heap[pos]           = e;
+	entries[e].heap_pos = pos;
+}
+
+/*
+ *  Move an entry towards the bottom of the heap until it's in order.
+ */
+
+void Time_queue::sift_down(int pos) {
+	const int e   = heap[pos];
+	const int cnt = heap.size();
+	for (;;) {
+		const int first = pos * c_heap_arity + 1;
+		if (first >= cnt) {
+			break;
+		}
+		const int last = std::min(first + c_heap_arity, cnt);
+		int       best = first;    // Find soonest child.
+		for (int child = first + 1; child < last; child++) {
+			if (before(heap[child], heap[best])) {
+				best = child;
+			}
+		}
+		if (!before(heap[best], e)) {
+			break;
+		}
+		heap[pos]                   = heap[best];
+		entries[heap[pos]].heap_pos = pos;
+		pos                         = best;
+	}
+	heap[pos]           = e;
+	entries[e].heap_pos = pos;
+}
+
+/*
+ *  Take an entry out of the heap and its handler's chain, and free it.
+ *  The handler's queue_cnt is left alone.
+ */
+
+void Time_queue::remove_entry(int e) {
+	Queue_entry& ent  = entries[e];
+	const int    pos  = ent.heap_pos;
+	const int    last = heap.back();
+	heap.pop_back();
+	if (last != e) {    // Fill the hole with the last one.
+		heap[pos]              = last;
+		entries[last].heap_pos = pos;
+		if (pos > 0 && before(last, heap[(pos - 1) / c_heap_arity])) {
+			sift_up(pos);
+		} else {
+			sift_down(pos);
+		}
+	}
+	if (ent.prev_same >= 0) {
+		entries[ent.prev_same].next_same = ent.next_same;
+	} else {
+		ent.handler->queue_first = ent.next_same;
+	}
+	if (ent.next_same >= 0) {
+		entries[ent.next_same].prev_same = ent.prev_same;
+	}
+	ent.handler = nullptr;
+	ent.sp_handler.reset();
+	ent.heap_pos = -1;
+	ent.generation++;
+	free_entries.push_back(e);
+}
+
+/*
+ *  Find an object's entry that's due first.
+ *
+ *  Output: Entry #, or -1 if none.
+ */
+
+int Time_queue::find_entry(const Time_sensitive* obj) const {
+	int found = -1;
+	for (int e = obj->queue_first; e >= 0; e = entries[e].next_same) {
+		if (found < 0 || before(e, found)) {
+			found = e;
+		}
+	}
+	return found;
+}
+
+int Time_queue::find_entry(const Time_sensitive* obj, uintptr udata) const {
+	int found = -1;
+	for (int e = obj->queue_first; e >= 0; e = entries[e].next_same) {
+		if (entries[e].udata == udata && (found < 0 || before(e, found))) {
+			found = e;
+		}
+	}
+	return found;
+}
+
 /*
  *  Remove all entries.
  */
 
 void Time_queue::clear() {
-	for (auto& ent : data) {
-		ent.handler->dequeue();
+	// Empty the queue first, since dequeue() may delete the handler.  The
+	//   entries are freed as remove_entry() does, so Handles to them don't
+	//   match what's added later.
+	std::vector<std::shared_ptr<Time_sensitive>> keep;    // Until dequeued.
+	std::vector<Time_sensitive*>                 dequeued;
+	for (size_t e = 0; e < entries.size(); e++) {
+		Queue_entry& ent = entries[e];
+		if (ent.heap_pos < 0) {
+			continue;
+		}
+		ent.handler->queue_first = -1;
+		dequeued.push_back(ent.handler);
+		if (ent.sp_handler) {
+			keep.push_back(std::move(ent.sp_handler));
+		}
+		ent.handler   = nullptr;
+		ent.heap_pos  = -1;
+		ent.next_same = ent.prev_same = -1;
+		ent.generation++;
+		free_entries.push_back(e);
+	}
+	heap.clear();
+	for (auto* handler : dequeued) {
+		handler->dequeue();
 	}
-	data.clear();
 }
 
 /*
  *  Add an entry to the queue.
+ *
+ *  Output: Handle for removing just this entry.
  */
 
-void Time_queue::add(
+Time_queue::Handle Time_queue::add(
 		uint32 t, std::shared_ptr<Time_sensitive> obj, uintptr ud) {
-	obj->queue_cnt++;    // It's going in, no matter what.
-	Queue_entry newent;
-	if (paused && !obj->always) {    // Paused?
-		// Messy, but we need to fix time.
-		t -= SDL_GetTicks() - pause_time;
-	}
-	newent.set(t, nullptr, ud, obj);
-	auto insertionPoint = std::upper_bound(data.begin(), data.end(), newent);
-	data.insert(insertionPoint, newent);
+	Time_sensitive* handler = obj.get();
+	const Handle    entry   = add(t, handler, ud);
+	entries[entry.index].sp_handler = std::move(obj);
+	return entry;
 }
 
-void Time_queue::add(
+Time_queue::Handle Time_queue::add(
 		uint32          t,      // When entry is to be activated.
 		Time_sensitive* obj,    // Object to be added.
 		uintptr         ud      // User data.
 ) {
 	obj->queue_cnt++;    // It's going in, no matter what.
-	Queue_entry newent;
 	if (paused && !obj->always) {    // Paused?
 		// Messy, but we need to fix time.
 		t -= SDL_GetTicks() - pause_time;
 	}
-	newent.set(t, obj, ud, nullptr);
-	auto insertionPoint = std::upper_bound(data.begin(), data.end(), newent);
-	data.insert(insertionPoint, newent);
+	int e;
+	if (free_entries.empty()) {
+		e = entries.size();
+		entries.emplace_back();
+	} else {
+		e = free_entries.back();
+		free_entries.pop_back();
+	}
+	Queue_entry& ent = entries[e];
+	ent.handler      = obj;
+	ent.udata        = ud;
+	ent.time         = t;
+	ent.seq          = next_seq++;
+	ent.prev_same    = -1;
+	ent.next_same    = obj->queue_first;
+	if (obj->queue_first >= 0) {
+		entries[obj->queue_first].prev_same = e;
+	}
+	obj->queue_first = e;
+	heap.push_back(e);
+	sift_up(heap.size() - 1);
+	return Handle(e, ent.generation);
 }
 
-bool operator<(const Queue_entry& q1, const Queue_entry& q2) {
-	return q1.time < q2.time;
+/*
+ *  Remove an entry returned by add().
+ *
+ *  Output: true if it was still in the queue.
+ */
+
+bool Time_queue::remove(Handle entry) {
+	if (entry.index < 0 || static_cast<size_t>(entry.index) >= entries.size()) {
+		return false;
+	}
+	Queue_entry& ent = entries[entry.index];
+	if (ent.generation != entry.generation || ent.heap_pos < 0) {
+		return false;    // Already gone.
+	}
+	ent.handler->queue_cnt--;
+	remove_entry(entry.index);
+	return true;
 }
 
 /*
@@ -95,29 +257,13 @@ bool operator<(const Queue_entry& q1, const Queue_entry& q2) {
  */
 
 bool Time_queue::remove(Time_sensitive* obj) {
-	auto toRemove
-			= std::find_if(data.begin(), data.end(), [obj](const auto& el) {
-				  return el.handler == obj || el.sp_handler.get() == obj;
-			  });
-	auto found = toRemove != data.end();
-	if (found) {
-		toRemove->handler->queue_cnt--;
-		data.erase(toRemove);
-	}
-	return found;
-}
-
-bool Time_queue::remove(std::shared_ptr<Time_sensitive> obj) {
-	auto toRemove
-			= std::find_if(data.begin(), data.end(), [obj](const auto& el) {
-				  return el.handler == obj.get() || el.sp_handler == obj;
-			  });
-	auto found = toRemove != data.end();
-	if (found) {
-		toRemove->handler->queue_cnt--;
-		data.erase(toRemove);
+	const int e = find_entry(obj);
+	if (e < 0) {
+		return false;
 	}
-	return found;
+	obj->queue_cnt--;
+	remove_entry(e);
+	return true;
 }
 
 /*
@@ -127,28 +273,13 @@ bool Time_queue::remove(std::shared_ptr<Time_sensitive> obj) {
  */
 
 bool Time_queue::remove(Time_sensitive* obj, uintptr udata) {
-	auto       it = std::find_if(data.begin(), data.end(), [&](const auto& el) {
-        return el.handler == obj && el.udata == udata;
-    });
-	const bool found = it != data.end();
-	if (found) {
-		obj->queue_cnt--;
-		data.erase(it);
-	}
-	return found;
-}
-
-bool Time_queue::remove(std::shared_ptr<Time_sensitive> obj, uintptr udata) {
-	auto       it = std::find_if(data.begin(), data.end(), [&](const auto& el) {
-        return (el.handler == obj.get() || el.sp_handler == obj)
-               && el.udata == udata;
-    });
-	const bool found = it != data.end();
-	if (found) {
-		obj->queue_cnt--;
-		data.erase(it);
+	const int e = find_entry(obj, udata);
+	if (e < 0) {
+		return false;
 	}
-	return found;
+	obj->queue_cnt--;
+	remove_entry(e);
+	return true;
 }
 
 /*
@@ -158,12 +289,7 @@ bool Time_queue::remove(std::shared_ptr<Time_sensitive> obj, uintptr udata) {
  */
 
 bool Time_queue::find(const Time_sensitive* obj) const {
-	return std::find_if(
-				   data.begin(), data.end(),
-				   [&](const auto& el) {
-					   return el.handler == obj || el.sp_handler.get() == obj;
-				   })
-		   != data.end();
+	return obj->queue_first >= 0;
 }
 
 /*
@@ -173,25 +299,23 @@ bool Time_queue::find(const Time_sensitive* obj) const {
  */
 
 long Time_queue::find_delay(const Time_sensitive* obj, uint32 curtime) const {
-	auto found = std::find_if(data.begin(), data.end(), [&](const auto& el) {
-		return obj == el.handler || obj == el.sp_handler.get();
-	});
-	if (found == data.end()) {
+	const int e = find_entry(obj);
+	if (e < 0) {
 		return -1;
 	}
 	if (pause_time) {    // Watch for case when paused.
 		curtime = pause_time;
 	}
-	const long delay = found->time - curtime;
+	const long delay = entries[e].time - curtime;
 	return delay >= 0 ? delay : 0;
 }
 
-void Time_queue::activate(uint32 curtime) {
-	if (cheat.in_map_editor()) {
-		activate_mapedit(curtime);
+void Time_queue::activate(uint32 curtime, const Time_sensitive* editing) {
+	if (editing) {
+		activate_only(curtime, editing);
 	} else if (paused > 0) {
-		activate_always(curtime);
-	} else if (!data.empty() && !(curtime < data.front().time)) {
+		activate_only(curtime, nullptr);
+	} else if (!heap.empty() && !(curtime < entries[heap[0]].time)) {
 		activate0(curtime);
 	}
 }
@@ -204,81 +328,72 @@ void Time_queue::activate(uint32 curtime) {
 void Time_queue::activate0(uint32 curtime    // Current time.
 ) {
 	do {
-		Queue_entry                     ent    = data.front();
-		Time_sensitive*                 obj    = ent.handler;
-		std::shared_ptr<Time_sensitive> sp_obj = ent.sp_handler;
-		const uintptr                   udata  = ent.udata;
-		data.pop_front();    // Remove from chain.
-
-		if (!obj && sp_obj) {
-			obj = sp_obj.get();
-		}
-		if (obj) {
-			obj->queue_cnt--;
-			obj->handle_event(curtime, udata);
-		}
-
-	} while (!data.empty() && !(curtime < data.front().time));
+		const int       e     = heap[0];
+		Queue_entry&    ent   = entries[e];
+		Time_sensitive* obj   = ent.handler;
+		const uintptr   udata = ent.udata;
+		// Keep it alive until it's done.
+		const std::shared_ptr<Time_sensitive> sp_obj
+				= std::move(ent.sp_handler);
+		remove_entry(e);    // Remove from chain.
+		obj->queue_cnt--;
+		obj->handle_event(curtime, udata);
+	} while (!heap.empty() && !(curtime < entries[heap[0]].time));
 }
 
 /*
- *  Remove & activate entries marked 'always'.  This is called when
- *  the queue is paused.
+ *  Remove & activate entries marked 'always', plus those for 'extra' if
+ *  given.  This is called when the queue is paused, or when map edit mode
+ *  is enabled (with the avatar as 'extra').
  */
 
-void Time_queue::activate_always(uint32 curtime    // Current time.
-) {
-	if (data.empty()) {
-		return;
+void Time_queue::activate_only(
+		uint32                curtime,    // Current time.
+		const Time_sensitive* extra) {
+	// Find the ones that are due, only looking down the heap while
+	//   they are.
+	std::vector<int> due;
+	std::vector<int> todo;
+	if (!heap.empty()) {
+		todo.push_back(0);
 	}
-	for (auto it = data.begin(); it != data.end() && !(curtime < it->time);) {
-		auto next = it;
-		++next;    // Get ->next in case we erase.
-		Queue_entry                     ent    = *it;
-		std::shared_ptr<Time_sensitive> sp_obj = ent.sp_handler;
-		Time_sensitive*                 obj    = ent.handler;
-		if (obj == nullptr && sp_obj) {
-			obj = sp_obj.get();
+	while (!todo.empty()) {
+		const int pos = todo.back();
+		todo.pop_back();
+		const Queue_entry& ent = entries[heap[pos]];
+		if (curtime < ent.time) {
+			continue;
+		}
+		if (ent.handler->always || ent.handler == extra) {
+			due.push_back(heap[pos]);
 		}
-		if (obj != nullptr && obj->always) {
-			obj->queue_cnt--;
-			const uintptr udata = ent.udata;
-			data.erase(it);
-			obj->handle_event(curtime, udata);
+		const int first = pos * c_heap_arity + 1;
+		const int last  = std::min<int>(first + c_heap_arity, heap.size());
+		for (int child = first; child < last; child++) {
+			todo.push_back(child);
 		}
-		it = next;
 	}
-}
-
-/*
- *  Remove & activate only the avatar.  This is called when
- *  map edit mode is enabled.
- */
-
-void Time_queue::activate_mapedit(uint32 curtime    // Current time.
-) {
-	if (data.empty()) {
-		return;
+	std::sort(due.begin(), due.end(), [this](int e1, int e2) {
+		return before(e1, e2);
+	});
+	std::vector<Handle> handles;
+	handles.reserve(due.size());
+	for (const int e : due) {
+		handles.push_back(Handle(e, entries[e].generation));
 	}
-
-	const Main_actor* const avatar
-			= Game_window::get_instance()->get_main_actor();
-	for (auto it = data.begin(); it != data.end() && !(curtime < it->time);) {
-		auto next = it;
-		++next;    // Get ->next in case we erase.
-		Queue_entry                     ent    = *it;
-		std::shared_ptr<Time_sensitive> sp_obj = ent.sp_handler;
-		Time_sensitive*                 obj    = ent.handler;
-		if (obj == nullptr && sp_obj) {
-			obj = sp_obj.get();
-		}
-		if (obj != nullptr && (obj == avatar || obj->always)) {
-			obj->queue_cnt--;
-			const uintptr udata = ent.udata;
-			data.erase(it);
-			obj->handle_event(curtime, udata);
+	// Handlers may add or remove entries, so go by handle.
+	for (const Handle& each : handles) {
+		Queue_entry& ent = entries[each.index];
+		if (ent.generation != each.generation || ent.heap_pos < 0) {
+			continue;    // Removed by an earlier one.
 		}
-		it = next;
+		Time_sensitive* obj   = ent.handler;
+		const uintptr   udata = ent.udata;
+		const std::shared_ptr<Time_sensitive> sp_obj
+				= std::move(ent.sp_handler);
+		remove_entry(each.index);
+		obj->queue_cnt--;
+		obj->handle_event(curtime, udata);
 	}
 }
 
@@ -295,9 +410,15 @@ void Time_queue::resume(uint32 curtime) {
 	if (diff < 0) {    // Should not happen.
 		return;
 	}
-	for (auto& it : data) {
-		if (!it.handler->always) {
-			it.time += diff;    // Push entries ahead.
+	for (const int e : heap) {
+		if (!entries[e].handler->always) {
+			entries[e].time += diff;    // Push entries ahead.
+		}
+	}
+	// Put the heap back in order.
+	if (heap.size() > 1) {
+		for (int pos = (heap.size() - 2) / c_heap_arity; pos >= 0; pos--) {
+			sift_down(pos);
 		}
 	}
 }
@@ -310,19 +431,12 @@ bool Time_queue_iterator::operator()(
 		Time_sensitive*& obj,    // Main object.
 		uintptr&         data    // Data that was added with it.
 ) {
-	auto remain = iter;
-	iter        = this_obj == nullptr
-						  ? remain
-						  : std::find_if(
-                             iter, tqueue->data.end(), [&](const auto& el) {
-                                 return el.handler == this_obj
-                                        || el.sp_handler.get() == this_obj;
-                             });
-	if (iter == tqueue->data.end()) {
+	if (next < 0) {
 		return false;
 	}
-	obj  = iter->handler;    // Return fields.
-	data = iter->udata;
-	++iter;    // On to the next.
+	const Time_queue::Queue_entry& ent = tqueue->entries[next];
+	obj  = ent.handler;    // Return fields.
+	data = ent.udata;
+	next = ent.next_same;    // On to the next.
 	return true;
 }
@@ -23,15 +23,16 @@
 
 #include "common_types.h"
 
-#include <list>
 #include <memory>
+#include <vector>
 
 /*
  *  An interface for entries in the queue:
  */
 class Time_sensitive {
-	int  queue_cnt = 0;        // # of entries for this in queue.
-	bool always    = false;    // Always do this, even if paused.
+	int  queue_cnt   = 0;        // # of entries for this in queue.
+	int  queue_first = -1;       // Index of first of them in queue.
+	bool always      = false;    // Always do this, even if paused.
 protected:
 	virtual void dequeue() {
 		queue_cnt--;
@@ -39,6 +40,7 @@ protected:
 
 public:
 	friend class Time_queue;
+	friend class Time_queue_iterator;
 	virtual ~Time_sensitive() = default;
 
 	bool in_queue() const {
@@ -54,89 +56,131 @@ public:
 	virtual void handle_event(unsigned long curtime, uintptr udata) = 0;
 };
 
-class Time_queue;
-
 /*
- *  A queue entry:
+ *  Time-based queue.  The entries are kept in a 4-ary heap by time (and
+ *  by order added, for equal times), so adding and removing are
+ *  O(log n).  Each object's entries are also chained together, so looking
+ *  one up by object only looks at that object's entries.
+ *
+ *  Note:  an object can only be in one Time_queue at a time.
  */
-struct Queue_entry {
-	// Queue_entry *next, *prev;    // Next, prev. in queue.
-	Time_sensitive* handler;    // Object to activate.
-	std::shared_ptr<Time_sensitive>
-			sp_handler;    // Shared pointer to object to activate
-	uintptr udata;         // Data to pass to handler.
-	uint32  time;          // Time when this is due.
-
-	inline void set(
-			uint32 t, Time_sensitive* h, uintptr ud,
-			std::shared_ptr<Time_sensitive> sp) {
-		time       = t;
-		handler    = h;
-		udata      = ud;
-		sp_handler = sp;
+class Time_queue {
+public:
+	/*
+	 *  Identifies one entry, for remove().  It's safe to keep after the
+	 *  entry is gone; remove() will just return false.
+	 */
+	class Handle {
+		int    index      = -1;
+		uint32 generation = 0;
+		friend class Time_queue;
+
+		Handle(int i, uint32 g) : index(i), generation(g) {}
+
+	public:
+		Handle() = default;
+
+		bool is_valid() const {
+			return index >= 0;
+		}
+	};
+
+private:
+	struct Queue_entry {
+		Time_sensitive* handler = nullptr;    // Object to activate.
+		// Only set when added as a shared_ptr, to keep it alive.
+		std::shared_ptr<Time_sensitive> sp_handler;
+		uintptr                         udata = 0;    // Data to pass to handler.
+		uint32                          time  = 0;    // Time when this is due.
+		uint64                          seq   = 0;    // Order added.
+		int    heap_pos   = -1;    // Index in 'heap', or -1 if free.
+		int    next_same  = -1;    // Handler's other entries.
+		int    prev_same  = -1;
+		uint32 generation = 0;    // Bumped each time it's freed.
+	};
+
+	std::vector<Queue_entry> entries;    // Indexed by entry #.
+	std::vector<int>         free_entries;
+	std::vector<int>         heap;    // Entry #'s, soonest first.
+	uint64                   next_seq   = 0;
+	uint32                   pause_time = 0;    // Time when paused.
+	int                      paused     = 0;    // Count of calls to 'pause()'.
+
+	bool before(int e1, int e2) const {    // Is entry e1 due before e2?
+		const Queue_entry& q1 = entries[e1];
+		const Queue_entry& q2 = entries[e2];
+		return q1.time < q2.time || (q1.time == q2.time && q1.seq < q2.seq);
 	}
-};
-
-bool operator<(const Queue_entry& q1, const Queue_entry& q2);
 
-/*
- *  Time-based queue.  The entries are kept sorted in increasing order
- *  by time.
- */
-class Time_queue {
-	using Temporal_sequence = std::list<Queue_entry>;
-	Temporal_sequence data;
-	uint32            pause_time = 0;    // Time when paused.
-	int               paused     = 0;    // Count of calls to 'pause()'.
+	void sift_up(int pos);
+	void sift_down(int pos);
+	void remove_entry(int e);    // Take out of heap and chain; free it.
+	// Find handler's first-due entry (with given udata, if any).
+	int find_entry(const Time_sensitive* obj) const;
+	int find_entry(const Time_sensitive* obj, uintptr udata) const;
 
 	// Activate head + any others due.
 	void activate0(uint32 curtime);
-	void activate_always(uint32 curtime);
-	void activate_mapedit(uint32 curtime);
+	// Activate 'always' entries, and also 'extra's if not null.
+	void activate_only(uint32 curtime, const Time_sensitive* extra);
 
 public:
 	friend class Time_queue_iterator;
 	void clear();    // Remove all entries.
 
 	// Add an entry.
-	void add(uint32 t, Time_sensitive* obj) {
-		add(t, obj, static_cast<uintptr>(0));
+	Handle add(uint32 t, Time_sensitive* obj) {
+		return add(t, obj, static_cast<uintptr>(0));
 	}
 
-	void add(uint32 t, std::shared_ptr<Time_sensitive> obj) {
-		add(t, obj, static_cast<uintptr>(0));
+	Handle add(uint32 t, std::shared_ptr<Time_sensitive> obj) {
+		return add(t, std::move(obj), static_cast<uintptr>(0));
 	}
 
-	void add(uint32 t, Time_sensitive* obj, void* ud) {
-		add(t, obj, reinterpret_cast<uintptr>(ud));
+	Handle add(uint32 t, Time_sensitive* obj, void* ud) {
+		return add(t, obj, reinterpret_cast<uintptr>(ud));
 	}
 
-	void add(uint32 t, std::shared_ptr<Time_sensitive> obj, void* ud) {
-		add(t, obj, reinterpret_cast<uintptr>(ud));
+	Handle add(uint32 t, std::shared_ptr<Time_sensitive> obj, void* ud) {
+		return add(t, std::move(obj), reinterpret_cast<uintptr>(ud));
 	}
 
-	void add(uint32 t, std::shared_ptr<Time_sensitive> obj, uintptr ud);
-	void add(uint32 t, Time_sensitive* obj, uintptr ud);
+	Handle add(uint32 t, std::shared_ptr<Time_sensitive> obj, uintptr ud);
+	Handle add(uint32 t, Time_sensitive* obj, uintptr ud);
+	// Remove one entry.
+	bool remove(Handle entry);
 	// Remove object's entry.
 	bool remove(Time_sensitive* obj);
-	bool remove(std::shared_ptr<Time_sensitive> obj);
+
+	bool remove(const std::shared_ptr<Time_sensitive>& obj) {
+		return remove(obj.get());
+	}
 
 	void remove(Time_sensitive* obj, void* ud) {
 		remove(obj, reinterpret_cast<uintptr>(ud));
 	}
 
-	void remove(std::shared_ptr<Time_sensitive> obj, void* ud) {
-		remove(obj, reinterpret_cast<uintptr>(ud));
+	void remove(const std::shared_ptr<Time_sensitive>& obj, void* ud) {
+		remove(obj.get(), reinterpret_cast<uintptr>(ud));
 	}
 
 	bool remove(Time_sensitive* obj, uintptr udata);
-	bool remove(std::shared_ptr<Time_sensitive> obj, uintptr udata);
+
+	bool remove(const std::shared_ptr<Time_sensitive>& obj, uintptr udata) {
+		return remove(obj.get(), udata);
+	}
+
 	bool find(const Time_sensitive* obj) const;    // Find an entry.
 	// Find delay when obj. is due.
 	long find_delay(const Time_sensitive* obj, uint32 curtime) const;
 
-	// Activate entries that are 'due'.
-	void activate(uint32 curtime);
+	size_t size() const {    // # of entries.
+		return heap.size();
+	}
+
+	// Activate entries that are 'due'.  If 'editing' isn't null, we're in
+	//   map-edit mode, and only it and 'always' entries are activated.
+	void activate(uint32 curtime, const Time_sensitive* editing = nullptr);
 
 	void pause(uint32 curtime) {    // Game paused.
 		if (!paused++) {
@@ -147,13 +191,16 @@ public:
 	void resume(uint32 curtime);
 };
 
+/*
+ *  Goes through one object's entries (in no particular order).
+ */
 class Time_queue_iterator {
-	Time_queue::Temporal_sequence::iterator iter;
-	Time_queue*                             tqueue;
-	Time_sensitive* this_obj;    // Only return entries for this obj.
+	int         next;
+	Time_queue* tqueue;
+
 public:
 	Time_queue_iterator(Time_queue* tq, Time_sensitive* obj)
-			: iter(tq->data.begin()), tqueue(tq), this_obj(obj) {}
+			: next(obj->queue_first), tqueue(tq) {}
 
 	bool operator()(Time_sensitive*& obj, uintptr& data);
 };
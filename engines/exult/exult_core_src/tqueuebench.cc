@@ -0,0 +1,106 @@
+/*
+ *  tqueuebench.cc - Stress Time_queue with many entries and time it.
+ *
+ *  Copyright (C) 2000-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/*
+ *  Usage:  tqueuebench [entries [frames]]
+ *
+ *  Queues 'entries' objects (50000 by default), then runs 'frames' 10ms
+ *  frames.  Each object re-queues itself when activated, like an
+ *  animation does, and each frame some are removed and re-added by
+ *  handle and by object, like NPC timers and usecode scripts are.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "ignore_unused_variable_warning.h"
+#include "tqueue.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using std::vector;
+
+namespace {
+	unsigned int seed = 12345;
+
+	int Rand(int range) {
+		seed = seed * 1103515245u + 12345u;
+		return static_cast<int>((seed >> 8) % range);
+	}
+
+	class Bench_event : public Time_sensitive {
+	public:
+		Time_queue*          tqueue;
+		Time_queue::Handle   entry;
+		static unsigned long activated;
+
+		Bench_event(Time_queue* tq) : tqueue(tq) {}
+
+		void handle_event(unsigned long curtime, uintptr udata) override {
+			ignore_unused_variable_warning(udata);
+			activated++;
+			// Come back in 50-1000 msecs.
+			entry = tqueue->add(curtime + 50 + Rand(950), this);
+		}
+	};
+
+	unsigned long Bench_event::activated = 0;
+}    // namespace
+
+int main(int argc, char* argv[]) {
+	const int num_entries = argc > 1 ? std::atoi(argv[1]) : 50000;
+	const int frames      = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+	Time_queue          tqueue;
+	vector<Bench_event> events(num_entries, Bench_event(&tqueue));
+	uint32              curtime = 0;
+	const auto          t0      = std::chrono::steady_clock::now();
+	for (auto& each : events) {
+		each.entry = tqueue.add(curtime + Rand(1000), &each);
+	}
+	unsigned long removed = 0;
+	for (int f = 0; f < frames; f++) {
+		curtime += 10;
+		tqueue.activate(curtime);
+		// Reschedule some, as timers and scripts do.
+		for (int i = 0; i < 50; i++) {
+			Bench_event& each = events[Rand(num_entries)];
+			if (i % 2 ? tqueue.remove(each.entry) : tqueue.remove(&each)) {
+				removed++;
+				each.entry = tqueue.add(curtime + Rand(1000), &each);
+			}
+		}
+	}
+	const auto   t1   = std::chrono::steady_clock::now();
+	const double secs = std::chrono::duration<double>(t1 - t0).count();
+	const unsigned long ops
+			= num_entries + Bench_event::activated + 2 * removed;
+	cout << tqueue.size() << " queued, " << Bench_event::activated
+		 << " activated, " << removed << " removed in " << secs << "s ("
+		 << (ops / secs) << " ops/sec)" << endl;
+	tqueue.clear();
+	return 0;
+}
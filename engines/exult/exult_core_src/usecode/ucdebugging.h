@@ -144,6 +144,10 @@ public:
 
 	int check(Stack_frame* frame);
 
+	bool empty() const {
+		return breaks.empty();
+	}
+
 	void transmit(int fd);
 
 	static int getNewID() {
@@ -0,0 +1,206 @@
+/*
+ *  ucdecode.cc - Usecode functions decoded ahead of time.
+ *
+ *  Copyright (C) 2001-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "ucdecode.h"
+
+#include "endianio.h"
+#include "opcodes.h"
+#include "stackframe.h"
+
+/*
+ *  Decode one instruction's operands.  'insn.kind' is left as 'interpret'
+ *  for anything we don't handle.
+ */
+
+void Usecode_decoded::decode(const Stack_frame* frame, Insn& insn) {
+	using Dec               = Usecode_decoded;
+	const int    num_locals = frame->num_vars + frame->num_args;
+	const uint8* ip         = frame->code + insn.ip;
+	const auto   opcode     = static_cast<UsecodeOps>(*ip++);
+	const bool   is_32bit   = opcode >= UC_EXTOPCODE;
+	// Check data-segment strings, as run() does.
+	auto string_kind = [frame](int offset, Dec::Kind kind) {
+		return offset < 0 || frame->data + offset >= frame->externs - 6
+					   ? Dec::interpret
+					   : kind;
+	};
+	switch (opcode) {
+	case UC_JMP:
+	case UC_JMP32:
+	case UC_JNE:
+	case UC_JNE32: {
+		const int offset = is_32bit ? little_endian::Read4s(ip)
+									: little_endian::Read2s(ip);
+		insn.kind = (opcode & 0x7f) == UC_JMP ? Dec::jump : Dec::jump_false;
+		insn.arg  = insn.next_ip + offset;    // Resolved later.
+		break;
+	}
+	case UC_PUSHI:
+	case UC_PUSHI32:
+		insn.kind = Dec::push_int;
+		insn.arg  = is_32bit ? little_endian::Read4s(ip)
+							 : little_endian::Read2s(ip);
+		break;
+	case UC_PUSHB:
+		insn.kind = Dec::push_int;
+		insn.arg  = *ip;
+		break;
+	case UC_PUSHTRUE:
+	case UC_PUSHFALSE:
+		insn.kind = Dec::push_int;
+		insn.arg  = opcode == UC_PUSHTRUE;
+		break;
+	case UC_PUSH:
+	case UC_POP:
+		insn.arg = little_endian::Read2(ip);
+		if (insn.arg < num_locals) {
+			insn.kind = opcode == UC_PUSH ? Dec::push_local : Dec::pop_local;
+		}
+		break;
+	case UC_PUSHS:
+	case UC_PUSHS32:
+	case UC_ADDSI:
+	case UC_ADDSI32:
+		insn.arg  = is_32bit ? little_endian::Read4s(ip)
+							 : little_endian::Read2(ip);
+		insn.kind = string_kind(
+				insn.arg, (opcode & 0x7f) == UC_PUSHS ? Dec::push_string
+													   : Dec::add_string);
+		break;
+	case UC_PUSHF:
+		insn.arg = little_endian::Read2(ip);
+		if (insn.arg <= c_last_gflag) {
+			insn.kind = Dec::push_flag;
+		}
+		break;
+	case UC_CALLI:
+	case UC_CALLIS:
+		insn.arg       = little_endian::Read2(ip);
+		insn.num_parms = *ip;
+		insn.intrinsic = Usecode_internal::find_intrinsic(insn.arg);
+		if (insn.intrinsic && insn.num_parms <= 12) {
+			insn.kind = opcode == UC_CALLIS ? Dec::call_intrinsic_ret
+											: Dec::call_intrinsic;
+		}
+		break;
+	case UC_ADD:
+		insn.kind = Dec::add;
+		break;
+	case UC_SUB:
+		insn.kind = Dec::sub;
+		break;
+	case UC_MUL:
+		insn.kind = Dec::mul;
+		break;
+	case UC_DIV:
+		insn.kind = Dec::div;
+		break;
+	case UC_MOD:
+		insn.kind = Dec::mod;
+		break;
+	case UC_AND:
+		insn.kind = Dec::logical_and;
+		break;
+	case UC_OR:
+		insn.kind = Dec::logical_or;
+		break;
+	case UC_NOT:
+		insn.kind = Dec::logical_not;
+		break;
+	case UC_CMPGT:
+		insn.kind = Dec::cmp_gt;
+		break;
+	case UC_CMPLT:
+		insn.kind = Dec::cmp_lt;
+		break;
+	case UC_CMPGE:
+		insn.kind = Dec::cmp_ge;
+		break;
+	case UC_CMPLE:
+		insn.kind = Dec::cmp_le;
+		break;
+	case UC_CMPEQ:
+		insn.kind = Dec::cmp_eq;
+		break;
+	case UC_CMPNE:
+		insn.kind = Dec::cmp_ne;
+		break;
+	case UC_IN:
+		insn.kind = Dec::in_array;
+		break;
+	case UC_ARRA:
+		insn.kind = Dec::array_append;
+		break;
+	case UC_PUSHEVENTID:
+		insn.kind = Dec::push_eventid;
+		break;
+	case UC_PUSHITEMREF:
+		insn.kind = Dec::push_itemref;
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ *  Decode from the start of the code until the end, or until an opcode we
+ *  don't know the length of.
+ */
+
+Usecode_decoded::Usecode_decoded(const Stack_frame* frame) {
+	const int len = frame->endp - frame->code;
+	index.assign(len + 1, -1);
+	int ip = 0;
+	while (ip < len) {
+		const int nbytes = Usecode_internal::get_opcode_length(frame->code[ip]);
+		if (nbytes <= 0 || ip + nbytes > len) {
+			break;
+		}
+		Insn insn;
+		insn.ip      = ip;
+		insn.next_ip = ip + nbytes;
+		decode(frame, insn);
+		index[ip] = insns.size();
+		insns.push_back(insn);
+		ip += nbytes;
+	}
+	// Leave the rest to the switch (which checks bounds).
+	Insn end;
+	end.ip      = ip;
+	end.next_ip = ip;
+	index[ip]   = insns.size();
+	insns.push_back(end);
+	// Now that all are known, turn jump offsets into insn #'s.
+	for (auto& insn : insns) {
+		if (insn.kind != jump && insn.kind != jump_false) {
+			continue;
+		}
+		const int target = insn.arg;
+		if (target < 0 || target > len || index[target] < 0) {
+			insn.kind = interpret;    // Bad target:  let run() complain.
+		} else {
+			insn.arg = index[target];
+		}
+	}
+}
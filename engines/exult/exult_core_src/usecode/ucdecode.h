@@ -0,0 +1,108 @@
+/*
+ *  ucdecode.h - Usecode functions decoded ahead of time.
+ *
+ *  Copyright (C) 2001-2022  The Exult Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef UCDECODE_H
+#define UCDECODE_H
+
+#include "common_types.h"
+#include "ucinternal.h"
+
+#include <vector>
+
+class Stack_frame;
+
+/*
+ *  A usecode function's instructions with their operands already read,
+ *  jumps resolved to instruction #'s and intrinsics looked up.  Only the
+ *  common, simple opcodes are decoded; the rest are left as 'interpret',
+ *  for Usecode_internal::run()'s switch.  So are any whose operands are
+ *  out of range, so the switch can report them as it always has.
+ */
+class Usecode_decoded {
+public:
+	enum Kind : uint8 {
+		interpret = 0,    // Let the switch do it.
+		jump,
+		jump_false,
+		push_int,
+		push_local,
+		pop_local,
+		push_string,
+		add_string,
+		add,
+		sub,
+		mul,
+		div,
+		mod,
+		logical_and,
+		logical_or,
+		logical_not,
+		cmp_gt,
+		cmp_lt,
+		cmp_ge,
+		cmp_le,
+		cmp_eq,
+		cmp_ne,
+		in_array,
+		array_append,
+		push_flag,
+		push_eventid,
+		push_itemref,
+		call_intrinsic,
+		call_intrinsic_ret,    // Pushes the result.
+		num_kinds
+	};
+
+	struct Insn {
+		Kind   kind      = interpret;
+		uint8  num_parms = 0;    // For intrinsics.
+		sint32 ip        = 0;    // Offset of opcode within code.
+		sint32 next_ip   = 0;    // Offset of following opcode.
+		// Value, local #, flag #, data offset, intrinsic # or
+		//   instruction # to jump to.
+		sint32 arg = 0;
+		// For intrinsics.
+		const Usecode_internal::IntrinsicTableEntry* intrinsic = nullptr;
+	};
+
+private:
+	std::vector<Insn>   insns;    // Ends with an 'interpret' at end of code.
+	std::vector<sint32> index;    // Insn # for each code offset, or -1.
+
+	static void decode(const Stack_frame* frame, Insn& insn);
+
+public:
+	// Decode the function that 'frame' is running.
+	Usecode_decoded(const Stack_frame* frame);
+
+	// Get instruction starting at a code offset, or nullptr.
+	const Insn* find(int ip) const {
+		return ip >= 0 && static_cast<size_t>(ip) < index.size()
+							   && index[ip] >= 0
+					   ? &insns[index[ip]]
+					   : nullptr;
+	}
+
+	const Insn* get_insns() const {
+		return insns.data();
+	}
+};
+
+#endif
@@ -25,8 +25,10 @@
 #include "ucfunction.h"
 
 #include "endianio.h"
+#include "ucdecode.h"
 
 #include <iostream>
+#include <string>
 
 using std::istream;
 
@@ -55,3 +57,22 @@ Usecode_function::Usecode_function(istream& file) : orig(nullptr) {
 	code = new unsigned char[len];    // Allocate buffer & read it in.
 	file.read(reinterpret_cast<char*>(code), len);
 }
+
+Usecode_function::~Usecode_function() {
+	delete[] code;
+}
+
+/*
+ *  Get a string from the data segment, creating it on first use.
+ */
+
+const Usecode_value& Usecode_function::get_literal(
+		const unsigned char* data, int offset) {
+	auto it = literals.find(offset);
+	if (it == literals.end()) {
+		auto str = std::make_shared<const std::string>(
+				reinterpret_cast<const char*>(data + offset));
+		it = literals.emplace(offset, Usecode_value(std::move(str))).first;
+	}
+	return it->second;
+}
@@ -24,8 +24,12 @@
 #include "useval.h"
 
 #include <iosfwd>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
+class Usecode_decoded;
+
 class Usecode_function {
 public:
 	int id;    // The function #.  (Appears to be the
@@ -39,12 +43,15 @@ public:
 	bool extended;    // is this an 'extented' function? (aka 32 bit function)
 	unsigned char*             code;       // The code.
 	std::vector<Usecode_value> statics;    // Local statics.
+	// Decoded when first run (if enabled).
+	std::unique_ptr<Usecode_decoded> decoded;
+	// Data-segment strings pushed so far, by offset.
+	std::unordered_map<int, Usecode_value> literals;
 	// Create from file.
 	Usecode_function(std::istream& file);
-
-	inline ~Usecode_function() {
-		delete[] code;
-	}
+	~Usecode_function();
+	// Get string at 'data + offset', shared by every push of it.
+	const Usecode_value& get_literal(const unsigned char* data, int offset);
 };
 
 #endif
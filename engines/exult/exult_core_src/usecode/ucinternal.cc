@@ -53,6 +53,7 @@
 #include "stackframe.h"
 #include "touchui.h"
 #include "tqueue.h"
+#include "ucdecode.h"
 #include "ucfunction.h"
 #include "ucinternal.h"
 #include "ucsched.h"
@@ -74,6 +75,8 @@
 #include <fstream>
 #include <iomanip>
 #include <map>
+#include <memory>
+#include <string>
 
 #ifdef XWIN
 #	include <csignal>
@@ -436,11 +439,16 @@ void Usecode_internal::append_string(const char* str) {
 	}
 }
 
-// Push/pop stack.
+// Push/pop stack.  Values are moved on and off where possible, so that
+//   strings and arrays aren't copied.
 inline void Usecode_internal::push(const Usecode_value& val) {
 	*sp++ = val;
 }
 
+inline void Usecode_internal::push(Usecode_value&& val) {
+	*sp++ = std::move(val);
+}
+
 inline Usecode_value Usecode_internal::pop() {
 	if (sp <= stack) {
 		// Happens in SI #0x939
@@ -452,8 +460,8 @@ inline Usecode_value Usecode_internal::pop() {
 		return Usecode_value(0);
 	}
 
-	// +++++SHARED:  Shouldn't we reset *sp.
-	return *--sp;
+	// Moving also frees what the slot held.
+	return std::move(*--sp);
 }
 
 inline Usecode_value Usecode_internal::peek() {
@@ -461,18 +469,15 @@ inline Usecode_value Usecode_internal::peek() {
 }
 
 inline void Usecode_internal::pushref(Game_object* obj) {
-	const Usecode_value v(obj);
-	push(v);
+	push(Usecode_value(obj));
 }
 
 inline void Usecode_internal::pushref(Game_object_shared obj) {
-	const Usecode_value v(std::move(obj));
-	push(v);
+	push(Usecode_value(std::move(obj)));
 }
 
 inline void Usecode_internal::pushi(long val) {    // Push/pop integers.
-	const Usecode_value v(val);
-	push(v);
+	*sp++ = static_cast<int>(val);
 }
 
 inline int Usecode_internal::popi() {
@@ -482,8 +487,7 @@ inline int Usecode_internal::popi() {
 
 // Push/pop strings.
 inline void Usecode_internal::pushs(const char* s) {
-	const Usecode_value val(s);
-	push(val);
+	push(Usecode_value(s));
 }
 
 /*
@@ -1650,8 +1654,7 @@ Usecode_value Usecode_internal::call_intrinsic(
 			std::size(intrinsics_sib) <= std::numeric_limits<uint16>::max());
 	Usecode_value parms[13];    // Get parms.
 	for (int i = 0; i < num_parms; i++) {
-		const Usecode_value val = pop();
-		parms[i]                = val;
+		parms[i] = pop();
 	}
 	tcb::span<Usecode_internal::IntrinsicTableEntry> table;
 	if (Game::get_game_type() == SERPENT_ISLE) {
@@ -1672,6 +1675,30 @@ Usecode_value Usecode_internal::call_intrinsic(
 	return no_ret;
 }
 
+/*
+ *  Look up an intrinsic for the current game.
+ *
+ *  Output: nullptr if out of range.
+ */
+
+const Usecode_internal::IntrinsicTableEntry* Usecode_internal::find_intrinsic(
+		int intrinsic) {
+	tcb::span<Usecode_internal::IntrinsicTableEntry> table;
+	if (Game::get_game_type() == SERPENT_ISLE) {
+		if (Game::is_si_beta()) {
+			table = intrinsics_sib;
+		} else {
+			table = intrinsics_si;
+		}
+	} else {
+		table = intrinsics_bg;
+	}
+	if (intrinsic < 0 || static_cast<size_t>(intrinsic) >= table.size()) {
+		return nullptr;
+	}
+	return &table[intrinsic];
+}
+
 /*
  *  Wait for user to click inside a conversation.
  */
@@ -1812,6 +1839,9 @@ Usecode_internal::Usecode_internal() : stack(new Usecode_value[1024]) {
 		auto& file = *pFile;
 		read_usecode(file, true);
 	}
+	std::string yn;
+	config->value("config/gameplay/predecode_usecode", yn, "yes");
+	predecode = yn == "yes";
 
 	//  set_breakpoint();
 }
@@ -1921,6 +1951,244 @@ void Clearbreak() {
 	cerr << "nullptr class pointer!"; \
 	CERR_CURRENT_IP()
 
+/*
+ *  Run the current frame from its decoded instructions, for as long as
+ *  they're ones Usecode_decoded handles.  Each must do just what run()'s
+ *  switch does for its opcode.  With GCC/Clang, each instruction jumps
+ *  straight to the next one's code ("computed goto").
+ *
+ *  Output: true if an intrinsic was called, so the frame may have changed.
+ *      false to let run() carry on from frame->ip.
+ */
+
+#ifdef __GNUC__
+#	define UC_THREADED
+#	pragma GCC diagnostic push
+#	pragma GCC diagnostic ignored "-Wpedantic"
+#endif    // __GNUC__
+
+#ifdef UC_THREADED
+#	define UC_OP(kind) \
+	case Dec::kind:     \
+	op_##kind
+#	define UC_NEXT()                    \
+		frame->ins_ip = code + insn->ip; \
+		goto* labels[insn->kind]
+#else
+#	define UC_OP(kind) case Dec::kind
+#	define UC_NEXT()   continue
+#endif
+
+bool Usecode_internal::run_decoded() {
+	using Dec             = Usecode_decoded;
+	Usecode_function* fun = frame->function;
+	if (!fun->decoded) {
+		fun->decoded = std::make_unique<Dec>(frame);
+	}
+	const Dec::Insn* insn = fun->decoded->find(frame->ip - frame->code);
+	if (!insn) {
+		return false;
+	}
+	const Dec::Insn* insns = fun->decoded->get_insns();
+	const uint8*     code  = frame->code;
+	int              sval;
+#ifdef UC_THREADED
+	// In the order of Usecode_decoded::Kind.
+	static void* const labels[] = {
+			&&op_interpret,    &&op_jump,           &&op_jump_false,
+			&&op_push_int,     &&op_push_local,     &&op_pop_local,
+			&&op_push_string,  &&op_add_string,     &&op_add,
+			&&op_sub,          &&op_mul,            &&op_div,
+			&&op_mod,          &&op_logical_and,    &&op_logical_or,
+			&&op_logical_not,  &&op_cmp_gt,         &&op_cmp_lt,
+			&&op_cmp_ge,       &&op_cmp_le,         &&op_cmp_eq,
+			&&op_cmp_ne,       &&op_in_array,       &&op_array_append,
+			&&op_push_flag,    &&op_push_eventid,   &&op_push_itemref,
+			&&op_call_intrinsic, &&op_call_intrinsic_ret};
+	static_assert(std::size(labels) == Dec::num_kinds);
+#endif
+	for (;;) {
+		frame->ins_ip = code + insn->ip;
+		switch (insn->kind) {
+		default:
+		UC_OP(interpret):
+			frame->ip = code + insn->ip;
+			return false;
+		UC_OP(jump):
+			insn = insns + insn->arg;
+			UC_NEXT();
+		UC_OP(jump_false): {
+			const Usecode_value val = pop();
+			insn = val.is_false() ? insns + insn->arg : insn + 1;
+			UC_NEXT();
+		}
+		UC_OP(push_int):
+			pushi(insn->arg);
+			++insn;
+			UC_NEXT();
+		UC_OP(push_local):
+			push(frame->locals[insn->arg]);
+			++insn;
+			UC_NEXT();
+		UC_OP(pop_local):
+			frame->locals[insn->arg] = pop();
+			++insn;
+			UC_NEXT();
+		UC_OP(push_string):
+			push(frame->function->get_literal(frame->data, insn->arg));
+			++insn;
+			UC_NEXT();
+		UC_OP(add_string):
+			append_string(frame->data + insn->arg);
+			++insn;
+			UC_NEXT();
+		UC_OP(add): {
+			const Usecode_value v2 = pop();
+			Usecode_value       v1 = pop();
+			v1 += v2;
+			push(std::move(v1));
+			++insn;
+			UC_NEXT();
+		}
+		UC_OP(sub): {
+			const Usecode_value v2 = pop();
+			Usecode_value       v1 = pop();
+			v1 -= v2;
+			push(std::move(v1));
+			++insn;
+			UC_NEXT();
+		}
+		UC_OP(mul): {
+			const Usecode_value v2 = pop();
+			Usecode_value       v1 = pop();
+			v1 *= v2;
+			push(std::move(v1));
+			++insn;
+			UC_NEXT();
+		}
+		UC_OP(div): {
+			const Usecode_value v2 = pop();
+			Usecode_value       v1 = pop();
+			v1 /= v2;
+			push(std::move(v1));
+			++insn;
+			UC_NEXT();
+		}
+		UC_OP(mod): {
+			const Usecode_value v2 = pop();
+			Usecode_value       v1 = pop();
+			v1 %= v2;
+			push(std::move(v1));
+			++insn;
+			UC_NEXT();
+		}
+		UC_OP(logical_and): {
+			const Usecode_value v1 = pop();
+			const Usecode_value v2 = pop();
+			pushi(v1.is_true() && v2.is_true());
+			++insn;
+			UC_NEXT();
+		}
+		UC_OP(logical_or): {
+			const Usecode_value v1 = pop();
+			const Usecode_value v2 = pop();
+			pushi(v1.is_true() || v2.is_true());
+			++insn;
+			UC_NEXT();
+		}
+		UC_OP(logical_not):
+			pushi(!pop().is_true());
+			++insn;
+			UC_NEXT();
+		UC_OP(cmp_gt):
+			sval = popi();
+			pushi(popi() > sval);
+			++insn;
+			UC_NEXT();
+		UC_OP(cmp_lt):
+			sval = popi();
+			pushi(popi() < sval);
+			++insn;
+			UC_NEXT();
+		UC_OP(cmp_ge):
+			sval = popi();
+			pushi(popi() >= sval);
+			++insn;
+			UC_NEXT();
+		UC_OP(cmp_le):
+			sval = popi();
+			pushi(popi() <= sval);
+			++insn;
+			UC_NEXT();
+		UC_OP(cmp_eq): {
+			const Usecode_value val1 = pop();
+			const Usecode_value val2 = pop();
+			pushi(val1 == val2);
+			++insn;
+			UC_NEXT();
+		}
+		UC_OP(cmp_ne): {
+			const Usecode_value val1 = pop();
+			const Usecode_value val2 = pop();
+			pushi(!(val1 == val2));
+			++insn;
+			UC_NEXT();
+		}
+		UC_OP(in_array): {
+			Usecode_value arr = pop();
+			// If an array, use 1st elem.
+			const Usecode_value val = pop().get_elem0();
+			pushi(arr.find_elem(val) >= 0);
+			++insn;
+			UC_NEXT();
+		}
+		UC_OP(array_append): {
+			Usecode_value val = pop();
+			Usecode_value arr = pop();
+			arr.concat(val);
+			push(std::move(arr));
+			++insn;
+			UC_NEXT();
+		}
+		UC_OP(push_flag):
+			pushi(gflags[insn->arg]);
+			++insn;
+			UC_NEXT();
+		UC_OP(push_eventid):
+			pushi(frame->eventid);
+			++insn;
+			UC_NEXT();
+		UC_OP(push_itemref):
+			pushref(frame->caller_item);
+			++insn;
+			UC_NEXT();
+		UC_OP(call_intrinsic):
+		UC_OP(call_intrinsic_ret): {
+			frame->ip = code + insn->next_ip;
+			Usecode_value parms[13];
+			for (int i = 0; i < insn->num_parms; i++) {
+				parms[i] = pop();
+			}
+			const auto* entry = insn->intrinsic;
+			Usecode_value ival = Execute_Intrinsic(
+					entry->func, entry->name, insn->arg, insn->num_parms,
+					parms);
+			if (insn->kind == Dec::call_intrinsic_ret) {
+				push(std::move(ival));
+			}
+			return true;
+		}
+		}
+	}
+}
+
+#undef UC_OP
+#undef UC_NEXT
+#ifdef UC_THREADED
+#	undef UC_THREADED
+#	pragma GCC diagnostic pop
+#endif
+
 /*
  *  The main usecode interpreter
  *
@@ -1945,6 +2213,18 @@ int Usecode_internal::run() {
 		 *  Main loop.
 		 */
 		while (!frame_changed) {
+			// Decoded instructions skip tracing and breakpoints.
+			bool use_decoded = predecode;
+#ifdef DEBUG
+			use_decoded = use_decoded && usecode_trace != 2;
+#endif
+#ifdef USECODE_DEBUGGER
+			use_decoded = use_decoded && breakpoints.empty();
+#endif
+			if (use_decoded && run_decoded()) {
+				frame_changed = true;
+				continue;
+			}
 			if ((frame->ip >= frame->endp) || (frame->ip < frame->code)) {
 				cerr << "Usecode: jumped outside of code segment of "
 					 << "function " << hex << setw(4) << setfill('0')
@@ -2113,38 +2393,38 @@ int Usecode_internal::run() {
 				}
 			} break;
 			case UC_ADD: {    // ADD.
-				const Usecode_value v2     = pop();
-				const Usecode_value v1     = pop();
-				const Usecode_value retval = v1 + v2;
-				push(retval);
+				const Usecode_value v2 = pop();
+				Usecode_value       v1 = pop();
+				v1 += v2;
+				push(std::move(v1));
 				break;
 			}
 			case UC_SUB: {    // SUB.
-				const Usecode_value v2     = pop();
-				const Usecode_value v1     = pop();
-				const Usecode_value retval = v1 - v2;
-				push(retval);
+				const Usecode_value v2 = pop();
+				Usecode_value       v1 = pop();
+				v1 -= v2;
+				push(std::move(v1));
 				break;
 			}
 			case UC_DIV: {    // DIV.
-				const Usecode_value v2     = pop();
-				const Usecode_value v1     = pop();
-				const Usecode_value retval = v1 / v2;
-				push(retval);
+				const Usecode_value v2 = pop();
+				Usecode_value       v1 = pop();
+				v1 /= v2;
+				push(std::move(v1));
 				break;
 			}
 			case UC_MUL: {    // MUL.
-				const Usecode_value v2     = pop();
-				const Usecode_value v1     = pop();
-				const Usecode_value retval = v1 * v2;
-				push(retval);
+				const Usecode_value v2 = pop();
+				Usecode_value       v1 = pop();
+				v1 *= v2;
+				push(std::move(v1));
 				break;
 			}
 			case UC_MOD: {    // MOD.
-				const Usecode_value v2     = pop();
-				const Usecode_value v1     = pop();
-				const Usecode_value retval = v1 % v2;
-				push(retval);
+				const Usecode_value v2 = pop();
+				Usecode_value       v1 = pop();
+				v1 %= v2;
+				push(std::move(v1));
 				break;
 			}
 			case UC_AND: {    // AND.
@@ -2227,7 +2507,7 @@ int Usecode_internal::run() {
 					DATA_SEGMENT_ERROR();
 					break;
 				}
-				pushs(frame->data + offset);
+				push(frame->function->get_literal(frame->data, offset));
 				break;
 			case UC_ARRC: {    // ARRC.
 				// Get # values to pop into array.
@@ -2242,7 +2522,7 @@ int Usecode_internal::run() {
 				if (to < num) {    // 1 or more vals empty arrays?
 					arr.resize(to);
 				}
-				push(arr);
+				push(std::move(arr));
 				break;
 			}
 			case UC_PUSHI:        // PUSHI.
@@ -2633,8 +2913,7 @@ int Usecode_internal::run() {
 			case UC_CALLIS: {    // CALLIS.
 				offset = little_endian::Read2(frame->ip);
 				sval   = *(frame->ip)++;    // # of parameters.
-				const Usecode_value ival = call_intrinsic(offset, sval);
-				push(ival);
+				push(call_intrinsic(offset, sval));
 				frame_changed = true;
 				break;
 			}
@@ -2799,7 +3078,8 @@ int Usecode_internal::run() {
 			case UC_ARRA: {    // ARRA.
 				Usecode_value val = pop();
 				Usecode_value arr = pop();
-				push(arr.concat(val));
+				arr.concat(val);
+				push(std::move(arr));
 				break;
 			}
 			case UC_POPEVENTID:    // POP EVENTID.
@@ -47,6 +47,7 @@ class Stack_frame;
 class Usecode_function;
 class Usecode_symbol_table;
 class Usecode_class_symbol;
+class UsecodeDecodedTestSuite;
 
 /*
  *  Recursively look for a barge that an object is a part of, or on.
@@ -89,6 +90,7 @@ class Usecode_internal : public Usecode_machine {
 	int        saved_map       = -1;    // Improvements for these intrinsics.
 	char*      String          = nullptr;    // The single string register.
 	int        telekenesis_fun = -1;    // For next Usecode call from spell.
+	bool       predecode       = true;    // Use Usecode_decoded in run().
 
 	void append_string(const uint8* txt) {
 		append_string(reinterpret_cast<const char*>(txt));
@@ -101,6 +103,7 @@ class Usecode_internal : public Usecode_machine {
 	Usecode_value* stack;                  // Stack.
 	Usecode_value* sp;                     // Stack ptr.  Grows upwards.
 	void           push(const Usecode_value& val);    // Push/pop stack.
+	void           push(Usecode_value&& val);
 	Usecode_value  pop();
 	Usecode_value  peek();
 	void           pushref(Game_object* obj);    // Push itemref
@@ -200,6 +203,8 @@ class Usecode_internal : public Usecode_machine {
 	Usecode_value Execute_Intrinsic(
 			UsecodeIntrinsicFn func, const char* name, int intrinsic,
 			int num_parms, Usecode_value parms[12]);
+	// Look up an intrinsic for the current game (nullptr if none).
+	static const IntrinsicTableEntry* find_intrinsic(int intrinsic);
 	USECODE_INTRINSIC_DECL(NOP);
 	USECODE_INTRINSIC_DECL(UNKNOWN);
 	USECODE_INTRINSIC_DECL(get_random);
@@ -448,6 +453,7 @@ class Usecode_internal : public Usecode_machine {
 	void return_from_procedure();
 	void abort_function(Usecode_value& retval);
 	int  run();
+	bool run_decoded();    // Fast path for run().
 
 	// debugging functions
 	void uc_trace_disasm(Stack_frame* frame);
@@ -499,6 +505,8 @@ private:
 
 public:
 	friend class Usecode_script;
+	friend class Usecode_decoded;
+	friend class ::UsecodeDecodedTestSuite;
 	Usecode_internal();
 	~Usecode_internal() override;
 	// Read in usecode functions.
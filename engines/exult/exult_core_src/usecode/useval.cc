@@ -55,6 +55,21 @@ Usecode_value::~Usecode_value() {
 	destroy();
 }
 
+/*
+ *  Get a string that can be changed, copying a shared literal first.
+ */
+
+string& Usecode_value::own_str() {
+	assert(type == string_type);
+	if (literal) {
+		string copy(*litval);
+		litval.~Shared_string();
+		literal = false;
+		construct(strval, std::move(copy));
+	}
+	return strval;
+}
+
 /*
  *  Steals an array from another usecode value. If the other
  *  usecode value is not an array, it will be converted into
@@ -149,7 +164,14 @@ bool Usecode_value::operator==(const Usecode_value& v2) const {
 			return false;
 		}
 	case string_type:
-		return v2.type == string_type && strval == v2.strval;
+		if (v2.type != string_type) {
+			return false;
+		}
+		// Same literal?
+		if (literal && v2.literal && litval == v2.litval) {
+			return true;
+		}
+		return str() == v2.str();
 	case class_sym_type:
 		return v2.type == class_sym_type && clssym == v2.clssym;
 	case class_obj_type:
@@ -273,7 +295,7 @@ void Usecode_value::print(ostream& out, bool shortformat) const {
 		out << reinterpret_cast<uintptr>(ptrval.get());
 		break;
 	case string_type:
-		out << '"' << strval << '"';
+		out << '"' << str() << '"';
 		break;
 	case array_type:
 		print_array(arrayval.cbegin(), arrayval.size());
@@ -310,15 +332,16 @@ Usecode_value& Usecode_value::operator+=(const Usecode_value& v2) {
 			// Note: this actually seems wrong compared to the originals,
 			// but I am leaving this the way it is unless it causes a bug.
 			string ret(std::to_string(v1.intval));
-			ret += v2.strval;
+			ret += v2.str();
 			v1 = std::move(ret);
 		}
 		return v1;
 	} else if (v1.get_type() == Usecode_value::string_type) {
 		if (v2.get_type() == Usecode_value::int_type) {
-			v1.strval += std::to_string(v2.intval);
+			v1.own_str() += std::to_string(v2.intval);
 		} else if (v2.get_type() == Usecode_value::string_type) {
-			v1.strval += v2.strval;
+			string& str = v1.own_str();
+			str += v2.str();
 		}
 		return v1;
 	} else {
@@ -367,8 +390,9 @@ Usecode_value& Usecode_value::operate(const Usecode_value& v2) {
 			// I decided to go the way usecode expects, adding a space along
 			// the way, to "fix" this as it seems to be the only places in
 			// the originals where this matters.
-			v1.strval += ' ';
-			v1.strval += v2.strval;
+			string& str = v1.own_str();
+			str += ' ';
+			str += v2.str();
 		}
 	} else {
 		v1 = Usecode_value(0);
@@ -416,8 +440,8 @@ bool Usecode_value::save(ODataSource* out) {
 		break;
 	}
 	case string_type: {
-		out->write2(strval.size());
-		out->write(strval);
+		out->write2(str().size());
+		out->write(str());
 		break;
 	}
 	case array_type:
@@ -456,6 +480,7 @@ bool Usecode_value::save(ODataSource* out) {
 
 bool Usecode_value::restore(IDataSource* in) {
 	undefined = false;
+	literal   = false;
 	type      = static_cast<Val_type>(in->read1());
 	switch (type) {
 	case int_type:
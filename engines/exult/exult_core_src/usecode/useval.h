@@ -29,6 +29,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <new>
 #include <string>    // STL string
 #include <vector>    // STL container
@@ -50,6 +51,8 @@ public:
 	};
 
 	using Usecode_vector = std::vector<Usecode_value>;
+	// Strings from a function's data segment are shared this way.
+	using Shared_string = std::shared_ptr<const std::string>;
 
 private:
 	struct ClassRef {
@@ -62,6 +65,7 @@ private:
 	union {
 		long                  intval;
 		std::string           strval;
+		Shared_string         litval;    // A string_type if 'literal'.
 		Usecode_vector        arrayval;
 		Game_object_shared    ptrval;
 		Usecode_class_symbol* clssym;
@@ -69,6 +73,7 @@ private:
 	};    // Anonymous union member
 
 	bool undefined = true;
+	bool literal   = false;    // String is in 'litval', not 'strval'.
 
 	template <typename Op>
 	Usecode_value& operate(const Usecode_value& v2);
@@ -79,8 +84,12 @@ private:
 			arrayval.~Usecode_vector();
 			break;
 		case string_type:
-			using std::string;
-			strval.~string();
+			if (literal) {
+				litval.~Shared_string();
+			} else {
+				using std::string;
+				strval.~string();
+			}
 			break;
 		case pointer_type:
 			ptrval.~Game_object_shared();
@@ -97,12 +106,14 @@ private:
 
 	template <typename T, typename U>
 	void replace(
-			T& var, U&& newval, Val_type newtype, bool newundefined = false) {
-		if (type == newtype) {
+			T& var, U&& newval, Val_type newtype, bool newundefined = false,
+			bool newliteral = false) {
+		if (type == newtype && literal == newliteral) {
 			var = std::forward<U>(newval);
 		} else {
 			destroy();
-			type = newtype;
+			type    = newtype;
+			literal = newliteral;
 			construct(var, std::forward<U>(newval));
 		}
 		undefined = newundefined;
@@ -115,6 +126,13 @@ private:
 				newundefined);
 	}
 
+	// The string, whichever way it's stored.
+	const std::string& str() const {
+		return literal ? *litval : strval;
+	}
+
+	std::string& own_str();    // Copy a literal before changing it.
+
 	template <typename T>
 	void copy_internal(T&& v2) noexcept(std::is_rvalue_reference<T>::value) {
 		const Val_type newtype = v2.type;
@@ -126,7 +144,13 @@ private:
 			replaceFrom(&Usecode_value::ptrval, std::forward<T>(v2), newtype);
 			break;
 		case string_type:
-			replaceFrom(&Usecode_value::strval, std::forward<T>(v2), newtype);
+			if (v2.literal) {
+				// Always copied, so a moved-from value is still usable.
+				replace(litval, v2.litval, newtype, v2.undefined, true);
+			} else {
+				replaceFrom(
+						&Usecode_value::strval, std::forward<T>(v2), newtype);
+			}
 			break;
 		case array_type:
 			replaceFrom(&Usecode_value::arrayval, std::forward<T>(v2), newtype);
@@ -172,6 +196,11 @@ public:
 	explicit Usecode_value(Usecode_class_symbol* ptr)
 			: type(class_sym_type), clssym(ptr), undefined(false) {}
 
+	// A string that copies share, and is only copied if changed.
+	explicit Usecode_value(Shared_string lit)
+			: type(string_type), litval(std::move(lit)), undefined(false),
+			  literal(true) {}
+
 	~Usecode_value();
 
 	Usecode_value& operator=(const Usecode_value& v2) {
@@ -284,7 +313,7 @@ public:
 	const char* get_str_value() const {
 		static const char* emptystr = "";
 		return (type == string_type)
-					   ? strval.c_str()
+					   ? str().c_str()
 					   : ((undefined
 						   || (type == array_type && arrayval.empty()))
 								  ? emptystr
@@ -404,24 +433,30 @@ public:
 	}
 };
 
+// (Returning 'v1' itself lets it be moved, not copied.)
 inline Usecode_value operator+(Usecode_value v1, const Usecode_value& v2) {
-	return v1 += v2;
+	v1 += v2;
+	return v1;
 }
 
 inline Usecode_value operator-(Usecode_value v1, const Usecode_value& v2) {
-	return v1 -= v2;
+	v1 -= v2;
+	return v1;
 }
 
 inline Usecode_value operator*(Usecode_value v1, const Usecode_value& v2) {
-	return v1 *= v2;
+	v1 *= v2;
+	return v1;
 }
 
 inline Usecode_value operator/(Usecode_value v1, const Usecode_value& v2) {
-	return v1 /= v2;
+	v1 /= v2;
+	return v1;
 }
 
 inline Usecode_value operator%(Usecode_value v1, const Usecode_value& v2) {
-	return v1 %= v2;
+	v1 %= v2;
+	return v1;
 }
 
 std::ostream& operator<<(std::ostream& out, Usecode_value& val);
@@ -31,12 +31,16 @@ EXULT_CORE_OBJS := \
 	exult_core_src/game.o \
 	exult_core_src/gameclk.o \
 	exult_core_src/gamedat.o \
+	exult_core_src/gamedatdelta.o \
+	exult_core_src/gamedatzip.o \
 	exult_core_src/gamemap.o \
 	exult_core_src/gamerend.o \
 	exult_core_src/gamewin.o \
 	exult_core_src/istring.o \
+	exult_core_src/jobpool.o \
 	exult_core_src/keyactions.o \
 	exult_core_src/keys.o \
+	exult_core_src/mapprefetch.o \
 	exult_core_src/menulist.o \
 	exult_core_src/monsters.o \
 	exult_core_src/mouse.o \
@@ -73,6 +77,7 @@ EXULT_CORE_OBJS := \
 	$(addprefix exult_core_src/files/, \
 		archive.o \
 		config.o \
+		crc.o \
 		file_utils.o \
 		gamefile.o \
 		listfiles.o \
@@ -144,10 +149,12 @@ EXULT_CORE_OBJS := \
 		funfont.o \
 		gamma.o \
 		ibuf8.o \
+		ibuf8_simd.o \
 		imagebuf.o \
 		imagewin.o \
 		mainactor.o \
 		map_scene.o \
+		scale_bands.o \
 		scene.o \
 		scrollmap.o \
 		smallmap.o \
@@ -183,6 +190,8 @@ EXULT_CORE_OBJS := \
 	$(addprefix exult_core_src/pathfinder/, \
 		a_star.o \
 		pathfinder.o \
+		pathqueue.o \
+		portals.o \
 	) \
 	$(addprefix exult_core_src/shapes/, \
 		font_render.o \
@@ -199,6 +208,7 @@ EXULT_CORE_OBJS := \
 		keyring.o \
 		stackframe.o \
 		ucdebugging.o \
+		ucdecode.o \
 		ucdisasm.o \
 		ucfunction.o \
 		ucinternal.o \
@@ -211,6 +221,19 @@ EXULT_CORE_OBJS := \
 
 MODULE_OBJS := $(WRAPPER_OBJS) $(EXULT_CORE_OBJS)
 
+ifdef SCUMMVM_NEON
+MODULE_OBJS += \
+	exult_core_src/imagewin/ibuf8_neon.o
+endif
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	exult_core_src/imagewin/ibuf8_sse2.o
+endif
+ifdef SCUMMVM_AVX2
+MODULE_OBJS += \
+	exult_core_src/imagewin/ibuf8_avx2.o
+endif
+
 # This module can be built as a plugin
 ifeq ($(ENABLE_EXULT), DYNAMIC_PLUGIN)
 PLUGIN := 1
@@ -0,0 +1,291 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "common/debug.h"
+#include "common/flathashmap.h"
+#include "common/hash-str.h"
+#include "common/system.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+namespace {
+
+// All keys fall in the same group, and share the same control byte.
+struct CollidingHash {
+	uint operator()(int x) const { return 0; }
+};
+
+typedef Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FlatStringMap;
+
+} // End of anonymous namespace
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	// The time taken to look up each key in @p keys @p rounds times.
+	template<class Map, class Key>
+	static uint32 timeLookups(const Map &map, const Common::Array<Key> &keys, uint rounds, uint &found) {
+		const uint32 start = g_system->getMillis();
+		found = 0;
+		for (uint round = 0; round < rounds; round++) {
+			for (uint i = 0; i < keys.size(); i++) {
+				if (map.contains(keys[i]))
+					found++;
+			}
+		}
+		return g_system->getMillis() - start;
+	}
+
+	public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+
+		FlatStringMap container2;
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(!container2.empty());
+		container2.clear();
+		TS_ASSERT(container2.empty());
+
+		// Also when the storage is given back.
+		for (int i = 0; i < 1000; i++)
+			container[i] = i;
+		container.clear(true);
+		TS_ASSERT(container.empty());
+		TS_ASSERT(!container.contains(5));
+		container[5] = 6;
+		TS_ASSERT_EQUALS(container[5], 6);
+	}
+
+	void test_contains() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(container.contains(0));
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT(!container.contains(17));
+		TS_ASSERT(!container.contains(-1));
+
+		FlatStringMap container2;
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(container2.contains("foo"));
+		TS_ASSERT(container2.contains("QUUX"));
+		TS_ASSERT(!container2.contains("bar"));
+		TS_ASSERT(!container2.contains("asdf"));
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		container.erase(1);
+		TS_ASSERT_EQUALS(container.size(), 2u);
+		container[1] = 42;
+		TS_ASSERT(container.contains(1));
+		container.erase(container.find(0));
+		TS_ASSERT(!container.contains(0));
+		container.erase(1);
+		container.erase(2);
+		TS_ASSERT(container.empty());
+		TS_ASSERT_EQUALS(container.find(2), container.end());
+	}
+
+	void test_lookup() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+		container.setVal(2, 45);
+
+		TS_ASSERT_EQUALS(container[0], 17);
+		TS_ASSERT_EQUALS(container[1], -1);
+		TS_ASSERT_EQUALS(container.getVal(2), 45);
+
+		int out = 0;
+		TS_ASSERT(container.tryGetVal(2, out));
+		TS_ASSERT_EQUALS(out, 45);
+		TS_ASSERT(!container.tryGetVal(3, out));
+
+		const Common::FlatHashMap<int, int> &containerRef = container;
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(17, -10), -10);
+		TS_ASSERT(!containerRef.contains(17));
+	}
+
+	void test_collision() {
+		// Every probe has to look at all the keys, and go past full groups.
+		Common::FlatHashMap<int, int, CollidingHash> h;
+		for (int i = 0; i < 100; i++)
+			h[i] = i * 2;
+		for (int i = 0; i < 100; i++)
+			TS_ASSERT_EQUALS(h.getValOrDefault(i, -1), i * 2);
+		TS_ASSERT(!h.contains(100));
+
+		for (int i = 0; i < 100; i += 2)
+			h.erase(i);
+		for (int i = 0; i < 100; i++)
+			TS_ASSERT_EQUALS(h.contains(i), (i & 1) != 0);
+		TS_ASSERT_EQUALS(h.size(), 50u);
+
+		for (int i = 0; i < 100; i += 2)
+			h[i] = 1;
+		TS_ASSERT_EQUALS(h.size(), 100u);
+	}
+
+	void test_iterator() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 5; i++)
+			container[i] = i * 10;
+		container.erase(1);
+		container[1] = 42;
+		container.erase(0);
+		container.erase(1);
+
+		int found = 0;
+		Common::FlatHashMap<int, int>::iterator i;
+		for (i = container.begin(); i != container.end(); ++i) {
+			int key = i->_key;
+			TS_ASSERT(key >= 0 && key <= 4);
+			TS_ASSERT_EQUALS(i->_value, key * 10);
+			TS_ASSERT(!(found & (1 << key)));
+			found |= 1 << key;
+		}
+		TS_ASSERT(found == 16+8+4);
+
+		found = 0;
+		const Common::FlatHashMap<int, int> &containerRef = container;
+		for (const auto &node : containerRef)
+			found |= 1 << node._key;
+		TS_ASSERT(found == 16+8+4);
+
+		// Erasing the current element does not end the iteration.
+		Common::FlatHashMap<int, int> big;
+		for (int k = 0; k < 500; k++)
+			big[k] = k;
+		for (Common::FlatHashMap<int, int>::iterator it = big.begin(); it != big.end(); ++it) {
+			if (it->_key % 3)
+				big.erase(it);
+		}
+		TS_ASSERT_EQUALS(big.size(), 167u);
+		for (int k = 0; k < 500; k++)
+			TS_ASSERT_EQUALS(big.contains(k), k % 3 == 0);
+
+		container.clear();
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+	}
+
+	void test_copy() {
+		FlatStringMap map1;
+		for (int i = 0; i < 100; i++)
+			map1[Common::String::format("key%d", i)] = Common::String::format("value%d", i);
+		map1.erase("key5");
+
+		FlatStringMap map2(map1), map3;
+		map3["other"] = "x";
+		map3 = map1;
+		map1.clear();
+		for (int i = 0; i < 100; i++) {
+			const Common::String key = Common::String::format("KEY%d", i);
+			TS_ASSERT_EQUALS(map2.contains(key), i != 5);
+			TS_ASSERT_EQUALS(map3.getValOrDefault(key), i != 5 ? Common::String::format("value%d", i) : Common::String());
+		}
+		TS_ASSERT(!map3.contains("other"));
+		TS_ASSERT_EQUALS(map2.size(), 99u);
+	}
+
+	void test_against_hashmap() {
+		// Random insertions and erasures, many of the latter, so that
+		// deleted slots build up and get cleaned.
+		uint32 seed = 1;
+		Common::HashMap<int, int> reference;
+		Common::FlatHashMap<int, int> map;
+		for (int i = 0; i < 100000; i++) {
+			seed = seed * 1103515245 + 12345;
+			const int key = ((seed >> 8) % 3000) * 64;
+			if ((seed >> 28) % 3 == 0) {
+				reference.erase(key);
+				map.erase(key);
+			} else {
+				reference[key] = i;
+				map[key] = i;
+			}
+		}
+
+		TS_ASSERT_EQUALS(map.size(), reference.size());
+		for (const auto &node : reference)
+			TS_ASSERT_EQUALS(map.getValOrDefault(node._key, -1), node._value);
+		uint count = 0;
+		for (const auto &node : map) {
+			TS_ASSERT_EQUALS(reference.getValOrDefault(node._key, -1), node._value);
+			count++;
+		}
+		TS_ASSERT_EQUALS(count, map.size());
+	}
+
+	void test_lookup_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+
+		const uint numKeys = 20000, rounds = 100;
+		Common::Array<int> denseKeys, sparseKeys;
+		Common::Array<Common::String> stringKeys;
+		Common::HashMap<int, int> denseMap, sparseMap;
+		Common::FlatHashMap<int, int> flatDenseMap, flatSparseMap;
+		Common::StringMap stringMap;
+		FlatStringMap flatStringMap;
+
+		// Half of the lookups are for keys that are not there. Dense keys
+		// are like script variable numbers, sparse ones like resource ids.
+		uint32 seed = 1;
+		for (uint i = 0; i < numKeys; i++) {
+			seed = seed * 1103515245 + 12345;
+			denseKeys.push_back(i);
+			sparseKeys.push_back(seed >> 1);
+			stringKeys.push_back(Common::String::format("resource%u.dat", i * 7));
+			if (i & 1)
+				continue;
+			denseMap[i] = i;
+			flatDenseMap[i] = i;
+			sparseMap[sparseKeys.back()] = i;
+			flatSparseMap[sparseKeys.back()] = i;
+			stringMap[stringKeys.back()] = stringKeys.back();
+			flatStringMap[stringKeys.back()] = stringKeys.back();
+		}
+
+		uint found, flatFound;
+		uint32 time = timeLookups(denseMap, denseKeys, rounds, found);
+		uint32 flatTime = timeLookups(flatDenseMap, denseKeys, rounds, flatFound);
+		TS_ASSERT_EQUALS(found, numKeys / 2 * rounds);
+		TS_ASSERT_EQUALS(flatFound, found);
+		debug("Dense int keys: %u lookups in %u ms with HashMap, %u ms with FlatHashMap", numKeys * rounds, time, flatTime);
+
+		time = timeLookups(sparseMap, sparseKeys, rounds, found);
+		flatTime = timeLookups(flatSparseMap, sparseKeys, rounds, flatFound);
+		TS_ASSERT_EQUALS(flatFound, found);
+		debug("Sparse int keys: %u lookups in %u ms with HashMap, %u ms with FlatHashMap", numKeys * rounds, time, flatTime);
+
+		time = timeLookups(stringMap, stringKeys, rounds / 10, found);
+		flatTime = timeLookups(flatStringMap, stringKeys, rounds / 10, flatFound);
+		TS_ASSERT_EQUALS(found, numKeys / 2 * rounds / 10);
+		TS_ASSERT_EQUALS(flatFound, found);
+		debug("String keys: %u lookups in %u ms with HashMap, %u ms with FlatHashMap", numKeys * rounds / 10, time, flatTime);
+#endif
+	}
+};
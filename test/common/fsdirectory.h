@@ -0,0 +1,220 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/fs.h"
+#include "common/stream.h"
+#include "common/system.h"
+
+#include "../null_osystem.h"
+
+#if defined(POSIX) && NULL_OSYSTEM_IS_AVAILABLE
+#define INDEX_TESTS 1
+#else
+#define INDEX_TESTS 0
+#endif
+
+#if INDEX_TESTS
+
+namespace {
+
+typedef Common::Array<byte> Bytes;
+
+const char *const kTreeName = "fsdirectory_test";
+const char *const kIndexName = "fsdirectory_test.idx";
+
+Common::FSNode treeNode(const char *name = nullptr) {
+	Common::Path path(kTreeName);
+	if (name)
+		path = path.join(name);
+	return Common::FSNode(path);
+}
+
+void writeFile(const Common::FSNode &node, const byte *data, uint32 size) {
+	Common::SeekableWriteStream *out = node.createWriteStream(false);
+	TS_ASSERT(out);
+	if (!out)
+		return;
+	out->write(data, size);
+	out->finalize();
+	delete out;
+}
+
+void writeFile(const Common::FSNode &node, const Bytes &contents) {
+	writeFile(node, contents.data(), contents.size());
+}
+
+Bytes readFile(const Common::FSNode &node) {
+	Bytes contents;
+	Common::SeekableReadStream *in = node.createReadStream();
+	if (!in)
+		return contents;
+	contents.resize(in->size());
+	if (in->size())
+		in->read(contents.data(), contents.size());
+	delete in;
+	return contents;
+}
+
+// Where @p str is in @p data, or -1.
+int findBytes(const Bytes &data, const char *str) {
+	const uint len = strlen(str);
+	for (uint i = 0; i + len <= data.size(); i++) {
+		if (!memcmp(data.data() + i, str, len))
+			return i;
+	}
+	return -1;
+}
+
+// The files FSDirectory has cached in @p path, in order, without asking
+// the file system whether they are there.
+Common::String filesIn(const Common::FSDirectory &dir, const char *path) {
+	Common::Array<Common::String> names;
+	dir.getChildren(Common::Path(path), names, Common::Archive::kListFilesOnly);
+	Common::sort(names.begin(), names.end());
+	Common::String list;
+	for (const auto &name : names) {
+		if (!list.empty())
+			list += ',';
+		list += name;
+	}
+	return list;
+}
+
+} // End of anonymous namespace
+
+#endif
+
+class FSDirectoryTestSuite : public CxxTest::TestSuite {
+#if INDEX_TESTS
+	// An FSDirectory of the whole tree, kept in the index.
+	static Common::FSDirectory *openTree() {
+		Common::FSDirectory *dir = new Common::FSDirectory(treeNode(), 2);
+		dir->setIndexFile(kIndexName);
+		return dir;
+	}
+
+	// List the tree, so that its index is written, and read that back.
+	static Bytes indexTree() {
+		Common::FSDirectory *dir = openTree();
+		TS_ASSERT_EQUALS(filesIn(*dir, ""), "a.txt");
+		delete dir;
+		return readFile(Common::FSNode(kIndexName));
+	}
+#endif
+
+public:
+#if INDEX_TESTS
+	void setUp() {
+		Common::install_null_g_system();
+		TS_ASSERT(treeNode().createDirectory());
+		TS_ASSERT(treeNode("sub").createDirectory());
+		writeFile(treeNode("a.txt"), (const byte *)"a", 1);
+		writeFile(treeNode("sub/b.txt"), (const byte *)"b", 1);
+	}
+
+	void tearDown() {
+		remove(kIndexName);
+		remove("fsdirectory_test/a.txt");
+		remove("fsdirectory_test/c.txt");
+		remove("fsdirectory_test/sub/b.txt");
+		remove("fsdirectory_test/sub");
+		remove(kTreeName);
+	}
+#endif
+
+	void test_build_and_reload() {
+#if INDEX_TESTS
+		Common::FSDirectory *dir = openTree();
+		TS_ASSERT_EQUALS(filesIn(*dir, ""), "a.txt");
+		TS_ASSERT_EQUALS(filesIn(*dir, "sub"), "b.txt");
+		TS_ASSERT(dir->hasFile("sub/b.txt"));
+		delete dir;
+		const Bytes index = readFile(Common::FSNode(kIndexName));
+		TS_ASSERT(!index.empty());
+
+		// The index is used while the directories are unchanged: a name
+		// changed in it, rather than on disk, is what is found.
+		Bytes edited = index;
+		const int pos = findBytes(edited, "a.txt");
+		TS_ASSERT(pos >= 0);
+		if (pos < 0)
+			return;
+		edited[pos] = 'x';
+		writeFile(Common::FSNode(kIndexName), edited);
+
+		dir = openTree();
+		TS_ASSERT_EQUALS(filesIn(*dir, ""), "x.txt");
+		TS_ASSERT_EQUALS(filesIn(*dir, "sub"), "b.txt");
+		delete dir;
+		TS_ASSERT(readFile(Common::FSNode(kIndexName)) == edited);
+
+		// One made for another depth isn't used.
+		dir = new Common::FSDirectory(treeNode(), 1);
+		dir->setIndexFile(kIndexName);
+		TS_ASSERT_EQUALS(filesIn(*dir, ""), "a.txt");
+		delete dir;
+#endif
+	}
+
+	void test_modified_directory() {
+#if INDEX_TESTS
+		const Bytes index = indexTree();
+
+		// Some file systems only keep modification times to the second.
+		g_system->delayMillis(1100);
+		writeFile(treeNode("c.txt"), (const byte *)"c", 1);
+
+		Common::FSDirectory *dir = openTree();
+		TS_ASSERT_EQUALS(filesIn(*dir, ""), "a.txt,c.txt");
+		TS_ASSERT_EQUALS(filesIn(*dir, "sub"), "b.txt");
+		delete dir;
+		const Bytes rebuilt = readFile(Common::FSNode(kIndexName));
+		TS_ASSERT(rebuilt != index);
+
+		// Also when it is a subdirectory that changed.
+		g_system->delayMillis(1100);
+		remove("fsdirectory_test/sub/b.txt");
+		dir = openTree();
+		TS_ASSERT_EQUALS(filesIn(*dir, ""), "a.txt,c.txt");
+		TS_ASSERT_EQUALS(filesIn(*dir, "sub"), "");
+		delete dir;
+		TS_ASSERT(readFile(Common::FSNode(kIndexName)) != rebuilt);
+#endif
+	}
+
+	void test_damaged_index() {
+#if INDEX_TESTS
+		const Bytes index = indexTree();
+
+		// The header is the tag, version, root path, depth and flat flag;
+		// the root's record then has its stamp, and its number of children.
+		const uint countPos = 4 + 4 + strlen(kTreeName) + 1 + 4 + 1 + 8;
+		TS_ASSERT(index.size() > countPos + 4);
+		if (index.size() <= countPos + 4)
+			return;
+
+		Bytes truncated(index.data(), index.size() - 1);
+		Bytes halved(index.data(), index.size() / 2);
+		Bytes trailing = index;
+		trailing.push_back(0);
+		Bytes badTag = index;
+		badTag[0] = 'X';
+		Bytes badCount = index;
+		badCount[countPos + 3] = 0x7f;
+		Bytes noChildren = index;
+		noChildren[countPos] = 0;
+		const Bytes damaged[] = { Bytes(), truncated, halved, trailing, badTag, badCount, noChildren };
+
+		// Each is rejected, and the tree listed and indexed again.
+		for (const Bytes &contents : damaged) {
+			writeFile(Common::FSNode(kIndexName), contents);
+			Common::FSDirectory *dir = openTree();
+			TS_ASSERT_EQUALS(filesIn(*dir, ""), "a.txt");
+			TS_ASSERT_EQUALS(filesIn(*dir, "sub"), "b.txt");
+			delete dir;
+			TS_ASSERT(readFile(Common::FSNode(kIndexName)) == index);
+		}
+#endif
+	}
+};
@@ -0,0 +1,216 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "common/debug.h"
+#include "common/job-system.h"
+#include "common/system.h"
+
+#include "../null_osystem.h"
+
+#ifdef POSIX
+#include "backends/jobs/pthread/pthread-jobs.h"
+#include "backends/mutex/pthread/pthread-mutex.h"
+#define THREADED_JOBS 1
+#else
+#define THREADED_JOBS 0
+#endif
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+namespace {
+
+struct Counter {
+	Common::MutexInternal *mutex;
+	uint count;
+};
+
+void countJob(void *arg) {
+	Counter *counter = (Counter *)arg;
+	if (counter->mutex)
+		counter->mutex->lock();
+	counter->count++;
+	if (counter->mutex)
+		counter->mutex->unlock();
+}
+
+void emptyJob(void *arg) {
+}
+
+struct Fib {
+	Common::JobSystem *jobs;
+	uint n;
+	uint result;
+
+	void operator()() {
+		if (n < 2) {
+			result = n;
+			return;
+		}
+		Fib a = { jobs, n - 1, 0 };
+		Fib b = { jobs, n - 2, 0 };
+		if (n < 8) {
+			a();
+			b();
+		} else {
+			jobs->forkJoin(a, b);
+		}
+		result = a.result + b.result;
+	}
+};
+
+uint fib(uint n) {
+	return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+
+// Count each index, so that both a gap and an overlap are seen. A range
+// that is too big counts twice; only the calling thread checks the order.
+struct Visit {
+	Common::Array<uint> *visits;
+	uint grain;
+	bool serial;
+	bool inOrder;
+	uint next;
+
+	void operator()(uint first, uint last) {
+		if (serial) {
+			if (first != next || first >= last)
+				inOrder = false;
+			next = last;
+		}
+		const uint mark = last - first > grain ? 2 : 1;
+		for (uint i = first; i < last; i++)
+			(*visits)[i] += mark;
+	}
+};
+
+} // End of anonymous namespace
+
+class JobSystemTestSuite : public CxxTest::TestSuite {
+	void checkJobs(Common::JobSystem &jobs, Common::MutexInternal *mutex) {
+		Counter counter = { mutex, 0 };
+		Common::JobGroup group;
+		for (uint i = 0; i < 5000; i++)
+			jobs.spawn(group, &countJob, &counter);
+		jobs.wait(group);
+		TS_ASSERT_EQUALS(counter.count, 5000u);
+
+		// An empty group is done at once.
+		Common::JobGroup empty;
+		jobs.wait(empty);
+	}
+
+	void checkParallelFor(Common::JobSystem &jobs, uint begin, uint end, uint grain) {
+		Common::Array<uint> visits;
+		visits.resize(end + 1);
+		Visit visit = { &visits, grain ? grain : 1, jobs.isSerial(), true, begin };
+		jobs.parallelFor(begin, end, grain, visit);
+		for (uint i = 0; i <= end; i++)
+			TS_ASSERT_EQUALS(visits[i], (i >= begin && i < end) ? 1u : 0u);
+		TS_ASSERT(visit.inOrder);
+	}
+
+	void checkForkJoin(Common::JobSystem &jobs) {
+		Fib top = { &jobs, 22, 0 };
+		top();
+		TS_ASSERT_EQUALS(top.result, fib(22));
+	}
+
+public:
+	void test_serial() {
+		Common::JobSystem jobs;
+		TS_ASSERT(jobs.isSerial());
+		TS_ASSERT_EQUALS(jobs.getNumThreads(), 0u);
+
+		// Serial jobs don't need a real mutex.
+		checkJobs(jobs, nullptr);
+		checkParallelFor(jobs, 0, 1000, 7);
+		checkParallelFor(jobs, 5, 6, 100);
+		checkParallelFor(jobs, 3, 3, 1);
+		checkParallelFor(jobs, 0, 64, 0);
+		checkForkJoin(jobs);
+
+		const Common::JobSystem::Stats stats = jobs.getStats();
+		TS_ASSERT_EQUALS(stats.spawned, 0u);
+		TS_ASSERT_DIFFERS(stats.inlined, 0u);
+	}
+
+	void test_threaded() {
+#if THREADED_JOBS
+		for (uint threads = 1; threads <= 4; threads++) {
+			Common::JobSystem *jobs = createPthreadJobSystem(threads);
+			TS_ASSERT_EQUALS(jobs->getNumThreads(), threads);
+
+			Common::MutexInternal *mutex = createPthreadMutexInternal();
+			checkJobs(*jobs, mutex);
+			delete mutex;
+			checkParallelFor(*jobs, 0, 100000, 64);
+			checkParallelFor(*jobs, 17, 5000, 1);
+			checkParallelFor(*jobs, 0, 3, 1);
+			checkForkJoin(*jobs);
+
+			const Common::JobSystem::Stats stats = jobs->getStats();
+			TS_ASSERT_DIFFERS(stats.spawned, 0u);
+			TS_ASSERT(stats.stolen <= stats.spawned);
+			delete jobs;
+		}
+#endif
+	}
+
+	void test_overflow() {
+#if THREADED_JOBS
+		// More jobs than a deque holds: the rest run as they are spawned.
+		Common::JobSystem *jobs = createPthreadJobSystem(1);
+		Common::MutexInternal *mutex = createPthreadMutexInternal();
+		Counter counter = { mutex, 0 };
+		{
+			Common::StackLock lock(mutex);
+			Common::JobGroup group;
+			for (uint i = 0; i < 3000; i++)
+				jobs->spawn(group, &countJob, &counter);
+			TS_ASSERT(counter.count > 0);
+			mutex->unlock();
+			jobs->wait(group);
+			mutex->lock();
+			TS_ASSERT_EQUALS(counter.count, 3000u);
+		}
+		delete mutex;
+		delete jobs;
+#endif
+	}
+
+	void test_spawn_speed() {
+#if BENCHMARK_TIME && THREADED_JOBS
+		Common::install_null_g_system();
+
+		const uint numJobs = 200000;
+		for (uint threads = 0; threads <= 4; threads++) {
+			Common::JobSystem *jobs = threads ? createPthreadJobSystem(threads) : new Common::JobSystem();
+
+			Common::JobGroup group;
+			uint32 start = g_system->getMillis();
+			for (uint i = 0; i < numJobs; i++) {
+				jobs->spawn(group, &emptyJob, nullptr);
+				if ((i & 511) == 511)
+					jobs->wait(group);
+			}
+			jobs->wait(group);
+			const uint32 spawnTime = g_system->getMillis() - start;
+
+			Fib top = { jobs, 27, 0 };
+			start = g_system->getMillis();
+			top();
+			const uint32 fibTime = g_system->getMillis() - start;
+
+			const Common::JobSystem::Stats stats = jobs->getStats();
+			debug("%u threads: %u empty jobs in %u ms (%.3f us each); fib(27) in %u ms; %u spawned, %u stolen",
+			      threads, numJobs, spawnTime, spawnTime * 1000.0 / numJobs, fibTime,
+			      stats.spawned, stats.stolen);
+			delete jobs;
+		}
+#endif
+	}
+};
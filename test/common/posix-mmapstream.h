@@ -0,0 +1,360 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/compression/unzip.h"
+#include "common/crc.h"
+#include "common/fs.h"
+#include "common/memstream.h"
+#include "common/stream.h"
+#include "common/system.h"
+
+#include "../null_osystem.h"
+
+#if defined(POSIX) && NULL_OSYSTEM_IS_AVAILABLE
+#include "backends/fs/posix/posix-mmapstream.h"
+#define MMAP_TESTS 1
+#else
+#define MMAP_TESTS 0
+#endif
+
+#if MMAP_TESTS
+
+namespace {
+
+// Big enough to be mapped, and not a whole number of pages.
+const uint32 kBigSize = 100000;
+const char *const kBigName = "posix_mmapstream_big.dat";
+const char *const kSmallName = "posix_mmapstream_small.dat";
+const char *const kZipName = "posix_mmapstream.zip";
+
+byte patternByte(uint32 i) {
+	return (byte)(i * 7 + (i >> 8));
+}
+
+bool hasPattern(const byte *data, uint32 size, uint32 first) {
+	for (uint32 i = 0; i < size; i++) {
+		if (data[i] != patternByte(first + i))
+			return false;
+	}
+	return true;
+}
+
+bool readsPattern(Common::SeekableReadStream &stream, uint32 size, uint32 first) {
+	byte *buf = new byte[size];
+	const bool ok = stream.read(buf, size) == size && hasPattern(buf, size, first);
+	delete[] buf;
+	return ok;
+}
+
+void writeFile(const char *name, const byte *data, uint32 size) {
+	Common::SeekableWriteStream *out = Common::FSNode(Common::Path(name)).createWriteStream(false);
+	TS_ASSERT(out);
+	TS_ASSERT_EQUALS(out->write(data, size), size);
+	out->finalize();
+	delete out;
+}
+
+void writePatternFile(const char *name, uint32 size) {
+	byte *data = new byte[size];
+	for (uint32 i = 0; i < size; i++)
+		data[i] = patternByte(i);
+	writeFile(name, data, size);
+	delete[] data;
+}
+
+struct ZipMember {
+	const char *name;
+	uint32 size;
+	bool badCrc;
+	uint32 dataOffset; ///< Set by writeStoredZip().
+};
+
+// Write a zip file of stored (uncompressed) members with the pattern as
+// their contents.
+void writeStoredZip(const char *name, ZipMember *members, int count, Common::MemoryWriteStreamDynamic &zip) {
+	byte *data = new byte[kBigSize];
+	for (uint32 i = 0; i < kBigSize; i++)
+		data[i] = patternByte(i);
+
+	uint32 *crcs = new uint32[count];
+	uint32 *offsets = new uint32[count];
+	for (int i = 0; i < count; i++) {
+		const uint32 nameLen = strlen(members[i].name);
+		crcs[i] = Common::CRC32().crcFast(data, members[i].size) ^ (members[i].badCrc ? 1 : 0);
+		offsets[i] = zip.pos();
+		zip.writeUint32LE(0x04034b50);
+		zip.writeUint16LE(10);      // Version needed
+		zip.writeUint16LE(0);       // Flags
+		zip.writeUint16LE(0);       // Stored
+		zip.writeUint32LE(0);       // Time and date
+		zip.writeUint32LE(crcs[i]);
+		zip.writeUint32LE(members[i].size);
+		zip.writeUint32LE(members[i].size);
+		zip.writeUint16LE(nameLen);
+		zip.writeUint16LE(0);       // Extra field
+		zip.write(members[i].name, nameLen);
+		members[i].dataOffset = zip.pos();
+		zip.write(data, members[i].size);
+	}
+
+	const uint32 dirOffset = zip.pos();
+	for (int i = 0; i < count; i++) {
+		const uint32 nameLen = strlen(members[i].name);
+		zip.writeUint32LE(0x02014b50);
+		zip.writeUint16LE(20);      // Version made by
+		zip.writeUint16LE(10);      // Version needed
+		zip.writeUint16LE(0);       // Flags
+		zip.writeUint16LE(0);       // Stored
+		zip.writeUint32LE(0);       // Time and date
+		zip.writeUint32LE(crcs[i]);
+		zip.writeUint32LE(members[i].size);
+		zip.writeUint32LE(members[i].size);
+		zip.writeUint16LE(nameLen);
+		zip.writeUint16LE(0);       // Extra field
+		zip.writeUint16LE(0);       // Comment
+		zip.writeUint16LE(0);       // Disk
+		zip.writeUint16LE(0);       // Internal attributes
+		zip.writeUint32LE(0);       // External attributes
+		zip.writeUint32LE(offsets[i]);
+		zip.write(members[i].name, nameLen);
+	}
+	const uint32 dirSize = zip.pos() - dirOffset;
+
+	zip.writeUint32LE(0x06054b50);
+	zip.writeUint16LE(0);
+	zip.writeUint16LE(0);
+	zip.writeUint16LE(count);
+	zip.writeUint16LE(count);
+	zip.writeUint32LE(dirSize);
+	zip.writeUint32LE(dirOffset);
+	zip.writeUint16LE(0);       // Comment
+
+	writeFile(name, zip.getData(), zip.size());
+	delete[] offsets;
+	delete[] crcs;
+	delete[] data;
+}
+
+} // End of anonymous namespace
+
+#endif
+
+class PosixMmapStreamTestSuite : public CxxTest::TestSuite {
+public:
+#if MMAP_TESTS
+	void setUp() {
+		Common::install_null_g_system();
+		writePatternFile(kBigName, kBigSize);
+	}
+
+	void tearDown() {
+		remove(kBigName);
+		remove(kSmallName);
+		remove(kZipName);
+	}
+#endif
+
+	void test_read_seek() {
+#if MMAP_TESTS
+		PosixMmapStream *stream = PosixMmapStream::makeFromPath(kBigName);
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+		TS_ASSERT_EQUALS(stream->size(), kBigSize);
+		TS_ASSERT(readsPattern(*stream, 16, 0));
+		TS_ASSERT_EQUALS(stream->pos(), 16);
+
+		TS_ASSERT(stream->seek(-4, SEEK_END));
+		byte buf[8];
+		TS_ASSERT_EQUALS(stream->read(buf, sizeof(buf)), 4u);
+		TS_ASSERT(hasPattern(buf, 4, kBigSize - 4));
+		TS_ASSERT(stream->eos());
+		TS_ASSERT_EQUALS(stream->pos(), kBigSize);
+
+		// Seeking clears eos(), even to past the end, where reads then fail.
+		TS_ASSERT(stream->seek(10, SEEK_CUR));
+		TS_ASSERT(!stream->eos());
+		TS_ASSERT_EQUALS(stream->pos(), kBigSize + 10);
+		TS_ASSERT_EQUALS(stream->read(buf, 1), 0u);
+		TS_ASSERT(stream->eos());
+		TS_ASSERT_EQUALS(stream->pos(), kBigSize + 10);
+		stream->clearErr();
+		TS_ASSERT(!stream->eos());
+
+		// Before the start is refused, and leaves the position alone.
+		TS_ASSERT(!stream->seek(-1, SEEK_SET));
+		TS_ASSERT(!stream->seek(-(int64)kBigSize - 1, SEEK_END));
+		TS_ASSERT_EQUALS(stream->pos(), kBigSize + 10);
+
+		TS_ASSERT(stream->seek(kBigSize / 2));
+		TS_ASSERT(readsPattern(*stream, 100, kBigSize / 2));
+		delete stream;
+#endif
+	}
+
+	void test_data_range() {
+#if MMAP_TESTS
+		PosixMmapStream *stream = PosixMmapStream::makeFromPath(kBigName);
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+		stream->seek(5);
+
+		const byte *data = stream->getDataRange(0, kBigSize);
+		TS_ASSERT(data && hasPattern(data, kBigSize, 0));
+		TS_ASSERT_EQUALS(stream->getDataRange(kBigSize, kBigSize), data + kBigSize);
+		TS_ASSERT(!stream->getDataRange(kBigSize - 1, kBigSize + 1));
+		TS_ASSERT(!stream->getDataRange(-1, 1));
+		TS_ASSERT(!stream->getDataRange(5, 4));
+		TS_ASSERT_EQUALS(stream->pos(), 5);
+
+		TS_ASSERT(!stream->createSubView(kBigSize - 1, kBigSize + 1));
+		TS_ASSERT(!stream->createSubView(-1, 1));
+		TS_ASSERT(!stream->createSubView(5, 4));
+
+		// A view has its own position, and shares the data.
+		Common::SeekableReadStream *view = stream->createSubView(1000, 2000);
+		TS_ASSERT(view);
+		if (!view) {
+			delete stream;
+			return;
+		}
+		TS_ASSERT_EQUALS(view->size(), 1000);
+		TS_ASSERT_EQUALS(view->pos(), 0);
+		TS_ASSERT_EQUALS(view->getDataRange(0, 1000), data + 1000);
+		TS_ASSERT(!view->getDataRange(0, 1001));
+		TS_ASSERT(readsPattern(*view, 1000, 1000));
+		TS_ASSERT_EQUALS(stream->pos(), 5);
+
+		// Its bounds are its own, not the file's.
+		TS_ASSERT(!view->createSubView(0, 1001));
+		Common::SeekableReadStream *nested = view->createSubView(10, 20);
+		TS_ASSERT(nested && nested->getDataRange(0, 10) == data + 1010);
+		delete nested;
+
+		Common::SeekableReadStream *empty = stream->createSubView(kBigSize, kBigSize);
+		TS_ASSERT(empty);
+		if (empty) {
+			TS_ASSERT_EQUALS(empty->size(), 0);
+			byte b;
+			TS_ASSERT_EQUALS(empty->read(&b, 1), 0u);
+			TS_ASSERT(empty->eos());
+		}
+		delete empty;
+		delete view;
+		delete stream;
+#endif
+	}
+
+	void test_view_outlives_parent() {
+#if MMAP_TESTS
+		PosixMmapStream *stream = PosixMmapStream::makeFromPath(kBigName);
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+		Common::SeekableReadStream *view = stream->createSubView(4096, kBigSize);
+		delete stream;
+		TS_ASSERT(view);
+		if (!view)
+			return;
+
+		// The mapping is only gone once the last view of it is.
+		Common::SeekableReadStream *nested = view->createSubView(100, 200);
+		TS_ASSERT(readsPattern(*view, kBigSize - 4096, 4096));
+		delete view;
+		TS_ASSERT(nested && readsPattern(*nested, 100, 4196));
+		delete nested;
+#endif
+	}
+
+	void test_small_file_fallback() {
+#if MMAP_TESTS
+		writePatternFile(kSmallName, 100);
+
+		// Too small to be worth mapping, a directory, or missing.
+		TS_ASSERT(!PosixMmapStream::makeFromPath(kSmallName));
+		TS_ASSERT(!PosixMmapStream::makeFromPath("."));
+		TS_ASSERT(!PosixMmapStream::makeFromPath("posix_mmapstream_missing.dat"));
+
+		// The filesystem node then reads it through stdio, without ranges.
+		Common::SeekableReadStream *small = Common::FSNode(Common::Path(kSmallName)).createReadStream();
+		TS_ASSERT(small);
+		if (small) {
+			TS_ASSERT_EQUALS(small->size(), 100);
+			TS_ASSERT(!small->getDataRange(0, 100));
+			TS_ASSERT(!small->createSubView(0, 100));
+			TS_ASSERT(readsPattern(*small, 100, 0));
+		}
+		delete small;
+
+		Common::SeekableReadStream *big = Common::FSNode(Common::Path(kBigName)).createReadStream();
+		TS_ASSERT(big);
+		if (big) {
+			const byte *data = big->getDataRange(0, kBigSize);
+			TS_ASSERT(data && hasPattern(data, kBigSize, 0));
+		}
+		delete big;
+#endif
+	}
+
+	void test_zip_stored_member() {
+#if MMAP_TESTS
+		ZipMember members[] = {
+			{ "big.bin", kBigSize, false, 0 },
+			{ "small.txt", 50, false, 0 },
+			{ "bad.bin", 1000, true, 0 }
+		};
+		Common::MemoryWriteStreamDynamic zip(DisposeAfterUse::YES);
+		writeStoredZip(kZipName, members, ARRAYSIZE(members), zip);
+
+		PosixMmapStream *mapped = PosixMmapStream::makeFromPath(kZipName);
+		TS_ASSERT(mapped);
+		if (!mapped)
+			return;
+		const byte *zipData = mapped->getDataRange(0, mapped->size());
+		Common::Archive *archive = Common::makeZipArchive(mapped);
+		TS_ASSERT(archive);
+		if (!archive)
+			return;
+
+		// A member of a mapped archive is a view of the mapping, not a copy.
+		Common::SeekableReadStream *big = archive->createReadStreamForMember("big.bin");
+		TS_ASSERT(big);
+		Common::SeekableReadStream *small = archive->createReadStreamForMember("small.txt");
+		TS_ASSERT(small);
+		if (big) {
+			TS_ASSERT_EQUALS(big->size(), kBigSize);
+			TS_ASSERT_EQUALS(big->getDataRange(0, kBigSize), zipData + members[0].dataOffset);
+		}
+		if (small)
+			TS_ASSERT_EQUALS(small->getDataRange(0, 50), zipData + members[1].dataOffset);
+
+		// The CRC is still checked.
+		TS_ASSERT(!archive->createReadStreamForMember("bad.bin"));
+
+		// The members can outlive the archive.
+		delete archive;
+		if (big)
+			TS_ASSERT(readsPattern(*big, kBigSize, 0));
+		if (small)
+			TS_ASSERT(readsPattern(*small, 50, 0));
+		delete big;
+		delete small;
+
+		// An archive in memory has its stored members copied out, as before.
+		Common::Archive *memArchive = Common::makeZipArchive(new Common::MemoryReadStream(zip.getData(), zip.size()));
+		TS_ASSERT(memArchive);
+		if (!memArchive)
+			return;
+		Common::SeekableReadStream *copy = memArchive->createReadStreamForMember("big.bin");
+		TS_ASSERT(copy);
+		if (copy) {
+			TS_ASSERT_DIFFERS(copy->getDataRange(0, kBigSize), zip.getData() + members[0].dataOffset);
+			TS_ASSERT(readsPattern(*copy, kBigSize, 0));
+		}
+		TS_ASSERT(!memArchive->createReadStreamForMember("bad.bin"));
+		delete copy;
+		delete memArchive;
+#endif
+	}
+};
@@ -0,0 +1,172 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/debug.h"
+#include "common/memstream.h"
+#include "common/system.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+namespace {
+
+// An archive of empty files, each one's stream holding its archive's id.
+class NamesArchive : public Common::Archive {
+public:
+	NamesArchive(byte id) : _id(id) {}
+
+	void addFile(const Common::Path &path) { _files[path] = true; }
+	void removeFile(const Common::Path &path) { _files.erase(path); }
+
+	bool hasFile(const Common::Path &path) const override {
+		return _files.contains(path);
+	}
+
+	int listMembers(Common::ArchiveMemberList &list) const override {
+		for (const auto &file : _files)
+			list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(file._key, *this)));
+		return _files.size();
+	}
+
+	const Common::ArchiveMemberPtr getMember(const Common::Path &path) const override {
+		if (!hasFile(path))
+			return Common::ArchiveMemberPtr();
+		return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(path, *this));
+	}
+
+	Common::SeekableReadStream *createReadStreamForMember(const Common::Path &path) const override {
+		if (!hasFile(path))
+			return nullptr;
+		return new Common::MemoryReadStream(&_id, 1);
+	}
+
+private:
+	typedef Common::HashMap<Common::Path, bool, Common::Path::IgnoreCaseAndMac_Hash, Common::Path::IgnoreCaseAndMac_EqualTo> FileMap;
+
+	const byte _id;
+	FileMap _files;
+};
+
+} // End of anonymous namespace
+
+class SearchSetTestSuite : public CxxTest::TestSuite {
+	// Which archive a file is read from, or -1.
+	static int readFrom(const Common::SearchSet &set, const char *path) {
+		Common::SeekableReadStream *stream = set.createReadStreamForMember(Common::Path(path));
+		if (!stream)
+			return -1;
+		const int id = stream->readByte();
+		delete stream;
+		return id;
+	}
+
+	void checkLookups(bool indexed) {
+		Common::SearchSet set;
+		set.setIndexed(indexed);
+
+		NamesArchive *low = new NamesArchive(1);
+		low->addFile("a.dat");
+		low->addFile("dir/b.dat");
+		low->addFile("shared.dat");
+		NamesArchive *high = new NamesArchive(2);
+		high->addFile("SHARED.DAT");
+		high->addFile("c.dat");
+		set.add("low", low, 0);
+		set.add("high", high, 10);
+
+		TS_ASSERT(set.hasFile("a.dat"));
+		TS_ASSERT(set.hasFile("DIR/B.dat"));
+		TS_ASSERT(set.hasFile("c.dat"));
+		TS_ASSERT(!set.hasFile("d.dat"));
+		TS_ASSERT(!set.hasFile("b.dat"));
+		TS_ASSERT_EQUALS(readFrom(set, "a.dat"), 1);
+		TS_ASSERT_EQUALS(readFrom(set, "shared.dat"), 2);
+		TS_ASSERT_EQUALS(readFrom(set, "d.dat"), -1);
+
+		Common::Archive *container = nullptr;
+		TS_ASSERT(set.getMember("dir/b.dat", &container));
+		TS_ASSERT_EQUALS(container, low);
+		TS_ASSERT(!set.getMember("dir/c.dat", &container));
+
+		// Changes to the set are seen.
+		set.setPriority("low", 20);
+		TS_ASSERT_EQUALS(readFrom(set, "shared.dat"), 1);
+		set.remove("low");
+		TS_ASSERT(!set.hasFile("a.dat"));
+		TS_ASSERT_EQUALS(readFrom(set, "shared.dat"), 2);
+
+		NamesArchive *extra = new NamesArchive(3);
+		extra->addFile("a.dat");
+		set.add("extra", extra);
+		TS_ASSERT_EQUALS(readFrom(set, "a.dat"), 3);
+
+		// So are changes to the archives, once the index is invalidated.
+		high->removeFile("c.dat");
+		TS_ASSERT(!set.hasFile("c.dat"));
+		high->addFile("e.dat");
+		set.invalidateIndex();
+		TS_ASSERT(set.hasFile("e.dat"));
+	}
+
+public:
+	void test_lookups() {
+		checkLookups(false);
+	}
+
+	void test_indexed_lookups() {
+		checkLookups(true);
+	}
+
+	void test_lookup_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+
+		// 100 directories of 1000 files each, as 50 archives.
+		const int numArchives = 50, numDirs = 100, numFiles = 1000;
+		Common::SearchSet set;
+		for (int i = 0; i < numArchives; i++) {
+			NamesArchive *archive = new NamesArchive(i);
+			for (int dir = i; dir < numDirs; dir += numArchives) {
+				for (int file = 0; file < numFiles; file++)
+					archive->addFile(Common::Path(Common::String::format("dir%d/file%d.dat", dir, file)));
+			}
+			set.add(Common::String::format("archive%d", i), archive, i);
+		}
+
+		Common::Array<Common::Path> paths;
+		for (int i = 0; i < 20000; i++) {
+			// Every fourth lookup is for a file that is not there.
+			const int dir = (i * 7919) % numDirs;
+			const int file = (i * 104729) % numFiles;
+			paths.push_back(Common::Path(Common::String::format((i & 3) ? "DIR%d/file%d.dat" : "dir%d/missing%d.dat", dir, file)));
+		}
+
+		for (int indexed = 0; indexed < 2; indexed++) {
+			set.setIndexed(indexed);
+
+			uint32 start = g_system->getMillis();
+			if (indexed)
+				set.hasFile("dir0/file0.dat");
+			const uint32 buildTime = g_system->getMillis() - start;
+
+			start = g_system->getMillis();
+			uint found = 0;
+			for (const Common::Path &path : paths) {
+				if (set.hasFile(path))
+					found++;
+			}
+			const uint32 lookupTime = g_system->getMillis() - start;
+
+			TS_ASSERT_EQUALS(found, 15000u);
+			debug("SearchSet %s: %u lookups over %d files in %d archives in %u ms (index built in %u ms)",
+			      indexed ? "indexed" : "not indexed", paths.size(), numDirs * numFiles, numArchives,
+			      lookupTime, buildTime);
+		}
+#endif
+	}
+};
@@ -70,4 +70,21 @@ class SeekableSubReadStreamTestSuite : public CxxTest::TestSuite {
 		b = ssrs.readByte();
 		TS_ASSERT_EQUALS(b, 1);
 	}
+
+	void test_data_range() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+		Common::SeekableSubReadStream ssrs(&ms, 2, 8);
+
+		const byte *data = ssrs.getDataRange(1, 6);
+		TS_ASSERT_EQUALS(data, contents + 3);
+		TS_ASSERT_EQUALS(ssrs.pos(), 0);
+		TS_ASSERT_EQUALS(ssrs.getDataRange(6, 6), contents + 8);
+		TS_ASSERT(!ssrs.getDataRange(0, 7));
+		TS_ASSERT(!ssrs.getDataRange(-1, 2));
+		TS_ASSERT(!ssrs.getDataRange(4, 3));
+
+		// A memory stream's data may not outlive it, so it has no views.
+		TS_ASSERT(!ssrs.createSubView(0, 2));
+	}
 };
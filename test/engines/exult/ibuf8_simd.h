@@ -0,0 +1,165 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "test/instrset_detect.h"
+
+#include "common/str.h"
+#include "common/util.h"
+
+#include "engines/exult/exult_core_src/imagewin/ibuf8_simd.h"
+
+#include <string.h>
+
+/**
+ * Checks that each SIMD version of Exult's 8-bit painting loops gives
+ * exactly the same pixels as the scalar one, for runs of every length up
+ * to a few blocks, at every alignment, and that nothing past a run is
+ * touched.
+ */
+class Ibuf8SimdTestSuite : public CxxTest::TestSuite {
+	enum {
+		kMaxRun = 160,
+		kGuard = 64,
+		kBufSize = kMaxRun + 32 + 2 * kGuard,
+		kGuardByte = 0xa5
+	};
+
+	uint32 _seed;
+
+	byte nextByte() {
+		_seed = _seed * 1103515245u + 12345u;
+		return _seed >> 24;
+	}
+
+	void fillRandom(byte *buf, int size) {
+		for (int i = 0; i < size; i++)
+			buf[i] = nextByte();
+	}
+
+	// Mostly opaque, with runs of translucent colors, like a spell effect.
+	void fillShape(byte *buf, int size, int first, int last) {
+		for (int i = 0; i < size; i++) {
+			byte c = nextByte();
+			if ((i / 20) % 3 == 1 && (c & 1))
+				c = first + c % (last - first + 1);
+			else if (c >= first && c <= last)
+				c = first > 0 ? first - 1 : last + 1;
+			buf[i] = c;
+		}
+	}
+
+	void checkRuns(const Ibuf8_kernels &kernels) {
+		byte table[256];
+		byte xforms[256 * 256];
+		byte src[kBufSize];
+		byte dest[kBufSize];
+		byte expected[kBufSize];
+		static const int ranges[][2] = {
+			{0, 0}, {0, 255}, {8, 11}, {224, 254}, {255, 255}
+		};
+
+		_seed = 12345;
+		fillRandom(table, sizeof(table));
+		fillRandom(xforms, sizeof(xforms));
+		for (int align = 0; align < 32; align++) {
+			for (int cnt = 0; cnt <= kMaxRun; cnt++) {
+				const int start = kGuard + align;
+				fillRandom(src, kBufSize);
+				fillRandom(dest, kBufSize);
+				memset(dest, kGuardByte, start);
+				memset(dest + start + cnt, kGuardByte, kBufSize - start - cnt);
+
+				memcpy(expected, dest, kBufSize);
+				Ibuf8_kernels::scalar.remap(expected + start, src + start, cnt, table);
+				kernels.remap(dest + start, src + start, cnt, table);
+				if (memcmp(dest, expected, kBufSize)) {
+					TS_FAIL(Common::String::format("%s remap: %d at %d", kernels.name, cnt, align).c_str());
+					return;
+				}
+
+				Ibuf8_kernels::scalar.xform(expected + start, cnt, table);
+				kernels.xform(dest + start, cnt, table);
+				if (memcmp(dest, expected, kBufSize)) {
+					TS_FAIL(Common::String::format("%s xform: %d at %d", kernels.name, cnt, align).c_str());
+					return;
+				}
+
+				for (int r = 0; r < ARRAYSIZE(ranges); r++) {
+					const int first = ranges[r][0];
+					const int last = ranges[r][1];
+					fillShape(src, kBufSize, first, last);
+					Ibuf8_kernels::scalar.copy_translucent(expected + start, src + start, cnt, first, last, xforms);
+					kernels.copy_translucent(dest + start, src + start, cnt, first, last, xforms);
+					if (memcmp(dest, expected, kBufSize)) {
+						TS_FAIL(Common::String::format("%s copy_translucent %d-%d: %d at %d", kernels.name, first, last, cnt, align).c_str());
+						return;
+					}
+				}
+			}
+		}
+	}
+
+public:
+	void test_scalar() {
+		byte table[256];
+		byte pixels[256];
+		for (int i = 0; i < 256; i++) {
+			table[i] = 255 - i;
+			pixels[i] = i;
+		}
+		Ibuf8_kernels::scalar.xform(pixels, 256, table);
+		for (int i = 0; i < 256; i++)
+			TS_ASSERT_EQUALS(pixels[i], 255 - i);
+
+		// Color 3 is translucent, with its table shifting everything by 1.
+		const byte src[4] = {1, 3, 2, 3};
+		byte dest[4] = {10, 20, 30, 40};
+		byte xforms[256];
+		for (int i = 0; i < 256; i++)
+			xforms[i] = i + 1;
+		Ibuf8_kernels::scalar.copy_translucent(dest, src, 4, 3, 3, xforms);
+		TS_ASSERT_EQUALS(dest[0], 1);
+		TS_ASSERT_EQUALS(dest[1], 21);
+		TS_ASSERT_EQUALS(dest[2], 2);
+		TS_ASSERT_EQUALS(dest[3], 41);
+	}
+
+	void test_sse2() {
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			checkRuns(Ibuf8_kernels::sse2);
+#endif
+	}
+
+	void test_avx2() {
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8)
+			checkRuns(Ibuf8_kernels::avx2);
+#endif
+	}
+
+	void test_neon() {
+#ifdef SCUMMVM_NEON
+		checkRuns(Ibuf8_kernels::neon);
+#endif
+	}
+};
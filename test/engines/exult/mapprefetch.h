@@ -0,0 +1,233 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+
+#include "engines/exult/exult_core_src/conf/Configuration.h"
+#include "engines/exult/exult_core_src/files/utils.h"
+#include "engines/exult/exult_core_src/mapprefetch.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+// Last, as they forbid C library calls in all that follows them.
+#include "common/debug.h"
+#include "common/job-system.h"
+#include "common/str.h"
+#include "common/system.h"
+
+#include "../../null_osystem.h"
+
+#ifdef POSIX
+#include "backends/jobs/pthread/pthread-jobs.h"
+#define THREADED_JOBS 1
+#else
+#define THREADED_JOBS 0
+#endif
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+// The game's settings, which exult.cc has in the engine.
+Configuration *config = nullptr;
+
+namespace {
+
+// The files U7open_in() finds, while a test runs.
+std::map<std::string, std::string> memoryFiles;
+
+std::unique_ptr<std::istream> openMemoryFile(const char *name, std::ios_base::openmode mode) {
+	std::map<std::string, std::string>::const_iterator it = memoryFiles.find(name);
+	if (it == memoryFiles.end())
+		return nullptr;
+	return std::make_unique<std::istringstream>(it->second, mode);
+}
+
+std::unique_ptr<std::istream> openRealFile(const char *name, std::ios_base::openmode mode) {
+	return std::make_unique<std::ifstream>(name, mode);
+}
+
+bool sameContents(const std::unique_ptr<unsigned char[]> &buf, size_t len, const std::string &expected) {
+	return buf && len == expected.size() && !memcmp(buf.get(), expected.data(), len);
+}
+
+} // End of anonymous namespace
+
+class MapPrefetchTestSuite : public CxxTest::TestSuite {
+	// Run a check with a serial job system, and with one worker thread.
+	template<class Check>
+	void withEachJobSystem(Check check) {
+		check(new Common::JobSystem());
+#if THREADED_JOBS
+		check(createPthreadJobSystem(1));
+#endif
+	}
+
+public:
+	void setUp() {
+		memoryFiles.clear();
+		memoryFiles["ifix0a"] = std::string(3000, 'f');
+		memoryFiles["ireg0a"] = "moveable objects";
+		memoryFiles["ireg0b"] = "restored objects";
+		memoryFiles["ifix1a"] = std::string(5, '\0');
+		U7set_istream_factory(openMemoryFile);
+	}
+
+	void tearDown() {
+		U7set_istream_factory(openRealFile);
+		memoryFiles.clear();
+	}
+
+	void test_read() {
+		withEachJobSystem([](Common::JobSystem *jobs) {
+			Schunk_prefetch prefetch(jobs);
+			TS_ASSERT(!prefetch.is_requested(0, 10));
+			prefetch.request(0, 10, "ifix0a", "ireg0a");
+			TS_ASSERT(prefetch.is_requested(0, 10));
+			TS_ASSERT(!prefetch.is_requested(1, 10));
+			prefetch.wait();
+			TS_ASSERT(prefetch.is_requested(0, 10));
+
+			Schunk_files files;
+			TS_ASSERT(prefetch.take(0, 10, files));
+			TS_ASSERT(sameContents(files.ifix, files.ifix_len, memoryFiles["ifix0a"]));
+			TS_ASSERT(sameContents(files.ireg, files.ireg_len, memoryFiles["ireg0a"]));
+			// It's forgotten once taken.
+			TS_ASSERT(!prefetch.is_requested(0, 10));
+			TS_ASSERT(!prefetch.take(0, 10, files));
+			TS_ASSERT_EQUALS(prefetch.get_num_requested(), 1u);
+			TS_ASSERT_EQUALS(prefetch.get_num_used(), 1u);
+		});
+	}
+
+	void test_missing_files() {
+		withEachJobSystem([](Common::JobSystem *jobs) {
+			Schunk_prefetch prefetch(jobs);
+			// A missing file, and one that isn't asked for.
+			prefetch.request(0, 1, "ifix1a", "ireg1a");
+			prefetch.request(0, 2, "", "ireg0a");
+			prefetch.wait();
+
+			Schunk_files files;
+			TS_ASSERT(prefetch.take(0, 1, files));
+			TS_ASSERT(sameContents(files.ifix, files.ifix_len, memoryFiles["ifix1a"]));
+			TS_ASSERT(!files.ireg);
+			Schunk_files files2;
+			TS_ASSERT(prefetch.take(0, 2, files2));
+			TS_ASSERT(!files2.ifix);
+			TS_ASSERT(sameContents(files2.ireg, files2.ireg_len, memoryFiles["ireg0a"]));
+		});
+	}
+
+	void test_forget() {
+		withEachJobSystem([](Common::JobSystem *jobs) {
+			Schunk_prefetch prefetch(jobs);
+			prefetch.request(0, 3, "ifix0a", "");
+			prefetch.request(1, 3, "ifix0a", "");
+			prefetch.forget(0);
+			prefetch.wait();
+			TS_ASSERT(!prefetch.is_requested(0, 3));
+			TS_ASSERT(prefetch.is_requested(1, 3));
+
+			Schunk_files files;
+			TS_ASSERT(!prefetch.take(0, 3, files));
+			TS_ASSERT(prefetch.take(1, 3, files));
+			TS_ASSERT_EQUALS(prefetch.get_num_used(), 1u);
+		});
+	}
+
+	void test_request_again() {
+		withEachJobSystem([](Common::JobSystem *jobs) {
+			// The latest request wins, whether the earlier one has been
+			// read or not.
+			Schunk_prefetch prefetch(jobs);
+			prefetch.request(0, 4, "", "ireg0a");
+			prefetch.request(0, 4, "", "ireg0b");
+			prefetch.wait();
+
+			Schunk_files files;
+			TS_ASSERT(prefetch.take(0, 4, files));
+			TS_ASSERT(sameContents(files.ireg, files.ireg_len, memoryFiles["ireg0b"]));
+			TS_ASSERT(!prefetch.is_requested(0, 4));
+		});
+	}
+
+	void test_prefetch_speed() {
+#if BENCHMARK_TIME && THREADED_JOBS
+		Common::install_null_g_system();
+		U7set_istream_factory(openRealFile);
+
+		// About the size of a busy superchunk's ifix file.
+		const int numFiles = 32;
+		const std::string contents(256 * 1024, 'x');
+		for (int i = 0; i < numFiles; i++) {
+			const Common::String name = Common::String::format("mapprefetch_bench%d.dat", i);
+			*U7open_out(name.c_str()) << contents;
+		}
+
+		// What the game thread spends reading the files itself...
+		uint32 start = g_system->getMillis();
+		size_t total = 0;
+		for (int i = 0; i < numFiles; i++) {
+			const Common::String name = Common::String::format("mapprefetch_bench%d.dat", i);
+			std::unique_ptr<std::istream> in = U7open_in(name.c_str());
+			std::unique_ptr<char[]> buf(new char[contents.size()]);
+			in->read(buf.get(), contents.size());
+			total += in->gcount();
+		}
+		const uint32 readTime = g_system->getMillis() - start;
+		TS_ASSERT_EQUALS(total, numFiles * contents.size());
+
+		// ...and taking them once they have been read ahead of time.
+		Schunk_prefetch prefetch(createPthreadJobSystem(1));
+		for (int i = 0; i < numFiles; i++) {
+			const Common::String name = Common::String::format("mapprefetch_bench%d.dat", i);
+			prefetch.request(0, i, name.c_str(), "");
+		}
+		prefetch.wait();
+		start = g_system->getMillis();
+		total = 0;
+		for (int i = 0; i < numFiles; i++) {
+			Schunk_files files;
+			if (prefetch.take(0, i, files))
+				total += files.ifix_len;
+		}
+		const uint32 takeTime = g_system->getMillis() - start;
+		TS_ASSERT_EQUALS(total, numFiles * contents.size());
+
+		// The files were just written, so reading them hits the page cache:
+		// a cold read from disk only costs the game thread more.
+		debug("Superchunk files: %d read in %u ms on the game thread, taken in %u ms when prefetched",
+		      numFiles, readTime, takeTime);
+
+		for (int i = 0; i < numFiles; i++) {
+			const Common::String name = Common::String::format("mapprefetch_bench%d.dat", i);
+			U7remove(name.c_str());
+		}
+#endif
+	}
+};
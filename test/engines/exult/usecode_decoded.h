@@ -0,0 +1,551 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+
+#include "engines/exult/exult_core_src/conf/Configuration.h"
+#include "engines/exult/exult_core_src/game.h"
+#include "engines/exult/exult_core_src/usecode/opcodes.h"
+#include "engines/exult/exult_core_src/usecode/ucfunction.h"
+#include "engines/exult/exult_core_src/usecode/ucinternal.h"
+
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Last, as they forbid C library calls in all that follows them.
+#include "common/debug.h"
+#include "common/system.h"
+
+#include "../../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+extern Configuration *config;
+
+namespace {
+
+// Heap allocations, counted while 'countingAllocations' is set.
+bool countingAllocations = false;
+unsigned long numAllocations = 0;
+
+} // End of anonymous namespace
+
+void *operator new(size_t size) {
+	if (countingAllocations)
+		numAllocations++;
+	if (void *ptr = malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+	free(ptr);
+}
+
+namespace {
+
+// Lets Usecode_internal start without a usecode file, as in map-editing.
+struct EditingGame : public Game {
+	static void setEditing(bool editing) { editing_flag = editing; }
+};
+
+/**
+ * Assembles one usecode function, in the format read_usecode() reads.
+ */
+class UsecodeAsm {
+	std::string _data;
+	std::string _code;
+	std::map<int, int> _labels;                  ///< Label -> code offset.
+	std::vector<std::pair<int, int> > _fixups;   ///< Operand offset, label.
+
+	void put16(int value) {
+		_code += char(value & 0xff);
+		_code += char((value >> 8) & 0xff);
+	}
+
+public:
+	/** Add a string to the data segment, returning its offset. */
+	int string(const char *str) {
+		const int offset = _data.size();
+		_data += str;
+		_data += '\0';
+		return offset;
+	}
+
+	void op(UsecodeOps opcode) { _code += char(opcode); }
+	void op(UsecodeOps opcode, int arg) { op(opcode); put16(arg); }
+	void opByte(UsecodeOps opcode, int arg) { op(opcode); _code += char(arg); }
+
+	void label(int num) { _labels[num] = _code.size(); }
+
+	void jump(UsecodeOps opcode, int num) {
+		op(opcode);
+		_fixups.push_back(std::make_pair(int(_code.size()), num));
+		put16(0);
+	}
+
+	std::string finish(int id, int numArgs, int numLocals) {
+		// Jumps are relative to the following opcode.
+		for (uint i = 0; i < _fixups.size(); i++) {
+			const int delta = _labels[_fixups[i].second] - (_fixups[i].first + 2);
+			_code[_fixups[i].first] = char(delta & 0xff);
+			_code[_fixups[i].first + 1] = char((delta >> 8) & 0xff);
+		}
+		std::string body;
+		body += char(_data.size() & 0xff);
+		body += char(_data.size() >> 8);
+		body += _data;
+		const int header[] = {numArgs, numLocals, 0};
+		for (int i = 0; i < 3; i++) {
+			body += char(header[i] & 0xff);
+			body += char(header[i] >> 8);
+		}
+		body += _code;
+		std::string fun;
+		fun += char(id & 0xff);
+		fun += char(id >> 8);
+		fun += char(body.size() & 0xff);
+		fun += char(body.size() >> 8);
+		return fun + body;
+	}
+};
+
+enum {
+	kLoopFun = 0x900,
+	kStringFun = 0x901,
+	kArrayFun = 0x902,
+	kLogicFun = 0x903,
+	kBadLocalFun = 0x904,
+	kConverseFun = 0x905,
+	kLiteralOnceFun = 0x906,
+	kLiteralLoopFun = 0x907
+};
+
+/**
+ * A loop doing integer arithmetic:
+ *     acc = 7;
+ *     for (i = 0; i < 200; i++)
+ *         acc = (acc * i + 3) % 10007 - i / 2;
+ *     return acc;
+ */
+std::string loopFunction() {
+	UsecodeAsm a;
+	a.op(UC_PUSHI, 0);
+	a.op(UC_POP, 0);
+	a.opByte(UC_PUSHB, 7);
+	a.op(UC_POP, 1);
+	a.label(0);
+	a.op(UC_PUSH, 0);
+	a.op(UC_PUSHI, 200);
+	a.op(UC_CMPLT);
+	a.jump(UC_JNE, 1);
+	a.op(UC_PUSH, 1);
+	a.op(UC_PUSH, 0);
+	a.op(UC_MUL);
+	a.op(UC_PUSHI, 3);
+	a.op(UC_ADD);
+	a.op(UC_PUSHI, 10007);
+	a.op(UC_MOD);
+	a.op(UC_PUSH, 0);
+	a.op(UC_PUSHI, 2);
+	a.op(UC_DIV);
+	a.op(UC_SUB);
+	a.op(UC_POP, 1);
+	a.op(UC_PUSH, 0);
+	a.op(UC_PUSHTRUE);
+	a.op(UC_ADD);
+	a.op(UC_POP, 0);
+	a.jump(UC_JMP, 0);
+	a.label(1);
+	a.op(UC_PUSH, 1);
+	a.op(UC_RETV);
+	return a.finish(kLoopFun, 0, 2);
+}
+
+/**
+ * Strings: literals added to numbers and each other, the string register,
+ * and comparisons, which go through Usecode_value's string code.
+ */
+std::string stringFunction() {
+	UsecodeAsm a;
+	const int hello = a.string("Hello");
+	const int world = a.string(" world");
+	a.op(UC_ADDSI, hello);
+	a.op(UC_ADDSI, world);
+	a.op(UC_PUSHS, hello);
+	a.op(UC_PUSHI, 42);
+	a.op(UC_ADD);
+	a.op(UC_PUSHS, world);
+	a.op(UC_ADD);
+	a.op(UC_POP, 0);
+	a.op(UC_PUSH, 0);
+	a.op(UC_PUSHS, hello);
+	a.op(UC_CMPEQ);
+	a.jump(UC_JNE, 0);
+	a.op(UC_PUSHS, world);
+	a.op(UC_RETV);
+	a.label(0);
+	a.op(UC_PUSH, 0);
+	a.op(UC_RETV);
+	return a.finish(kStringFun, 0, 1);
+}
+
+/**
+ * Arrays: appending, 'in', and comparing them.
+ */
+std::string arrayFunction() {
+	UsecodeAsm a;
+	const int str = a.string("x");
+	a.op(UC_PUSHI, 1);
+	a.op(UC_PUSHI, 2);
+	a.op(UC_ARRA);
+	a.op(UC_PUSHS, str);
+	a.op(UC_ARRA);
+	a.op(UC_POP, 0);
+	a.op(UC_PUSHS, str);
+	a.op(UC_PUSH, 0);
+	a.op(UC_IN);
+	a.op(UC_PUSHI, 3);
+	a.op(UC_PUSH, 0);
+	a.op(UC_IN);
+	a.op(UC_CMPNE);
+	a.op(UC_PUSH, 0);
+	a.op(UC_PUSH, 0);
+	a.op(UC_CMPEQ);
+	a.op(UC_AND);
+	a.op(UC_PUSH, 0);
+	a.op(UC_ARRA);
+	a.op(UC_RETV);
+	return a.finish(kArrayFun, 0, 1);
+}
+
+/**
+ * Comparisons, logic, a global flag and the event id.
+ */
+std::string logicFunction() {
+	UsecodeAsm a;
+	a.op(UC_PUSHEVENTID);
+	a.op(UC_PUSHI, 7);
+	a.op(UC_MUL);
+	a.op(UC_PUSHI, 10);
+	a.op(UC_SUB);
+	a.op(UC_POP, 0);
+	a.op(UC_PUSH, 0);
+	a.op(UC_PUSHI, -5);
+	a.op(UC_CMPGT);
+	a.op(UC_PUSH, 0);
+	a.op(UC_PUSHI, 5);
+	a.op(UC_CMPLE);
+	a.op(UC_OR);
+	a.op(UC_PUSHF, 0x3b);
+	a.op(UC_NOT);
+	a.op(UC_AND);
+	a.op(UC_PUSHEVENTID);
+	a.op(UC_PUSHI, 2);
+	a.op(UC_CMPGE);
+	a.op(UC_PUSHFALSE);
+	a.op(UC_OR);
+	a.op(UC_ARRA);
+	a.op(UC_PUSHEVENTID);
+	a.op(UC_ARRA);
+	a.op(UC_RETV);
+	return a.finish(kLogicFun, 0, 1);
+}
+
+/**
+ * A local past the end, which the decoder leaves for the switch to report.
+ */
+std::string badLocalFunction() {
+	UsecodeAsm a;
+	a.op(UC_PUSHI, 9);
+	a.op(UC_PUSH, 5);
+	a.op(UC_ADD);
+	a.op(UC_RETV);
+	return a.finish(kBadLocalFun, 0, 1);
+}
+
+/**
+ * The stack traffic of a conversation, as UCC compiles one: the answers are
+ * built from literals, the user's choice is looked for in them and matched
+ * against each case, and a reply is built from it.
+ *     for (i = 0; i < 20; i++) {
+ *         answers = ["name", "job", "bye"];
+ *         choice = "job";
+ *         if (choice in answers) {
+ *             if (choice == "name") reply = "I am Iolo." + choice;
+ *             else if (choice == "job") reply = "I am a bard." + choice;
+ *         }
+ *     }
+ *     return reply;
+ */
+std::string converseFunction() {
+	UsecodeAsm a;
+	const int name = a.string("name");
+	const int job = a.string("job");
+	const int bye = a.string("bye");
+	const int iolo = a.string("I am Iolo, thy friend of old!");
+	const int bard = a.string("I am a bard, and an archer of some renown.");
+	a.op(UC_PUSHI, 0);
+	a.op(UC_POP, 0);
+	a.label(0);
+	a.op(UC_PUSH, 0);
+	a.op(UC_PUSHI, 20);
+	a.op(UC_CMPLT);
+	a.jump(UC_JNE, 1);
+	a.op(UC_PUSHS, name);
+	a.op(UC_PUSHS, job);
+	a.op(UC_ARRA);
+	a.op(UC_PUSHS, bye);
+	a.op(UC_ARRA);
+	a.op(UC_POP, 1);
+	a.op(UC_PUSHS, job);
+	a.op(UC_POP, 2);
+	a.op(UC_PUSH, 2);
+	a.op(UC_PUSH, 1);
+	a.op(UC_IN);
+	a.jump(UC_JNE, 2);
+	a.op(UC_PUSH, 2);
+	a.op(UC_PUSHS, name);
+	a.op(UC_CMPEQ);
+	a.jump(UC_JNE, 3);
+	a.op(UC_PUSHS, iolo);
+	a.op(UC_PUSH, 2);
+	a.op(UC_ADD);
+	a.op(UC_POP, 3);
+	a.jump(UC_JMP, 2);
+	a.label(3);
+	a.op(UC_PUSH, 2);
+	a.op(UC_PUSHS, job);
+	a.op(UC_CMPEQ);
+	a.jump(UC_JNE, 2);
+	a.op(UC_PUSHS, bard);
+	a.op(UC_PUSH, 2);
+	a.op(UC_ADD);
+	a.op(UC_POP, 3);
+	a.label(2);
+	a.op(UC_PUSH, 0);
+	a.op(UC_PUSHTRUE);
+	a.op(UC_ADD);
+	a.op(UC_POP, 0);
+	a.jump(UC_JMP, 0);
+	a.label(1);
+	a.op(UC_PUSH, 3);
+	a.op(UC_RETV);
+	return a.finish(kConverseFun, 0, 4);
+}
+
+/**
+ * A string literal pushed, stored, copied and compared on each trip:
+ *     for (i = 0; i < trips; i++) {
+ *         str = "Thou dost not know me? I am Iolo, thy friend of old!";
+ *         copy = str;
+ *         if (copy != "Thou dost not know me? ...") break;
+ *     }
+ *     return copy;
+ */
+std::string literalFunction(int id, int trips) {
+	UsecodeAsm a;
+	const int iolo = a.string("Thou dost not know me? I am Iolo, thy friend of old!");
+	a.op(UC_PUSHI, 0);
+	a.op(UC_POP, 0);
+	a.label(0);
+	a.op(UC_PUSH, 0);
+	a.op(UC_PUSHI, trips);
+	a.op(UC_CMPLT);
+	a.jump(UC_JNE, 1);
+	a.op(UC_PUSHS, iolo);
+	a.op(UC_POP, 1);
+	a.op(UC_PUSH, 1);
+	a.op(UC_POP, 2);
+	a.op(UC_PUSH, 2);
+	a.op(UC_PUSHS, iolo);
+	a.op(UC_CMPEQ);
+	a.jump(UC_JNE, 1);
+	a.op(UC_PUSH, 0);
+	a.op(UC_PUSHTRUE);
+	a.op(UC_ADD);
+	a.op(UC_POP, 0);
+	a.jump(UC_JMP, 0);
+	a.label(1);
+	a.op(UC_PUSH, 2);
+	a.op(UC_RETV);
+	return a.finish(id, 0, 3);
+}
+
+} // End of anonymous namespace
+
+/**
+ * Runs the same usecode functions with Usecode_internal's decoded fast path
+ * and with the switch in run() alone, and checks they give the same results.
+ */
+class UsecodeDecodedTestSuite : public CxxTest::TestSuite {
+	Usecode_internal *_decoded;
+	Usecode_internal *_reference;
+
+	Usecode_internal *createMachine(bool predecode) {
+		Usecode_internal *uc = new Usecode_internal();
+		std::istringstream in(loopFunction() + stringFunction() + arrayFunction() +
+		                      logicFunction() + badLocalFunction() +
+		                      converseFunction() +
+		                      literalFunction(kLiteralOnceFun, 1) +
+		                      literalFunction(kLiteralLoopFun, 500));
+		uc->read_usecode(in);
+		uc->predecode = predecode;
+		return uc;
+	}
+
+	// Call a function the way call_usecode() does, without its conversation
+	// and barge handling, returning what it returned.
+	static Usecode_value call(Usecode_internal *uc, int id, int event) {
+		TS_ASSERT(uc->call_function(id, event, nullptr, true));
+		uc->run();
+		TS_ASSERT_EQUALS(uc->sp - uc->stack, 1);
+		return uc->pop();
+	}
+
+	// The time taken to call a function @p calls times.
+	static uint32 timeCalls(Usecode_internal *uc, int id, int calls) {
+		const uint32 start = g_system->getMillis();
+		for (int i = 0; i < calls; i++)
+			call(uc, id, 2);
+		return g_system->getMillis() - start;
+	}
+
+	// The heap allocations made calling a function.
+	static unsigned long countCalls(Usecode_internal *uc, int id) {
+		numAllocations = 0;
+		countingAllocations = true;
+		call(uc, id, 2);
+		countingAllocations = false;
+		return numAllocations;
+	}
+
+	static std::string describe(const Usecode_value &val) {
+		std::ostringstream out;
+		val.print(out);
+		return out.str();
+	}
+
+	void checkSame(int id, int event = 2) {
+		const Usecode_value fast = call(_decoded, id, event);
+		const Usecode_value slow = call(_reference, id, event);
+		TS_ASSERT_EQUALS(describe(fast), describe(slow));
+		TS_ASSERT(fast == slow);
+	}
+
+public:
+	void setUp() {
+		if (!config)
+			config = new Configuration();
+		EditingGame::setEditing(true);
+		_decoded = createMachine(true);
+		_reference = createMachine(false);
+	}
+
+	void tearDown() {
+		delete _decoded;
+		delete _reference;
+		EditingGame::setEditing(false);
+	}
+
+	void test_loop() {
+		checkSame(kLoopFun);
+		// The decoded function is kept, and run again.
+		checkSame(kLoopFun);
+		TS_ASSERT(_decoded->find_function(kLoopFun)->decoded);
+		TS_ASSERT(!_reference->find_function(kLoopFun)->decoded);
+	}
+
+	void test_strings() {
+		checkSame(kStringFun);
+		TS_ASSERT(_decoded->String && _reference->String);
+		TS_ASSERT_EQUALS(std::string(_decoded->String), std::string(_reference->String));
+		TS_ASSERT_EQUALS(std::string(_decoded->String), "Hello world");
+	}
+
+	void test_arrays() {
+		checkSame(kArrayFun);
+	}
+
+	void test_logic() {
+		for (int flag = 0; flag < 2; flag++) {
+			_decoded->set_global_flag(0x3b, flag);
+			_reference->set_global_flag(0x3b, flag);
+			for (int event = 0; event < 4; event++)
+				checkSame(kLogicFun, event);
+		}
+	}
+
+	void test_bad_local() {
+		checkSame(kBadLocalFun);
+	}
+
+	void test_conversation() {
+		checkSame(kConverseFun);
+		// The second case matched.
+		const Usecode_value reply = call(_decoded, kConverseFun, 2);
+		TS_ASSERT(reply.get_str_value() && !strncmp(reply.get_str_value(), "I am a bard", 11));
+	}
+
+	void test_literal_allocations() {
+		Usecode_internal *const machines[] = {_decoded, _reference};
+		for (Usecode_internal *uc : machines) {
+			// The first calls decode the functions and make their literals.
+			const Usecode_value once = call(uc, kLiteralOnceFun, 2);
+			const Usecode_value loop = call(uc, kLiteralLoopFun, 2);
+			TS_ASSERT(once == loop);
+			TS_ASSERT(loop.get_str_value() && !strncmp(loop.get_str_value(), "Thou dost", 9));
+
+			// After that, pushing a literal shares the function's string,
+			// and values are moved off the stack, so the trips through the
+			// loop allocate nothing.  (When each PUSHS made a new string,
+			// and each pop copied one, every trip allocated.)
+			TS_ASSERT_EQUALS(countCalls(uc, kLiteralLoopFun), countCalls(uc, kLiteralOnceFun));
+		}
+	}
+
+	void test_interpreter_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+
+		const int calls = 20000;
+		uint32 time = timeCalls(_reference, kLoopFun, calls);
+		uint32 decodedTime = timeCalls(_decoded, kLoopFun, calls);
+		debug("Arithmetic loop: %d calls in %u ms with the switch, %u ms decoded", calls, time, decodedTime);
+
+		time = timeCalls(_reference, kConverseFun, calls);
+		decodedTime = timeCalls(_decoded, kConverseFun, calls);
+		debug("Conversation: %d calls in %u ms with the switch, %u ms decoded", calls, time, decodedTime);
+#endif
+	}
+};